@@ -0,0 +1,153 @@
+#include "asyncLoader.h"
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// AsyncRequest
+
+AsyncRequest::
+  AsyncRequest()
+  : m_loader(nullptr)
+  , m_state(k_idle)
+  , m_loaded(false)
+{ }
+
+// -----------------------------------------------------------------------
+
+AsyncRequest::
+  ~AsyncRequest()
+{
+  TLOC_ASSERT(m_state != k_loading,
+              "AsyncRequest destroyed while it is being loaded");
+}
+
+// -----------------------------------------------------------------------
+
+bool
+AsyncRequest::
+  IsDone() const
+{ return m_state == k_done || m_state == k_failed; }
+
+// -----------------------------------------------------------------------
+
+bool
+AsyncRequest::
+  DoFinish()
+{ return true; }
+
+// -----------------------------------------------------------------------
+
+void
+AsyncRequest::
+  Run()
+{
+  m_loaded = DoLoad();
+  m_loader->DoComplete(*this);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// AsyncLoader
+
+AsyncLoader::
+  AsyncLoader(tl_int a_numThreads)
+  : m_nextFinish(0)
+  , m_numPending(0)
+  , m_pool(a_numThreads)
+{ }
+
+// -----------------------------------------------------------------------
+
+AsyncLoader::
+  ~AsyncLoader()
+{
+  m_pool.Wait();
+
+  for (tl_size i = m_nextFinish; i < m_finishing.size(); ++i)
+  { m_finishing[i]->m_state = AsyncRequest::k_failed; }
+  for (tl_size i = 0; i < m_completed.size(); ++i)
+  { m_completed[i]->m_state = AsyncRequest::k_failed; }
+}
+
+// -----------------------------------------------------------------------
+
+void
+AsyncLoader::
+  Load(AsyncRequest& a_request)
+{
+  TLOC_ASSERT(a_request.m_state != AsyncRequest::k_loading,
+              "The request is already being loaded");
+
+  a_request.m_loader = this;
+  a_request.m_state = AsyncRequest::k_loading;
+  a_request.m_loaded = false;
+
+  ++m_numPending;
+  m_pool.Push(a_request);
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+AsyncLoader::
+  Finish(f64 a_budgetSeconds)
+{
+  core_time::Timer timer;
+  tl_size numFinished = 0;
+
+  for (;;)
+  {
+    if (m_nextFinish == m_finishing.size())
+    {
+      m_finishing.clear();
+      m_nextFinish = 0;
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_finishing.swap(m_completed);
+    }
+
+    if (m_finishing.empty())
+    { break; }
+
+    if (numFinished > 0 && timer.ElapsedSeconds() >= a_budgetSeconds)
+    { break; }
+
+    AsyncRequest& request = *m_finishing[m_nextFinish++];
+    request.m_state = request.m_loaded && request.DoFinish()
+      ? AsyncRequest::k_done
+      : AsyncRequest::k_failed;
+
+    --m_numPending;
+    ++numFinished;
+  }
+
+  return numFinished;
+}
+
+// -----------------------------------------------------------------------
+
+void
+AsyncLoader::
+  FinishAll()
+{
+  m_pool.Wait();
+
+  while (m_numPending > 0)
+  { Finish(1.0); }
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+AsyncLoader::
+  GetNumThreads() const
+{ return m_pool.GetNumThreads(); }
+
+// -----------------------------------------------------------------------
+
+void
+AsyncLoader::
+  DoComplete(AsyncRequest& a_request)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_completed.push_back(&a_request);
+}
@@ -0,0 +1,109 @@
+#ifndef _TLOC_ASYNC_LOADING_ASYNC_LOADER_H_
+#define _TLOC_ASYNC_LOADING_ASYNC_LOADER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "workerPool.h"
+
+class AsyncLoader;
+
+// ///////////////////////////////////////////////////////////////////////
+// A resource loaded by an AsyncLoader, the request is also the handle the
+// resource is used through once IsDone().
+//
+// DoLoad() runs on a worker thread and does all the work that does not need
+// the main thread: reading, decoding, parsing. DoFinish() runs on the main
+// thread from AsyncLoader::Finish() and only creates what has to be created
+// there (GPU objects). It is not called if DoLoad() failed. Only one thread
+// uses a request at a time, DoFinish() sees everything DoLoad() wrote.
+//
+// The loader does not own the request, it has to live until IsDone() (or
+// the loader is destroyed) and can be loaded again after that.
+
+class AsyncRequest
+  : private WorkerJob
+{
+public:
+  enum state { k_idle, k_loading, k_done, k_failed };
+
+public:
+  AsyncRequest();
+  virtual ~AsyncRequest();
+
+  bool  IsDone() const;       // k_done or k_failed
+
+  TLOC_DECL_AND_DEF_GETTER(state, GetState, m_state);
+
+protected:
+  virtual bool  DoLoad() = 0;
+  virtual bool  DoFinish();
+
+private:
+  AsyncRequest(const AsyncRequest&);
+  AsyncRequest& operator=(const AsyncRequest&);
+
+  void  Run();
+
+private:
+  friend class AsyncLoader;
+
+  AsyncLoader*  m_loader;
+  state         m_state;      // only changed on the main thread
+  bool          m_loaded;     // written by the worker thread
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Loads requests on a WorkerPool. Loaded requests wait in a completion
+// queue until the main thread calls Finish(), usually once per frame with
+// the part of the frame it can spend on them. Finish() finishes them in
+// the order they were loaded and stops once a_budgetSeconds have passed,
+// so a frame never stalls for more than about one DoFinish().
+//
+// Requests still loading when the loader is destroyed are waited for and
+// become k_failed without being finished.
+
+class AsyncLoader
+{
+public:
+  explicit AsyncLoader(tl_int a_numThreads);
+  ~AsyncLoader();
+
+  void    Load(AsyncRequest& a_request);
+
+  // finishes at least one loaded request (if there is one), returns the
+  // number finished
+  tl_size Finish(f64 a_budgetSeconds);
+
+  // waits for every request and finishes it (loading screens)
+  void    FinishAll();
+
+  // requests loading or waiting to be finished
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetNumPending, m_numPending);
+
+  tl_size GetNumThreads() const;
+
+private:
+  AsyncLoader(const AsyncLoader&);
+  AsyncLoader& operator=(const AsyncLoader&);
+
+  void    DoComplete(AsyncRequest& a_request);
+
+private:
+  friend class AsyncRequest;
+
+  typedef tl_core_conts::Array<AsyncRequest*>   request_cont;
+
+  // filled by the worker threads, swapped with m_finishing (which only
+  // the main thread uses) once m_finishing has been finished
+  request_cont  m_completed;
+  request_cont  m_finishing;
+  tl_size       m_nextFinish;
+  tl_size       m_numPending;
+
+  std::mutex    m_mutex;
+
+  // last, so the threads are joined before the queues are destroyed
+  WorkerPool    m_pool;
+};
+
+#endif
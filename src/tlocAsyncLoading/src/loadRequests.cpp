@@ -0,0 +1,97 @@
+#include "loadRequests.h"
+
+#include <tlocMeshTools/src/mappedFile.h>
+#include <tlocMeshTools/src/objParser.h>
+
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// FileRequest
+
+FileRequest::
+  FileRequest(const char* a_fileName)
+  : m_fileName(a_fileName)
+  , m_contents(1, 0)
+{ }
+
+// -----------------------------------------------------------------------
+
+tl_size
+FileRequest::
+  GetSize() const
+{ return m_contents.size() - 1; }
+
+// -----------------------------------------------------------------------
+
+bool
+FileRequest::
+  DoLoad()
+{
+  m_contents.clear();
+
+  MappedFile file;
+  const bool opened = file.Open(m_fileName.c_str());
+
+  const tl_size size = opened ? file.GetSize() : 0;
+  m_contents.resize(size + 1, 0);
+  if (size > 0)
+  { memcpy(&m_contents[0], file.GetData(), size); }
+
+  return opened;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// ObjMeshRequest
+
+ObjMeshRequest::
+  ObjMeshRequest(const char* a_fileName)
+  : m_fileName(a_fileName)
+  , m_errorLine(0)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+ObjMeshRequest::
+  DoLoad()
+{
+  m_mesh.Clear();
+  m_errorLine = 0;
+
+  MappedFile file;
+  if (file.Open(m_fileName.c_str()) == false)
+  { return false; }
+
+  // the other workers load the other files, the file is parsed serially
+  ObjMesh   mesh;
+  ObjParser parser;
+  if (parser.Parse(file.GetData(), file.GetSize(), mesh) == false)
+  {
+    m_errorLine = parser.GetErrorLine();
+    return false;
+  }
+
+  file.Close();
+
+  WeldMesh(mesh, m_mesh);
+  return true;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// CookedMeshRequest
+
+CookedMeshRequest::
+  CookedMeshRequest(const char* a_objFile, const MeshCookSettings& a_settings)
+  : m_fileName(a_objFile)
+  , m_settings(a_settings)
+  , m_cooked(false)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+CookedMeshRequest::
+  DoLoad()
+{ return LoadCookedMesh(m_fileName.c_str(), m_settings, m_mesh, &m_cooked); }
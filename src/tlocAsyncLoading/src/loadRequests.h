@@ -0,0 +1,89 @@
+#ifndef _TLOC_ASYNC_LOADING_LOAD_REQUESTS_H_
+#define _TLOC_ASYNC_LOADING_LOAD_REQUESTS_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include <tlocMeshTools/src/cookedMesh.h>
+#include <tlocMeshTools/src/indexedMesh.h>
+
+#include "asyncLoader.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Requests for the resources the samples load before their first frame.
+// They only do the worker thread part, a sample derives from them and
+// overrides DoFinish() to create its GPU objects (e.g. fill a
+// gfx_gl::AttributeVBO from GetMesh()) on the main thread.
+
+// -----------------------------------------------------------------------
+// The whole file (shader sources, font and image files to be decoded by
+// the derived request). The contents are followed by a 0 that is not part
+// of GetSize(), so text can be used as a C string.
+
+class FileRequest
+  : public AsyncRequest
+{
+public:
+  explicit FileRequest(const char* a_fileName);
+
+  tl_size     GetSize() const;
+
+  TLOC_DECL_AND_DEF_GETTER(const char*, GetFileName, m_fileName.c_str());
+  TLOC_DECL_AND_DEF_GETTER(const char*, GetContents, &m_contents[0]);
+
+protected:
+  bool        DoLoad();
+
+private:
+  tl_core_str::String         m_fileName;
+  tl_core_conts::Array<char>  m_contents;
+};
+
+// -----------------------------------------------------------------------
+// An OBJ file parsed and welded (see WeldMesh()) on the worker thread.
+
+class ObjMeshRequest
+  : public AsyncRequest
+{
+public:
+  explicit ObjMeshRequest(const char* a_fileName);
+
+  TLOC_DECL_AND_DEF_GETTER(const char*, GetFileName, m_fileName.c_str());
+  TLOC_DECL_AND_DEF_GETTER(const IndexedMesh&, GetMesh, m_mesh);
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetErrorLine, m_errorLine);
+
+protected:
+  bool        DoLoad();
+
+private:
+  tl_core_str::String         m_fileName;
+  IndexedMesh                 m_mesh;
+  tl_size                     m_errorLine;
+};
+
+// -----------------------------------------------------------------------
+// An OBJ file through LoadCookedMesh(): the cooked mesh is mapped, or the
+// OBJ file is cooked first if it is not up to date. Cooking uses
+// a_settings.m_numThreads threads on top of the worker, 1 is best when
+// there are more files than workers.
+
+class CookedMeshRequest
+  : public AsyncRequest
+{
+public:
+  CookedMeshRequest(const char* a_objFile, const MeshCookSettings& a_settings);
+
+  TLOC_DECL_AND_DEF_GETTER(const char*, GetFileName, m_fileName.c_str());
+  TLOC_DECL_AND_DEF_GETTER(const CookedMesh&, GetMesh, m_mesh);
+  TLOC_DECL_AND_DEF_GETTER(bool, IsCooked, m_cooked);
+
+protected:
+  bool        DoLoad();
+
+private:
+  tl_core_str::String         m_fileName;
+  MeshCookSettings            m_settings;
+  CookedMesh                  m_mesh;
+  bool                        m_cooked;
+};
+
+#endif
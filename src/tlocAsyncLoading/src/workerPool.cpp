@@ -0,0 +1,120 @@
+#include "workerPool.h"
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// WorkerJob
+
+WorkerJob::
+  ~WorkerJob()
+{ }
+
+// ///////////////////////////////////////////////////////////////////////
+// WorkerPool
+
+WorkerPool::
+  WorkerPool(tl_int a_numThreads)
+  : m_nextJob(0)
+  , m_numRunning(0)
+  , m_stop(false)
+{
+  const tl_int numThreads = core::tlMax(a_numThreads, 1);
+  for (tl_int i = 0; i < numThreads; ++i)
+  { m_threads.push_back(new std::thread(&WorkerPool::DoRun, this)); }
+}
+
+// -----------------------------------------------------------------------
+
+WorkerPool::
+  ~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_jobReady.notify_all();
+
+  for (tl_size i = 0; i < m_threads.size(); ++i)
+  {
+    m_threads[i]->join();
+    delete m_threads[i];
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+WorkerPool::
+  Push(WorkerJob& a_job)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.push_back(&a_job);
+  }
+  m_jobReady.notify_one();
+}
+
+// -----------------------------------------------------------------------
+
+void
+WorkerPool::
+  Wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (m_jobs.empty() == false || m_numRunning > 0)
+  { m_idle.wait(lock); }
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+WorkerPool::
+  GetNumThreads() const
+{ return m_threads.size(); }
+
+// -----------------------------------------------------------------------
+
+tl_size
+WorkerPool::
+  GetNumQueued() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_jobs.size() - m_nextJob;
+}
+
+// -----------------------------------------------------------------------
+
+void
+WorkerPool::
+  DoRun()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;)
+  {
+    while (m_nextJob == m_jobs.size() && m_stop == false)
+    { m_jobReady.wait(lock); }
+
+    // only stops once the queue is empty
+    if (m_nextJob == m_jobs.size())
+    { break; }
+
+    WorkerJob* job = m_jobs[m_nextJob++];
+    if (m_nextJob == m_jobs.size())
+    {
+      m_jobs.clear();
+      m_nextJob = 0;
+    }
+
+    ++m_numRunning;
+    lock.unlock();
+
+    job->Run();
+
+    lock.lock();
+    --m_numRunning;
+
+    if (m_numRunning == 0 && m_jobs.empty())
+    { m_idle.notify_all(); }
+  }
+}
@@ -0,0 +1,63 @@
+#ifndef _TLOC_ASYNC_LOADING_WORKER_POOL_H_
+#define _TLOC_ASYNC_LOADING_WORKER_POOL_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// ///////////////////////////////////////////////////////////////////////
+// Work run by a WorkerPool. The pool does not own the job, it has to live
+// until Run() has returned.
+
+class WorkerJob
+{
+public:
+  virtual ~WorkerJob();
+
+  virtual void  Run() = 0;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// A fixed number of threads taking jobs in the order they were pushed.
+// The threads are started once and sleep while there is nothing to do.
+// The destructor runs the jobs still queued before joining the threads.
+
+class WorkerPool
+{
+public:
+  explicit WorkerPool(tl_int a_numThreads);
+  ~WorkerPool();
+
+  void    Push(WorkerJob& a_job);
+  void    Wait();             // until every pushed job has run
+
+  tl_size GetNumThreads() const;
+  tl_size GetNumQueued() const;
+
+private:
+  WorkerPool(const WorkerPool&);
+  WorkerPool& operator=(const WorkerPool&);
+
+  void    DoRun();
+
+private:
+  typedef tl_core_conts::Array<std::thread*>  thread_cont;
+  typedef tl_core_conts::Array<WorkerJob*>    job_cont;
+
+  thread_cont             m_threads;
+
+  // m_jobs before m_nextJob have been taken, the array is emptied once
+  // every job in it has been taken
+  job_cont                m_jobs;
+  tl_size                 m_nextJob;
+  tl_size                 m_numRunning;
+  bool                    m_stop;
+
+  mutable std::mutex      m_mutex;
+  std::condition_variable m_jobReady;
+  std::condition_variable m_idle;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef _TLOC_DISTANCE_FIELD_H_
+#define _TLOC_DISTANCE_FIELD_H_
+
+#include <tlocCore/tloc_core.h>
+
+typedef tl_core_conts::Array<u8>      df_mask_cont;
+typedef tl_core_conts::Array<tl_int>  df_index_cont;
+
+// ///////////////////////////////////////////////////////////////////////
+// The taps of a circular kernel sorted by distance. The first tap that lands
+// on a pixel of the opposite class is the closest edge, which lets most
+// pixels (the ones near an edge) stop after a handful of taps. Taps at the
+// same distance are kept in row major order so that ties always resolve to
+// the same tap. The tap count is padded to a multiple of k_blockSize with taps
+// that point at the pixel itself.
+
+struct KernelTaps
+{
+  enum { k_noTap = -1, k_blockSize = 8 };
+
+  df_index_cont               m_x;
+  df_index_cont               m_y;
+  df_index_cont               m_offset; // m_x + m_y * mask width
+  tl_core_conts::Array<f32>   m_distance;
+  tl_int                      m_numTaps;
+};
+
+KernelTaps  GetSortedKernelTaps(tl_int a_kernelSize, tl_int a_maskWidth);
+
+// Returns the index of the closest tap that crosses an edge, or k_noTap.
+// a_checkBounds is only needed for pixels within a kernel of the border.
+tl_int      FindClosestEdgeTap(const df_mask_cont& a_mask, const KernelTaps& a_taps,
+                               tl_int a_x, tl_int a_y, 
+                               tl_int a_width, tl_int a_height, 
+                               bool a_checkBounds);
+
+// ///////////////////////////////////////////////////////////////////////
+// A binary mask (1 inside, 0 outside) and its signed distance field, which
+// is negative inside and clamped to the kernel size. The field is kept
+// between edits: after changing the mask the caller marks the changed
+// rectangles dirty and Update() only recomputes the pixels that are within a
+// kernel of them.
+
+class DistanceField
+{
+public:
+  DistanceField();
+
+  void    Initialize(const df_mask_cont& a_mask, tl_int a_width, 
+                     tl_int a_height, tl_int a_kernelSize);
+
+  void    SetMaskValue(tl_int a_x, tl_int a_y, bool a_inside);
+  void    MarkDirty(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height);
+
+  // returns the number of pixels that were recomputed
+  tl_int  Update();
+
+  f32     GetDistance(tl_int a_x, tl_int a_y) const;
+  bool    GetVectorToEdge(tl_int a_x, tl_int a_y, 
+                          tl_int& a_dx, tl_int& a_dy) const;
+
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetWidth, m_width);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetHeight, m_height);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetKernelSize, m_kernelSize);
+
+  const df_mask_cont& GetMask() const;
+
+private:
+  void    DoUpdateRect(tl_int a_x0, tl_int a_y0, tl_int a_x1, tl_int a_y1);
+
+private:
+  struct Rect
+  {
+    tl_int m_x0, m_y0, m_x1, m_y1; // [x0, x1) x [y0, y1)
+  };
+
+  tl_core_conts::Array<Rect>  m_dirtyRects;
+
+  df_mask_cont    m_mask;
+  df_index_cont   m_nearestTap;
+  KernelTaps      m_taps;
+
+  tl_int  m_width;
+  tl_int  m_height;
+  tl_int  m_kernelSize;
+};
+
+#endif
@@ -0,0 +1,609 @@
+#include "distanceVolume.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  typedef tl_core_conts::Array<s32>   index_cont;
+
+  const f32     g_maxDistSq = 1e30f;
+  const tl_int  g_noIndex = -1;
+
+  // closest features, indices into TriangleBVH::Triangle::m_normal
+  enum
+  {
+    k_face = 0,
+    k_vertex0, k_vertex1, k_vertex2,
+    k_edge01, k_edge12, k_edge20
+  };
+
+  f32   DoDot(const f32* a, const f32* b)
+  { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+  void  DoSub(const f32* a, const f32* b, f32* a_out)
+  { a_out[0] = a[0] - b[0]; a_out[1] = a[1] - b[1]; a_out[2] = a[2] - b[2]; }
+
+  void  DoCross(const f32* a, const f32* b, f32* a_out)
+  {
+    a_out[0] = a[1] * b[2] - a[2] * b[1];
+    a_out[1] = a[2] * b[0] - a[0] * b[2];
+    a_out[2] = a[0] * b[1] - a[1] * b[0];
+  }
+
+  void  DoMulAdd(const f32* a, const f32* b, f32 s, f32* a_out)
+  { a_out[0] = a[0] + b[0] * s; a_out[1] = a[1] + b[1] * s; a_out[2] = a[2] + b[2] * s; }
+
+  f32   DoNormalize(f32* a)
+  {
+    const f32 length = sqrtf(DoDot(a, a));
+    if (length > 0.0f)
+    { a[0] /= length; a[1] /= length; a[2] /= length; }
+    return length;
+  }
+
+  u32   DoHash(u32 a_hash, u32 a_value)
+  { return (a_hash ^ a_value) * 16777619u; }
+
+  u32   DoHashPosition(const f32* a_pos)
+  {
+    u32 hash = 2166136261u;
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      // + 0.0f turns -0 into 0 so that both hash the same
+      const f32 value = a_pos[i] + 0.0f;
+      u32 bits;
+      memcpy(&bits, &value, sizeof(bits));
+      hash = DoHash(hash, bits);
+    }
+    return hash;
+  }
+
+  tl_size DoGetTableSize(tl_size a_numEntries)
+  {
+    tl_size size = 16;
+    while (size < a_numEntries * 2) { size *= 2; }
+    return size;
+  }
+
+  // -----------------------------------------------------------------------
+  // Gives every vertex the index of the first vertex with the same position
+
+  void  DoWeldVertices(const dv_triangle_cont& a_triangles, index_cont& a_ids)
+  {
+    const tl_size numVerts = a_triangles.size() / 3;
+    const tl_size tableMask = DoGetTableSize(numVerts) - 1;
+
+    index_cont table(tableMask + 1, g_noIndex);
+    a_ids.clear();
+    a_ids.resize(numVerts, g_noIndex);
+
+    for (tl_size v = 0; v < numVerts; ++v)
+    {
+      const f32* pos = &a_triangles[v * 3];
+      tl_size slot = DoHashPosition(pos) & tableMask;
+      for (;;)
+      {
+        const s32 other = table[slot];
+        if (other == g_noIndex)
+        {
+          table[slot] = (s32)v;
+          a_ids[v] = (s32)v;
+          break;
+        }
+
+        const f32* otherPos = &a_triangles[other * 3];
+        if (otherPos[0] == pos[0] && otherPos[1] == pos[1] && otherPos[2] == pos[2])
+        {
+          a_ids[v] = other;
+          break;
+        }
+
+        slot = (slot + 1) & tableMask;
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Closest point on a triangle (Ericson, Real-Time Collision Detection 5.1.5)
+  // which also returns the feature (face, edge or vertex) it lies on.
+
+  tl_int DoClosestPointOnTriangle(const f32* p, const f32* a, const f32* b,
+                                  const f32* c, f32* a_out)
+  {
+    f32 ab[3], ac[3], ap[3], bp[3], cp[3];
+    DoSub(b, a, ab);
+    DoSub(c, a, ac);
+    DoSub(p, a, ap);
+
+    const f32 d1 = DoDot(ab, ap);
+    const f32 d2 = DoDot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+    { memcpy(a_out, a, sizeof(f32) * 3); return k_vertex0; }
+
+    DoSub(p, b, bp);
+    const f32 d3 = DoDot(ab, bp);
+    const f32 d4 = DoDot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+    { memcpy(a_out, b, sizeof(f32) * 3); return k_vertex1; }
+
+    const f32 vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    { DoMulAdd(a, ab, d1 / (d1 - d3), a_out); return k_edge01; }
+
+    DoSub(p, c, cp);
+    const f32 d5 = DoDot(ab, cp);
+    const f32 d6 = DoDot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+    { memcpy(a_out, c, sizeof(f32) * 3); return k_vertex2; }
+
+    const f32 vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    { DoMulAdd(a, ac, d2 / (d2 - d6), a_out); return k_edge20; }
+
+    const f32 va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+      f32 bc[3];
+      DoSub(c, b, bc);
+      DoMulAdd(b, bc, (d4 - d3) / ( (d4 - d3) + (d5 - d6) ), a_out);
+      return k_edge12;
+    }
+
+    const f32 denom = 1.0f / (va + vb + vc);
+    DoMulAdd(a, ab, vb * denom, a_out);
+    DoMulAdd(a_out, ac, vc * denom, a_out);
+    return k_face;
+  }
+
+  f32   DoBoxDistanceSq(const f32* a_point, const f32* a_min, const f32* a_max)
+  {
+    f32 distSq = 0.0f;
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      f32 d = 0.0f;
+      if (a_point[i] < a_min[i])      { d = a_min[i] - a_point[i]; }
+      else if (a_point[i] > a_max[i]) { d = a_point[i] - a_max[i]; }
+      distSq += d * d;
+    }
+    return distSq;
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// TriangleBVH
+
+TriangleBVH::
+  TriangleBVH()
+{ }
+
+// -----------------------------------------------------------------------
+
+void
+TriangleBVH::
+  Initialize(const dv_triangle_cont& a_triangles)
+{
+  TLOC_ASSERT(a_triangles.size() % 9 == 0, "Expected 9 floats per triangle");
+
+  m_nodes.clear();
+  m_triangles.clear();
+
+  const tl_int numTris = core_utils::CastNumber<tl_int>(a_triangles.size() / 9);
+
+  // -----------------------------------------------------------------------
+  // pseudo normals
+
+  index_cont vertexIds;
+  DoWeldVertices(a_triangles, vertexIds);
+
+  dv_triangle_cont vertexNormals(a_triangles.size(), 0.0f);
+  dv_triangle_cont faceNormals(numTris * 3, 0.0f);
+
+  for (tl_int t = 0; t < numTris; ++t)
+  {
+    const f32* v = &a_triangles[t * 9];
+    f32* n = &faceNormals[t * 3];
+
+    f32 e0[3], e1[3];
+    DoSub(v + 3, v, e0);
+    DoSub(v + 6, v, e1);
+    DoCross(e0, e1, n);
+    DoNormalize(n);
+
+    for (tl_int corner = 0; corner < 3; ++corner)
+    {
+      const f32* p0 = v + corner * 3;
+      const f32* p1 = v + ( (corner + 1) % 3) * 3;
+      const f32* p2 = v + ( (corner + 2) % 3) * 3;
+
+      f32 d0[3], d1[3];
+      DoSub(p1, p0, d0);
+      DoSub(p2, p0, d1);
+      DoNormalize(d0);
+      DoNormalize(d1);
+
+      const f32 angle = acosf(core::Clamp(DoDot(d0, d1), -1.0f, 1.0f));
+      f32* vn = &vertexNormals[vertexIds[t * 3 + corner] * 3];
+      DoMulAdd(vn, n, angle, vn);
+    }
+  }
+
+  // edges are keyed by their (sorted) welded vertices and sum the normals of
+  // all the faces sharing them
+  const tl_size edgeTableMask = DoGetTableSize(numTris * 3) - 1;
+  index_cont  edgeTable(edgeTableMask + 1, g_noIndex);
+  index_cont  edgeKeys;
+  index_cont  triEdges(numTris * 3, g_noIndex);
+  dv_triangle_cont edgeNormals;
+
+  for (tl_int t = 0; t < numTris; ++t)
+  {
+    for (tl_int e = 0; e < 3; ++e)
+    {
+      s32 v0 = vertexIds[t * 3 + e];
+      s32 v1 = vertexIds[t * 3 + (e + 1) % 3];
+      if (v0 > v1) { const s32 temp = v0; v0 = v1; v1 = temp; }
+
+      tl_size slot = DoHash(DoHash(2166136261u, (u32)v0), (u32)v1) & edgeTableMask;
+      for (;;)
+      {
+        const s32 edge = edgeTable[slot];
+        if (edge == g_noIndex)
+        {
+          const s32 newEdge = core_utils::CastNumber<s32>(edgeKeys.size() / 2);
+          edgeTable[slot] = newEdge;
+          edgeKeys.push_back(v0);
+          edgeKeys.push_back(v1);
+          edgeNormals.resize(edgeNormals.size() + 3, 0.0f);
+          triEdges[t * 3 + e] = newEdge;
+          break;
+        }
+
+        if (edgeKeys[edge * 2] == v0 && edgeKeys[edge * 2 + 1] == v1)
+        {
+          triEdges[t * 3 + e] = edge;
+          break;
+        }
+
+        slot = (slot + 1) & edgeTableMask;
+      }
+
+      f32* en = &edgeNormals[triEdges[t * 3 + e] * 3];
+      DoMulAdd(en, &faceNormals[t * 3], 1.0f, en);
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // triangles, degenerate ones are dropped since they have no normal
+
+  index_cont        order;
+  dv_triangle_cont  centroids;
+
+  for (tl_int t = 0; t < numTris; ++t)
+  {
+    const f32* n = &faceNormals[t * 3];
+    if (DoDot(n, n) == 0.0f)
+    { continue; }
+
+    Triangle tri;
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      const f32* pos = &a_triangles[t * 9 + i * 3];
+      const f32* vn = &vertexNormals[vertexIds[t * 3 + i] * 3];
+      const f32* en = &edgeNormals[triEdges[t * 3 + i] * 3];
+
+      for (tl_int axis = 0; axis < 3; ++axis)
+      {
+        tri.m_v[i][axis] = pos[axis];
+        tri.m_normal[k_face][axis] = n[axis];
+        tri.m_normal[k_vertex0 + i][axis] = vn[axis];
+        tri.m_normal[k_edge01 + i][axis] = en[axis];
+      }
+    }
+
+    for (tl_int axis = 0; axis < 3; ++axis)
+    {
+      centroids.push_back( (tri.m_v[0][axis] + tri.m_v[1][axis] +
+                            tri.m_v[2][axis]) / 3.0f );
+    }
+
+    order.push_back(core_utils::CastNumber<s32>(m_triangles.size()));
+    m_triangles.push_back(tri);
+  }
+
+  if (m_triangles.empty())
+  { return; }
+
+  DoBuild(order, centroids, 0, core_utils::CastNumber<tl_int>(order.size()), 0);
+
+  // leaves reference contiguous ranges of triangles
+  tl_core_conts::Array<Triangle> sortedTriangles;
+  sortedTriangles.reserve(m_triangles.size());
+  for (tl_size i = 0; i < order.size(); ++i)
+  { sortedTriangles.push_back(m_triangles[order[i]]); }
+
+  m_triangles.swap(sortedTriangles);
+}
+
+// -----------------------------------------------------------------------
+// Splits at the middle of the centroid bounds along the longest axis, or
+// in half if all the centroids land on one side. Returns the node index.
+
+tl_int
+TriangleBVH::
+  DoBuild(index_cont& a_order, const dv_triangle_cont& a_centroids,
+          tl_int a_begin, tl_int a_end, tl_int a_depth)
+{
+  const tl_int nodeIndex = core_utils::CastNumber<tl_int>(m_nodes.size());
+  m_nodes.push_back(Node());
+
+  Node node;
+  f32 centroidMin[3], centroidMax[3];
+  for (tl_int axis = 0; axis < 3; ++axis)
+  {
+    node.m_min[axis] = centroidMin[axis] = g_maxDistSq;
+    node.m_max[axis] = centroidMax[axis] = -g_maxDistSq;
+  }
+
+  for (tl_int i = a_begin; i < a_end; ++i)
+  {
+    const tl_int t = a_order[i];
+    const Triangle& tri = m_triangles[t];
+
+    for (tl_int axis = 0; axis < 3; ++axis)
+    {
+      for (tl_int v = 0; v < 3; ++v)
+      {
+        node.m_min[axis] = core::tlMin(node.m_min[axis], tri.m_v[v][axis]);
+        node.m_max[axis] = core::tlMax(node.m_max[axis], tri.m_v[v][axis]);
+      }
+
+      const f32 c = a_centroids[t * 3 + axis];
+      centroidMin[axis] = core::tlMin(centroidMin[axis], c);
+      centroidMax[axis] = core::tlMax(centroidMax[axis], c);
+    }
+  }
+
+  const tl_int count = a_end - a_begin;
+  if (count <= k_maxLeafSize || a_depth >= k_maxDepth)
+  {
+    node.m_first = a_begin;
+    node.m_count = count;
+    m_nodes[nodeIndex] = node;
+    return nodeIndex;
+  }
+
+  tl_int axis = 0;
+  for (tl_int i = 1; i < 3; ++i)
+  {
+    if (centroidMax[i] - centroidMin[i] > centroidMax[axis] - centroidMin[axis])
+    { axis = i; }
+  }
+
+  const f32 split = (centroidMin[axis] + centroidMax[axis]) * 0.5f;
+
+  tl_int mid = a_begin;
+  for (tl_int i = a_begin; i < a_end; ++i)
+  {
+    if (a_centroids[a_order[i] * 3 + axis] < split)
+    {
+      const s32 temp = a_order[i];
+      a_order[i] = a_order[mid];
+      a_order[mid] = temp;
+      ++mid;
+    }
+  }
+
+  if (mid == a_begin || mid == a_end)
+  { mid = a_begin + count / 2; }
+
+  DoBuild(a_order, a_centroids, a_begin, mid, a_depth + 1);
+  node.m_first = DoBuild(a_order, a_centroids, mid, a_end, a_depth + 1);
+  node.m_count = 0;
+  m_nodes[nodeIndex] = node;
+
+  return nodeIndex;
+}
+
+// -----------------------------------------------------------------------
+
+f32
+TriangleBVH::
+  DoFindClosest(const f32 a_point[3], f32 a_maxDistSq, tl_int& a_closestTri,
+                f32 a_closestPoint[3], tl_int& a_feature) const
+{
+  a_closestTri = k_noTriangle;
+  a_feature = k_face;
+
+  f32 bestDistSq = a_maxDistSq;
+  if (m_nodes.empty())
+  { return bestDistSq; }
+
+  // the near child is always pushed last, so the stack never holds more
+  // than one node per level
+  s32     stack[k_maxDepth + 2];
+  tl_int  stackSize = 0;
+  stack[stackSize++] = 0;
+
+  while (stackSize > 0)
+  {
+    const Node& node = m_nodes[stack[--stackSize]];
+    if (DoBoxDistanceSq(a_point, node.m_min, node.m_max) >= bestDistSq)
+    { continue; }
+
+    if (node.m_count > 0)
+    {
+      for (tl_int t = node.m_first; t < node.m_first + node.m_count; ++t)
+      {
+        const Triangle& tri = m_triangles[t];
+
+        f32 closest[3], diff[3];
+        const tl_int feature = 
+          DoClosestPointOnTriangle(a_point, tri.m_v[0], tri.m_v[1], tri.m_v[2], closest);
+        DoSub(a_point, closest, diff);
+
+        const f32 distSq = DoDot(diff, diff);
+        if (distSq < bestDistSq)
+        {
+          bestDistSq = distSq;
+          a_closestTri = t;
+          a_feature = feature;
+          memcpy(a_closestPoint, closest, sizeof(closest));
+        }
+      }
+      continue;
+    }
+
+    const tl_int left = (tl_int)(&node - &m_nodes[0]) + 1;
+    const tl_int right = node.m_first;
+
+    const f32 leftDistSq = 
+      DoBoxDistanceSq(a_point, m_nodes[left].m_min, m_nodes[left].m_max);
+    const f32 rightDistSq = 
+      DoBoxDistanceSq(a_point, m_nodes[right].m_min, m_nodes[right].m_max);
+
+    if (leftDistSq < rightDistSq)
+    {
+      if (rightDistSq < bestDistSq) { stack[stackSize++] = right; }
+      if (leftDistSq < bestDistSq)  { stack[stackSize++] = left; }
+    }
+    else
+    {
+      if (leftDistSq < bestDistSq)  { stack[stackSize++] = left; }
+      if (rightDistSq < bestDistSq) { stack[stackSize++] = right; }
+    }
+  }
+
+  return bestDistSq;
+}
+
+// -----------------------------------------------------------------------
+
+f32
+TriangleBVH::
+  FindClosest(const f32 a_point[3], f32 a_maxDistSq, tl_int& a_closestTri,
+              f32 a_closestPoint[3]) const
+{
+  tl_int feature;
+  return DoFindClosest(a_point, a_maxDistSq, a_closestTri, a_closestPoint, feature);
+}
+
+// -----------------------------------------------------------------------
+
+f32
+TriangleBVH::
+  GetSignedDistance(const f32 a_point[3], f32 a_maxDistance) const
+{
+  tl_int  tri = k_noTriangle;
+  tl_int  feature = k_face;
+  f32     closest[3];
+  f32     distSq = g_maxDistSq;
+
+  if (a_maxDistance >= 0.0f)
+  {
+    // a little slack so that rounding never loses the closest triangle
+    const f32 maxDistance = a_maxDistance * 1.001f + 1e-6f;
+    distSq = DoFindClosest(a_point, maxDistance * maxDistance, tri, closest, feature);
+  }
+
+  if (tri == k_noTriangle)
+  { distSq = DoFindClosest(a_point, g_maxDistSq, tri, closest, feature); }
+
+  if (tri == k_noTriangle)
+  { return sqrtf(g_maxDistSq); }
+
+  f32 diff[3];
+  DoSub(a_point, closest, diff);
+
+  const f32 distance = sqrtf(distSq);
+  return DoDot(diff, m_triangles[tri].m_normal[feature]) < 0.0f 
+    ? -distance : distance;
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+TriangleBVH::
+  GetNumTriangles() const
+{ return core_utils::CastNumber<tl_int>(m_triangles.size()); }
+
+// -----------------------------------------------------------------------
+
+void
+TriangleBVH::
+  GetBounds(f32 a_min[3], f32 a_max[3]) const
+{
+  for (tl_int axis = 0; axis < 3; ++axis)
+  {
+    a_min[axis] = m_nodes.empty() ? 0.0f : m_nodes[0].m_min[axis];
+    a_max[axis] = m_nodes.empty() ? 0.0f : m_nodes[0].m_max[axis];
+  }
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// BakeDistanceVolume
+
+void
+  BakeDistanceVolume(const TriangleBVH& a_bvh, const f32 a_origin[3],
+                     f32 a_voxelSize, tl_int a_dimX, tl_int a_dimY,
+                     tl_int a_dimZ, dv_volume_cont& a_volume)
+{
+  const tl_int brickSize = k_distanceVolumeBrickSize;
+  const tl_int numBricksX = (a_dimX + brickSize - 1) / brickSize;
+  const tl_int numBricksY = (a_dimY + brickSize - 1) / brickSize;
+  const tl_int numBricksZ = (a_dimZ + brickSize - 1) / brickSize;
+  const tl_int numBricks = numBricksX * numBricksY * numBricksZ;
+
+  a_volume.clear();
+  a_volume.resize( (tl_size)a_dimX * a_dimY * a_dimZ, 0.0f);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (tl_int brick = 0; brick < numBricks; ++brick)
+  {
+    const tl_int bx = (brick % numBricksX) * brickSize;
+    const tl_int by = ( (brick / numBricksX) % numBricksY) * brickSize;
+    const tl_int bz = (brick / (numBricksX * numBricksY)) * brickSize;
+
+    const tl_int xEnd = core::tlMin(bx + brickSize, a_dimX);
+    const tl_int yEnd = core::tlMin(by + brickSize, a_dimY);
+    const tl_int zEnd = core::tlMin(bz + brickSize, a_dimZ);
+
+    // the distance of the previous voxel plus the distance to it bounds the
+    // distance of the next one (triangle inequality)
+    f32 prevPoint[3] = { 0, 0, 0 };
+    f32 prevDistance = -1.0f;
+
+    for (tl_int z = bz; z < zEnd; ++z)
+    {
+      for (tl_int y = by; y < yEnd; ++y)
+      {
+        for (tl_int x = bx; x < xEnd; ++x)
+        {
+          const f32 point[3] = 
+          {
+            a_origin[0] + ( (f32)x + 0.5f) * a_voxelSize,
+            a_origin[1] + ( (f32)y + 0.5f) * a_voxelSize,
+            a_origin[2] + ( (f32)z + 0.5f) * a_voxelSize
+          };
+
+          f32 maxDistance = -1.0f;
+          if (prevDistance >= 0.0f)
+          {
+            f32 diff[3];
+            DoSub(point, prevPoint, diff);
+            maxDistance = prevDistance + sqrtf(DoDot(diff, diff));
+          }
+
+          const f32 distance = a_bvh.GetSignedDistance(point, maxDistance);
+          a_volume[x + (y + (tl_size)z * a_dimY) * a_dimX] = distance / a_voxelSize;
+
+          memcpy(prevPoint, point, sizeof(point));
+          prevDistance = fabsf(distance);
+        }
+      }
+    }
+  }
+}
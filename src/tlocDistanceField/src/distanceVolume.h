@@ -0,0 +1,86 @@
+#ifndef _TLOC_DISTANCE_VOLUME_H_
+#define _TLOC_DISTANCE_VOLUME_H_
+
+#include <tlocCore/tloc_core.h>
+
+// Triangle soup, 9 floats (three xyz positions) per triangle
+typedef tl_core_conts::Array<f32>     dv_triangle_cont;
+typedef tl_core_conts::Array<f32>     dv_volume_cont;
+
+// ///////////////////////////////////////////////////////////////////////
+// A bounding volume hierarchy over a triangle mesh for closest point
+// queries. The sign of the distance comes from angle weighted pseudo normals
+// (Baerentzen and Aanaes) which is exact for closed, consistently wound
+// meshes. Vertices are welded by position so that unpacked (non-indexed)
+// meshes, e.g. from ObjLoader::GetUnpacked(), work as well.
+
+class TriangleBVH
+{
+public:
+  enum { k_noTriangle = -1, k_maxLeafSize = 4 };
+
+public:
+  TriangleBVH();
+
+  void    Initialize(const dv_triangle_cont& a_triangles);
+
+  // Returns the squared distance to the closest triangle. Triangles further
+  // than sqrt(a_maxDistSq) are skipped, a_closestTri is k_noTriangle if
+  // none were closer.
+  f32     FindClosest(const f32 a_point[3], f32 a_maxDistSq,
+                      tl_int& a_closestTri, f32 a_closestPoint[3]) const;
+
+  // Negative inside. a_maxDistance must be an upper bound of the distance
+  // to the mesh (e.g. the distance of a neighbour plus the distance to it)
+  // or a negative value if there is none.
+  f32     GetSignedDistance(const f32 a_point[3], f32 a_maxDistance = -1.0f) const;
+
+  tl_int  GetNumTriangles() const;
+  void    GetBounds(f32 a_min[3], f32 a_max[3]) const;
+
+private:
+  f32     DoFindClosest(const f32 a_point[3], f32 a_maxDistSq, 
+                        tl_int& a_closestTri, f32 a_closestPoint[3],
+                        tl_int& a_feature) const;
+
+  tl_int  DoBuild(tl_core_conts::Array<s32>& a_order, 
+                  const dv_triangle_cont& a_centroids,
+                  tl_int a_begin, tl_int a_end, tl_int a_depth);
+
+private:
+  enum { k_maxDepth = 64 };
+
+  struct Node
+  {
+    f32     m_min[3];
+    f32     m_max[3];
+    s32     m_first;  // leaf: first triangle, otherwise: right child
+    s32     m_count;  // 0 for internal nodes, the left child is the next node
+  };
+
+  // positions followed by the face, vertex and edge (01, 12, 20) normals
+  struct Triangle
+  {
+    f32     m_v[3][3];
+    f32     m_normal[7][3];
+  };
+
+  tl_core_conts::Array<Node>      m_nodes;
+  tl_core_conts::Array<Triangle>  m_triangles;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Bakes a signed distance volume. Voxel (x, y, z) is sampled at
+//   a_origin + (x + 0.5, y + 0.5, z + 0.5) * a_voxelSize
+// and stored at x + (y + z * a_dimY) * a_dimX, in voxels (not world units)
+// and negative inside. The volume is split into bricks of
+// k_distanceVolumeBrickSize^3 voxels which are baked in parallel. Inside a
+// brick every voxel bounds its query with the distance of the previous one.
+
+enum { k_distanceVolumeBrickSize = 8 };
+
+void  BakeDistanceVolume(const TriangleBVH& a_bvh, const f32 a_origin[3],
+                         f32 a_voxelSize, tl_int a_dimX, tl_int a_dimY,
+                         tl_int a_dimZ, dv_volume_cont& a_volume);
+
+#endif
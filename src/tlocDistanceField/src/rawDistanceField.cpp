@@ -0,0 +1,118 @@
+#include "rawDistanceField.h"
+
+using namespace tloc;
+
+namespace {
+
+  const char    g_magic[4] = { 'T', 'L', 'D', 'F' };
+  const tl_size g_dataAlignment = 16;
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+
+RawDistanceFieldHeader
+  MakeRawDistanceFieldHeader(u32 a_format, u32 a_width, u32 a_height, f32 a_range,
+                             u32 a_depth)
+{
+  RawDistanceFieldHeader header;
+  for (tl_int i = 0; i < 4; ++i)
+  { header.m_magic[i] = g_magic[i]; }
+
+  header.m_version = RawDistanceFieldHeader::k_version;
+  header.m_format = a_format;
+  header.m_width = a_width;
+  header.m_height = a_height;
+  header.m_range = a_range;
+  header.m_dataOffset = (u32)
+    ( ( (sizeof(RawDistanceFieldHeader) + g_dataAlignment - 1) / g_dataAlignment) * 
+      g_dataAlignment );
+  header.m_depth = a_depth;
+
+  return header;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+  GetRawDistanceFieldSampleSize(u32 a_format)
+{
+  switch(a_format)
+  {
+  case RawDistanceFieldHeader::k_formatU16: return sizeof(u16);
+  case RawDistanceFieldHeader::k_formatF32: return sizeof(f32);
+  default: return 0;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+const RawDistanceFieldHeader*
+  GetRawDistanceFieldHeader(const void* a_fileData, tl_size a_fileSize)
+{
+  if (a_fileData == nullptr || a_fileSize < sizeof(RawDistanceFieldHeader))
+  { return nullptr; }
+
+  const RawDistanceFieldHeader* header = 
+    reinterpret_cast<const RawDistanceFieldHeader*>(a_fileData);
+
+  for (tl_int i = 0; i < 4; ++i)
+  {
+    if (header->m_magic[i] != g_magic[i])
+    { return nullptr; }
+  }
+
+  if (header->m_version != RawDistanceFieldHeader::k_version &&
+      header->m_version != RawDistanceFieldHeader::k_versionNoDepth)
+  { return nullptr; }
+
+  // the samples are used in place, they must not overlap the header and
+  // must be aligned like MakeRawDistanceFieldHeader() aligns them
+  const tl_size sampleSize = GetRawDistanceFieldSampleSize(header->m_format);
+  if (sampleSize == 0 || header->m_dataOffset < sizeof(RawDistanceFieldHeader) ||
+      header->m_dataOffset % g_dataAlignment != 0)
+  { return nullptr; }
+
+  const u32 depth = GetRawDistanceFieldDepth(header);
+  if (depth == 0)
+  { return nullptr; }
+
+  const tl_size dataSize = (tl_size)header->m_width * (tl_size)header->m_height * 
+    (tl_size)depth * sampleSize;
+  if (a_fileSize < header->m_dataOffset + dataSize)
+  { return nullptr; }
+
+  return header;
+}
+
+// -----------------------------------------------------------------------
+
+const void*
+  GetRawDistanceFieldSamples(const RawDistanceFieldHeader* a_header)
+{ return reinterpret_cast<const u8*>(a_header) + a_header->m_dataOffset; }
+
+// -----------------------------------------------------------------------
+
+u32
+  GetRawDistanceFieldDepth(const RawDistanceFieldHeader* a_header)
+{
+  if (a_header->m_version == RawDistanceFieldHeader::k_versionNoDepth)
+  { return 1; }
+
+  return a_header->m_depth;
+}
+
+// -----------------------------------------------------------------------
+
+u16
+  EncodeDistanceU16(f32 a_distance, f32 a_range)
+{
+  const f32 value = (a_distance / a_range * 0.5f + 0.5f) * 65535.0f + 0.5f;
+  return (u16)core::Clamp(value, 0.0f, 65535.0f);
+}
+
+// -----------------------------------------------------------------------
+
+f32
+  DecodeDistanceU16(u16 a_value, f32 a_range)
+{ return ( (f32)a_value / 65535.0f - 0.5f) * 2.0f * a_range; }
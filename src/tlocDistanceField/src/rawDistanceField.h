@@ -0,0 +1,59 @@
+#ifndef _TLOC_RAW_DISTANCE_FIELD_H_
+#define _TLOC_RAW_DISTANCE_FIELD_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// Uncompressed distance field file. The header is followed by width * height
+// * depth samples (row major, top row first, then slice by slice, little
+// endian) starting at m_dataOffset. 2D fields have a depth of 1.
+// The offset is 16 byte aligned so that the file can be memory mapped (or
+// read in one go) and the samples used in place, e.g. uploaded as an R16 or
+// R32F texture without decoding.
+//
+//   k_formatU16: the signed distance mapped from [-m_range, m_range] to
+//                [0, 65535] (same layout as gfx_med::image_u16_r)
+//   k_formatF32: the signed distance in pixels (voxels)
+//
+// Distances are negative inside.
+//
+// Version 1 files (2D only) had a reserved field, written as 0, where
+// m_depth is now. They are still read, with a depth of 1: use
+// GetRawDistanceFieldDepth() rather than m_depth.
+
+struct RawDistanceFieldHeader
+{
+  enum { k_formatU16 = 1, k_formatF32 = 2 };
+  enum { k_version = 2, k_versionNoDepth = 1 };
+
+  char  m_magic[4]; // "TLDF"
+  u32   m_version;
+  u32   m_format;
+  u32   m_width;
+  u32   m_height;
+  f32   m_range;
+  u32   m_dataOffset;
+  u32   m_depth;
+};
+
+RawDistanceFieldHeader  
+  MakeRawDistanceFieldHeader(u32 a_format, u32 a_width, u32 a_height, f32 a_range,
+                             u32 a_depth = 1);
+
+tl_size   GetRawDistanceFieldSampleSize(u32 a_format);
+
+// a_fileData is the whole file. Returns nullptr if it is not a valid (and
+// complete) distance field, or if its samples do not start on a 16 byte
+// boundary.
+const RawDistanceFieldHeader* 
+  GetRawDistanceFieldHeader(const void* a_fileData, tl_size a_fileSize);
+
+const void* 
+  GetRawDistanceFieldSamples(const RawDistanceFieldHeader* a_header);
+
+u32       GetRawDistanceFieldDepth(const RawDistanceFieldHeader* a_header);
+
+u16       EncodeDistanceU16(f32 a_distance, f32 a_range);
+f32       DecodeDistanceU16(u16 a_value, f32 a_range);
+
+#endif
@@ -0,0 +1,560 @@
+#include "bcEncoder.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// BC1 colors
+
+namespace {
+
+  const tl_int  g_numBlockPixels = 16;
+  const tl_int  g_maxSearchSteps = 8;
+
+  struct Color565
+  {
+    tl_int  m_rgb[3];               // 5, 6 and 5 bits
+  };
+
+  u16   DoPack565(const Color565& a_color)
+  {
+    return (u16)((a_color.m_rgb[0] << 11) | (a_color.m_rgb[1] << 5) |
+                  a_color.m_rgb[2]);
+  }
+
+  Color565  DoUnpack565(u16 a_packed)
+  {
+    Color565 color;
+    color.m_rgb[0] = (a_packed >> 11) & 31;
+    color.m_rgb[1] = (a_packed >> 5) & 63;
+    color.m_rgb[2] = a_packed & 31;
+    return color;
+  }
+
+  Color565  DoQuantize565(const f32* a_rgb)
+  {
+    const tl_int maxValues[3] = { 31, 63, 31 };
+
+    Color565 color;
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      const f32 value = a_rgb[c] * (f32)maxValues[c] / 255.0f + 0.5f;
+      color.m_rgb[c] = core::Clamp((tl_int)value, 0, maxValues[c]);
+    }
+    return color;
+  }
+
+  void  DoExpand565(const Color565& a_color, tl_int* a_rgb)
+  {
+    a_rgb[0] = (a_color.m_rgb[0] << 3) | (a_color.m_rgb[0] >> 2);
+    a_rgb[1] = (a_color.m_rgb[1] << 2) | (a_color.m_rgb[1] >> 4);
+    a_rgb[2] = (a_color.m_rgb[2] << 3) | (a_color.m_rgb[2] >> 2);
+  }
+
+  // 4 color mode: the endpoints and the colors 1/3 and 2/3 of the way
+  void  DoGetBc1Palette(const Color565& a_color0, const Color565& a_color1,
+                        tl_int (*a_palette)[3])
+  {
+    DoExpand565(a_color0, a_palette[0]);
+    DoExpand565(a_color1, a_palette[1]);
+
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      a_palette[2][c] = (2 * a_palette[0][c] + a_palette[1][c]) / 3;
+      a_palette[3][c] = (a_palette[0][c] + 2 * a_palette[1][c]) / 3;
+    }
+  }
+
+  // stops early once the error reaches a_maxError
+  tl_int  DoChooseBc1Indices(const u8* a_block, const Color565& a_color0,
+                             const Color565& a_color1, u8* a_indices,
+                             tl_int a_maxError = 0x7FFFFFFF)
+  {
+    tl_int palette[4][3];
+    DoGetBc1Palette(a_color0, a_color1, palette);
+
+    tl_int error = 0;
+    for (tl_int i = 0; i < g_numBlockPixels && error < a_maxError; ++i)
+    {
+      const u8* pixel = a_block + i * 4;
+
+      tl_int bestError = 0x7FFFFFFF;
+      for (tl_int p = 0; p < 4; ++p)
+      {
+        const tl_int dr = pixel[0] - palette[p][0];
+        const tl_int dg = pixel[1] - palette[p][1];
+        const tl_int db = pixel[2] - palette[p][2];
+        const tl_int pixelError = dr * dr + dg * dg + db * db;
+
+        if (pixelError < bestError)
+        {
+          bestError = pixelError;
+          a_indices[i] = (u8)p;
+        }
+      }
+
+      error += bestError;
+    }
+
+    return error;
+  }
+
+  // Endpoints from the principal axis of the colors
+  void  DoGetPrincipalEndpoints(const u8* a_block, f32* a_end0, f32* a_end1)
+  {
+    f32 mean[3] = { 0, 0, 0 };
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      for (tl_int c = 0; c < 3; ++c)
+      { mean[c] += a_block[i * 4 + c]; }
+    }
+    for (tl_int c = 0; c < 3; ++c)
+    { mean[c] /= (f32)g_numBlockPixels; }
+
+    // covariance: rr, rg, rb, gg, gb, bb
+    f32 cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      const f32 r = a_block[i * 4 + 0] - mean[0];
+      const f32 g = a_block[i * 4 + 1] - mean[1];
+      const f32 b = a_block[i * 4 + 2] - mean[2];
+
+      cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+      cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    f32 axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (tl_int iter = 0; iter < 4; ++iter)
+    {
+      const f32 x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+      const f32 y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+      const f32 z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+
+      const f32 length = core::tlMax(fabsf(x), core::tlMax(fabsf(y), fabsf(z)));
+      if (length < 1e-6f)
+      { break; }
+
+      axis[0] = x / length;
+      axis[1] = y / length;
+      axis[2] = z / length;
+    }
+
+    const f32 lengthSq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+
+    f32 minT = 0.0f;
+    f32 maxT = 0.0f;
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      const f32 t =
+        ((a_block[i * 4 + 0] - mean[0]) * axis[0] +
+         (a_block[i * 4 + 1] - mean[1]) * axis[1] +
+         (a_block[i * 4 + 2] - mean[2]) * axis[2]) / lengthSq;
+
+      minT = core::tlMin(minT, t);
+      maxT = core::tlMax(maxT, t);
+    }
+
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      a_end0[c] = core::Clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+      a_end1[c] = core::Clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+    }
+  }
+
+  // Least squares endpoints for the chosen indices, false if every pixel
+  // picked the same weight
+  bool  DoRefineBc1Endpoints(const u8* a_block, const u8* a_indices,
+                             Color565& a_color0, Color565& a_color1)
+  {
+    // weight of color0 for each index
+    const f32 weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+    f32 aa = 0, ab = 0, bb = 0;
+    f32 ax[3] = { 0, 0, 0 };
+    f32 bx[3] = { 0, 0, 0 };
+
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      const f32 a = weights[a_indices[i]];
+      const f32 b = 1.0f - a;
+
+      aa += a * a; ab += a * b; bb += b * b;
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        ax[c] += a * a_block[i * 4 + c];
+        bx[c] += b * a_block[i * 4 + c];
+      }
+    }
+
+    const f32 det = aa * bb - ab * ab;
+    if (fabsf(det) < 1e-6f)
+    { return false; }
+
+    f32 end0[3], end1[3];
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      end0[c] = core::Clamp((ax[c] * bb - bx[c] * ab) / det, 0.0f, 255.0f);
+      end1[c] = core::Clamp((bx[c] * aa - ax[c] * ab) / det, 0.0f, 255.0f);
+    }
+
+    a_color0 = DoQuantize565(end0);
+    a_color1 = DoQuantize565(end1);
+    return true;
+  }
+
+  // Moves one endpoint channel at a time by one step while the error drops
+  tl_int  DoSearchBc1Endpoints(const u8* a_block, Color565& a_color0,
+                               Color565& a_color1, tl_int a_error)
+  {
+    const tl_int maxValues[3] = { 31, 63, 31 };
+    u8 indices[g_numBlockPixels];
+
+    for (tl_int step = 0; step < g_maxSearchSteps; ++step)
+    {
+      bool improved = false;
+
+      for (tl_int e = 0; e < 2; ++e)
+      {
+        for (tl_int c = 0; c < 3; ++c)
+        {
+          for (tl_int delta = -1; delta <= 1; delta += 2)
+          {
+            Color565 color0 = a_color0;
+            Color565 color1 = a_color1;
+            Color565& color = e == 0 ? color0 : color1;
+
+            color.m_rgb[c] += delta;
+            if (color.m_rgb[c] < 0 || color.m_rgb[c] > maxValues[c])
+            { continue; }
+
+            const tl_int error = DoChooseBc1Indices(a_block, color0, color1,
+                                                    indices, a_error);
+            if (error < a_error)
+            {
+              a_error = error;
+              a_color0 = color0;
+              a_color1 = color1;
+              improved = true;
+            }
+          }
+        }
+      }
+
+      if (improved == false)
+      { break; }
+    }
+
+    return a_error;
+  }
+
+  void  DoWriteBc1Block(const Color565& a_color0, const Color565& a_color1,
+                        const u8* a_indices, u8* a_out)
+  {
+    u16 color0 = DoPack565(a_color0);
+    u16 color1 = DoPack565(a_color1);
+
+    // 4 color mode needs color0 > color1, swapping the endpoints swaps
+    // index 0 with 1 and 2 with 3
+    u32 swap = 0;
+    if (color0 < color1)
+    {
+      const u16 temp = color0;
+      color0 = color1;
+      color1 = temp;
+      swap = 1;
+    }
+
+    u32 packed = 0;
+    if (color0 != color1)
+    {
+      for (tl_int i = 0; i < g_numBlockPixels; ++i)
+      { packed |= (u32)(a_indices[i] ^ swap) << (i * 2); }
+    }
+
+    a_out[0] = (u8)color0;
+    a_out[1] = (u8)(color0 >> 8);
+    a_out[2] = (u8)color1;
+    a_out[3] = (u8)(color1 >> 8);
+    a_out[4] = (u8)packed;
+    a_out[5] = (u8)(packed >> 8);
+    a_out[6] = (u8)(packed >> 16);
+    a_out[7] = (u8)(packed >> 24);
+  }
+
+  // BC1 blocks with color0 <= color1 are in 3 color mode: the endpoints,
+  // their average and transparent black. BC3 color is always 4 color mode.
+  void  DoDecodeBc1(const u8* a_in, bool a_fourColors, u8* a_block)
+  {
+    const u16 packed0 = (u16)(a_in[0] | (a_in[1] << 8));
+    const u16 packed1 = (u16)(a_in[2] | (a_in[3] << 8));
+
+    tl_int palette[4][4];
+    tl_int colors[4][3];
+    DoGetBc1Palette(DoUnpack565(packed0), DoUnpack565(packed1), colors);
+
+    for (tl_int p = 0; p < 4; ++p)
+    {
+      for (tl_int c = 0; c < 3; ++c)
+      { palette[p][c] = colors[p][c]; }
+      palette[p][3] = 255;
+    }
+
+    if (a_fourColors == false && packed0 <= packed1)
+    {
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        palette[2][c] = (colors[0][c] + colors[1][c]) / 2;
+        palette[3][c] = 0;
+      }
+      palette[3][3] = 0;
+    }
+
+    const u32 indices = (u32)a_in[4] | ((u32)a_in[5] << 8) |
+                        ((u32)a_in[6] << 16) | ((u32)a_in[7] << 24);
+
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      const tl_int* color = palette[(indices >> (i * 2)) & 3];
+      for (tl_int c = 0; c < 4; ++c)
+      { a_block[i * 4 + c] = (u8)color[c]; }
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// BC4 channels
+
+namespace {
+
+  // 8 value mode when a_end0 > a_end1, 6 values plus 0 and 255 otherwise
+  void  DoGetBc4Palette(tl_int a_end0, tl_int a_end1, tl_int* a_palette)
+  {
+    a_palette[0] = a_end0;
+    a_palette[1] = a_end1;
+
+    if (a_end0 > a_end1)
+    {
+      for (tl_int i = 1; i < 7; ++i)
+      { a_palette[i + 1] = ((7 - i) * a_end0 + i * a_end1 + 3) / 7; }
+    }
+    else
+    {
+      for (tl_int i = 1; i < 5; ++i)
+      { a_palette[i + 1] = ((5 - i) * a_end0 + i * a_end1 + 2) / 5; }
+      a_palette[6] = 0;
+      a_palette[7] = 255;
+    }
+  }
+
+  tl_int  DoChooseBc4Indices(const tl_int* a_values, tl_int a_end0,
+                             tl_int a_end1, u8* a_indices,
+                             tl_int a_maxError = 0x7FFFFFFF)
+  {
+    tl_int palette[8];
+    DoGetBc4Palette(a_end0, a_end1, palette);
+
+    tl_int error = 0;
+    for (tl_int i = 0; i < g_numBlockPixels && error < a_maxError; ++i)
+    {
+      tl_int bestError = 0x7FFFFFFF;
+      for (tl_int p = 0; p < 8; ++p)
+      {
+        const tl_int diff = a_values[i] - palette[p];
+        if (diff * diff < bestError)
+        {
+          bestError = diff * diff;
+          a_indices[i] = (u8)p;
+        }
+      }
+
+      error += bestError;
+    }
+
+    return error;
+  }
+
+  void  DoEncodeBc4(const u8* a_block, tl_int a_channel, bool a_highQuality,
+                    u8* a_out)
+  {
+    tl_int values[g_numBlockPixels];
+    tl_int minValue = 255, maxValue = 0;
+    tl_int minInner = 255, maxInner = 0;   // without 0 and 255
+
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      values[i] = a_block[i * 4 + a_channel];
+      minValue = core::tlMin(minValue, values[i]);
+      maxValue = core::tlMax(maxValue, values[i]);
+
+      if (values[i] != 0 && values[i] != 255)
+      {
+        minInner = core::tlMin(minInner, values[i]);
+        maxInner = core::tlMax(maxInner, values[i]);
+      }
+    }
+
+    tl_int end0 = maxValue;
+    tl_int end1 = minValue;
+    u8     indices[g_numBlockPixels];
+    tl_int error = DoChooseBc4Indices(values, end0, end1, indices);
+
+    if (a_highQuality && error > 0)
+    {
+      u8 candidate[g_numBlockPixels];
+
+      for (tl_int hi = maxValue - 3; hi <= maxValue + 1; ++hi)
+      {
+        for (tl_int lo = minValue - 1; lo <= minValue + 3; ++lo)
+        {
+          if (hi <= lo || hi > 255 || lo < 0)
+          { continue; }
+
+          const tl_int candidateError =
+            DoChooseBc4Indices(values, hi, lo, candidate, error);
+          if (candidateError < error)
+          {
+            error = candidateError;
+            end0 = hi;
+            end1 = lo;
+            memcpy(indices, candidate, sizeof(indices));
+          }
+        }
+      }
+
+      if (minInner <= maxInner && (minValue == 0 || maxValue == 255))
+      {
+        const tl_int candidateError =
+          DoChooseBc4Indices(values, minInner, maxInner, candidate,
+                             error);
+        if (candidateError < error)
+        {
+          error = candidateError;
+          end0 = minInner;
+          end1 = maxInner;
+          memcpy(indices, candidate, sizeof(indices));
+        }
+      }
+    }
+
+    a_out[0] = (u8)end0;
+    a_out[1] = (u8)end1;
+
+    // 16 3 bit indices, little endian
+    u64 packed = 0;
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    { packed |= (u64)indices[i] << (i * 3); }
+
+    for (tl_int i = 0; i < 6; ++i)
+    { a_out[2 + i] = (u8)(packed >> (i * 8)); }
+  }
+
+  void  DoDecodeBc4(const u8* a_in, tl_int a_channel, u8* a_block)
+  {
+    tl_int palette[8];
+    DoGetBc4Palette(a_in[0], a_in[1], palette);
+
+    u64 packed = 0;
+    for (tl_int i = 0; i < 6; ++i)
+    { packed |= (u64)a_in[2 + i] << (i * 8); }
+
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    { a_block[i * 4 + a_channel] = (u8)palette[(packed >> (i * 3)) & 7]; }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Encoding
+
+void
+  EncodeBc1Block(const u8* a_block, bool a_highQuality, u8* a_out)
+{
+  f32 end0[3], end1[3];
+  DoGetPrincipalEndpoints(a_block, end0, end1);
+
+  Color565 color0 = DoQuantize565(end0);
+  Color565 color1 = DoQuantize565(end1);
+
+  u8     indices[g_numBlockPixels];
+  tl_int error = DoChooseBc1Indices(a_block, color0, color1, indices);
+
+  const tl_int numRefinements = a_highQuality ? 2 : 1;
+  for (tl_int i = 0; i < numRefinements && error > 0; ++i)
+  {
+    Color565 refined0 = color0;
+    Color565 refined1 = color1;
+    if (DoRefineBc1Endpoints(a_block, indices, refined0, refined1) == false)
+    { break; }
+
+    u8 refinedIndices[g_numBlockPixels];
+    const tl_int refinedError =
+      DoChooseBc1Indices(a_block, refined0, refined1, refinedIndices);
+    if (refinedError >= error)
+    { break; }
+
+    error = refinedError;
+    color0 = refined0;
+    color1 = refined1;
+    memcpy(indices, refinedIndices, sizeof(indices));
+  }
+
+  if (a_highQuality && error > 0)
+  {
+    error = DoSearchBc1Endpoints(a_block, color0, color1, error);
+    DoChooseBc1Indices(a_block, color0, color1, indices);
+  }
+
+  DoWriteBc1Block(color0, color1, indices, a_out);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  EncodeBc3Block(const u8* a_block, bool a_highQuality, u8* a_out)
+{
+  DoEncodeBc4(a_block, 3, a_highQuality, a_out);
+  EncodeBc1Block(a_block, a_highQuality, a_out + 8);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  EncodeBc5Block(const u8* a_block, bool a_highQuality, u8* a_out)
+{
+  DoEncodeBc4(a_block, 0, a_highQuality, a_out);
+  DoEncodeBc4(a_block, 1, a_highQuality, a_out + 8);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Decoding
+
+void
+  DecodeBc1Block(const u8* a_in, u8* a_block)
+{ DoDecodeBc1(a_in, false, a_block); }
+
+// -----------------------------------------------------------------------
+
+void
+  DecodeBc3Block(const u8* a_in, u8* a_block)
+{
+  DoDecodeBc1(a_in + 8, true, a_block);
+  DoDecodeBc4(a_in, 3, a_block);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  DecodeBc5Block(const u8* a_in, u8* a_block)
+{
+  for (tl_int i = 0; i < g_numBlockPixels; ++i)
+  {
+    a_block[i * 4 + 2] = 0;
+    a_block[i * 4 + 3] = 255;
+  }
+
+  DoDecodeBc4(a_in, 0, a_block);
+  DoDecodeBc4(a_in + 8, 1, a_block);
+}
@@ -0,0 +1,32 @@
+#ifndef _TLOC_IMAGE_TOOLS_BC_ENCODER_H_
+#define _TLOC_IMAGE_TOOLS_BC_ENCODER_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// BC1 (DXT1), BC3 (DXT5) and BC5 (RGTC2) blocks. Every function works on
+// one 4x4 block of 8 bit RGBA pixels, rows from top to bottom (64 bytes).
+//
+// BC1 colors: the endpoints are the ends of the principal axis of the
+// colors (power iteration on their covariance), refined by least squares
+// on the chosen indices. The high quality mode refines twice and then
+// moves the endpoints one step at a time while the error drops. Blocks are
+// always encoded in 4 color mode (no punch-through alpha), which is also
+// what the color part of a BC3 block needs.
+//
+// BC4 channels (BC3 alpha, BC5 red and green): the fast mode interpolates
+// between the channel's minimum and maximum, the high quality mode also
+// searches the endpoints around them and tries the 6 value mode (with
+// exact 0 and 255) for blocks that reach either.
+
+void  EncodeBc1Block(const u8* a_block, bool a_highQuality, u8* a_out);
+void  EncodeBc3Block(const u8* a_block, bool a_highQuality, u8* a_out);
+void  EncodeBc5Block(const u8* a_block, bool a_highQuality, u8* a_out);
+
+// the decoders write all 4 channels of the block: BC1 in 3 color mode has
+// transparent black, BC5 has blue 0 and alpha 255
+void  DecodeBc1Block(const u8* a_in, u8* a_block);
+void  DecodeBc3Block(const u8* a_in, u8* a_block);
+void  DecodeBc5Block(const u8* a_in, u8* a_block);
+
+#endif
@@ -0,0 +1,343 @@
+#include "dirtyRegions.h"
+#include "imageView.h"
+
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// DirtyRect
+
+tl_int
+DirtyRect::
+  GetWidth() const
+{ return m_x1 - m_x0; }
+
+// -----------------------------------------------------------------------
+
+tl_int
+DirtyRect::
+  GetHeight() const
+{ return m_y1 - m_y0; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+DirtyRect::
+  GetArea() const
+{ return (tl_size)GetWidth() * (tl_size)GetHeight(); }
+
+// ///////////////////////////////////////////////////////////////////////
+// DirtyRegionTracker
+
+namespace {
+
+  // overlapping, or sharing (part of) an edge. Rectangles that only share
+  // a corner are kept apart, otherwise a diagonal stroke grows into its
+  // whole bounding box.
+  bool  DoTouch(const DirtyRect& a_first, const DirtyRect& a_second)
+  {
+    const bool overlapX =
+      a_first.m_x0 < a_second.m_x1 && a_second.m_x0 < a_first.m_x1;
+    const bool overlapY =
+      a_first.m_y0 < a_second.m_y1 && a_second.m_y0 < a_first.m_y1;
+    const bool touchX =
+      a_first.m_x0 <= a_second.m_x1 && a_second.m_x0 <= a_first.m_x1;
+    const bool touchY =
+      a_first.m_y0 <= a_second.m_y1 && a_second.m_y0 <= a_first.m_y1;
+
+    return (overlapX && touchY) || (overlapY && touchX);
+  }
+
+  DirtyRect DoGetUnion(const DirtyRect& a_first, const DirtyRect& a_second)
+  {
+    DirtyRect r;
+    r.m_x0 = core::tlMin(a_first.m_x0, a_second.m_x0);
+    r.m_y0 = core::tlMin(a_first.m_y0, a_second.m_y0);
+    r.m_x1 = core::tlMax(a_first.m_x1, a_second.m_x1);
+    r.m_y1 = core::tlMax(a_first.m_y1, a_second.m_y1);
+    return r;
+  }
+
+};
+
+DirtyRegionTracker::
+  DirtyRegionTracker(tl_size a_maxRects)
+  : m_maxRects(core::tlMax(a_maxRects, (tl_size)1))
+  , m_lastRect(0)
+  , m_width(0)
+  , m_height(0)
+{ }
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  Reset(tl_int a_width, tl_int a_height)
+{
+  m_width = a_width;
+  m_height = a_height;
+  Clear();
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  MarkDirty(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height)
+{
+  DirtyRect r;
+  r.m_x0 = core::tlMax(a_x, 0);
+  r.m_y0 = core::tlMax(a_y, 0);
+  r.m_x1 = core::tlMin(a_x + a_width, m_width);
+  r.m_y1 = core::tlMin(a_y + a_height, m_height);
+
+  if (r.m_x0 >= r.m_x1 || r.m_y0 >= r.m_y1)
+  { return; }
+
+  DoAdd(r);
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  MarkPixel(tl_int a_x, tl_int a_y)
+{
+  if (m_lastRect < m_rects.size())
+  {
+    const DirtyRect& last = m_rects[m_lastRect];
+    if (a_x >= last.m_x0 && a_x < last.m_x1 &&
+        a_y >= last.m_y0 && a_y < last.m_y1)
+    { return; }
+  }
+
+  MarkDirty(a_x, a_y, 1, 1);
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  MarkAll()
+{
+  Clear();
+  MarkDirty(0, 0, m_width, m_height);
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  Clear()
+{
+  m_rects.clear();
+  m_lastRect = 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+DirtyRegionTracker::
+  IsDirty() const
+{ return m_rects.empty() == false; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+DirtyRegionTracker::
+  GetDirtyArea() const
+{
+  // the rectangles never overlap
+  tl_size area = 0;
+  for (tl_size i = 0; i < m_rects.size(); ++i)
+  { area += m_rects[i].GetArea(); }
+
+  return area;
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  DoAdd(DirtyRect a_rect)
+{
+  for (tl_size i = 0; i < m_rects.size(); ++i)
+  {
+    if (DoTouch(a_rect, m_rects[i]))
+    {
+      a_rect = DoGetUnion(a_rect, m_rects[i]);
+
+      m_rects.erase(m_rects.begin() + i);
+      i = (tl_size)-1; // the grown rectangle may now touch earlier ones
+    }
+  }
+
+  m_rects.push_back(a_rect);
+  m_lastRect = m_rects.size() - 1;
+
+  if (m_rects.size() > m_maxRects)
+  { DoMergeClosest(); }
+}
+
+// -----------------------------------------------------------------------
+
+void
+DirtyRegionTracker::
+  DoMergeClosest()
+{
+  tl_size first = 0;
+  tl_size second = 1;
+  tl_size leastWaste = (tl_size)-1;
+
+  for (tl_size i = 0; i < m_rects.size(); ++i)
+  {
+    for (tl_size j = i + 1; j < m_rects.size(); ++j)
+    {
+      // clean pixels the bounding box would upload
+      const tl_size waste = DoGetUnion(m_rects[i], m_rects[j]).GetArea() -
+                            m_rects[i].GetArea() - m_rects[j].GetArea();
+      if (waste < leastWaste)
+      {
+        leastWaste = waste;
+        first = i;
+        second = j;
+      }
+    }
+  }
+
+  const DirtyRect merged = DoGetUnion(m_rects[first], m_rects[second]);
+  m_rects.erase(m_rects.begin() + second);
+  m_rects.erase(m_rects.begin() + first);
+
+  // the bounding box may cover other rectangles
+  DoAdd(merged);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// TrackedImage
+
+namespace {
+
+  ImageView DoGetView(tl_core_conts::Array<u8>& a_pixels, tl_int a_width,
+                      tl_int a_height)
+  {
+    if (a_pixels.empty())
+    { return ImageView(); }
+    return ImageView(&a_pixels[0], a_width, a_height, PixelFormat());
+  }
+
+};
+
+TrackedImage::
+  TrackedImage(tl_size a_maxDirtyRects)
+  : m_dirty(a_maxDirtyRects)
+  , m_width(0)
+  , m_height(0)
+{ }
+
+// -----------------------------------------------------------------------
+
+void
+TrackedImage::
+  Create(tl_int a_width, tl_int a_height, const u8* a_rgba)
+{
+  TLOC_ASSERT(a_width >= 0 && a_height >= 0, "Image size cannot be negative");
+
+  m_width = a_width;
+  m_height = a_height;
+  m_pixels.resize((tl_size)a_width * a_height * 4);
+
+  const u8 black[4] = { 0, 0, 0, 255 };
+  FillImage(DoGetView(m_pixels, m_width, m_height), a_rgba ? a_rgba : black);
+
+  m_dirty.Reset(a_width, a_height);
+  m_dirty.MarkAll();
+}
+
+// -----------------------------------------------------------------------
+
+void
+TrackedImage::
+  SetPixel(tl_int a_x, tl_int a_y, const u8* a_rgba)
+{
+  TLOC_ASSERT(a_x >= 0 && a_x < m_width && a_y >= 0 && a_y < m_height,
+              "Pixel is outside the image");
+
+  memcpy(&m_pixels[((tl_size)a_y * m_width + a_x) * 4], a_rgba, 4);
+  m_dirty.MarkPixel(a_x, a_y);
+}
+
+// -----------------------------------------------------------------------
+
+const u8*
+TrackedImage::
+  GetPixel(tl_int a_x, tl_int a_y) const
+{
+  TLOC_ASSERT(a_x >= 0 && a_x < m_width && a_y >= 0 && a_y < m_height,
+              "Pixel is outside the image");
+
+  return &m_pixels[((tl_size)a_y * m_width + a_x) * 4];
+}
+
+// -----------------------------------------------------------------------
+
+void
+TrackedImage::
+  SetPixels(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height,
+            const u8* a_rgba, tl_int a_srcWidth)
+{
+  tl_int x = a_x, y = a_y, width = a_width, height = a_height;
+  if (DoClip(x, y, width, height) == false)
+  { return; }
+
+  // the views never write to the source
+  const ImageView src(const_cast<u8*>(a_rgba), a_srcWidth, a_height,
+                      PixelFormat(), (tl_size)a_srcWidth * 4);
+  ConvertImage(src.GetSubView(x - a_x, y - a_y, width, height),
+               DoGetView(m_pixels, m_width, m_height).GetSubView(x, y, width,
+                                                                 height));
+
+  m_dirty.MarkDirty(x, y, width, height);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TrackedImage::
+  Fill(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height,
+       const u8* a_rgba)
+{
+  tl_int x = a_x, y = a_y, width = a_width, height = a_height;
+  if (DoClip(x, y, width, height) == false)
+  { return; }
+
+  FillImage(DoGetView(m_pixels, m_width, m_height).GetSubView(x, y, width,
+                                                              height), a_rgba);
+
+  m_dirty.MarkDirty(x, y, width, height);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TrackedImage::
+  ClearDirty()
+{ m_dirty.Clear(); }
+
+// -----------------------------------------------------------------------
+
+bool
+TrackedImage::
+  DoClip(tl_int& a_x, tl_int& a_y, tl_int& a_width, tl_int& a_height) const
+{
+  const tl_int x1 = core::tlMin(a_x + a_width, m_width);
+  const tl_int y1 = core::tlMin(a_y + a_height, m_height);
+
+  a_x = core::tlMax(a_x, 0);
+  a_y = core::tlMax(a_y, 0);
+  a_width = x1 - a_x;
+  a_height = y1 - a_y;
+
+  return a_width > 0 && a_height > 0;
+}
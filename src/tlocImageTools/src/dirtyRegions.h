@@ -0,0 +1,108 @@
+#ifndef _TLOC_IMAGE_TOOLS_DIRTY_REGIONS_H_
+#define _TLOC_IMAGE_TOOLS_DIRTY_REGIONS_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// A rectangle of pixels, [x0, x1) x [y0, y1)
+
+struct DirtyRect
+{
+  tl_int  GetWidth() const;
+  tl_int  GetHeight() const;
+  tl_size GetArea() const;
+
+  tl_int  m_x0, m_y0, m_x1, m_y1;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// The parts of an image that changed since they were last uploaded.
+//
+// Marked rectangles are clipped to the image. A rectangle that overlaps or
+// shares an edge with one already in the list is merged with it, so
+// writing an area pixel by pixel (or row by row) grows one rectangle.
+// Rectangles that only share a corner stay apart. The list never holds
+// more than GetMaxRects(): past that the two rectangles whose bounding box
+// wastes the fewest clean pixels are merged. MarkPixel() returns right
+// away for a pixel inside the rectangle the previous one went into.
+//
+// The tracker knows nothing about the pixels or the GPU, it is plain
+// bookkeeping.
+
+class DirtyRegionTracker
+{
+public:
+  typedef tl_core_conts::Array<DirtyRect>   rect_cont;
+
+public:
+  explicit DirtyRegionTracker(tl_size a_maxRects = 8);
+
+  // a clean a_width x a_height image
+  void    Reset(tl_int a_width, tl_int a_height);
+
+  void    MarkDirty(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height);
+  void    MarkPixel(tl_int a_x, tl_int a_y);
+  void    MarkAll();
+  void    Clear();
+
+  bool    IsDirty() const;
+  tl_size GetDirtyArea() const;
+
+  TLOC_DECL_AND_DEF_GETTER(const rect_cont&, GetRects, m_rects);
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetMaxRects, m_maxRects);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetWidth, m_width);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetHeight, m_height);
+
+private:
+  void    DoAdd(DirtyRect a_rect);
+  void    DoMergeClosest();
+
+private:
+  rect_cont m_rects;
+  tl_size   m_maxRects;
+  tl_size   m_lastRect;         // where the last marked pixel went
+  tl_int    m_width;
+  tl_int    m_height;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// An 8 bit RGBA image (the layout of gfx_med::image_rgba) that records
+// the rectangles it is written to. Pixels are read and written by column
+// and row, like gfx_med::Image::SetPixel().
+
+class TrackedImage
+{
+public:
+  explicit TrackedImage(tl_size a_maxDirtyRects = 8);
+
+  // the whole new image is dirty
+  void      Create(tl_int a_width, tl_int a_height, const u8* a_rgba);
+
+  void      SetPixel(tl_int a_x, tl_int a_y, const u8* a_rgba);
+  const u8* GetPixel(tl_int a_x, tl_int a_y) const;
+
+  // a_width x a_height pixels, rows a_srcWidth pixels apart
+  void      SetPixels(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height,
+                      const u8* a_rgba, tl_int a_srcWidth);
+  void      Fill(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height,
+                 const u8* a_rgba);
+
+  void      ClearDirty();
+
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetWidth, m_width);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetHeight, m_height);
+  TLOC_DECL_AND_DEF_GETTER(const tl_core_conts::Array<u8>&, GetPixels, m_pixels);
+  TLOC_DECL_AND_DEF_GETTER(const DirtyRegionTracker&, GetDirtyRegions, m_dirty);
+
+private:
+  bool      DoClip(tl_int& a_x, tl_int& a_y, tl_int& a_width,
+                   tl_int& a_height) const;
+
+private:
+  tl_core_conts::Array<u8>  m_pixels;
+  DirtyRegionTracker        m_dirty;
+  tl_int                    m_width;
+  tl_int                    m_height;
+};
+
+#endif
@@ -0,0 +1,553 @@
+#include "etcEncoder.h"
+
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// ETC2 colors
+
+namespace {
+
+  const tl_int  g_numBlockPixels = 16;
+  const tl_int  g_numHalfPixels = 8;
+  const tl_int  g_numTables = 8;
+  const tl_int  g_maxSearchSteps = 4;
+
+  // the modifier for index 0 and 1 (added), 2 and 3 subtract them
+  const tl_int  g_etcModifiers[g_numTables][2] =
+  {
+    { 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+    { 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+  };
+
+  tl_int  DoGetModifier(tl_int a_table, tl_int a_index)
+  {
+    const tl_int modifier = g_etcModifiers[a_table][a_index & 1];
+    return a_index < 2 ? modifier : -modifier;
+  }
+
+  tl_int  DoClampByte(tl_int a_value)
+  { return core::Clamp(a_value, 0, 255); }
+
+  // base colors are stored with 4 (individual mode) or 5 bits
+  tl_int  DoExpand(tl_int a_value, tl_int a_bits)
+  {
+    return a_bits == 4 ? (a_value << 4) | a_value
+                       : (a_value << 3) | (a_value >> 2);
+  }
+
+  tl_int  DoQuantize(f32 a_value, tl_int a_bits)
+  {
+    const tl_int maxValue = (1 << a_bits) - 1;
+    return core::Clamp((tl_int)(a_value * (f32)maxValue / 255.0f + 0.5f),
+                       0, maxValue);
+  }
+
+  // Position of a pixel in the block (rows from top to bottom) and in the
+  // index bits of an ETC block (columns from left to right)
+  tl_int  DoGetHalfPixel(tl_int a_flip, tl_int a_half, tl_int a_i)
+  {
+    const tl_int x = a_flip ? a_i & 3 : a_half * 2 + (a_i & 1);
+    const tl_int y = a_flip ? a_half * 2 + (a_i >> 2) : a_i >> 1;
+    return y * 4 + x;
+  }
+
+  tl_int  DoGetEtcBit(tl_int a_pixel)
+  { return (a_pixel & 3) * 4 + (a_pixel >> 2); }
+
+  // -----------------------------------------------------------------------
+  // Half blocks
+
+  struct HalfBlock
+  {
+    tl_int  m_pixels[g_numHalfPixels][3];
+  };
+
+  struct HalfEncoding
+  {
+    tl_int  m_base[3];              // quantized
+    tl_int  m_table;
+    u8      m_indices[g_numHalfPixels];
+    tl_int  m_error;
+  };
+
+  // stops early once the error reaches a_maxError
+  tl_int  DoChooseIndices(const HalfBlock& a_half, const tl_int* a_base,
+                          tl_int a_table, u8* a_indices,
+                          tl_int a_maxError = 0x7FFFFFFF)
+  {
+    tl_int palette[4][3];
+    for (tl_int m = 0; m < 4; ++m)
+    {
+      const tl_int modifier = DoGetModifier(a_table, m);
+      for (tl_int c = 0; c < 3; ++c)
+      { palette[m][c] = DoClampByte(a_base[c] + modifier); }
+    }
+
+    tl_int error = 0;
+    for (tl_int i = 0; i < g_numHalfPixels && error < a_maxError; ++i)
+    {
+      const tl_int* pixel = a_half.m_pixels[i];
+
+      tl_int bestError = 0x7FFFFFFF;
+      for (tl_int m = 0; m < 4; ++m)
+      {
+        const tl_int dr = palette[m][0] - pixel[0];
+        const tl_int dg = palette[m][1] - pixel[1];
+        const tl_int db = palette[m][2] - pixel[2];
+        const tl_int pixelError = dr * dr + dg * dg + db * db;
+
+        if (pixelError < bestError)
+        {
+          bestError = pixelError;
+          a_indices[i] = (u8)m;
+        }
+      }
+
+      error += bestError;
+    }
+
+    return error;
+  }
+
+  // Tries a quantized base color with one table (or all of them when
+  // a_table is negative), keeps it if it beats a_best
+  void  DoTryBase(const HalfBlock& a_half, const tl_int* a_base, tl_int a_bits,
+                  tl_int a_table, HalfEncoding& a_best)
+  {
+    const tl_int expanded[3] = { DoExpand(a_base[0], a_bits),
+                                 DoExpand(a_base[1], a_bits),
+                                 DoExpand(a_base[2], a_bits) };
+
+    const tl_int firstTable = a_table < 0 ? 0 : a_table;
+    const tl_int lastTable = a_table < 0 ? g_numTables - 1 : a_table;
+
+    for (tl_int t = firstTable; t <= lastTable; ++t)
+    {
+      u8 indices[g_numHalfPixels];
+      const tl_int error = DoChooseIndices(a_half, expanded, t, indices,
+                                           a_best.m_error);
+
+      if (error < a_best.m_error)
+      {
+        memcpy(a_best.m_base, a_base, sizeof(a_best.m_base));
+        memcpy(a_best.m_indices, indices, sizeof(indices));
+        a_best.m_table = t;
+        a_best.m_error = error;
+      }
+    }
+  }
+
+  // a_reference (if given) is the base color of the first half of a
+  // differential block, the base of this half has to stay within -4..3 of
+  // it
+  void  DoEncodeHalf(const HalfBlock& a_half, tl_int a_bits,
+                     const tl_int* a_reference, bool a_highQuality,
+                     HalfEncoding& a_out)
+  {
+    a_out.m_error = 0x7FFFFFFF;
+
+    tl_int minBase[3] = { 0, 0, 0 };
+    tl_int maxBase[3];
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      maxBase[c] = (1 << a_bits) - 1;
+      if (a_reference)
+      {
+        minBase[c] = core::tlMax(a_reference[c] - 4, 0);
+        maxBase[c] = core::tlMin(a_reference[c] + 3, maxBase[c]);
+      }
+    }
+
+    f32 average[3] = { 0, 0, 0 };
+    for (tl_int i = 0; i < g_numHalfPixels; ++i)
+    {
+      for (tl_int c = 0; c < 3; ++c)
+      { average[c] += (f32)a_half.m_pixels[i][c]; }
+    }
+
+    tl_int base[3];
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      average[c] /= (f32)g_numHalfPixels;
+      base[c] = core::Clamp(DoQuantize(average[c], a_bits),
+                            minBase[c], maxBase[c]);
+    }
+
+    DoTryBase(a_half, base, a_bits, -1, a_out);
+
+    if (a_highQuality == false || a_out.m_error == 0)
+    { return; }
+
+    // the base that best fits the modifiers each table picked
+    for (tl_int t = 0; t < g_numTables; ++t)
+    {
+      const tl_int expanded[3] = { DoExpand(base[0], a_bits),
+                                   DoExpand(base[1], a_bits),
+                                   DoExpand(base[2], a_bits) };
+
+      u8 indices[g_numHalfPixels];
+      DoChooseIndices(a_half, expanded, t, indices);
+
+      f32 fitted[3] = { 0, 0, 0 };
+      for (tl_int i = 0; i < g_numHalfPixels; ++i)
+      {
+        const tl_int modifier = DoGetModifier(t, indices[i]);
+        for (tl_int c = 0; c < 3; ++c)
+        { fitted[c] += (f32)(a_half.m_pixels[i][c] - modifier); }
+      }
+
+      tl_int refined[3];
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        refined[c] = core::Clamp
+          (DoQuantize(core::Clamp(fitted[c] / (f32)g_numHalfPixels, 0.0f, 255.0f),
+                      a_bits), minBase[c], maxBase[c]);
+      }
+
+      DoTryBase(a_half, refined, a_bits, t, a_out);
+    }
+
+    // then the neighbours of the best base with its table
+    for (tl_int step = 0; step < g_maxSearchSteps; ++step)
+    {
+      const tl_int prevError = a_out.m_error;
+      const HalfEncoding prev = a_out;
+
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        for (tl_int delta = -1; delta <= 1; delta += 2)
+        {
+          tl_int neighbour[3] = { prev.m_base[0], prev.m_base[1], prev.m_base[2] };
+          neighbour[c] += delta;
+
+          if (neighbour[c] < minBase[c] || neighbour[c] > maxBase[c])
+          { continue; }
+
+          DoTryBase(a_half, neighbour, a_bits, prev.m_table, a_out);
+        }
+      }
+
+      if (a_out.m_error == prevError || a_out.m_error == 0)
+      { break; }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Blocks
+
+  struct EtcBlock
+  {
+    HalfEncoding  m_halves[2];
+    tl_int        m_flip;
+    bool          m_differential;
+    tl_int        m_error;
+  };
+
+  void  DoEncodeEtcBlock(const u8* a_block, tl_int a_flip, bool a_differential,
+                         bool a_highQuality, EtcBlock& a_out)
+  {
+    const tl_int bits = a_differential ? 5 : 4;
+
+    a_out.m_flip = a_flip;
+    a_out.m_differential = a_differential;
+    a_out.m_error = 0;
+
+    for (tl_int h = 0; h < 2; ++h)
+    {
+      HalfBlock half;
+      for (tl_int i = 0; i < g_numHalfPixels; ++i)
+      {
+        const u8* pixel = a_block + DoGetHalfPixel(a_flip, h, i) * 4;
+        for (tl_int c = 0; c < 3; ++c)
+        { half.m_pixels[i][c] = pixel[c]; }
+      }
+
+      const tl_int* reference =
+        a_differential && h == 1 ? a_out.m_halves[0].m_base : nullptr;
+
+      DoEncodeHalf(half, bits, reference, a_highQuality, a_out.m_halves[h]);
+      a_out.m_error += a_out.m_halves[h].m_error;
+    }
+  }
+
+  void  DoWriteEtcBlock(const EtcBlock& a_block, u8* a_out)
+  {
+    const HalfEncoding& half0 = a_block.m_halves[0];
+    const HalfEncoding& half1 = a_block.m_halves[1];
+
+    u64 packed = 0;
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      const tl_int shift = 56 - c * 8;
+      if (a_block.m_differential)
+      {
+        const tl_int delta = (half1.m_base[c] - half0.m_base[c]) & 7;
+        packed |= (u64)((half0.m_base[c] << 3) | delta) << shift;
+      }
+      else
+      { packed |= (u64)((half0.m_base[c] << 4) | half1.m_base[c]) << shift; }
+    }
+
+    packed |= (u64)half0.m_table << 37;
+    packed |= (u64)half1.m_table << 34;
+    packed |= (u64)(a_block.m_differential ? 1 : 0) << 33;
+    packed |= (u64)a_block.m_flip << 32;
+
+    for (tl_int h = 0; h < 2; ++h)
+    {
+      for (tl_int i = 0; i < g_numHalfPixels; ++i)
+      {
+        const tl_int bit = DoGetEtcBit(DoGetHalfPixel(a_block.m_flip, h, i));
+        const u8     index = a_block.m_halves[h].m_indices[i];
+
+        packed |= (u64)(index >> 1) << (bit + 16);
+        packed |= (u64)(index & 1) << bit;
+      }
+    }
+
+    for (tl_int i = 0; i < 8; ++i)
+    { a_out[i] = (u8)(packed >> (56 - i * 8)); }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// EAC alpha
+
+namespace {
+
+  const tl_int  g_numAlphaTables = 16;
+
+  const tl_int  g_eacModifiers[g_numAlphaTables][8] =
+  {
+    { -3, -6,  -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5,  -8, -13, 1, 4, 7, 12 },
+    { -2, -4,  -6, -13, 1, 3, 5, 12 },
+    { -3, -6,  -8, -12, 2, 5, 7, 11 },
+    { -3, -7,  -9, -11, 2, 6, 8, 10 },
+    { -4, -7,  -8, -11, 3, 6, 7, 10 },
+    { -3, -5,  -8, -11, 2, 4, 7, 10 },
+    { -2, -6,  -8, -10, 1, 5, 7,  9 },
+    { -2, -5,  -8, -10, 1, 4, 7,  9 },
+    { -2, -4,  -8, -10, 1, 3, 7,  9 },
+    { -2, -5,  -7, -10, 1, 4, 6,  9 },
+    { -3, -4,  -7, -10, 2, 3, 6,  9 },
+    { -1, -2,  -3, -10, 0, 1, 2,  9 },
+    { -4, -6,  -8,  -9, 3, 5, 7,  8 },
+    { -3, -5,  -7,  -9, 2, 4, 6,  8 }
+  };
+
+  struct AlphaEncoding
+  {
+    tl_int  m_base;
+    tl_int  m_multiplier;
+    tl_int  m_table;
+    u8      m_indices[g_numBlockPixels];
+    tl_int  m_error;
+  };
+
+  void  DoTryAlpha(const tl_int* a_values, tl_int a_base, tl_int a_multiplier,
+                   tl_int a_table, AlphaEncoding& a_best)
+  {
+    tl_int palette[8];
+    for (tl_int m = 0; m < 8; ++m)
+    {
+      palette[m] =
+        DoClampByte(a_base + g_eacModifiers[a_table][m] * a_multiplier);
+    }
+
+    u8     indices[g_numBlockPixels];
+    tl_int error = 0;
+    for (tl_int i = 0; i < g_numBlockPixels && error < a_best.m_error; ++i)
+    {
+      tl_int bestError = 0x7FFFFFFF;
+      for (tl_int m = 0; m < 8; ++m)
+      {
+        const tl_int diff = a_values[i] - palette[m];
+        if (diff * diff < bestError)
+        {
+          bestError = diff * diff;
+          indices[i] = (u8)m;
+        }
+      }
+
+      error += bestError;
+    }
+
+    if (error < a_best.m_error)
+    {
+      a_best.m_base = a_base;
+      a_best.m_multiplier = a_multiplier;
+      a_best.m_table = a_table;
+      a_best.m_error = error;
+      memcpy(a_best.m_indices, indices, sizeof(indices));
+    }
+  }
+
+  void  DoEncodeEacAlpha(const u8* a_block, bool a_highQuality, u8* a_out)
+  {
+    tl_int values[g_numBlockPixels];
+    tl_int minValue = 255, maxValue = 0;
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    {
+      values[i] = a_block[i * 4 + 3];
+      minValue = core::tlMin(minValue, values[i]);
+      maxValue = core::tlMax(maxValue, values[i]);
+    }
+
+    const tl_int middle = (minValue + maxValue + 1) / 2;
+    const tl_int baseRange = a_highQuality ? 2 : 0;
+    const tl_int multiplierRange = a_highQuality ? 1 : 0;
+
+    // table 13 has a 0 modifier, enough for a block of one alpha value
+    AlphaEncoding best;
+    best.m_base = middle;
+    best.m_multiplier = 1;
+    best.m_table = 13;
+    best.m_error = 0x7FFFFFFF;
+    memset(best.m_indices, 4, sizeof(best.m_indices));
+
+    for (tl_int t = 0; t < g_numAlphaTables && best.m_error > 0; ++t)
+    {
+      // the multiplier that stretches the table over the alpha range
+      const tl_int span = g_eacModifiers[t][7] - g_eacModifiers[t][3];
+      const tl_int multiplier =
+        core::Clamp((maxValue - minValue + span / 2) / span, 1, 15);
+
+      for (tl_int m = multiplier - multiplierRange;
+           m <= multiplier + multiplierRange; ++m)
+      {
+        if (m < 1 || m > 15)
+        { continue; }
+
+        for (tl_int b = middle - baseRange; b <= middle + baseRange; ++b)
+        {
+          if (b >= 0 && b <= 255)
+          { DoTryAlpha(values, b, m, t, best); }
+        }
+      }
+    }
+
+    a_out[0] = (u8)best.m_base;
+    a_out[1] = (u8)((best.m_multiplier << 4) | best.m_table);
+
+    // 16 3 bit indices, big endian, columns from left to right
+    u64 packed = 0;
+    for (tl_int i = 0; i < g_numBlockPixels; ++i)
+    { packed |= (u64)best.m_indices[i] << (45 - DoGetEtcBit(i) * 3); }
+
+    for (tl_int i = 0; i < 6; ++i)
+    { a_out[2 + i] = (u8)(packed >> (40 - i * 8)); }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Encoding
+
+void
+  EncodeEtc2RgbBlock(const u8* a_block, bool a_highQuality, u8* a_out)
+{
+  EtcBlock best;
+  DoEncodeEtcBlock(a_block, 0, false, a_highQuality, best);
+
+  // the other flip and the differential mode
+  for (tl_int i = 1; i < 4 && best.m_error > 0; ++i)
+  {
+    EtcBlock block;
+    DoEncodeEtcBlock(a_block, i >> 1, (i & 1) != 0, a_highQuality, block);
+
+    if (block.m_error < best.m_error)
+    { best = block; }
+  }
+
+  DoWriteEtcBlock(best, a_out);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  EncodeEtc2RgbaBlock(const u8* a_block, bool a_highQuality, u8* a_out)
+{
+  DoEncodeEacAlpha(a_block, a_highQuality, a_out);
+  EncodeEtc2RgbBlock(a_block, a_highQuality, a_out + 8);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Decoding
+
+void
+  DecodeEtc2RgbBlock(const u8* a_in, u8* a_block)
+{
+  u64 packed = 0;
+  for (tl_int i = 0; i < 8; ++i)
+  { packed = (packed << 8) | a_in[i]; }
+
+  const bool   differential = ((packed >> 33) & 1) != 0;
+  const tl_int flip = (tl_int)((packed >> 32) & 1);
+
+  tl_int bases[2][3];
+  for (tl_int c = 0; c < 3; ++c)
+  {
+    const tl_int value = (tl_int)((packed >> (56 - c * 8)) & 0xFF);
+    if (differential)
+    {
+      // the 3 bit delta is signed
+      const tl_int base = value >> 3;
+      const tl_int delta = ((value & 7) ^ 4) - 4;
+
+      bases[0][c] = DoExpand(base, 5);
+      bases[1][c] = DoExpand(core::Clamp(base + delta, 0, 31), 5);
+    }
+    else
+    {
+      bases[0][c] = DoExpand(value >> 4, 4);
+      bases[1][c] = DoExpand(value & 15, 4);
+    }
+  }
+
+  const tl_int tables[2] = { (tl_int)((packed >> 37) & 7),
+                             (tl_int)((packed >> 34) & 7) };
+
+  for (tl_int h = 0; h < 2; ++h)
+  {
+    for (tl_int i = 0; i < g_numHalfPixels; ++i)
+    {
+      const tl_int pixel = DoGetHalfPixel(flip, h, i);
+      const tl_int bit = DoGetEtcBit(pixel);
+      const tl_int index = (tl_int)((((packed >> (bit + 16)) & 1) << 1) |
+                                    ((packed >> bit) & 1));
+      const tl_int modifier = DoGetModifier(tables[h], index);
+
+      for (tl_int c = 0; c < 3; ++c)
+      { a_block[pixel * 4 + c] = (u8)DoClampByte(bases[h][c] + modifier); }
+      a_block[pixel * 4 + 3] = 255;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+  DecodeEtc2RgbaBlock(const u8* a_in, u8* a_block)
+{
+  DecodeEtc2RgbBlock(a_in + 8, a_block);
+
+  const tl_int base = a_in[0];
+  const tl_int multiplier = a_in[1] >> 4;
+  const tl_int table = a_in[1] & 15;
+
+  u64 packed = 0;
+  for (tl_int i = 0; i < 6; ++i)
+  { packed = (packed << 8) | a_in[2 + i]; }
+
+  for (tl_int i = 0; i < g_numBlockPixels; ++i)
+  {
+    const tl_int index = (tl_int)((packed >> (45 - DoGetEtcBit(i) * 3)) & 7);
+    a_block[i * 4 + 3] =
+      (u8)DoClampByte(base + g_eacModifiers[table][index] * multiplier);
+  }
+}
@@ -0,0 +1,30 @@
+#ifndef _TLOC_IMAGE_TOOLS_ETC_ENCODER_H_
+#define _TLOC_IMAGE_TOOLS_ETC_ENCODER_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// ETC2 RGB8 and RGBA8 (EAC alpha) blocks. Every function works on one 4x4
+// block of 8 bit RGBA pixels, rows from top to bottom (64 bytes).
+//
+// Colors are encoded in the individual and differential modes, which are
+// the ones ETC2 shares with ETC1 (the T, H and planar modes are not
+// searched, the blocks are valid ETC2 all the same). Both flips and all 8
+// intensity tables are tried for each half block. The fast mode uses the
+// average of the half block as its base color, the high quality mode
+// refines the base color for every table against the modifiers the pixels
+// picked and tries its neighbours.
+//
+// Alpha: the fast mode centers the 16 EAC tables on the middle of the
+// alpha range with a matching multiplier, the high quality mode also
+// searches the base and the multiplier around them.
+
+void  EncodeEtc2RgbBlock(const u8* a_block, bool a_highQuality, u8* a_out);
+void  EncodeEtc2RgbaBlock(const u8* a_block, bool a_highQuality, u8* a_out);
+
+// the decoders write all 4 channels of the block, ETC2 RGB is opaque. They
+// read the modes the encoders write, not T, H or planar blocks.
+void  DecodeEtc2RgbBlock(const u8* a_in, u8* a_block);
+void  DecodeEtc2RgbaBlock(const u8* a_in, u8* a_block);
+
+#endif
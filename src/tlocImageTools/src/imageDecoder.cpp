@@ -0,0 +1,173 @@
+#include "imageDecoder.h"
+
+#include "jpegDecoder.h"
+#include "pngDecoder.h"
+
+#include <tlocGraphics/tloc_graphics.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// DecodedImage
+
+DecodedImage::
+  DecodedImage()
+  : m_width(0)
+  , m_height(0)
+{ }
+
+// -----------------------------------------------------------------------
+
+void
+DecodedImage::
+  Clear()
+{
+  m_width = 0;
+  m_height = 0;
+  m_pixels.clear();
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Decoding
+
+namespace {
+
+  bool  DoReadFile(const char* a_fileName, tl_core_conts::Array<u8>& a_out)
+  {
+    FILE* file = fopen(a_fileName, "rb");
+    if (file == nullptr)
+    { return false; }
+
+    bool success = fseek(file, 0, SEEK_END) == 0;
+    const long size = success ? ftell(file) : -1;
+    success = size > 0 && fseek(file, 0, SEEK_SET) == 0;
+
+    if (success)
+    {
+      a_out.resize((tl_size)size);
+      success = fread(&a_out[0], 1, (tl_size)size, file) == (tl_size)size;
+    }
+
+    fclose(file);
+    return success;
+  }
+
+  // Loads a_fileName with one of the engine's image loaders, a new one for
+  // every call so that every thread has its own
+  template <typename T_Loader>
+  bool  DoLoadWithImageLoader(const char* a_fileName, DecodedImage& a_out)
+  {
+    a_out.Clear();
+
+    T_Loader loader;
+    if (loader.Load(core_io::Path(a_fileName)) != ErrorSuccess)
+    { return false; }
+
+    auto_cref image = loader.GetImage();
+    a_out.m_width = core_utils::CastNumber<tl_int>(image->GetWidth());
+    a_out.m_height = core_utils::CastNumber<tl_int>(image->GetHeight());
+    a_out.m_pixels.resize((tl_size)a_out.m_width * a_out.m_height * 4);
+
+    u8* out = a_out.m_pixels.empty() ? nullptr : &a_out.m_pixels[0];
+    for (tl_int y = 0; y < a_out.m_height; ++y)
+    {
+      for (tl_int x = 0; x < a_out.m_width; ++x, out += 4)
+      {
+        const gfx_t::Color& color = image->GetPixel(x, y);
+        for (tl_int i = 0; i < 4; ++i)
+        { out[i] = color[i]; }
+      }
+    }
+
+    return true;
+  }
+
+};
+
+image_format
+  GetImageFormat(const u8* a_data, tl_size a_size)
+{
+  const u8 pngSignature[4] = { 137, 'P', 'N', 'G' };
+
+  if (a_size >= 4 && memcmp(a_data, pngSignature, 4) == 0)
+  { return k_png; }
+  if (a_size >= 3 && a_data[0] == 0xFF && a_data[1] == 0xD8 && a_data[2] == 0xFF)
+  { return k_jpeg; }
+
+  return k_unknownFormat;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  DecodeImage(const u8* a_data, tl_size a_size, DecodedImage& a_out)
+{
+  switch (GetImageFormat(a_data, a_size))
+  {
+  case k_png:   return DecodePng(a_data, a_size, a_out);
+  case k_jpeg:  return DecodeJpeg(a_data, a_size, a_out);
+  default:
+    a_out.Clear();
+    return false;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  DecodeImageFile(const char* a_fileName, DecodedImage& a_out)
+{
+  tl_core_conts::Array<u8> data;
+  if (DoReadFile(a_fileName, data) == false)
+  {
+    a_out.Clear();
+    return false;
+  }
+
+  if (DecodeImage(&data[0], data.size(), a_out))
+  { return true; }
+
+  switch (GetImageFormat(&data[0], data.size()))
+  {
+  case k_png:   return DoLoadWithImageLoader<gfx_med::ImageLoaderPng>(a_fileName, a_out);
+  case k_jpeg:  return DoLoadWithImageLoader<gfx_med::ImageLoaderJpeg>(a_fileName, a_out);
+  default:      return false;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+  DecodeImageFiles(const char* const* a_fileNames, tl_size a_numFiles,
+                   DecodedImage* a_out, ImageDecodeStats* a_stats,
+                   tl_int a_numThreads)
+{
+  const int numFiles = (int)a_numFiles;
+
+  tl_size numDecoded = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(a_numThreads)
+  for (int i = 0; i < numFiles; ++i)
+  {
+    core_time::Timer timer;
+
+    const bool decoded = DecodeImageFile(a_fileNames[i], a_out[i]);
+
+    if (a_stats)
+    {
+      a_stats[i].m_seconds = timer.ElapsedSeconds();
+      a_stats[i].m_decoded = decoded;
+    }
+
+    if (decoded)
+    {
+#pragma omp atomic
+      numDecoded++;
+    }
+  }
+
+  return numDecoded;
+}
@@ -0,0 +1,53 @@
+#ifndef _TLOC_IMAGE_TOOLS_IMAGE_DECODER_H_
+#define _TLOC_IMAGE_TOOLS_IMAGE_DECODER_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// A decoded image: 8 bit RGBA, rows from top to bottom. The pixels have
+// the layout of gfx_t::Color, so they can be copied into a gfx_med::Image
+// or uploaded as they are.
+
+struct DecodedImage
+{
+  DecodedImage();
+
+  void    Clear();
+
+  tl_int                    m_width;
+  tl_int                    m_height;
+  tl_core_conts::Array<u8>  m_pixels;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Decodes PNG and baseline JPEG images (see DecodePng() and DecodeJpeg()),
+// the format is taken from the signature at the start of the data.
+// DecodeImageFile() loads the files these refuse (interlaced PNGs,
+// progressive JPEGs) with gfx_med::ImageLoaderPng and ImageLoaderJpeg.
+
+enum image_format { k_unknownFormat, k_png, k_jpeg };
+
+image_format  GetImageFormat(const u8* a_data, tl_size a_size);
+
+bool  DecodeImage(const u8* a_data, tl_size a_size, DecodedImage& a_out);
+bool  DecodeImageFile(const char* a_fileName, DecodedImage& a_out);
+
+// ///////////////////////////////////////////////////////////////////////
+// Batch decoding. Every thread reads and decodes a whole file at a time,
+// so loading the six faces of a cube map or the pages of an atlas takes
+// about as long as the largest one (with enough threads) instead of the
+// sum of all of them.
+
+struct ImageDecodeStats
+{
+  f64     m_seconds;      // reading and decoding the file
+  bool    m_decoded;
+};
+
+// a_stats (if given) has a_numFiles entries, returns the number of images
+// that were decoded
+tl_size DecodeImageFiles(const char* const* a_fileNames, tl_size a_numFiles,
+                         DecodedImage* a_out, ImageDecodeStats* a_stats = nullptr,
+                         tl_int a_numThreads = 1);
+
+#endif
@@ -0,0 +1,434 @@
+#include "imageView.h"
+
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+    (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TLOC_IMAGE_TOOLS_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// ImageView
+
+ImageView::
+  ImageView()
+  : m_data(nullptr)
+  , m_width(0)
+  , m_height(0)
+  , m_pitch(0)
+{ }
+
+// -----------------------------------------------------------------------
+
+ImageView::
+  ImageView(u8* a_data, tl_int a_width, tl_int a_height,
+            const PixelFormat& a_format, tl_size a_pitch)
+  : m_data(a_data)
+  , m_width(a_width)
+  , m_height(a_height)
+  , m_pitch(a_pitch ? a_pitch : (tl_size)a_width * a_format.GetPixelSize())
+  , m_format(a_format)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+ImageView::
+  IsValid() const
+{
+  const tl_int bytes = m_format.m_bytesPerChannel;
+
+  return m_data && m_width > 0 && m_height > 0 &&
+         m_format.m_numChannels >= 1 && m_format.m_numChannels <= 4 &&
+         (bytes == 1 || bytes == 2 || bytes == 4) &&
+         m_pitch >= (tl_size)m_width * m_format.GetPixelSize();
+}
+
+// -----------------------------------------------------------------------
+
+u8*
+ImageView::
+  GetRow(tl_int a_y) const
+{
+  TLOC_ASSERT(a_y >= 0 && a_y < m_height, "Row is outside the view");
+  return m_data + (tl_size)a_y * m_pitch;
+}
+
+// -----------------------------------------------------------------------
+
+u8*
+ImageView::
+  GetPixel(tl_int a_x, tl_int a_y) const
+{
+  TLOC_ASSERT(a_x >= 0 && a_x < m_width, "Pixel is outside the view");
+  return GetRow(a_y) + (tl_size)a_x * m_format.GetPixelSize();
+}
+
+// -----------------------------------------------------------------------
+
+ImageView
+ImageView::
+  GetSubView(tl_int a_x, tl_int a_y, tl_int a_width, tl_int a_height) const
+{
+  const tl_int x0 = core::tlMax(a_x, 0);
+  const tl_int y0 = core::tlMax(a_y, 0);
+  const tl_int x1 = core::tlMin(a_x + a_width, m_width);
+  const tl_int y1 = core::tlMin(a_y + a_height, m_height);
+
+  if (x0 >= x1 || y0 >= y1)
+  { return ImageView(); }
+
+  return ImageView(m_data + (tl_size)y0 * m_pitch +
+                   (tl_size)x0 * m_format.GetPixelSize(),
+                   x1 - x0, y1 - y0, m_format, m_pitch);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Converting values
+
+namespace {
+
+  // below this many bytes a single thread does the whole image
+  const tl_size g_minBytesPerThread = 256 * 1024;
+
+  tl_int  DoGetNumThreads(const ImageView& a_view, tl_int a_numThreads)
+  {
+    const tl_size bytes = (tl_size)a_view.GetWidth() * a_view.GetHeight() *
+                          a_view.GetFormat().GetPixelSize();
+    const tl_int  maxThreads = (tl_int)(bytes / g_minBytesPerThread) + 1;
+
+    return core::Clamp(a_numThreads, 1, maxThreads);
+  }
+
+  void  DoConvertValue(u8 a_in, u8& a_out)    { a_out = a_in; }
+  void  DoConvertValue(u8 a_in, u16& a_out)   { a_out = (u16)(a_in * 257); }
+  void  DoConvertValue(u8 a_in, f32& a_out)   { a_out = a_in * (1.0f / 255.0f); }
+
+  void  DoConvertValue(u16 a_in, u8& a_out)
+  { a_out = (u8)((a_in * 255u + 32895u) >> 16); }   // a_in / 257, rounded
+  void  DoConvertValue(u16 a_in, u16& a_out)  { a_out = a_in; }
+  void  DoConvertValue(u16 a_in, f32& a_out)  { a_out = a_in * (1.0f / 65535.0f); }
+
+  void  DoConvertValue(f32 a_in, u8& a_out)
+  { a_out = (u8)(core::Clamp(a_in, 0.0f, 1.0f) * 255.0f + 0.5f); }
+  void  DoConvertValue(f32 a_in, u16& a_out)
+  { a_out = (u16)(core::Clamp(a_in, 0.0f, 1.0f) * 65535.0f + 0.5f); }
+  void  DoConvertValue(f32 a_in, f32& a_out)  { a_out = a_in; }
+
+  void  DoGetOne(u8& a_out)   { a_out = 255; }
+  void  DoGetOne(u16& a_out)  { a_out = 65535; }
+  void  DoGetOne(f32& a_out)  { a_out = 1.0f; }
+
+  // -----------------------------------------------------------------------
+  // Arrays of values
+
+  template <typename T_Src, typename T_Dst>
+  void  DoConvertValues(const T_Src* a_src, T_Dst* a_dst, tl_size a_count)
+  {
+    for (tl_size i = 0; i < a_count; ++i)
+    { DoConvertValue(a_src[i], a_dst[i]); }
+  }
+
+  template <>
+  void  DoConvertValues(const u8* a_src, u8* a_dst, tl_size a_count)
+  { memcpy(a_dst, a_src, a_count); }
+
+  template <>
+  void  DoConvertValues(const u16* a_src, u16* a_dst, tl_size a_count)
+  { memcpy(a_dst, a_src, a_count * sizeof(u16)); }
+
+  template <>
+  void  DoConvertValues(const f32* a_src, f32* a_dst, tl_size a_count)
+  { memcpy(a_dst, a_src, a_count * sizeof(f32)); }
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+
+  // 16 values per iteration, the rest one at a time
+
+  template <>
+  void  DoConvertValues(const u8* a_src, u16* a_dst, tl_size a_count)
+  {
+    tl_size i = 0;
+    for (; i + 16 <= a_count; i += 16)
+    {
+      // v | v << 8 is v * 257
+      const __m128i v = _mm_loadu_si128((const __m128i*)(a_src + i));
+      _mm_storeu_si128((__m128i*)(a_dst + i), _mm_unpacklo_epi8(v, v));
+      _mm_storeu_si128((__m128i*)(a_dst + i + 8), _mm_unpackhi_epi8(v, v));
+    }
+
+    for (; i < a_count; ++i)
+    { DoConvertValue(a_src[i], a_dst[i]); }
+  }
+
+  template <>
+  void  DoConvertValues(const u16* a_src, u8* a_dst, tl_size a_count)
+  {
+    const __m128i c255 = _mm_set1_epi16(255);
+    const __m128i signBit = _mm_set1_epi16((short)0x8000);
+    const __m128i carryLimit = _mm_set1_epi16(32640 - 32768);
+
+    tl_size i = 0;
+    for (; i + 16 <= a_count; i += 16)
+    {
+      __m128i halves[2];
+      for (tl_int h = 0; h < 2; ++h)
+      {
+        // (v * 255 + 32895) >> 16: the high half of v * 255, plus one when
+        // adding 32895 to the low half carries (low half > 32640)
+        const __m128i v = _mm_loadu_si128((const __m128i*)(a_src + i + h * 8));
+        const __m128i hi = _mm_mulhi_epu16(v, c255);
+        const __m128i lo = _mm_mullo_epi16(v, c255);
+        const __m128i carry =
+          _mm_cmpgt_epi16(_mm_xor_si128(lo, signBit), carryLimit);
+        halves[h] = _mm_sub_epi16(hi, carry);
+      }
+
+      _mm_storeu_si128((__m128i*)(a_dst + i),
+                       _mm_packus_epi16(halves[0], halves[1]));
+    }
+
+    for (; i < a_count; ++i)
+    { DoConvertValue(a_src[i], a_dst[i]); }
+  }
+
+  template <>
+  void  DoConvertValues(const u8* a_src, f32* a_dst, tl_size a_count)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128  scale = _mm_set1_ps(1.0f / 255.0f);
+
+    tl_size i = 0;
+    for (; i + 16 <= a_count; i += 16)
+    {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(a_src + i));
+      const __m128i lo = _mm_unpacklo_epi8(v, zero);
+      const __m128i hi = _mm_unpackhi_epi8(v, zero);
+
+      const __m128i values[4] = { _mm_unpacklo_epi16(lo, zero),
+                                  _mm_unpackhi_epi16(lo, zero),
+                                  _mm_unpacklo_epi16(hi, zero),
+                                  _mm_unpackhi_epi16(hi, zero) };
+
+      for (tl_int q = 0; q < 4; ++q)
+      {
+        _mm_storeu_ps(a_dst + i + q * 4,
+                      _mm_mul_ps(_mm_cvtepi32_ps(values[q]), scale));
+      }
+    }
+
+    for (; i < a_count; ++i)
+    { DoConvertValue(a_src[i], a_dst[i]); }
+  }
+
+  template <>
+  void  DoConvertValues(const f32* a_src, u8* a_dst, tl_size a_count)
+  {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+
+    tl_size i = 0;
+    for (; i + 16 <= a_count; i += 16)
+    {
+      // clamped, scaled and truncated after adding 0.5, as DoConvertValue()
+      __m128i values[4];
+      for (tl_int q = 0; q < 4; ++q)
+      {
+        __m128 v = _mm_loadu_ps(a_src + i + q * 4);
+        v = _mm_min_ps(_mm_max_ps(v, zero), one);
+        values[q] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+      }
+
+      const __m128i lo = _mm_packs_epi32(values[0], values[1]);
+      const __m128i hi = _mm_packs_epi32(values[2], values[3]);
+      _mm_storeu_si128((__m128i*)(a_dst + i), _mm_packus_epi16(lo, hi));
+    }
+
+    for (; i < a_count; ++i)
+    { DoConvertValue(a_src[i], a_dst[i]); }
+  }
+
+#endif
+
+  // -----------------------------------------------------------------------
+  // Rows
+
+  typedef void (*convert_row_func)(const u8*, u8*, tl_int);
+
+  template <typename T_Src, tl_int T_SrcChannels,
+            typename T_Dst, tl_int T_DstChannels>
+  void  DoConvertRow(const u8* a_src, u8* a_dst, tl_int a_width)
+  {
+    const T_Src* src = reinterpret_cast<const T_Src*>(a_src);
+    T_Dst*       dst = reinterpret_cast<T_Dst*>(a_dst);
+
+    if (T_SrcChannels == T_DstChannels)
+    {
+      DoConvertValues(src, dst, (tl_size)a_width * T_SrcChannels);
+      return;
+    }
+
+    T_Dst one;
+    DoGetOne(one);
+
+    for (tl_int x = 0; x < a_width; ++x)
+    {
+      for (tl_int c = 0; c < T_DstChannels; ++c)
+      {
+        if (c < T_SrcChannels)
+        { DoConvertValue(src[x * T_SrcChannels + c], dst[x * T_DstChannels + c]); }
+        else
+        { dst[x * T_DstChannels + c] = c == 3 ? one : T_Dst(0); }
+      }
+    }
+  }
+
+  template <typename T_Src, tl_int T_SrcChannels, typename T_Dst>
+  convert_row_func  DoGetRowConverter(tl_int a_dstChannels)
+  {
+    switch (a_dstChannels)
+    {
+    case 1:   return &DoConvertRow<T_Src, T_SrcChannels, T_Dst, 1>;
+    case 2:   return &DoConvertRow<T_Src, T_SrcChannels, T_Dst, 2>;
+    case 3:   return &DoConvertRow<T_Src, T_SrcChannels, T_Dst, 3>;
+    case 4:   return &DoConvertRow<T_Src, T_SrcChannels, T_Dst, 4>;
+    default:  return nullptr;
+    }
+  }
+
+  template <typename T_Src, tl_int T_SrcChannels>
+  convert_row_func  DoGetRowConverter(const PixelFormat& a_dst)
+  {
+    switch (a_dst.m_bytesPerChannel)
+    {
+    case 1:   return DoGetRowConverter<T_Src, T_SrcChannels, u8>(a_dst.m_numChannels);
+    case 2:   return DoGetRowConverter<T_Src, T_SrcChannels, u16>(a_dst.m_numChannels);
+    case 4:   return DoGetRowConverter<T_Src, T_SrcChannels, f32>(a_dst.m_numChannels);
+    default:  return nullptr;
+    }
+  }
+
+  template <typename T_Src>
+  convert_row_func  DoGetRowConverter(tl_int a_srcChannels,
+                                      const PixelFormat& a_dst)
+  {
+    switch (a_srcChannels)
+    {
+    case 1:   return DoGetRowConverter<T_Src, 1>(a_dst);
+    case 2:   return DoGetRowConverter<T_Src, 2>(a_dst);
+    case 3:   return DoGetRowConverter<T_Src, 3>(a_dst);
+    case 4:   return DoGetRowConverter<T_Src, 4>(a_dst);
+    default:  return nullptr;
+    }
+  }
+
+  convert_row_func  DoGetRowConverter(const PixelFormat& a_src,
+                                      const PixelFormat& a_dst)
+  {
+    switch (a_src.m_bytesPerChannel)
+    {
+    case 1:   return DoGetRowConverter<u8>(a_src.m_numChannels, a_dst);
+    case 2:   return DoGetRowConverter<u16>(a_src.m_numChannels, a_dst);
+    case 4:   return DoGetRowConverter<f32>(a_src.m_numChannels, a_dst);
+    default:  return nullptr;
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Bulk operations
+
+bool
+  FillImage(const ImageView& a_dst, const u8* a_pixel, tl_int a_numThreads)
+{
+  if (a_dst.IsValid() == false || a_pixel == nullptr)
+  { return false; }
+
+  const tl_size pixelSize = a_dst.GetFormat().GetPixelSize();
+  const tl_size rowSize = (tl_size)a_dst.GetWidth() * pixelSize;
+
+  // the first row doubles what it has filled until it is full, the other
+  // rows are copies of it
+  u8* firstRow = a_dst.GetRow(0);
+  memcpy(firstRow, a_pixel, pixelSize);
+  for (tl_size filled = pixelSize; filled < rowSize; filled *= 2)
+  { memcpy(firstRow + filled, firstRow, core::tlMin(filled, rowSize - filled)); }
+
+  const int    height = a_dst.GetHeight();
+  const tl_int numThreads = DoGetNumThreads(a_dst, a_numThreads);
+
+#pragma omp parallel for num_threads(numThreads)
+  for (int y = 1; y < height; ++y)
+  { memcpy(a_dst.GetRow(y), firstRow, rowSize); }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  FillImage(const ImageView& a_dst, const f32* a_rgba, tl_int a_numThreads)
+{
+  if (a_dst.IsValid() == false || a_rgba == nullptr)
+  { return false; }
+
+  u8 pixel[16];
+  const convert_row_func convert =
+    DoGetRowConverter(PixelFormat(4, 4), a_dst.GetFormat());
+  convert(reinterpret_cast<const u8*>(a_rgba), pixel, 1);
+
+  return FillImage(a_dst, pixel, a_numThreads);
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  ConvertImage(const ImageView& a_src, const ImageView& a_dst,
+               tl_int a_numThreads)
+{
+  if (a_src.IsValid() == false || a_dst.IsValid() == false ||
+      a_src.GetWidth() != a_dst.GetWidth() ||
+      a_src.GetHeight() != a_dst.GetHeight())
+  { return false; }
+
+  const convert_row_func convert =
+    DoGetRowConverter(a_src.GetFormat(), a_dst.GetFormat());
+
+  const tl_int width = a_src.GetWidth();
+  const int    height = a_src.GetHeight();
+  const tl_int numThreads = DoGetNumThreads(a_dst, a_numThreads);
+
+#pragma omp parallel for num_threads(numThreads)
+  for (int y = 0; y < height; ++y)
+  { convert(a_src.GetRow(y), a_dst.GetRow(y), width); }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  BlitImage(const ImageView& a_src, const ImageView& a_dst, tl_int a_x,
+            tl_int a_y, tl_int a_numThreads)
+{
+  if (a_src.IsValid() == false || a_dst.IsValid() == false)
+  { return false; }
+
+  const ImageView dst =
+    a_dst.GetSubView(a_x, a_y, a_src.GetWidth(), a_src.GetHeight());
+  if (dst.IsValid() == false)
+  { return true; }
+
+  // the part of the source that is not clipped away
+  const ImageView src =
+    a_src.GetSubView(core::tlMax(-a_x, 0), core::tlMax(-a_y, 0),
+                     dst.GetWidth(), dst.GetHeight());
+
+  return ConvertImage(src, dst, a_numThreads);
+}
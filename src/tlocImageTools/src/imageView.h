@@ -0,0 +1,84 @@
+#ifndef _TLOC_IMAGE_TOOLS_IMAGE_VIEW_H_
+#define _TLOC_IMAGE_TOOLS_IMAGE_VIEW_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "resampler.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// A view of pixels stored somewhere else: a whole image, or a rectangle
+// of one (GetSubView()). Rows are m_pitch bytes apart, so a rectangle of
+// a larger image is a view like any other. The pixel format is one of
+// the gfx_med image types: 1 to 4 channels of u8, u16 or (4 bytes per
+// channel) f32.
+//
+// GetRow() and GetPixel() only check their arguments in debug builds;
+// loops should get a row once and walk it, a span of a row is
+// GetRow(y) + x * GetPixelSize(), or a GetSubView() one pixel high.
+
+class ImageView
+{
+public:
+  ImageView();
+  // a_pitch 0: the rows are packed (a_width pixels apart)
+  ImageView(u8* a_data, tl_int a_width, tl_int a_height,
+            const PixelFormat& a_format, tl_size a_pitch = 0);
+
+  bool      IsValid() const;
+
+  u8*       GetRow(tl_int a_y) const;
+  u8*       GetPixel(tl_int a_x, tl_int a_y) const;
+
+  template <typename T_Component>
+  T_Component*  GetRowAs(tl_int a_y) const
+  { return reinterpret_cast<T_Component*>(GetRow(a_y)); }
+
+  // the part of the view inside the rectangle
+  ImageView GetSubView(tl_int a_x, tl_int a_y, tl_int a_width,
+                       tl_int a_height) const;
+
+  TLOC_DECL_AND_DEF_GETTER(u8*, GetData, m_data);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetWidth, m_width);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetHeight, m_height);
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetPitch, m_pitch);
+  TLOC_DECL_AND_DEF_GETTER(const PixelFormat&, GetFormat, m_format);
+
+private:
+  u8*         m_data;
+  tl_int      m_width;
+  tl_int      m_height;
+  tl_size     m_pitch;
+  PixelFormat m_format;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Bulk operations, one row at a time. Rows are split across a_numThreads
+// threads when there are enough bytes to make it worth it.
+//
+// Converting between formats scales the values (u8 255, u16 65535 and f32
+// 1 are the same value, f32 is clamped to 0-1) and maps the channels in
+// order. Channels the source does not have become 0, except alpha which
+// becomes 1, the way glTexImage2D() expands them. sRGB is not converted,
+// values keep their encoding. Same channel counts convert whole rows as
+// one array of values, with SSE2 for u8 from and to u16 and f32.
+//
+// Every function returns false (and does nothing) when a view is not
+// valid or the sizes do not match.
+
+// a_pixel is one pixel in the format of the view
+bool  FillImage(const ImageView& a_dst, const u8* a_pixel,
+                tl_int a_numThreads = 1);
+// a_rgba is converted to the format of the view first
+bool  FillImage(const ImageView& a_dst, const f32* a_rgba,
+                tl_int a_numThreads = 1);
+
+// the views have the same size, any formats
+bool  ConvertImage(const ImageView& a_src, const ImageView& a_dst,
+                   tl_int a_numThreads = 1);
+
+// copies (and converts) a_src to a_dst with its top left corner at a_x,
+// a_y, clipped to a_dst
+bool  BlitImage(const ImageView& a_src, const ImageView& a_dst, tl_int a_x,
+                tl_int a_y, tl_int a_numThreads = 1);
+
+#endif
@@ -0,0 +1,532 @@
+#include "inflate.h"
+
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  const u16 g_lengthBase[29] =
+  { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+    67, 83, 99, 115, 131, 163, 195, 227, 258 };
+  const u8  g_lengthExtra[29] =
+  { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+    5, 5, 5, 5, 0 };
+  const u16 g_distanceBase[30] =
+  { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+    769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+  const u8  g_distanceExtra[30] =
+  { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+    11, 11, 12, 12, 13, 13 };
+  const u8  g_codeLengthOrder[19] =
+  { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+  const tl_int g_maxCodeLength = 15;
+  const tl_int g_numLiteralCodes = 288;
+  const tl_int g_numDistanceCodes = 32;
+
+  // -----------------------------------------------------------------------
+  // Bits are taken from the low end of m_bits. Past the end of the data
+  // the buffer is filled with zero bytes, IsPastEnd() is true once one of
+  // them has been consumed.
+
+  class BitReader
+  {
+  public:
+    BitReader(const u8* a_begin, const u8* a_end);
+
+    void    Refill();
+    u32     Peek(tl_int a_numBits);
+    void    Consume(tl_int a_numBits);
+    u32     Get(tl_int a_numBits);
+    void    AlignToByte();
+
+    bool    IsPastEnd() const;
+
+  private:
+    const u8* m_data;
+    const u8* m_end;
+    u64       m_bits;
+    tl_int    m_numBits;
+    tl_int    m_numPadding;
+  };
+
+  // -----------------------------------------------------------------------
+  // Canonical Huffman code. Codes of up to k_fastBits bits are decoded with
+  // one lookup, longer ones bit by bit.
+
+  class Huffman
+  {
+  public:
+    enum { k_fastBits = 9 };
+
+    bool    Build(const u8* a_lengths, tl_int a_numSymbols);
+    s32     Decode(BitReader& a_reader) const;
+
+  private:
+    u16     m_fast[1 << k_fastBits];        // symbol << 4 | length, 0 if longer
+    u16     m_count[g_maxCodeLength + 1];
+    u16     m_firstCode[g_maxCodeLength + 1];
+    u16     m_firstIndex[g_maxCodeLength + 1];
+    u16     m_symbols[g_numLiteralCodes];   // sorted by length, then symbol
+  };
+
+  // -----------------------------------------------------------------------
+  // Output that grows by doubling, written through a raw pointer.
+
+  class Output
+  {
+  public:
+    Output(tl_core_conts::Array<u8>& a_out, tl_size a_sizeHint);
+
+    void    Put(u8 a_value);
+    bool    Copy(tl_size a_distance, tl_size a_length);
+    void    Finish();
+
+    TLOC_DECL_AND_DEF_GETTER(tl_size, GetSize, m_size);
+
+  private:
+    void    DoReserve(tl_size a_size);
+
+  private:
+    tl_core_conts::Array<u8>& m_out;
+    u8*                       m_data;
+    tl_size                   m_size;
+  };
+
+  // ///////////////////////////////////////////////////////////////////////
+  // BitReader
+
+  BitReader::
+    BitReader(const u8* a_begin, const u8* a_end)
+    : m_data(a_begin)
+    , m_end(a_end)
+    , m_bits(0)
+    , m_numBits(0)
+    , m_numPadding(0)
+  { }
+
+  void
+  BitReader::
+    Refill()
+  {
+    while (m_numBits <= 56)
+    {
+      u64 byte = 0;
+      if (m_data < m_end)
+      { byte = *m_data++; }
+      else
+      { ++m_numPadding; }
+
+      m_bits |= byte << m_numBits;
+      m_numBits += 8;
+    }
+  }
+
+  u32
+  BitReader::
+    Peek(tl_int a_numBits)
+  {
+    if (m_numBits < a_numBits)
+    { Refill(); }
+    return (u32)(m_bits & ((1ull << a_numBits) - 1));
+  }
+
+  void
+  BitReader::
+    Consume(tl_int a_numBits)
+  {
+    m_bits >>= a_numBits;
+    m_numBits -= a_numBits;
+  }
+
+  u32
+  BitReader::
+    Get(tl_int a_numBits)
+  {
+    const u32 value = Peek(a_numBits);
+    Consume(a_numBits);
+    return value;
+  }
+
+  void
+  BitReader::
+    AlignToByte()
+  { Consume(m_numBits & 7); }
+
+  bool
+  BitReader::
+    IsPastEnd() const
+  { return m_numPadding * 8 > m_numBits; }
+
+  // ///////////////////////////////////////////////////////////////////////
+  // Huffman
+
+  bool
+  Huffman::
+    Build(const u8* a_lengths, tl_int a_numSymbols)
+  {
+    memset(m_fast, 0, sizeof(m_fast));
+    memset(m_count, 0, sizeof(m_count));
+
+    for (tl_int i = 0; i < a_numSymbols; ++i)
+    { ++m_count[a_lengths[i]]; }
+    m_count[0] = 0;
+
+    // more codes of a length than there is room for
+    s32 left = 1;
+    for (tl_int len = 1; len <= g_maxCodeLength; ++len)
+    {
+      left = (left << 1) - m_count[len];
+      if (left < 0)
+      { return false; }
+    }
+
+    u16 code = 0;
+    u16 index = 0;
+    for (tl_int len = 1; len <= g_maxCodeLength; ++len)
+    {
+      m_firstCode[len] = code;
+      m_firstIndex[len] = index;
+      code = (u16)((code + m_count[len]) << 1);
+      index = (u16)(index + m_count[len]);
+    }
+
+    u16 nextIndex[g_maxCodeLength + 1];
+    memcpy(nextIndex, m_firstIndex, sizeof(nextIndex));
+
+    for (tl_int symbol = 0; symbol < a_numSymbols; ++symbol)
+    {
+      const tl_int len = a_lengths[symbol];
+      if (len == 0)
+      { continue; }
+
+      const u16 symbolIndex = nextIndex[len]++;
+      m_symbols[symbolIndex] = (u16)symbol;
+
+      if (len > k_fastBits)
+      { continue; }
+
+      // the code is read a bit at a time from the low end, so the table is
+      // indexed with it reversed
+      const u32 symbolCode = m_firstCode[len] + symbolIndex - m_firstIndex[len];
+      u32 reversed = 0;
+      for (tl_int bit = 0; bit < len; ++bit)
+      { reversed |= ((symbolCode >> bit) & 1) << (len - 1 - bit); }
+
+      for (u32 i = reversed; i < (1u << k_fastBits); i += 1u << len)
+      { m_fast[i] = (u16)(symbol << 4 | len); }
+    }
+
+    return true;
+  }
+
+  s32
+  Huffman::
+    Decode(BitReader& a_reader) const
+  {
+    const u16 entry = m_fast[a_reader.Peek(k_fastBits)];
+    if (entry != 0)
+    {
+      a_reader.Consume(entry & 15);
+      return entry >> 4;
+    }
+
+    // longer than k_fastBits (or not a code at all)
+    s32 code = 0;
+    for (tl_int len = 1; len <= g_maxCodeLength; ++len)
+    {
+      code |= (s32)a_reader.Get(1);
+
+      const s32 index = code - m_firstCode[len];
+      if (index < m_count[len])
+      { return m_symbols[m_firstIndex[len] + index]; }
+
+      code <<= 1;
+    }
+
+    return -1;
+  }
+
+  // ///////////////////////////////////////////////////////////////////////
+  // Output
+
+  Output::
+    Output(tl_core_conts::Array<u8>& a_out, tl_size a_sizeHint)
+    : m_out(a_out)
+    , m_data(nullptr)
+    , m_size(0)
+  { DoReserve(core::tlMax<tl_size>(a_sizeHint, 1024)); }
+
+  void
+  Output::
+    DoReserve(tl_size a_size)
+  {
+    m_out.resize(a_size);
+    m_data = &m_out[0];
+  }
+
+  void
+  Output::
+    Put(u8 a_value)
+  {
+    if (m_size == m_out.size())
+    { DoReserve(m_out.size() * 2); }
+
+    m_data[m_size++] = a_value;
+  }
+
+  bool
+  Output::
+    Copy(tl_size a_distance, tl_size a_length)
+  {
+    if (a_distance > m_size)
+    { return false; }
+
+    while (m_size + a_length > m_out.size())
+    { DoReserve(m_out.size() * 2); }
+
+    u8*       to = m_data + m_size;
+    const u8* from = to - a_distance;
+
+    // overlapping copies repeat the last a_distance bytes
+    if (a_distance >= a_length)
+    { memcpy(to, from, a_length); }
+    else
+    {
+      for (tl_size i = 0; i < a_length; ++i)
+      { to[i] = from[i]; }
+    }
+
+    m_size += a_length;
+    return true;
+  }
+
+  void
+  Output::
+    Finish()
+  { m_out.resize(m_size); }
+
+  // -----------------------------------------------------------------------
+
+  bool
+    DoReadDynamicCodes(BitReader& a_reader, Huffman& a_literals,
+                       Huffman& a_distances)
+  {
+    const tl_int numLiterals = (tl_int)a_reader.Get(5) + 257;
+    const tl_int numDistances = (tl_int)a_reader.Get(5) + 1;
+    const tl_int numCodeLengths = (tl_int)a_reader.Get(4) + 4;
+
+    u8 codeLengthLengths[19];
+    memset(codeLengthLengths, 0, sizeof(codeLengthLengths));
+    for (tl_int i = 0; i < numCodeLengths; ++i)
+    { codeLengthLengths[g_codeLengthOrder[i]] = (u8)a_reader.Get(3); }
+
+    Huffman codeLengths;
+    if (codeLengths.Build(codeLengthLengths, 19) == false)
+    { return false; }
+
+    // the literal and distance lengths are one sequence, a repeat can
+    // cross from one to the other
+    u8 lengths[g_numLiteralCodes + g_numDistanceCodes];
+    tl_int numLengths = 0;
+    while (numLengths < numLiterals + numDistances)
+    {
+      const s32 symbol = codeLengths.Decode(a_reader);
+      if (symbol < 0)
+      { return false; }
+
+      if (symbol < 16)
+      {
+        lengths[numLengths++] = (u8)symbol;
+        continue;
+      }
+
+      u8     value = 0;
+      tl_int repeat = 0;
+      if (symbol == 16)
+      {
+        if (numLengths == 0)
+        { return false; }
+        value = lengths[numLengths - 1];
+        repeat = 3 + (tl_int)a_reader.Get(2);
+      }
+      else if (symbol == 17)
+      { repeat = 3 + (tl_int)a_reader.Get(3); }
+      else
+      { repeat = 11 + (tl_int)a_reader.Get(7); }
+
+      if (numLengths + repeat > numLiterals + numDistances)
+      { return false; }
+
+      memset(lengths + numLengths, value, repeat);
+      numLengths += repeat;
+    }
+
+    // the end of block code has to be there
+    if (lengths[256] == 0)
+    { return false; }
+
+    return a_literals.Build(lengths, numLiterals) &&
+           a_distances.Build(lengths + numLiterals, numDistances);
+  }
+
+  void
+    DoGetFixedCodes(Huffman& a_literals, Huffman& a_distances)
+  {
+    u8 lengths[g_numLiteralCodes];
+    for (tl_int i = 0; i < 144; ++i) { lengths[i] = 8; }
+    for (tl_int i = 144; i < 256; ++i) { lengths[i] = 9; }
+    for (tl_int i = 256; i < 280; ++i) { lengths[i] = 7; }
+    for (tl_int i = 280; i < 288; ++i) { lengths[i] = 8; }
+    a_literals.Build(lengths, g_numLiteralCodes);
+
+    for (tl_int i = 0; i < 30; ++i) { lengths[i] = 5; }
+    a_distances.Build(lengths, 30);
+  }
+
+  // -----------------------------------------------------------------------
+
+  bool
+    DoInflateBlock(BitReader& a_reader, const Huffman& a_literals,
+                   const Huffman& a_distances, Output& a_out)
+  {
+    for (;;)
+    {
+      const s32 symbol = a_literals.Decode(a_reader);
+      if (symbol < 0 || a_reader.IsPastEnd())
+      { return false; }
+
+      if (symbol < 256)
+      {
+        a_out.Put((u8)symbol);
+        continue;
+      }
+
+      if (symbol == 256)
+      { return true; }
+
+      const tl_int lengthCode = symbol - 257;
+      if (lengthCode >= 29)
+      { return false; }
+
+      const tl_size length = g_lengthBase[lengthCode] +
+        a_reader.Get(g_lengthExtra[lengthCode]);
+
+      const s32 distanceCode = a_distances.Decode(a_reader);
+      if (distanceCode < 0 || distanceCode >= 30)
+      { return false; }
+
+      const tl_size distance = g_distanceBase[distanceCode] +
+        a_reader.Get(g_distanceExtra[distanceCode]);
+
+      if (a_out.Copy(distance, length) == false)
+      { return false; }
+    }
+  }
+
+  bool
+    DoInflateStored(BitReader& a_reader, Output& a_out)
+  {
+    a_reader.AlignToByte();
+
+    const u32 length = a_reader.Get(16);
+    const u32 lengthComplement = a_reader.Get(16);
+    if ((length ^ 0xFFFF) != lengthComplement)
+    { return false; }
+
+    for (u32 i = 0; i < length; ++i)
+    { a_out.Put((u8)a_reader.Get(8)); }
+
+    return a_reader.IsPastEnd() == false;
+  }
+
+  u32
+    DoGetAdler32(const u8* a_data, tl_size a_size)
+  {
+    // 5552 bytes is the most that can be summed before the sums overflow
+    u32 a = 1, b = 0;
+    while (a_size > 0)
+    {
+      const tl_size blockSize = core::tlMin<tl_size>(a_size, 5552);
+      for (tl_size i = 0; i < blockSize; ++i)
+      {
+        a += a_data[i];
+        b += a;
+      }
+      a %= 65521;
+      b %= 65521;
+
+      a_data += blockSize;
+      a_size -= blockSize;
+    }
+    return b << 16 | a;
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Inflate
+
+bool
+  Inflate(const u8* a_data, tl_size a_size, tl_core_conts::Array<u8>& a_out,
+          tl_size a_sizeHint)
+{
+  a_out.clear();
+
+  // zlib header: deflate, a window of at most 32K, no preset dictionary
+  if (a_size < 6 || (a_data[0] & 15) != 8 || (a_data[0] >> 4) > 7 ||
+      ((a_data[0] << 8) | a_data[1]) % 31 != 0 || (a_data[1] & 0x20) != 0)
+  { return false; }
+
+  BitReader reader(a_data + 2, a_data + a_size - 4);
+  Output    out(a_out, a_sizeHint);
+
+  Huffman literals;
+  Huffman distances;
+
+  bool lastBlock = false;
+  while (lastBlock == false)
+  {
+    lastBlock = reader.Get(1) != 0;
+
+    bool valid = false;
+    switch (reader.Get(2))
+    {
+    case 0:
+      valid = DoInflateStored(reader, out);
+      break;
+    case 1:
+      DoGetFixedCodes(literals, distances);
+      valid = DoInflateBlock(reader, literals, distances, out);
+      break;
+    case 2:
+      valid = DoReadDynamicCodes(reader, literals, distances) &&
+              DoInflateBlock(reader, literals, distances, out);
+      break;
+    default:
+      break;
+    }
+
+    if (valid == false || reader.IsPastEnd())
+    {
+      a_out.clear();
+      return false;
+    }
+  }
+
+  out.Finish();
+
+  const u8* adler = a_data + a_size - 4;
+  const u32 expected =
+    (u32)adler[0] << 24 | (u32)adler[1] << 16 | (u32)adler[2] << 8 | adler[3];
+
+  const u32 adler32 = a_out.empty() ? 1 : DoGetAdler32(&a_out[0], a_out.size());
+  if (adler32 != expected)
+  {
+    a_out.clear();
+    return false;
+  }
+
+  return true;
+}
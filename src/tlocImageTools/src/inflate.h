@@ -0,0 +1,15 @@
+#ifndef _TLOC_IMAGE_TOOLS_INFLATE_H_
+#define _TLOC_IMAGE_TOOLS_INFLATE_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// Decompresses a zlib stream (RFC 1950 around RFC 1951 deflate data) and
+// checks its Adler-32. a_sizeHint is the expected size of the output
+// (e.g. the size of the filtered image data of a PNG), the output is only
+// grown past it if the data is larger.
+
+bool  Inflate(const u8* a_data, tl_size a_size,
+              tl_core_conts::Array<u8>& a_out, tl_size a_sizeHint = 0);
+
+#endif
@@ -0,0 +1,1108 @@
+#include "jpegDecoder.h"
+
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+    (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TLOC_IMAGE_TOOLS_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tloc;
+
+namespace {
+
+  const tl_int  g_maxDimension = 1 << 15;
+  const tl_int  g_maxComponents = 3;
+  const tl_int  g_fastBits = 9;
+
+  // position of the i'th coefficient of the zigzag order in the block
+  const u8      g_zigzag[64] =
+  {
+     0,  1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+  };
+
+  // -----------------------------------------------------------------------
+  // Huffman table. Codes of up to g_fastBits bits are looked up directly
+  // with the next bits of the stream, longer ones are found by comparing
+  // with the largest code of each length.
+
+  class HuffmanTable
+  {
+  public:
+    HuffmanTable()
+      : m_defined(false)
+    { }
+
+    bool  Build(const u8* a_counts, const u8* a_values, tl_int a_numValues)
+    {
+      tl_int k = 0;
+      for (tl_int i = 0; i < 16; ++i)
+      {
+        for (tl_int j = 0; j < a_counts[i]; ++j)
+        { m_sizes[k++] = (u8)(i + 1); }
+      }
+      m_sizes[k] = 0;
+
+      if (k != a_numValues)
+      { return false; }
+
+      memcpy(m_values, a_values, a_numValues);
+
+      // canonical codes, and the largest code of each length left aligned
+      // to 16 bits
+      u32 code = 0;
+      k = 0;
+      for (tl_int length = 1; length <= 16; ++length)
+      {
+        m_delta[length] = k - (s32)code;
+        while (m_sizes[k] == length)
+        { m_codes[k++] = (u16)code++; }
+
+        if (code > (1u << length))
+        { return false; }
+
+        m_maxCode[length] = code << (16 - length);
+        code <<= 1;
+      }
+      m_maxCode[17] = 0xFFFFFFFF;
+
+      memset(m_fast, 255, sizeof(m_fast));
+      for (tl_int i = 0; i < k; ++i)
+      {
+        const tl_int size = m_sizes[i];
+        if (size <= g_fastBits)
+        {
+          const tl_int first = m_codes[i] << (g_fastBits - size);
+          const tl_int count = 1 << (g_fastBits - size);
+          for (tl_int j = 0; j < count; ++j)
+          { m_fast[first + j] = (u8)i; }
+        }
+      }
+
+      m_defined = true;
+      return true;
+    }
+
+    bool    m_defined;
+    u8      m_fast[1 << g_fastBits];    // index of the code, 255 if longer
+    u16     m_codes[256];
+    u8      m_values[256];
+    u8      m_sizes[257];
+    u32     m_maxCode[18];
+    s32     m_delta[17];                // value index minus code, per length
+  };
+
+  // -----------------------------------------------------------------------
+  // Reads the entropy coded data of a scan MSB first, dropping the 0x00
+  // after stuffed 0xFF bytes. A marker ends the data, after it the reader
+  // returns zeros.
+
+  class BitReader
+  {
+  public:
+    BitReader(const u8* a_begin, const u8* a_end)
+      : m_it(a_begin)
+      , m_end(a_end)
+      , m_bits(0)
+      , m_count(0)
+      , m_marker(0)
+    { }
+
+    void  Fill()
+    {
+      while (m_count <= 24)
+      {
+        u32 byte = 0;
+        if (m_marker == 0 && m_it < m_end)
+        {
+          byte = *m_it++;
+          if (byte == 0xFF)
+          {
+            while (m_it < m_end && *m_it == 0xFF)
+            { ++m_it; }
+
+            const u8 next = m_it < m_end ? *m_it : 0xD9;
+            ++m_it;
+            if (next != 0)
+            {
+              m_marker = next;
+              byte = 0;
+            }
+          }
+        }
+
+        m_bits |= byte << (24 - m_count);
+        m_count += 8;
+      }
+    }
+
+    s32   Decode(const HuffmanTable& a_table)
+    {
+      if (m_count < 16)
+      { Fill(); }
+
+      const tl_int fast = a_table.m_fast[m_bits >> (32 - g_fastBits)];
+      if (fast != 255)
+      {
+        DoConsume(a_table.m_sizes[fast]);
+        return a_table.m_values[fast];
+      }
+
+      const u32 top = m_bits >> 16;
+      tl_int length = g_fastBits + 1;
+      while (top >= a_table.m_maxCode[length])
+      { ++length; }
+
+      if (length > 16)
+      { return -1; }
+
+      const s32 index = (s32)(m_bits >> (32 - length)) + a_table.m_delta[length];
+      DoConsume(length);
+      if (index < 0 || index > 255)
+      { return -1; }
+
+      return a_table.m_values[index];
+    }
+
+    // a_size bits, sign extended as in F.2.2.1 of the standard
+    s32   ReceiveExtend(tl_int a_size)
+    {
+      if (a_size == 0)
+      { return 0; }
+
+      if (m_count < a_size)
+      { Fill(); }
+
+      s32 value = (s32)(m_bits >> (32 - a_size));
+      DoConsume(a_size);
+
+      if (value < (1 << (a_size - 1)))
+      { value -= (1 << a_size) - 1; }
+      return value;
+    }
+
+    // at a restart interval, the data continues after the RSTn marker
+    bool  Restart()
+    {
+      m_bits = 0;
+      m_count = 0;
+
+      if (m_marker == 0)
+      {
+        while (m_it + 1 < m_end && (m_it[0] != 0xFF || m_it[1] == 0 ||
+                                    m_it[1] == 0xFF))
+        { ++m_it; }
+
+        if (m_it + 1 >= m_end)
+        { return false; }
+
+        m_marker = m_it[1];
+        m_it += 2;
+      }
+
+      if (m_marker < 0xD0 || m_marker > 0xD7)
+      { return false; }
+
+      m_marker = 0;
+      return true;
+    }
+
+    // where the marker search continues after the scan
+    const u8* GetPosition() const
+    { return m_marker != 0 ? m_it - 2 : m_it; }
+
+  private:
+    void  DoConsume(tl_int a_size)
+    {
+      m_bits <<= a_size;
+      m_count -= a_size;
+    }
+
+    const u8* m_it;
+    const u8* m_end;
+    u32       m_bits;
+    tl_int    m_count;
+    u8        m_marker;
+  };
+
+  // -----------------------------------------------------------------------
+  // IDCT (jidctint.c), 12 bits of fraction for the constants
+
+  s32   DoFix(f32 a_value)
+  { return (s32)(a_value * 4096.0f + 0.5f); }
+
+  // Coefficients (and the outputs of the column pass) of valid images stay
+  // well within this, corrupt ones are clamped so the integer IDCT cannot
+  // overflow
+  const s32 g_maxCoefficient = 1 << 14;
+
+  s32   DoClampCoefficient(s32 a_value)
+  { return core::Clamp(a_value, -g_maxCoefficient, g_maxCoefficient); }
+
+  u8    DoClampByte(s32 a_value)
+  {
+    if (a_value < 0) { return 0; }
+    if (a_value > 255) { return 255; }
+    return (u8)a_value;
+  }
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+
+  // -----------------------------------------------------------------------
+  // The same IDCT on 8 columns (then 8 rows) at once, in 16 bit lanes. The
+  // products are summed in pairs with _mm_madd_epi16(), the constants of
+  // DoIdct1D() are combined so that every output is the same sum of
+  // products, the results are identical.
+
+  __m128i DoPair(s32 a_a, s32 a_b)
+  { return _mm_setr_epi16((s16)a_a, (s16)a_b, (s16)a_a, (s16)a_b,
+                          (s16)a_a, (s16)a_b, (s16)a_a, (s16)a_b); }
+
+  // a_a * a_pair[0] + a_b * a_pair[1], 32 bits
+  void  DoMadd(__m128i a_a, __m128i a_b, __m128i a_pair,
+               __m128i& a_lo, __m128i& a_hi)
+  {
+    a_lo = _mm_madd_epi16(_mm_unpacklo_epi16(a_a, a_b), a_pair);
+    a_hi = _mm_madd_epi16(_mm_unpackhi_epi16(a_a, a_b), a_pair);
+  }
+
+  // a_rows[i] holds input i of 8 IDCTs, the outputs are
+  // (result + a_bias) >> a_shift, saturated to 16 bits
+  void  DoIdct1DSSE2(__m128i a_rows[8], s32 a_bias, tl_int a_shift)
+  {
+    const s32 c1 = DoFix(0.5411961f);
+    const s32 c2 = DoFix(-1.847759065f);
+    const s32 c3 = DoFix(0.765366865f);
+
+    const s32 c5 = DoFix(1.175875602f);
+    const s32 t0 = DoFix(0.298631336f);
+    const s32 t1 = DoFix(2.053119869f);
+    const s32 t2 = DoFix(3.072711026f);
+    const s32 t3 = DoFix(1.501321110f);
+    const s32 p1 = DoFix(-0.899976223f);
+    const s32 p2 = DoFix(-2.562915447f);
+    const s32 p3 = DoFix(-1.961570560f);
+    const s32 p4 = DoFix(-0.390180644f);
+
+    const __m128i bias = _mm_set1_epi32(a_bias);
+    const __m128i shift = _mm_cvtsi32_si128(a_shift);
+
+    // even part
+    __m128i t0lo, t0hi, t1lo, t1hi, t2lo, t2hi, t3lo, t3hi;
+    DoMadd(a_rows[0], a_rows[4], DoPair(4096, 4096), t0lo, t0hi);
+    DoMadd(a_rows[0], a_rows[4], DoPair(4096, -4096), t1lo, t1hi);
+    DoMadd(a_rows[2], a_rows[6], DoPair(c1, c1 + c2), t2lo, t2hi);
+    DoMadd(a_rows[2], a_rows[6], DoPair(c1 + c3, c1), t3lo, t3hi);
+
+    t0lo = _mm_add_epi32(t0lo, bias);
+    t0hi = _mm_add_epi32(t0hi, bias);
+    t1lo = _mm_add_epi32(t1lo, bias);
+    t1hi = _mm_add_epi32(t1hi, bias);
+
+    __m128i x[4][2] =
+    {
+      { _mm_add_epi32(t0lo, t3lo), _mm_add_epi32(t0hi, t3hi) },
+      { _mm_add_epi32(t1lo, t2lo), _mm_add_epi32(t1hi, t2hi) },
+      { _mm_sub_epi32(t1lo, t2lo), _mm_sub_epi32(t1hi, t2hi) },
+      { _mm_sub_epi32(t0lo, t3lo), _mm_sub_epi32(t0hi, t3hi) },
+    };
+
+    // odd part, the terms of the inputs 1 and 7 and of 3 and 5
+    const s32 pairs[4][4] =
+    {
+      { t3 + p1 + p4 + c5, p1 + c5, c5, p4 + c5 },
+      { c5, p3 + c5, t2 + p2 + p3 + c5, p2 + c5 },
+      { p4 + c5, c5, p2 + c5, t1 + p2 + p4 + c5 },
+      { p1 + c5, t0 + p1 + p3 + c5, p3 + c5, c5 },
+    };
+
+    __m128i odd[4][2];
+    for (tl_int i = 0; i < 4; ++i)
+    {
+      __m128i lo17, hi17, lo35, hi35;
+      DoMadd(a_rows[1], a_rows[7], DoPair(pairs[i][0], pairs[i][1]), lo17, hi17);
+      DoMadd(a_rows[3], a_rows[5], DoPair(pairs[i][2], pairs[i][3]), lo35, hi35);
+      odd[i][0] = _mm_add_epi32(lo17, lo35);
+      odd[i][1] = _mm_add_epi32(hi17, hi35);
+    }
+
+    for (tl_int i = 0; i < 4; ++i)
+    {
+      a_rows[i] = _mm_packs_epi32
+        (_mm_sra_epi32(_mm_add_epi32(x[i][0], odd[i][0]), shift),
+         _mm_sra_epi32(_mm_add_epi32(x[i][1], odd[i][1]), shift));
+      a_rows[7 - i] = _mm_packs_epi32
+        (_mm_sra_epi32(_mm_sub_epi32(x[i][0], odd[i][0]), shift),
+         _mm_sra_epi32(_mm_sub_epi32(x[i][1], odd[i][1]), shift));
+    }
+  }
+
+  void  DoTranspose8x8(__m128i a_rows[8])
+  {
+    const __m128i a0 = _mm_unpacklo_epi16(a_rows[0], a_rows[1]);
+    const __m128i a1 = _mm_unpackhi_epi16(a_rows[0], a_rows[1]);
+    const __m128i a2 = _mm_unpacklo_epi16(a_rows[2], a_rows[3]);
+    const __m128i a3 = _mm_unpackhi_epi16(a_rows[2], a_rows[3]);
+    const __m128i a4 = _mm_unpacklo_epi16(a_rows[4], a_rows[5]);
+    const __m128i a5 = _mm_unpackhi_epi16(a_rows[4], a_rows[5]);
+    const __m128i a6 = _mm_unpacklo_epi16(a_rows[6], a_rows[7]);
+    const __m128i a7 = _mm_unpackhi_epi16(a_rows[6], a_rows[7]);
+
+    const __m128i b0 = _mm_unpacklo_epi32(a0, a2);
+    const __m128i b1 = _mm_unpackhi_epi32(a0, a2);
+    const __m128i b2 = _mm_unpacklo_epi32(a1, a3);
+    const __m128i b3 = _mm_unpackhi_epi32(a1, a3);
+    const __m128i b4 = _mm_unpacklo_epi32(a4, a6);
+    const __m128i b5 = _mm_unpackhi_epi32(a4, a6);
+    const __m128i b6 = _mm_unpacklo_epi32(a5, a7);
+    const __m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+    a_rows[0] = _mm_unpacklo_epi64(b0, b4);
+    a_rows[1] = _mm_unpackhi_epi64(b0, b4);
+    a_rows[2] = _mm_unpacklo_epi64(b1, b5);
+    a_rows[3] = _mm_unpackhi_epi64(b1, b5);
+    a_rows[4] = _mm_unpacklo_epi64(b2, b6);
+    a_rows[5] = _mm_unpackhi_epi64(b2, b6);
+    a_rows[6] = _mm_unpacklo_epi64(b3, b7);
+    a_rows[7] = _mm_unpackhi_epi64(b3, b7);
+  }
+
+  void  DoInverseDct(const s32* a_coefs, u8* a_out, tl_int a_stride)
+  {
+    // the coefficients are clamped, they fit in 16 bits
+    __m128i rows[8];
+    for (tl_int y = 0; y < 8; ++y)
+    {
+      const __m128i* coefs = reinterpret_cast<const __m128i*>(a_coefs + y * 8);
+      rows[y] = _mm_packs_epi32(_mm_loadu_si128(coefs), _mm_loadu_si128(coefs + 1));
+    }
+
+    // columns, 2 extra bits of precision for the rows
+    DoIdct1DSSE2(rows, 512, 10);
+
+    const __m128i minCoef = _mm_set1_epi16(-g_maxCoefficient);
+    const __m128i maxCoef = _mm_set1_epi16(g_maxCoefficient);
+    for (tl_int i = 0; i < 8; ++i)
+    { rows[i] = _mm_min_epi16(_mm_max_epi16(rows[i], minCoef), maxCoef); }
+
+    // rows, removing the precision bits and the level shift of 128
+    DoTranspose8x8(rows);
+    DoIdct1DSSE2(rows, 65536 + (128 << 17), 17);
+    DoTranspose8x8(rows);
+
+    for (tl_int y = 0; y < 8; ++y)
+    {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(a_out + y * a_stride),
+                       _mm_packus_epi16(rows[y], rows[y]));
+    }
+  }
+
+#else
+
+  // 1D IDCT of 8 values a_stride apart, the outputs are
+  // (result + a_bias) >> a_shift
+  void  DoIdct1D(const s32* a_in, tl_int a_stride, s32 a_bias, tl_int a_shift,
+                 s32* a_out)
+  {
+    const s32 s0 = a_in[0 * a_stride];
+    const s32 s1 = a_in[1 * a_stride];
+    const s32 s2 = a_in[2 * a_stride];
+    const s32 s3 = a_in[3 * a_stride];
+    const s32 s4 = a_in[4 * a_stride];
+    const s32 s5 = a_in[5 * a_stride];
+    const s32 s6 = a_in[6 * a_stride];
+    const s32 s7 = a_in[7 * a_stride];
+
+    // even part
+    s32 p1 = (s2 + s6) * DoFix(0.5411961f);
+    s32 t2 = p1 + s6 * DoFix(-1.847759065f);
+    s32 t3 = p1 + s2 * DoFix(0.765366865f);
+    s32 t0 = (s0 + s4) * 4096;
+    s32 t1 = (s0 - s4) * 4096;
+
+    const s32 x0 = t0 + t3 + a_bias;
+    const s32 x3 = t0 - t3 + a_bias;
+    const s32 x1 = t1 + t2 + a_bias;
+    const s32 x2 = t1 - t2 + a_bias;
+
+    // odd part
+    t0 = s7;
+    t1 = s5;
+    t2 = s3;
+    t3 = s1;
+
+    s32 p3 = t0 + t2;
+    s32 p4 = t1 + t3;
+    p1 = t0 + t3;
+    s32 p2 = t1 + t2;
+
+    const s32 p5 = (p3 + p4) * DoFix(1.175875602f);
+    t0 = t0 * DoFix(0.298631336f);
+    t1 = t1 * DoFix(2.053119869f);
+    t2 = t2 * DoFix(3.072711026f);
+    t3 = t3 * DoFix(1.501321110f);
+    p1 = p5 + p1 * DoFix(-0.899976223f);
+    p2 = p5 + p2 * DoFix(-2.562915447f);
+    p3 = p3 * DoFix(-1.961570560f);
+    p4 = p4 * DoFix(-0.390180644f);
+
+    t3 += p1 + p4;
+    t2 += p2 + p3;
+    t1 += p2 + p4;
+    t0 += p1 + p3;
+
+    a_out[0] = (x0 + t3) >> a_shift;
+    a_out[7] = (x0 - t3) >> a_shift;
+    a_out[1] = (x1 + t2) >> a_shift;
+    a_out[6] = (x1 - t2) >> a_shift;
+    a_out[2] = (x2 + t1) >> a_shift;
+    a_out[5] = (x2 - t1) >> a_shift;
+    a_out[3] = (x3 + t0) >> a_shift;
+    a_out[4] = (x3 - t0) >> a_shift;
+  }
+
+  void  DoInverseDct(const s32* a_coefs, u8* a_out, tl_int a_stride)
+  {
+    s32 columns[64];
+    s32 values[8];
+
+    // columns, 2 extra bits of precision for the rows
+    for (tl_int x = 0; x < 8; ++x)
+    {
+      const s32* column = a_coefs + x;
+      if ((column[8] | column[16] | column[24] | column[32] |
+           column[40] | column[48] | column[56]) == 0)
+      {
+        const s32 dc = DoClampCoefficient(column[0] * 4);
+        for (tl_int y = 0; y < 8; ++y)
+        { columns[y * 8 + x] = dc; }
+        continue;
+      }
+
+      DoIdct1D(column, 8, 512, 10, values);
+      for (tl_int y = 0; y < 8; ++y)
+      { columns[y * 8 + x] = DoClampCoefficient(values[y]); }
+    }
+
+    // rows, removing the precision bits and the level shift of 128
+    const s32 bias = 65536 + (128 << 17);
+    for (tl_int y = 0; y < 8; ++y)
+    {
+      DoIdct1D(columns + y * 8, 1, bias, 17, values);
+
+      u8* out = a_out + y * a_stride;
+      for (tl_int x = 0; x < 8; ++x)
+      { out[x] = DoClampByte(values[x]); }
+    }
+  }
+
+#endif
+
+  // -----------------------------------------------------------------------
+  // Decoder state
+
+  struct JpegComponent
+  {
+    tl_int    m_id;
+    tl_int    m_h;
+    tl_int    m_v;
+    tl_int    m_quantTable;
+    tl_int    m_dcTable;
+    tl_int    m_acTable;
+    s32       m_dcPrediction;
+
+    tl_int    m_width;              // samples of the image
+    tl_int    m_height;
+    tl_int    m_stride;             // samples of whole MCUs
+    tl_core_conts::Array<u8>  m_plane;
+  };
+
+  struct JpegDecoder
+  {
+    JpegDecoder()
+      : m_width(0)
+      , m_height(0)
+      , m_numComponents(0)
+      , m_maxH(1)
+      , m_maxV(1)
+      , m_mcusX(0)
+      , m_mcusY(0)
+      , m_restartInterval(0)
+    {
+      memset(m_quant, 0, sizeof(m_quant));
+      memset(m_hasQuant, 0, sizeof(m_hasQuant));
+    }
+
+    tl_int          m_width;
+    tl_int          m_height;
+    tl_int          m_numComponents;
+    tl_int          m_maxH;
+    tl_int          m_maxV;
+    tl_int          m_mcusX;
+    tl_int          m_mcusY;
+    tl_int          m_restartInterval;
+
+    u16             m_quant[4][64];     // zigzag order
+    bool            m_hasQuant[4];
+    HuffmanTable    m_dc[4];
+    HuffmanTable    m_ac[4];
+    JpegComponent   m_components[g_maxComponents];
+  };
+
+  u32   DoReadU16(const u8* a_data)
+  { return (u32)a_data[0] << 8 | a_data[1]; }
+
+  bool  DoReadQuantTables(JpegDecoder& a_dec, const u8* a_data, tl_size a_size)
+  {
+    while (a_size > 0)
+    {
+      const tl_int precision = a_data[0] >> 4;
+      const tl_int table = a_data[0] & 15;
+      const tl_size size = 1 + (precision ? 128 : 64);
+      if (precision > 1 || table > 3 || a_size < size)
+      { return false; }
+
+      for (tl_int i = 0; i < 64; ++i)
+      {
+        a_dec.m_quant[table][i] = (u16)(precision
+          ? DoReadU16(a_data + 1 + i * 2) : a_data[1 + i]);
+      }
+      a_dec.m_hasQuant[table] = true;
+
+      a_data += size;
+      a_size -= size;
+    }
+    return true;
+  }
+
+  bool  DoReadHuffmanTables(JpegDecoder& a_dec, const u8* a_data, tl_size a_size)
+  {
+    while (a_size > 0)
+    {
+      if (a_size < 17)
+      { return false; }
+
+      const tl_int tableClass = a_data[0] >> 4;
+      const tl_int table = a_data[0] & 15;
+      if (tableClass > 1 || table > 3)
+      { return false; }
+
+      tl_int numValues = 0;
+      for (tl_int i = 0; i < 16; ++i)
+      { numValues += a_data[1 + i]; }
+
+      if (numValues > 256 || a_size < (tl_size)(17 + numValues))
+      { return false; }
+
+      HuffmanTable& huffman = tableClass ? a_dec.m_ac[table] : a_dec.m_dc[table];
+      if (huffman.Build(a_data + 1, a_data + 17, numValues) == false)
+      { return false; }
+
+      a_data += 17 + numValues;
+      a_size -= 17 + numValues;
+    }
+    return true;
+  }
+
+  bool  DoReadFrame(JpegDecoder& a_dec, const u8* a_data, tl_size a_size)
+  {
+    if (a_size < 6)
+    { return false; }
+
+    const tl_int precision = a_data[0];
+    a_dec.m_height = (tl_int)DoReadU16(a_data + 1);
+    a_dec.m_width = (tl_int)DoReadU16(a_data + 3);
+    a_dec.m_numComponents = a_data[5];
+
+    // a height of 0 (defined by a DNL marker) is not supported
+    if (precision != 8 || a_dec.m_width <= 0 || a_dec.m_height <= 0 ||
+        a_dec.m_width > g_maxDimension || a_dec.m_height > g_maxDimension ||
+        (a_dec.m_numComponents != 1 && a_dec.m_numComponents != 3) ||
+        a_size < (tl_size)(6 + a_dec.m_numComponents * 3))
+    { return false; }
+
+    for (tl_int i = 0; i < a_dec.m_numComponents; ++i)
+    {
+      JpegComponent& comp = a_dec.m_components[i];
+      const u8* data = a_data + 6 + i * 3;
+
+      comp.m_id = data[0];
+      comp.m_h = data[1] >> 4;
+      comp.m_v = data[1] & 15;
+      comp.m_quantTable = data[2];
+
+      if (comp.m_h < 1 || comp.m_h > 4 || comp.m_v < 1 || comp.m_v > 4 ||
+          comp.m_quantTable > 3)
+      { return false; }
+
+      a_dec.m_maxH = core::tlMax(a_dec.m_maxH, comp.m_h);
+      a_dec.m_maxV = core::tlMax(a_dec.m_maxV, comp.m_v);
+    }
+
+    a_dec.m_mcusX = (a_dec.m_width + a_dec.m_maxH * 8 - 1) / (a_dec.m_maxH * 8);
+    a_dec.m_mcusY = (a_dec.m_height + a_dec.m_maxV * 8 - 1) / (a_dec.m_maxV * 8);
+
+    for (tl_int i = 0; i < a_dec.m_numComponents; ++i)
+    {
+      JpegComponent& comp = a_dec.m_components[i];
+
+      comp.m_width =
+        (a_dec.m_width * comp.m_h + a_dec.m_maxH - 1) / a_dec.m_maxH;
+      comp.m_height =
+        (a_dec.m_height * comp.m_v + a_dec.m_maxV - 1) / a_dec.m_maxV;
+      comp.m_stride = a_dec.m_mcusX * comp.m_h * 8;
+      comp.m_plane.resize((tl_size)comp.m_stride * a_dec.m_mcusY * comp.m_v * 8);
+    }
+
+    return true;
+  }
+
+  bool  DoDecodeBlock(JpegDecoder& a_dec, BitReader& a_reader,
+                      JpegComponent& a_comp, u8* a_out)
+  {
+    const u16* quant = a_dec.m_quant[a_comp.m_quantTable];
+
+    s32 coefs[64];
+    memset(coefs, 0, sizeof(coefs));
+
+    const s32 dcSize = a_reader.Decode(a_dec.m_dc[a_comp.m_dcTable]);
+    if (dcSize < 0 || dcSize > 11)
+    { return false; }
+
+    a_comp.m_dcPrediction = core::Clamp
+      (a_comp.m_dcPrediction + a_reader.ReceiveExtend(dcSize), -32767, 32767);
+    coefs[0] = DoClampCoefficient(a_comp.m_dcPrediction * quant[0]);
+
+    const HuffmanTable& ac = a_dec.m_ac[a_comp.m_acTable];
+    for (tl_int k = 1; k < 64; ++k)
+    {
+      const s32 runSize = a_reader.Decode(ac);
+      if (runSize < 0)
+      { return false; }
+
+      const tl_int size = runSize & 15;
+      const tl_int run = runSize >> 4;
+      if (size == 0)
+      {
+        if (run != 15)
+        { break; }      // end of block
+        k += 15;
+        continue;
+      }
+
+      k += run;
+      if (k > 63)
+      { return false; }
+
+      coefs[g_zigzag[k]] =
+        DoClampCoefficient(a_reader.ReceiveExtend(size) * quant[k]);
+    }
+
+    DoInverseDct(coefs, a_out, a_comp.m_stride);
+    return true;
+  }
+
+  // returns the end of the entropy coded data, nullptr on errors
+  const u8* DoDecodeScan(JpegDecoder& a_dec, const u8* a_header,
+                         tl_size a_headerSize, const u8* a_end)
+  {
+    if (a_headerSize < 1)
+    { return nullptr; }
+
+    const tl_int numScanComponents = a_header[0];
+    if (numScanComponents < 1 || numScanComponents > a_dec.m_numComponents ||
+        a_headerSize < (tl_size)(4 + numScanComponents * 2))
+    { return nullptr; }
+
+    JpegComponent* scanComponents[g_maxComponents];
+    for (tl_int i = 0; i < numScanComponents; ++i)
+    {
+      const tl_int id = a_header[1 + i * 2];
+      const tl_int tables = a_header[2 + i * 2];
+
+      JpegComponent* comp = nullptr;
+      for (tl_int j = 0; j < a_dec.m_numComponents; ++j)
+      {
+        if (a_dec.m_components[j].m_id == id)
+        { comp = &a_dec.m_components[j]; }
+      }
+
+      if (comp == nullptr)
+      { return nullptr; }
+
+      comp->m_dcTable = tables >> 4;
+      comp->m_acTable = tables & 15;
+      comp->m_dcPrediction = 0;
+
+      if (comp->m_dcTable > 3 || comp->m_acTable > 3 ||
+          a_dec.m_dc[comp->m_dcTable].m_defined == false ||
+          a_dec.m_ac[comp->m_acTable].m_defined == false ||
+          a_dec.m_hasQuant[comp->m_quantTable] == false)
+      { return nullptr; }
+
+      scanComponents[i] = comp;
+    }
+
+    BitReader reader(a_header + a_headerSize, a_end);
+
+    // a scan of a single component has no MCUs, its blocks are in raster
+    // order and only cover the component
+    tl_int blocksX = a_dec.m_mcusX;
+    tl_int blocksY = a_dec.m_mcusY;
+    if (numScanComponents == 1)
+    {
+      blocksX = (scanComponents[0]->m_width + 7) / 8;
+      blocksY = (scanComponents[0]->m_height + 7) / 8;
+    }
+
+    tl_int restartsLeft = a_dec.m_restartInterval;
+    for (tl_int y = 0; y < blocksY; ++y)
+    {
+      for (tl_int x = 0; x < blocksX; ++x)
+      {
+        if (numScanComponents == 1)
+        {
+          JpegComponent& comp = *scanComponents[0];
+          u8* out = &comp.m_plane[((tl_size)y * comp.m_stride + x) * 8];
+          if (DoDecodeBlock(a_dec, reader, comp, out) == false)
+          { return nullptr; }
+        }
+        else
+        {
+          for (tl_int i = 0; i < numScanComponents; ++i)
+          {
+            JpegComponent& comp = *scanComponents[i];
+            for (tl_int v = 0; v < comp.m_v; ++v)
+            {
+              for (tl_int h = 0; h < comp.m_h; ++h)
+              {
+                const tl_size blockX = x * comp.m_h + h;
+                const tl_size blockY = y * comp.m_v + v;
+                u8* out = &comp.m_plane[(blockY * comp.m_stride + blockX) * 8];
+                if (DoDecodeBlock(a_dec, reader, comp, out) == false)
+                { return nullptr; }
+              }
+            }
+          }
+        }
+
+        const bool isLast = y == blocksY - 1 && x == blocksX - 1;
+        if (a_dec.m_restartInterval > 0 && --restartsLeft == 0 && isLast == false)
+        {
+          if (reader.Restart() == false)
+          { return nullptr; }
+
+          for (tl_int i = 0; i < numScanComponents; ++i)
+          { scanComponents[i]->m_dcPrediction = 0; }
+          restartsLeft = a_dec.m_restartInterval;
+        }
+      }
+    }
+
+    return reader.GetPosition();
+  }
+
+  // -----------------------------------------------------------------------
+  // Upsampling and color conversion
+
+  // one row of a component, upsampled to the width of the image. a_column
+  // holds the vertically filtered samples.
+  const u8* DoGetUpsampledRow(const JpegDecoder& a_dec, const JpegComponent& a_comp,
+                              tl_int a_y, u8* a_buffer, u16* a_column)
+  {
+    const tl_int scaleH = a_dec.m_maxH / a_comp.m_h;
+    const tl_int scaleV = a_dec.m_maxV / a_comp.m_v;
+
+    const tl_int  width = a_comp.m_width;
+    const tl_int  nearY = a_y / scaleV;
+    const u8*     near = &a_comp.m_plane[(tl_size)nearY * a_comp.m_stride];
+
+    const bool isExact = a_dec.m_maxH % a_comp.m_h == 0 &&
+                         a_dec.m_maxV % a_comp.m_v == 0;
+
+    if (isExact && scaleH == 1 && scaleV == 1)
+    { return near; }
+
+    if (isExact == false || scaleH > 2 || scaleV > 2)
+    {
+      // replication of the closest sample
+      for (tl_int x = 0; x < a_dec.m_width; ++x)
+      {
+        const tl_int srcX = (x * a_comp.m_h) / a_dec.m_maxH;
+        const tl_int srcY = (a_y * a_comp.m_v) / a_dec.m_maxV;
+        a_buffer[x] = a_comp.m_plane[(tl_size)srcY * a_comp.m_stride + srcX];
+      }
+      return a_buffer;
+    }
+
+    // the sample centers of the output rows are a quarter of a source row
+    // away from the nearest source row, towards the far one
+    u16* column = a_column;
+    if (scaleV == 2)
+    {
+      tl_int farY = (a_y & 1) ? nearY + 1 : nearY - 1;
+      farY = core::Clamp(farY, 0, a_comp.m_height - 1);
+
+      const u8* far = &a_comp.m_plane[(tl_size)farY * a_comp.m_stride];
+      for (tl_int x = 0; x < width; ++x)
+      { column[x] = (u16)(near[x] * 3 + far[x]); }
+    }
+    else
+    {
+      for (tl_int x = 0; x < width; ++x)
+      { column[x] = (u16)(near[x] * 4); }
+    }
+
+    if (scaleH == 1)
+    {
+      for (tl_int x = 0; x < width; ++x)
+      { a_buffer[x] = (u8)((column[x] + 2) >> 2); }
+      return a_buffer;
+    }
+
+    // the same horizontally, column[] has 2 bits of fraction
+    if (width == 1)
+    {
+      a_buffer[0] = a_buffer[1] = (u8)((column[0] + 2) >> 2);
+      return a_buffer;
+    }
+
+    a_buffer[0] = (u8)((column[0] + 2) >> 2);
+    for (tl_int x = 1; x < width; ++x)
+    {
+      a_buffer[x * 2 - 1] = (u8)((column[x - 1] * 3 + column[x] + 8) >> 4);
+      a_buffer[x * 2] = (u8)((column[x] * 3 + column[x - 1] + 8) >> 4);
+    }
+    a_buffer[width * 2 - 1] = (u8)((column[width - 1] + 2) >> 2);
+    return a_buffer;
+  }
+
+  s32   DoFixColor(f32 a_value)
+  { return (s32)(a_value * 4096.0f + 0.5f) << 8; }
+
+  void  DoConvertYCbCr(const u8* a_y, const u8* a_cb, const u8* a_cr,
+                       tl_int a_width, u8* a_out)
+  {
+    const s32 crToR = DoFixColor(1.40200f);
+    const s32 crToG = -DoFixColor(0.71414f);
+    const s32 cbToG = -DoFixColor(0.34414f);
+    const s32 cbToB = DoFixColor(1.77200f);
+
+    tl_int x = 0;
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+    // 8 pixels at a time, the constants without the 8 bits the scalar
+    // loop below shifts out again, which gives the same results
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i offset = _mm_set1_epi16(128);
+    const __m128i round = _mm_set1_epi32(1 << 11);
+    const __m128i alpha = _mm_set1_epi8((char)255);
+
+    const __m128i yCrToR = _mm_setr_epi16(4096, (s16)(crToR >> 8), 4096, (s16)(crToR >> 8),
+                                          4096, (s16)(crToR >> 8), 4096, (s16)(crToR >> 8));
+    const __m128i yCrToG = _mm_setr_epi16(4096, (s16)(crToG >> 8), 4096, (s16)(crToG >> 8),
+                                          4096, (s16)(crToG >> 8), 4096, (s16)(crToG >> 8));
+    const __m128i yCbToB = _mm_setr_epi16(4096, (s16)(cbToB >> 8), 4096, (s16)(cbToB >> 8),
+                                          4096, (s16)(cbToB >> 8), 4096, (s16)(cbToB >> 8));
+    const __m128i cbToGOnly = _mm_setr_epi16((s16)(cbToG >> 8), 0, (s16)(cbToG >> 8), 0,
+                                             (s16)(cbToG >> 8), 0, (s16)(cbToG >> 8), 0);
+
+    for (; x + 8 <= a_width; x += 8)
+    {
+      const __m128i y = _mm_unpacklo_epi8
+        (_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a_y + x)), zero);
+      const __m128i cb = _mm_sub_epi16(_mm_unpacklo_epi8
+        (_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a_cb + x)), zero), offset);
+      const __m128i cr = _mm_sub_epi16(_mm_unpacklo_epi8
+        (_mm_loadl_epi64(reinterpret_cast<const __m128i*>(a_cr + x)), zero), offset);
+
+      const __m128i yCrLo = _mm_unpacklo_epi16(y, cr);
+      const __m128i yCrHi = _mm_unpackhi_epi16(y, cr);
+      const __m128i yCbLo = _mm_unpacklo_epi16(y, cb);
+      const __m128i yCbHi = _mm_unpackhi_epi16(y, cb);
+      const __m128i cbLo = _mm_unpacklo_epi16(cb, zero);
+      const __m128i cbHi = _mm_unpackhi_epi16(cb, zero);
+
+      const __m128i r = _mm_packs_epi32
+        (_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yCrLo, yCrToR), round), 12),
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yCrHi, yCrToR), round), 12));
+      const __m128i g = _mm_packs_epi32
+        (_mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yCrLo, yCrToG),
+                                                    _mm_madd_epi16(cbLo, cbToGOnly)), round), 12),
+         _mm_srai_epi32(_mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(yCrHi, yCrToG),
+                                                    _mm_madd_epi16(cbHi, cbToGOnly)), round), 12));
+      const __m128i b = _mm_packs_epi32
+        (_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yCbLo, yCbToB), round), 12),
+         _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yCbHi, yCbToB), round), 12));
+
+      // saturating to bytes is the clamp
+      const __m128i rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+      const __m128i ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), alpha);
+
+      __m128i* out = reinterpret_cast<__m128i*>(a_out + x * 4);
+      _mm_storeu_si128(out, _mm_unpacklo_epi16(rg, ba));
+      _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rg, ba));
+    }
+#endif
+
+    for (; x < a_width; ++x)
+    {
+      const s32 y = (a_y[x] << 20) + (1 << 19);
+      const s32 cb = a_cb[x] - 128;
+      const s32 cr = a_cr[x] - 128;
+
+      a_out[x * 4 + 0] = DoClampByte((y + cr * crToR) >> 20);
+      a_out[x * 4 + 1] = DoClampByte((y + cr * crToG + cb * cbToG) >> 20);
+      a_out[x * 4 + 2] = DoClampByte((y + cb * cbToB) >> 20);
+      a_out[x * 4 + 3] = 255;
+    }
+  }
+
+  void  DoConvert(const JpegDecoder& a_dec, DecodedImage& a_out)
+  {
+    const tl_int width = a_dec.m_width;
+
+    a_out.m_width = width;
+    a_out.m_height = a_dec.m_height;
+    a_out.m_pixels.resize((tl_size)width * a_dec.m_height * 4);
+
+    // the widest upsampled row of a component
+    tl_core_conts::Array<u8> buffers;
+    buffers.resize((tl_size)a_dec.m_mcusX * a_dec.m_maxH * 8 * g_maxComponents);
+    const tl_size bufferSize = buffers.size() / g_maxComponents;
+
+    tl_core_conts::Array<u16> column;
+    column.resize(bufferSize);
+
+    for (tl_int y = 0; y < a_dec.m_height; ++y)
+    {
+      u8* out = &a_out.m_pixels[(tl_size)y * width * 4];
+
+      if (a_dec.m_numComponents == 1)
+      {
+        const JpegComponent& comp = a_dec.m_components[0];
+        const u8* gray = &comp.m_plane[(tl_size)y * comp.m_stride];
+        for (tl_int x = 0; x < width; ++x)
+        {
+          out[x * 4 + 0] = out[x * 4 + 1] = out[x * 4 + 2] = gray[x];
+          out[x * 4 + 3] = 255;
+        }
+        continue;
+      }
+
+      const u8* rows[g_maxComponents];
+      for (tl_int i = 0; i < g_maxComponents; ++i)
+      {
+        rows[i] = DoGetUpsampledRow(a_dec, a_dec.m_components[i], y,
+                                    &buffers[bufferSize * i], &column[0]);
+      }
+
+      DoConvertYCbCr(rows[0], rows[1], rows[2], width, out);
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// DecodeJpeg
+
+bool
+  DecodeJpeg(const u8* a_data, tl_size a_size, DecodedImage& a_out)
+{
+  a_out.Clear();
+
+  if (a_size < 4 || a_data[0] != 0xFF || a_data[1] != 0xD8)
+  { return false; }
+
+  JpegDecoder dec;
+  bool        hasFrame = false;
+  bool        hasScan = false;
+
+  const u8* it = a_data + 2;
+  const u8* end = a_data + a_size;
+  while (true)
+  {
+    // markers may be preceded by any number of 0xFF, anything else between
+    // segments (e.g. after the last restart interval) is skipped
+    while (it + 1 < end && (it[0] != 0xFF || it[1] == 0 || it[1] == 0xFF ||
+                            (it[1] >= 0xD0 && it[1] <= 0xD7)))
+    { ++it; }
+
+    if (it + 1 >= end)
+    { break; }
+
+    const u8 marker = it[1];
+    it += 2;
+
+    if (marker == 0xD9)
+    { break; }    // EOI
+
+    if (end - it < 2)
+    { return false; }
+
+    const tl_size length = DoReadU16(it);
+    if (length < 2 || length > (tl_size)(end - it))
+    { return false; }
+
+    const u8*     data = it + 2;
+    const tl_size size = length - 2;
+    it += length;
+
+    switch (marker)
+    {
+    case 0xC0:    // baseline
+    case 0xC1:    // extended sequential, Huffman coded
+      if (hasFrame || DoReadFrame(dec, data, size) == false)
+      { return false; }
+      hasFrame = true;
+      break;
+
+    case 0xC4:
+      if (DoReadHuffmanTables(dec, data, size) == false)
+      { return false; }
+      break;
+
+    case 0xDB:
+      if (DoReadQuantTables(dec, data, size) == false)
+      { return false; }
+      break;
+
+    case 0xDD:
+      if (size < 2)
+      { return false; }
+      dec.m_restartInterval = (tl_int)DoReadU16(data);
+      break;
+
+    case 0xDA:
+      if (hasFrame == false)
+      { return false; }
+
+      it = DoDecodeScan(dec, data, size, end);
+      if (it == nullptr)
+      { return false; }
+      hasScan = true;
+      break;
+
+    default:
+      // progressive, lossless, hierarchical and arithmetic coded frames
+      if (marker >= 0xC2 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 &&
+          marker != 0xCC)
+      { return false; }
+      break;      // APPn, COM, DAC etc.
+    }
+  }
+
+  if (hasScan == false)
+  { return false; }
+
+  DoConvert(dec, a_out);
+  return true;
+}
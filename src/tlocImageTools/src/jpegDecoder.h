@@ -0,0 +1,23 @@
+#ifndef _TLOC_IMAGE_TOOLS_JPEG_DECODER_H_
+#define _TLOC_IMAGE_TOOLS_JPEG_DECODER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "imageDecoder.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Decodes a baseline (or extended sequential, 8 bit) JPEG with one (gray)
+// or three (YCbCr) components to 8 bit RGBA. Any sampling factors and
+// restart intervals are supported, progressive and arithmetic coded images
+// are not (DecodeImageFile() loads them with gfx_med::ImageLoaderJpeg).
+//
+// The IDCT is the integer one of the IJG library (jidctint.c). 2x1 and 2x2
+// subsampled chroma is upsampled with the same triangle filter libjpeg
+// uses ("fancy upsampling"), other factors replicate samples. With SSE2
+// the IDCT transforms the 8 columns and then the 8 rows of a block at once
+// and the color conversion runs 8 pixels at a time, both with the same
+// results as the scalar code.
+
+bool  DecodeJpeg(const u8* a_data, tl_size a_size, DecodedImage& a_out);
+
+#endif
@@ -0,0 +1,558 @@
+#include "pngDecoder.h"
+
+#include "inflate.h"
+
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+    (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TLOC_IMAGE_TOOLS_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tloc;
+
+namespace {
+
+  enum { k_gray = 0, k_rgb = 2, k_palette = 3, k_grayAlpha = 4, k_rgba = 6 };
+
+  enum { k_filterNone, k_filterSub, k_filterUp, k_filterAverage, k_filterPaeth };
+
+  const u8      g_signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+  // larger images are rejected rather than risking overflows
+  const tl_int  g_maxDimension = 1 << 15;
+
+  struct PngHeader
+  {
+    tl_int  m_width;
+    tl_int  m_height;
+    tl_int  m_depth;
+    tl_int  m_colorType;
+    tl_int  m_interlace;
+  };
+
+  // palette and tRNS, as RGBA
+  struct PngColors
+  {
+    u8      m_palette[256 * 4];
+    tl_int  m_numPaletteEntries;
+
+    bool    m_hasKey;             // tRNS of gray and RGB images
+    u16     m_key[3];
+  };
+
+  u32   DoReadU32(const u8* a_data)
+  {
+    return (u32)a_data[0] << 24 | (u32)a_data[1] << 16 |
+           (u32)a_data[2] << 8 | a_data[3];
+  }
+
+  tl_int  DoGetNumChannels(tl_int a_colorType)
+  {
+    switch (a_colorType)
+    {
+    case k_gray:      return 1;
+    case k_rgb:       return 3;
+    case k_palette:   return 1;
+    case k_grayAlpha: return 2;
+    case k_rgba:      return 4;
+    default:          return 0;
+    }
+  }
+
+  bool  DoIsValidDepth(tl_int a_colorType, tl_int a_depth)
+  {
+    switch (a_colorType)
+    {
+    case k_gray:
+      return a_depth == 1 || a_depth == 2 || a_depth == 4 || a_depth == 8 ||
+             a_depth == 16;
+    case k_palette:
+      return a_depth == 1 || a_depth == 2 || a_depth == 4 || a_depth == 8;
+    case k_rgb:
+    case k_grayAlpha:
+    case k_rgba:
+      return a_depth == 8 || a_depth == 16;
+    default:
+      return false;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Filters. a_prev is the unfiltered row above (zeros for the first row).
+
+  void  DoUnfilterSub(u8* a_row, tl_size a_rowBytes, tl_int a_bpp)
+  {
+    for (tl_size i = a_bpp; i < a_rowBytes; ++i)
+    { a_row[i] = (u8)(a_row[i] + a_row[i - a_bpp]); }
+  }
+
+  void  DoUnfilterUp(u8* a_row, const u8* a_prev, tl_size a_rowBytes)
+  {
+    for (tl_size i = 0; i < a_rowBytes; ++i)
+    { a_row[i] = (u8)(a_row[i] + a_prev[i]); }
+  }
+
+  void  DoUnfilterAverage(u8* a_row, const u8* a_prev, tl_size a_rowBytes,
+                          tl_int a_bpp)
+  {
+    for (tl_int i = 0; i < a_bpp; ++i)
+    { a_row[i] = (u8)(a_row[i] + (a_prev[i] >> 1)); }
+
+    for (tl_size i = a_bpp; i < a_rowBytes; ++i)
+    { a_row[i] = (u8)(a_row[i] + ((a_row[i - a_bpp] + a_prev[i]) >> 1)); }
+  }
+
+  u8    DoPaeth(s32 a_left, s32 a_up, s32 a_upLeft)
+  {
+    const s32 pa = a_up - a_upLeft;
+    const s32 pb = a_left - a_upLeft;
+    const s32 pc = pa + pb;
+
+    const s32 absA = pa < 0 ? -pa : pa;
+    const s32 absB = pb < 0 ? -pb : pb;
+    const s32 absC = pc < 0 ? -pc : pc;
+
+    if (absA <= absB && absA <= absC)
+    { return (u8)a_left; }
+    return (u8)(absB <= absC ? a_up : a_upLeft);
+  }
+
+  void  DoUnfilterPaeth(u8* a_row, const u8* a_prev, tl_size a_rowBytes,
+                        tl_int a_bpp)
+  {
+    for (tl_int i = 0; i < a_bpp; ++i)
+    { a_row[i] = (u8)(a_row[i] + a_prev[i]); }
+
+    for (tl_size i = a_bpp; i < a_rowBytes; ++i)
+    {
+      a_row[i] = (u8)(a_row[i] +
+        DoPaeth(a_row[i - a_bpp], a_prev[i], a_prev[i - a_bpp]));
+    }
+  }
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+
+  // -----------------------------------------------------------------------
+  // The same filters for 3 and 4 byte pixels, a pixel at a time in the low
+  // lanes of a register.
+
+  template <tl_int T_bpp>
+  __m128i DoLoadPixel(const u8* a_pixel)
+  {
+    s32 value = 0;
+    memcpy(&value, a_pixel, T_bpp);
+    return _mm_cvtsi32_si128(value);
+  }
+
+  template <tl_int T_bpp>
+  void  DoStorePixel(u8* a_pixel, __m128i a_value)
+  {
+    const s32 value = _mm_cvtsi128_si32(a_value);
+    memcpy(a_pixel, &value, T_bpp);
+  }
+
+  __m128i DoSelect(__m128i a_mask, __m128i a_ifTrue, __m128i a_ifFalse)
+  {
+    return _mm_or_si128(_mm_and_si128(a_mask, a_ifTrue),
+                        _mm_andnot_si128(a_mask, a_ifFalse));
+  }
+
+  __m128i DoAbs16(__m128i a_value)
+  { return _mm_max_epi16(a_value, _mm_sub_epi16(_mm_setzero_si128(), a_value)); }
+
+  template <tl_int T_bpp>
+  void  DoUnfilterSubSSE2(u8* a_row, tl_size a_rowBytes)
+  {
+    __m128i left = _mm_setzero_si128();
+    for (tl_size i = 0; i < a_rowBytes; i += T_bpp)
+    {
+      left = _mm_add_epi8(left, DoLoadPixel<T_bpp>(a_row + i));
+      DoStorePixel<T_bpp>(a_row + i, left);
+    }
+  }
+
+  template <tl_int T_bpp>
+  void  DoUnfilterAverageSSE2(u8* a_row, const u8* a_prev, tl_size a_rowBytes)
+  {
+    const __m128i one = _mm_set1_epi8(1);
+
+    __m128i left = _mm_setzero_si128();
+    for (tl_size i = 0; i < a_rowBytes; i += T_bpp)
+    {
+      const __m128i up = DoLoadPixel<T_bpp>(a_prev + i);
+
+      // _mm_avg_epu8 rounds up, the filter rounds down
+      __m128i average = _mm_avg_epu8(left, up);
+      average = _mm_sub_epi8(average,
+        _mm_and_si128(_mm_xor_si128(left, up), one));
+
+      left = _mm_add_epi8(DoLoadPixel<T_bpp>(a_row + i), average);
+      DoStorePixel<T_bpp>(a_row + i, left);
+    }
+  }
+
+  template <tl_int T_bpp>
+  void  DoUnfilterPaethSSE2(u8* a_row, const u8* a_prev, tl_size a_rowBytes)
+  {
+    const __m128i zero = _mm_setzero_si128();
+
+    // 16 bit lanes, the predictor differences need 9 bits and a sign
+    __m128i left = zero;
+    __m128i upLeft = zero;
+    for (tl_size i = 0; i < a_rowBytes; i += T_bpp)
+    {
+      const __m128i up =
+        _mm_unpacklo_epi8(DoLoadPixel<T_bpp>(a_prev + i), zero);
+
+      const __m128i pa = _mm_sub_epi16(up, upLeft);
+      const __m128i pb = _mm_sub_epi16(left, upLeft);
+      const __m128i pc = _mm_add_epi16(pa, pb);
+
+      const __m128i absA = DoAbs16(pa);
+      const __m128i absB = DoAbs16(pb);
+      const __m128i absC = DoAbs16(pc);
+
+      const __m128i smallest = _mm_min_epi16(absC, _mm_min_epi16(absA, absB));
+
+      const __m128i predictor =
+        DoSelect(_mm_cmpeq_epi16(smallest, absA), left,
+                 DoSelect(_mm_cmpeq_epi16(smallest, absB), up, upLeft));
+
+      const __m128i value = _mm_add_epi8(DoLoadPixel<T_bpp>(a_row + i),
+        _mm_packus_epi16(predictor, predictor));
+      DoStorePixel<T_bpp>(a_row + i, value);
+
+      left = _mm_unpacklo_epi8(value, zero);
+      upLeft = up;
+    }
+  }
+
+#endif
+
+  bool  DoUnfilterRow(tl_int a_filter, u8* a_row, const u8* a_prev,
+                      tl_size a_rowBytes, tl_int a_bpp)
+  {
+    switch (a_filter)
+    {
+    case k_filterNone:
+      return true;
+
+    case k_filterUp:
+      DoUnfilterUp(a_row, a_prev, a_rowBytes);
+      return true;
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+    case k_filterSub:
+      if (a_bpp == 4) { DoUnfilterSubSSE2<4>(a_row, a_rowBytes); }
+      else if (a_bpp == 3) { DoUnfilterSubSSE2<3>(a_row, a_rowBytes); }
+      else { DoUnfilterSub(a_row, a_rowBytes, a_bpp); }
+      return true;
+
+    case k_filterAverage:
+      if (a_bpp == 4) { DoUnfilterAverageSSE2<4>(a_row, a_prev, a_rowBytes); }
+      else if (a_bpp == 3) { DoUnfilterAverageSSE2<3>(a_row, a_prev, a_rowBytes); }
+      else { DoUnfilterAverage(a_row, a_prev, a_rowBytes, a_bpp); }
+      return true;
+
+    case k_filterPaeth:
+      if (a_bpp == 4) { DoUnfilterPaethSSE2<4>(a_row, a_prev, a_rowBytes); }
+      else if (a_bpp == 3) { DoUnfilterPaethSSE2<3>(a_row, a_prev, a_rowBytes); }
+      else { DoUnfilterPaeth(a_row, a_prev, a_rowBytes, a_bpp); }
+      return true;
+#else
+    case k_filterSub:
+      DoUnfilterSub(a_row, a_rowBytes, a_bpp);
+      return true;
+
+    case k_filterAverage:
+      DoUnfilterAverage(a_row, a_prev, a_rowBytes, a_bpp);
+      return true;
+
+    case k_filterPaeth:
+      DoUnfilterPaeth(a_row, a_prev, a_rowBytes, a_bpp);
+      return true;
+#endif
+
+    default:
+      return false;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Conversion of an unfiltered row to RGBA
+
+  u32   DoGetSample(const u8* a_row, tl_int a_index, tl_int a_depth)
+  {
+    if (a_depth == 16)
+    { return (u32)a_row[a_index * 2] << 8 | a_row[a_index * 2 + 1]; }
+    if (a_depth == 8)
+    { return a_row[a_index]; }
+
+    const tl_int  bit = a_index * a_depth;
+    const u32     mask = (1u << a_depth) - 1;
+    return (a_row[bit >> 3] >> (8 - a_depth - (bit & 7))) & mask;
+  }
+
+  u8    DoScaleSample(u32 a_sample, tl_int a_depth)
+  {
+    switch (a_depth)
+    {
+    case 1:   return (u8)(a_sample * 255);
+    case 2:   return (u8)(a_sample * 85);
+    case 4:   return (u8)(a_sample * 17);
+    case 16:  return (u8)(a_sample >> 8);
+    default:  return (u8)a_sample;
+    }
+  }
+
+  void  DoConvertRow(const u8* a_row, const PngHeader& a_header,
+                     const PngColors& a_colors, u8* a_out)
+  {
+    const tl_int width = a_header.m_width;
+    const tl_int depth = a_header.m_depth;
+
+    // the common cases first
+    if (depth == 8 && a_colors.m_hasKey == false)
+    {
+      switch (a_header.m_colorType)
+      {
+      case k_rgba:
+        memcpy(a_out, a_row, width * 4);
+        return;
+
+      case k_rgb:
+        for (tl_int x = 0; x < width; ++x)
+        {
+          a_out[x * 4 + 0] = a_row[x * 3 + 0];
+          a_out[x * 4 + 1] = a_row[x * 3 + 1];
+          a_out[x * 4 + 2] = a_row[x * 3 + 2];
+          a_out[x * 4 + 3] = 255;
+        }
+        return;
+
+      case k_gray:
+        for (tl_int x = 0; x < width; ++x)
+        {
+          a_out[x * 4 + 0] = a_row[x];
+          a_out[x * 4 + 1] = a_row[x];
+          a_out[x * 4 + 2] = a_row[x];
+          a_out[x * 4 + 3] = 255;
+        }
+        return;
+
+      case k_grayAlpha:
+        for (tl_int x = 0; x < width; ++x)
+        {
+          a_out[x * 4 + 0] = a_row[x * 2];
+          a_out[x * 4 + 1] = a_row[x * 2];
+          a_out[x * 4 + 2] = a_row[x * 2];
+          a_out[x * 4 + 3] = a_row[x * 2 + 1];
+        }
+        return;
+
+      default:
+        break;
+      }
+    }
+
+    const tl_int numChannels = DoGetNumChannels(a_header.m_colorType);
+
+    for (tl_int x = 0; x < width; ++x)
+    {
+      u8* out = a_out + x * 4;
+
+      u32 samples[4];
+      for (tl_int c = 0; c < numChannels; ++c)
+      { samples[c] = DoGetSample(a_row, x * numChannels + c, depth); }
+
+      switch (a_header.m_colorType)
+      {
+      case k_palette:
+        // out of range indices are black, like most decoders
+        if ((tl_int)samples[0] < a_colors.m_numPaletteEntries)
+        { memcpy(out, a_colors.m_palette + samples[0] * 4, 4); }
+        else
+        { out[0] = out[1] = out[2] = 0; out[3] = 255; }
+        break;
+
+      case k_gray:
+        out[0] = out[1] = out[2] = DoScaleSample(samples[0], depth);
+        out[3] = a_colors.m_hasKey && samples[0] == a_colors.m_key[0] ? 0 : 255;
+        break;
+
+      case k_grayAlpha:
+        out[0] = out[1] = out[2] = DoScaleSample(samples[0], depth);
+        out[3] = DoScaleSample(samples[1], depth);
+        break;
+
+      case k_rgb:
+        for (tl_int c = 0; c < 3; ++c)
+        { out[c] = DoScaleSample(samples[c], depth); }
+        out[3] = a_colors.m_hasKey && samples[0] == a_colors.m_key[0] &&
+          samples[1] == a_colors.m_key[1] && samples[2] == a_colors.m_key[2]
+          ? 0 : 255;
+        break;
+
+      case k_rgba:
+        for (tl_int c = 0; c < 4; ++c)
+        { out[c] = DoScaleSample(samples[c], depth); }
+        break;
+      }
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// DecodePng
+
+bool
+  DecodePng(const u8* a_data, tl_size a_size, DecodedImage& a_out)
+{
+  a_out.Clear();
+
+  if (a_size < 8 || memcmp(a_data, g_signature, 8) != 0)
+  { return false; }
+
+  PngHeader header;
+  memset(&header, 0, sizeof(header));
+
+  PngColors colors;
+  memset(&colors, 0, sizeof(colors));
+
+  tl_core_conts::Array<u8> compressed;
+
+  bool hasHeader = false;
+  bool hasEnd = false;
+
+  const u8* it = a_data + 8;
+  const u8* end = a_data + a_size;
+  while (hasEnd == false)
+  {
+    if (end - it < 12)
+    { return false; }
+
+    const u32 length = DoReadU32(it);
+    const u8* type = it + 4;
+    const u8* data = it + 8;
+    if (length > (u32)(end - data) - 4)
+    { return false; }
+
+    it = data + length + 4;
+
+    if (memcmp(type, "IHDR", 4) == 0)
+    {
+      if (length != 13)
+      { return false; }
+
+      header.m_width = (tl_int)DoReadU32(data);
+      header.m_height = (tl_int)DoReadU32(data + 4);
+      header.m_depth = data[8];
+      header.m_colorType = data[9];
+      header.m_interlace = data[12];
+
+      // compression and filter method 0 are the only ones
+      if (header.m_width <= 0 || header.m_width > g_maxDimension ||
+          header.m_height <= 0 || header.m_height > g_maxDimension ||
+          DoIsValidDepth(header.m_colorType, header.m_depth) == false ||
+          data[10] != 0 || data[11] != 0)
+      { return false; }
+
+      // Adam7 is not supported
+      if (header.m_interlace != 0)
+      { return false; }
+
+      hasHeader = true;
+    }
+    else if (hasHeader == false)
+    { return false; }
+    else if (memcmp(type, "PLTE", 4) == 0)
+    {
+      if (length % 3 != 0 || length > 256 * 3)
+      { return false; }
+
+      colors.m_numPaletteEntries = (tl_int)length / 3;
+      for (tl_int i = 0; i < colors.m_numPaletteEntries; ++i)
+      {
+        colors.m_palette[i * 4 + 0] = data[i * 3 + 0];
+        colors.m_palette[i * 4 + 1] = data[i * 3 + 1];
+        colors.m_palette[i * 4 + 2] = data[i * 3 + 2];
+        colors.m_palette[i * 4 + 3] = 255;
+      }
+    }
+    else if (memcmp(type, "tRNS", 4) == 0)
+    {
+      if (header.m_colorType == k_palette)
+      {
+        for (u32 i = 0; i < length && i < 256; ++i)
+        { colors.m_palette[i * 4 + 3] = data[i]; }
+      }
+      else if (header.m_colorType == k_gray && length == 2)
+      {
+        colors.m_hasKey = true;
+        colors.m_key[0] = (u16)(data[0] << 8 | data[1]);
+      }
+      else if (header.m_colorType == k_rgb && length == 6)
+      {
+        colors.m_hasKey = true;
+        for (tl_int c = 0; c < 3; ++c)
+        { colors.m_key[c] = (u16)(data[c * 2] << 8 | data[c * 2 + 1]); }
+      }
+    }
+    else if (memcmp(type, "IDAT", 4) == 0)
+    {
+      const tl_size offset = compressed.size();
+      compressed.resize(offset + length);
+      if (length > 0)
+      { memcpy(&compressed[offset], data, length); }
+    }
+    else if (memcmp(type, "IEND", 4) == 0)
+    { hasEnd = true; }
+    else if ((type[0] & 0x20) == 0)
+    { return false; } // an unknown critical chunk
+  }
+
+  if (compressed.empty() ||
+      (header.m_colorType == k_palette && colors.m_numPaletteEntries == 0))
+  { return false; }
+
+  const tl_int  bitsPerPixel =
+    DoGetNumChannels(header.m_colorType) * header.m_depth;
+  const tl_int  bpp = core::tlMax(bitsPerPixel / 8, 1);
+  const tl_size rowBytes = ((tl_size)header.m_width * bitsPerPixel + 7) / 8;
+  const tl_size filteredSize = (rowBytes + 1) * header.m_height;
+
+  tl_core_conts::Array<u8> filtered;
+  if (Inflate(&compressed[0], compressed.size(), filtered, filteredSize) == false ||
+      filtered.size() < filteredSize)
+  { return false; }
+
+  compressed.clear();
+
+  a_out.m_width = header.m_width;
+  a_out.m_height = header.m_height;
+  a_out.m_pixels.resize((tl_size)header.m_width * header.m_height * 4);
+
+  // each row is unfiltered in place, after its filter byte
+  tl_core_conts::Array<u8> zeros;
+  zeros.resize(rowBytes, 0);
+  const u8* prev = &zeros[0];
+
+  for (tl_int y = 0; y < header.m_height; ++y)
+  {
+    u8* row = &filtered[y * (rowBytes + 1)];
+    if (DoUnfilterRow(row[0], row + 1, prev, rowBytes, bpp) == false)
+    {
+      a_out.Clear();
+      return false;
+    }
+
+    DoConvertRow(row + 1, header, colors,
+                 &a_out.m_pixels[(tl_size)y * header.m_width * 4]);
+    prev = row + 1;
+  }
+
+  return true;
+}
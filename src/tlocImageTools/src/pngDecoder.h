@@ -0,0 +1,21 @@
+#ifndef _TLOC_IMAGE_TOOLS_PNG_DECODER_H_
+#define _TLOC_IMAGE_TOOLS_PNG_DECODER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "imageDecoder.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Decodes a non-interlaced PNG of any color type and bit depth to 8 bit
+// RGBA. 16 bit samples keep their high byte, low bit depths are scaled to
+// 0-255, tRNS becomes the alpha channel. Chunk CRCs are not checked, the
+// image data is (through its Adler-32). Interlaced images are refused,
+// DecodeImageFile() loads them with gfx_med::ImageLoaderPng.
+//
+// The row filters of 3 and 4 byte pixels are undone with SSE2 (one pixel
+// per instruction, the filters depend on the pixel to the left), Up is a
+// plain loop the compiler vectorizes.
+
+bool  DecodePng(const u8* a_data, tl_size a_size, DecodedImage& a_out);
+
+#endif
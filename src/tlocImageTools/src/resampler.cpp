@@ -0,0 +1,615 @@
+#include "resampler.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+    (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TLOC_IMAGE_TOOLS_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// PixelFormat
+
+PixelFormat::
+  PixelFormat(tl_int a_numChannels, tl_int a_bytesPerChannel, bool a_srgb)
+  : m_numChannels(a_numChannels)
+  , m_bytesPerChannel(a_bytesPerChannel)
+  , m_srgb(a_srgb)
+{ }
+
+// -----------------------------------------------------------------------
+
+tl_size
+PixelFormat::
+  GetPixelSize() const
+{ return (tl_size)(m_numChannels * m_bytesPerChannel); }
+
+// -----------------------------------------------------------------------
+
+bool
+PixelFormat::
+  HasAlpha() const
+{ return m_numChannels == 4; }
+
+// ///////////////////////////////////////////////////////////////////////
+// ResampleSettings
+
+ResampleSettings::
+  ResampleSettings()
+  : m_filter(k_filterKaiser)
+  , m_wrap(false)
+  , m_numThreads(1)
+{ }
+
+// ///////////////////////////////////////////////////////////////////////
+// Filtering
+
+namespace {
+
+  const f32 g_pi = 3.14159265358979f;
+
+  const f32 g_boxWidth = 0.5f;
+  const f32 g_kaiserWidth = 3.0f;
+  const f32 g_kaiserAlpha = 4.0f;
+  const f32 g_lanczosWidth = 3.0f;
+
+  f32   DoSinc(f32 a_x)
+  {
+    if (fabsf(a_x) < 1e-6f)
+    { return 1.0f; }
+
+    const f32 x = a_x * g_pi;
+    return sinf(x) / x;
+  }
+
+  // modified Bessel function of the first kind, order 0
+  f32   DoBessel0(f32 a_x)
+  {
+    f32 sum = 1.0f;
+    f32 term = 1.0f;
+    const f32 halfX = a_x * 0.5f;
+
+    for (tl_int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+    {
+      const f32 factor = halfX / (f32)k;
+      term *= factor * factor;
+      sum += term;
+    }
+    return sum;
+  }
+
+  f32   DoGetFilterWidth(resample_filter a_filter)
+  {
+    switch (a_filter)
+    {
+    case k_filterBox:     return g_boxWidth;
+    case k_filterKaiser:  return g_kaiserWidth;
+    default:              return g_lanczosWidth;
+    }
+  }
+
+  f32   DoEvaluateFilter(resample_filter a_filter, f32 a_x)
+  {
+    const f32 x = fabsf(a_x);
+
+    switch (a_filter)
+    {
+    case k_filterBox:
+      return x <= g_boxWidth ? 1.0f : 0.0f;
+
+    case k_filterKaiser:
+      {
+        if (x >= g_kaiserWidth)
+        { return 0.0f; }
+
+        const f32 t = x / g_kaiserWidth;
+        return DoSinc(x) * DoBessel0(g_kaiserAlpha * sqrtf(1.0f - t * t)) /
+               DoBessel0(g_kaiserAlpha);
+      }
+
+    default:
+      return x < g_lanczosWidth ? DoSinc(x) * DoSinc(x / g_lanczosWidth) : 0.0f;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Source pixels (and their weights) of each target pixel along one axis.
+  // Every target pixel has m_numTaps of them, unused ones have a weight of
+  // 0.
+
+  struct FilterTaps
+  {
+    tl_int                    m_numTaps;
+    tl_core_conts::Array<s32> m_indices;
+    tl_core_conts::Array<f32> m_weights;
+  };
+
+  void  DoGetTaps(tl_int a_srcSize, tl_int a_dstSize,
+                  const ResampleSettings& a_settings, FilterTaps& a_out)
+  {
+    // when downsampling the filter is stretched to the size of the target
+    // pixels
+    const f32 scale = (f32)a_dstSize / (f32)a_srcSize;
+    const f32 filterScale = core::tlMin(scale, 1.0f);
+    const f32 radius = DoGetFilterWidth(a_settings.m_filter) / filterScale;
+
+    a_out.m_numTaps = (tl_int)ceilf(radius * 2.0f) + 1;
+    a_out.m_indices.clear();
+    a_out.m_indices.resize((tl_size)a_dstSize * a_out.m_numTaps, 0);
+    a_out.m_weights.clear();
+    a_out.m_weights.resize((tl_size)a_dstSize * a_out.m_numTaps, 0.0f);
+
+    for (tl_int i = 0; i < a_dstSize; ++i)
+    {
+      s32* indices = &a_out.m_indices[(tl_size)i * a_out.m_numTaps];
+      f32* weights = &a_out.m_weights[(tl_size)i * a_out.m_numTaps];
+
+      const f32     center = ((f32)i + 0.5f) / scale - 0.5f;
+      const tl_int  first = (tl_int)ceilf(center - radius);
+      const tl_int  last = (tl_int)floorf(center + radius);
+
+      f32     sum = 0.0f;
+      tl_int  numTaps = 0;
+      for (tl_int j = first; j <= last && numTaps < a_out.m_numTaps; ++j)
+      {
+        const f32 weight =
+          DoEvaluateFilter(a_settings.m_filter, ((f32)j - center) * filterScale);
+        if (weight == 0.0f)
+        { continue; }
+
+        tl_int index = core::Clamp(j, 0, a_srcSize - 1);
+        if (a_settings.m_wrap)
+        { index = ((j % a_srcSize) + a_srcSize) % a_srcSize; }
+
+        indices[numTaps] = (s32)index;
+        weights[numTaps] = weight;
+        sum += weight;
+        ++numTaps;
+      }
+
+      if (fabsf(sum) > 1e-6f)
+      {
+        for (tl_int j = 0; j < numTaps; ++j)
+        { weights[j] /= sum; }
+      }
+      else
+      {
+        // nothing under the filter, the closest pixel
+        for (tl_int j = 0; j < numTaps; ++j)
+        { weights[j] = 0.0f; }
+
+        indices[0] = (s32)core::Clamp((tl_int)floorf(center + 0.5f), 0,
+                                      a_srcSize - 1);
+        weights[0] = 1.0f;
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Linear, alpha weighted pixels
+
+  struct FloatImage
+  {
+    void  Resize(tl_int a_width, tl_int a_height, tl_int a_numChannels)
+    {
+      m_width = a_width;
+      m_height = a_height;
+      m_numChannels = a_numChannels;
+      m_pixels.resize((tl_size)a_width * a_height * a_numChannels);
+    }
+
+    f32*        GetRow(tl_int a_y)
+    { return &m_pixels[(tl_size)a_y * m_width * m_numChannels]; }
+    const f32*  GetRow(tl_int a_y) const
+    { return &m_pixels[(tl_size)a_y * m_width * m_numChannels]; }
+
+    tl_int                    m_width;
+    tl_int                    m_height;
+    tl_int                    m_numChannels;
+    tl_core_conts::Array<f32> m_pixels;
+  };
+
+  // a_out = sum of the source pixels of each target pixel in the row
+  void  DoFilterRow(const f32* a_in, const FilterTaps& a_taps, tl_int a_width,
+                    tl_int a_numChannels, f32* a_out)
+  {
+    const tl_int numTaps = a_taps.m_numTaps;
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+    if (a_numChannels == 4)
+    {
+      for (tl_int x = 0; x < a_width; ++x)
+      {
+        const s32* indices = &a_taps.m_indices[(tl_size)x * numTaps];
+        const f32* weights = &a_taps.m_weights[(tl_size)x * numTaps];
+
+        __m128 sum = _mm_setzero_ps();
+        for (tl_int i = 0; i < numTaps; ++i)
+        {
+          sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[i]),
+                                           _mm_loadu_ps(a_in + indices[i] * 4)));
+        }
+        _mm_storeu_ps(a_out + x * 4, sum);
+      }
+      return;
+    }
+#endif
+
+    for (tl_int x = 0; x < a_width; ++x)
+    {
+      const s32* indices = &a_taps.m_indices[(tl_size)x * numTaps];
+      const f32* weights = &a_taps.m_weights[(tl_size)x * numTaps];
+
+      for (tl_int c = 0; c < a_numChannels; ++c)
+      {
+        f32 sum = 0.0f;
+        for (tl_int i = 0; i < numTaps; ++i)
+        { sum += weights[i] * a_in[indices[i] * a_numChannels + c]; }
+        a_out[x * a_numChannels + c] = sum;
+      }
+    }
+  }
+
+  // a_out += a_in * a_weight, for a whole row
+  void  DoAddScaledRow(const f32* a_in, f32 a_weight, tl_size a_size, f32* a_out)
+  {
+    tl_size i = 0;
+
+#if defined (TLOC_IMAGE_TOOLS_SSE2)
+    const __m128 weight = _mm_set1_ps(a_weight);
+    for (; i + 4 <= a_size; i += 4)
+    {
+      _mm_storeu_ps(a_out + i, _mm_add_ps(_mm_loadu_ps(a_out + i),
+        _mm_mul_ps(weight, _mm_loadu_ps(a_in + i))));
+    }
+#endif
+
+    for (; i < a_size; ++i)
+    { a_out[i] += a_in[i] * a_weight; }
+  }
+
+  // horizontally into a_temp, then vertically into a_out
+  void  DoResample(const FloatImage& a_in, tl_int a_width, tl_int a_height,
+                   const ResampleSettings& a_settings, FloatImage& a_temp,
+                   FloatImage& a_out)
+  {
+    const tl_int numThreads = core::tlMax(a_settings.m_numThreads, 1);
+    const tl_int numChannels = a_in.m_numChannels;
+
+    FilterTaps taps;
+    DoGetTaps(a_in.m_width, a_width, a_settings, taps);
+
+    a_temp.Resize(a_width, a_in.m_height, numChannels);
+
+#pragma omp parallel for num_threads(numThreads)
+    for (int y = 0; y < a_in.m_height; ++y)
+    { DoFilterRow(a_in.GetRow(y), taps, a_width, numChannels, a_temp.GetRow(y)); }
+
+    DoGetTaps(a_in.m_height, a_height, a_settings, taps);
+
+    a_out.Resize(a_width, a_height, numChannels);
+    const tl_size rowSize = (tl_size)a_width * numChannels;
+
+#pragma omp parallel for num_threads(numThreads)
+    for (int y = 0; y < a_height; ++y)
+    {
+      const s32* indices = &taps.m_indices[(tl_size)y * taps.m_numTaps];
+      const f32* weights = &taps.m_weights[(tl_size)y * taps.m_numTaps];
+
+      f32* out = a_out.GetRow(y);
+      memset(out, 0, rowSize * sizeof(f32));
+
+      for (tl_int i = 0; i < taps.m_numTaps; ++i)
+      {
+        if (weights[i] != 0.0f)
+        { DoAddScaledRow(a_temp.GetRow(indices[i]), weights[i], rowSize, out); }
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Conversion
+
+  f32   DoSrgbToLinear(f32 a_value)
+  {
+    return a_value <= 0.04045f ? a_value / 12.92f
+                               : powf((a_value + 0.055f) / 1.055f, 2.4f);
+  }
+
+  f32   DoLinearToSrgb(f32 a_value)
+  {
+    return a_value <= 0.0031308f ? a_value * 12.92f
+                                 : 1.055f * powf(a_value, 1.0f / 2.4f) - 0.055f;
+  }
+
+  // 8 bit sRGB values in linear space, and the linear values half way
+  // between two of them. Rounding back starts at the value of a bucket of
+  // linear values, which is at most one below the result.
+  const tl_int g_numSrgbBuckets = 4096;
+
+  struct SrgbTables
+  {
+    SrgbTables()
+    {
+      for (tl_int i = 0; i < 256; ++i)
+      { m_toLinear[i] = DoSrgbToLinear((f32)i / 255.0f); }
+
+      for (tl_int i = 0; i < 255; ++i)
+      { m_thresholds[i] = DoSrgbToLinear(((f32)i + 0.5f) / 255.0f); }
+      m_thresholds[255] = 2.0f;
+
+      u8 value = 0;
+      for (tl_int i = 0; i < g_numSrgbBuckets; ++i)
+      {
+        const f32 linear = (f32)i / (f32)(g_numSrgbBuckets - 1);
+        while (linear > m_thresholds[value])
+        { ++value; }
+        m_buckets[i] = value;
+      }
+    }
+
+    // a_linear in [0, 1]
+    u8    ToSrgb(f32 a_linear) const
+    {
+      tl_int value = m_buckets[(tl_int)(a_linear * (f32)(g_numSrgbBuckets - 1))];
+      while (a_linear > m_thresholds[value])
+      { ++value; }
+      return (u8)value;
+    }
+
+    f32   m_toLinear[256];
+    f32   m_thresholds[256];
+    u8    m_buckets[g_numSrgbBuckets];
+  };
+
+  void  DoToLinear(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                   const PixelFormat& a_format, const SrgbTables& a_tables,
+                   tl_int a_numThreads, FloatImage& a_out)
+  {
+    const tl_int  numChannels = a_format.m_numChannels;
+    const tl_int  numColors = a_format.HasAlpha() ? 3 : numChannels;
+    const tl_size rowSize = (tl_size)a_width * a_format.GetPixelSize();
+
+    // 8 bit channels are looked up, whether they are sRGB or not
+    f32 table[4][256];
+    for (tl_int c = 0; c < numChannels; ++c)
+    {
+      for (tl_int i = 0; i < 256; ++i)
+      {
+        table[c][i] = a_format.m_srgb && c < numColors
+          ? a_tables.m_toLinear[i] : (f32)i / 255.0f;
+      }
+    }
+
+    a_out.Resize(a_width, a_height, numChannels);
+
+#pragma omp parallel for num_threads(a_numThreads)
+    for (int y = 0; y < a_height; ++y)
+    {
+      const u8* row = a_pixels + y * rowSize;
+      f32*      out = a_out.GetRow(y);
+
+      if (a_format.m_bytesPerChannel == 1)
+      {
+        for (tl_int x = 0; x < a_width; ++x)
+        {
+          for (tl_int c = 0; c < numChannels; ++c)
+          { out[x * numChannels + c] = table[c][row[x * numChannels + c]]; }
+        }
+      }
+      else
+      {
+        const u16* wideRow = reinterpret_cast<const u16*>(row);
+        for (tl_int x = 0; x < a_width; ++x)
+        {
+          for (tl_int c = 0; c < numChannels; ++c)
+          {
+            const tl_int  i = x * numChannels + c;
+            const f32     value = (f32)wideRow[i] / 65535.0f;
+            out[i] = a_format.m_srgb && c < numColors
+              ? DoSrgbToLinear(value) : value;
+          }
+        }
+      }
+
+      if (a_format.HasAlpha())
+      {
+        for (tl_int x = 0; x < a_width; ++x)
+        {
+          f32* pixel = out + x * 4;
+          pixel[0] *= pixel[3];
+          pixel[1] *= pixel[3];
+          pixel[2] *= pixel[3];
+        }
+      }
+    }
+  }
+
+  void  DoFromLinear(const FloatImage& a_image, const PixelFormat& a_format,
+                     const SrgbTables& a_tables, tl_int a_numThreads, u8* a_out)
+  {
+    const tl_int  numChannels = a_format.m_numChannels;
+    const tl_int  numColors = a_format.HasAlpha() ? 3 : numChannels;
+    const bool    isSrgb = a_format.m_srgb;
+    const tl_int  width = a_image.m_width;
+    const tl_size rowSize = (tl_size)width * a_format.GetPixelSize();
+
+#pragma omp parallel for num_threads(a_numThreads)
+    for (int y = 0; y < a_image.m_height; ++y)
+    {
+      const f32*  in = a_image.GetRow(y);
+      u8*         row = a_out + y * rowSize;
+      u16*        wideRow = reinterpret_cast<u16*>(row);
+
+      for (tl_int x = 0; x < width; ++x)
+      {
+        const f32*  pixel = in + x * numChannels;
+
+        // undo the alpha weighting
+        f32 scale = 1.0f;
+        if (a_format.HasAlpha())
+        {
+          const f32 alpha = core::Clamp(pixel[3], 0.0f, 1.0f);
+          scale = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+        }
+
+        for (tl_int c = 0; c < numChannels; ++c)
+        {
+          const tl_int  i = x * numChannels + c;
+          const bool    isColor = c < numColors;
+          const f32     value =
+            core::Clamp(isColor ? pixel[c] * scale : pixel[c], 0.0f, 1.0f);
+
+          if (a_format.m_bytesPerChannel == 1)
+          {
+            row[i] = isSrgb && isColor ? a_tables.ToSrgb(value)
+                                       : (u8)(value * 255.0f + 0.5f);
+          }
+          else
+          {
+            wideRow[i] = (u16)((isSrgb && isColor ? DoLinearToSrgb(value) : value)
+                               * 65535.0f + 0.5f);
+          }
+        }
+      }
+    }
+  }
+
+  bool  DoIsValid(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                  const PixelFormat& a_format)
+  {
+    return a_pixels && a_width > 0 && a_height > 0 &&
+           a_format.m_numChannels >= 1 && a_format.m_numChannels <= 4 &&
+           (a_format.m_bytesPerChannel == 1 || a_format.m_bytesPerChannel == 2);
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// ResampleImage
+
+bool
+  ResampleImage(const u8* a_src, tl_int a_srcWidth, tl_int a_srcHeight,
+                const PixelFormat& a_format, u8* a_dst, tl_int a_dstWidth,
+                tl_int a_dstHeight, const ResampleSettings& a_settings)
+{
+  if (DoIsValid(a_src, a_srcWidth, a_srcHeight, a_format) == false ||
+      a_dst == nullptr || a_dstWidth <= 0 || a_dstHeight <= 0)
+  { return false; }
+
+  const tl_int numThreads = core::tlMax(a_settings.m_numThreads, 1);
+  const SrgbTables tables;
+
+  FloatImage src, temp, dst;
+  DoToLinear(a_src, a_srcWidth, a_srcHeight, a_format, tables, numThreads, src);
+  DoResample(src, a_dstWidth, a_dstHeight, a_settings, temp, dst);
+  DoFromLinear(dst, a_format, tables, numThreads, a_dst);
+
+  return true;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// MipChain
+
+MipChain::
+  MipChain()
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+MipChain::
+  Generate(const u8* a_pixels, tl_int a_width, tl_int a_height,
+           const PixelFormat& a_format, const ResampleSettings& a_settings)
+{
+  Clear();
+
+  if (DoIsValid(a_pixels, a_width, a_height, a_format) == false)
+  { return false; }
+
+  m_format = a_format;
+
+  // every level is half the size of the previous one (rounded down), the
+  // last one is 1x1
+  tl_int  width = a_width;
+  tl_int  height = a_height;
+  tl_size offset = 0;
+  while (true)
+  {
+    Level level;
+    level.m_width = width;
+    level.m_height = height;
+    level.m_offset = offset;
+    level.m_size = (tl_size)width * height * a_format.GetPixelSize();
+    m_levels.push_back(level);
+
+    offset += level.m_size;
+
+    if (width == 1 && height == 1)
+    { break; }
+
+    width = core::tlMax(width / 2, 1);
+    height = core::tlMax(height / 2, 1);
+  }
+
+  m_data.resize(offset);
+  memcpy(&m_data[0], a_pixels, m_levels[0].m_size);
+
+  const tl_int numThreads = core::tlMax(a_settings.m_numThreads, 1);
+  const SrgbTables tables;
+
+  FloatImage levels[2];
+  FloatImage temp;
+  DoToLinear(a_pixels, a_width, a_height, a_format, tables, numThreads,
+             levels[0]);
+
+  for (tl_size i = 1; i < m_levels.size(); ++i)
+  {
+    const FloatImage& prev = levels[(i - 1) & 1];
+    FloatImage&       next = levels[i & 1];
+
+    const Level& level = m_levels[i];
+    DoResample(prev, level.m_width, level.m_height, a_settings, temp, next);
+    DoFromLinear(next, a_format, tables, numThreads, &m_data[level.m_offset]);
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+void
+MipChain::
+  Clear()
+{
+  m_levels.clear();
+  m_data.clear();
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+MipChain::
+  GetNumLevels() const
+{ return m_levels.size(); }
+
+// -----------------------------------------------------------------------
+
+const MipChain::Level&
+MipChain::
+  GetLevel(tl_size a_index) const
+{
+  TLOC_ASSERT(a_index < m_levels.size(), "Mip level index out of range");
+  return m_levels[a_index];
+}
+
+// -----------------------------------------------------------------------
+
+const u8*
+MipChain::
+  GetLevelData(tl_size a_index) const
+{ return &m_data[GetLevel(a_index).m_offset]; }
@@ -0,0 +1,98 @@
+#ifndef _TLOC_IMAGE_TOOLS_RESAMPLER_H_
+#define _TLOC_IMAGE_TOOLS_RESAMPLER_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// Layout of the pixels of an image: 1 to 4 channels of 8 or 16 bits (host
+// byte order), rows without padding. This covers every gfx_med image type:
+// image_rgba/rgb/rg/r and their u16 variants. With 4 channels the last one
+// is alpha. 4 bytes per channel (f32) is only understood by the image views
+// (imageView.h), the resampler rejects it.
+//
+// sRGB images are filtered in linear space, so a downsampled image keeps
+// the brightness of the original. Alpha is always linear.
+
+struct PixelFormat
+{
+  PixelFormat(tl_int a_numChannels = 4, tl_int a_bytesPerChannel = 1,
+              bool a_srgb = false);
+
+  tl_size GetPixelSize() const;
+  bool    HasAlpha() const;
+
+  tl_int  m_numChannels;
+  tl_int  m_bytesPerChannel;
+  bool    m_srgb;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Resampling filters, all separable
+//
+// k_filterBox      average of the source pixels under the target pixel,
+//                  the classic 2x2 mip filter
+// k_filterKaiser   Kaiser windowed sinc (3 pixels wide, alpha 4), sharp
+//                  with little ringing, the usual choice for mips
+// k_filterLanczos  Lanczos 3, the sharpest, rings a little at hard edges
+
+enum resample_filter { k_filterBox, k_filterKaiser, k_filterLanczos };
+
+struct ResampleSettings
+{
+  ResampleSettings();
+
+  resample_filter m_filter;
+  bool            m_wrap;           // tiling texture, filters wrap around
+  tl_int          m_numThreads;     // rows are split across them
+};
+
+// Resizes an image to any size. Colors are weighted by alpha while they
+// are filtered, so fully transparent pixels do not bleed into their
+// neighbours.
+bool  ResampleImage(const u8* a_src, tl_int a_srcWidth, tl_int a_srcHeight,
+                    const PixelFormat& a_format, u8* a_dst, tl_int a_dstWidth,
+                    tl_int a_dstHeight,
+                    const ResampleSettings& a_settings = ResampleSettings());
+
+// ///////////////////////////////////////////////////////////////////////
+// A full mip chain, from the image down to 1x1, in one buffer. Every level
+// has the pixel format of the image and is stored right after the previous
+// one, the way glTexImage2D() expects each level (with GL_UNPACK_ALIGNMENT
+// set to 1 for formats that are not a multiple of 4 bytes per pixel).
+//
+// Each level is filtered from the previous one, which is kept in floating
+// point so the levels are only rounded once.
+
+class MipChain
+{
+public:
+  struct Level
+  {
+    tl_int    m_width;
+    tl_int    m_height;
+    tl_size   m_offset;             // in GetData()
+    tl_size   m_size;
+  };
+
+public:
+  MipChain();
+
+  bool      Generate(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                     const PixelFormat& a_format,
+                     const ResampleSettings& a_settings = ResampleSettings());
+  void      Clear();
+
+  tl_size   GetNumLevels() const;
+  const Level&  GetLevel(tl_size a_index) const;
+  const u8*     GetLevelData(tl_size a_index) const;
+
+  TLOC_DECL_AND_DEF_GETTER(const PixelFormat&, GetFormat, m_format);
+  TLOC_DECL_AND_DEF_GETTER(const tl_core_conts::Array<u8>&, GetData, m_data);
+
+private:
+  PixelFormat                   m_format;
+  tl_core_conts::Array<Level>   m_levels;
+  tl_core_conts::Array<u8>      m_data;
+};
+
+#endif
@@ -0,0 +1,384 @@
+#include "textureCompressor.h"
+
+#include "bcEncoder.h"
+#include "etcEncoder.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// CompressSettings
+
+CompressSettings::
+  CompressSettings()
+  : m_format(k_bc1)
+  , m_quality(k_qualityFast)
+  , m_srgb(false)
+  , m_numThreads(1)
+{ }
+
+// ///////////////////////////////////////////////////////////////////////
+// Formats
+
+namespace {
+
+  // EXT_texture_compression_s3tc, EXT_texture_sRGB, ARB_texture_rg and
+  // OpenGL ES 3.0
+  const u32 g_glCompressedRgbS3tcDxt1 = 0x83F0;
+  const u32 g_glCompressedRgbaS3tcDxt5 = 0x83F3;
+  const u32 g_glCompressedSrgbS3tcDxt1 = 0x8C4C;
+  const u32 g_glCompressedSrgbAlphaS3tcDxt5 = 0x8C4F;
+  const u32 g_glCompressedRgRgtc2 = 0x8DBD;
+  const u32 g_glCompressedRgb8Etc2 = 0x9274;
+  const u32 g_glCompressedSrgb8Etc2 = 0x9275;
+  const u32 g_glCompressedRgba8Etc2Eac = 0x9278;
+  const u32 g_glCompressedSrgb8Alpha8Etc2Eac = 0x9279;
+
+  const tl_int  g_blockDim = 4;
+  const tl_int  g_blockPixelSize = 4 * g_blockDim * g_blockDim;
+
+  const f64     g_maxPsnr = 99.0;
+
+  typedef void (*encode_block_func)(const u8*, bool, u8*);
+  typedef void (*decode_block_func)(const u8*, u8*);
+
+  encode_block_func DoGetEncoder(compressed_format a_format)
+  {
+    switch (a_format)
+    {
+    case k_bc1:       return &EncodeBc1Block;
+    case k_bc3:       return &EncodeBc3Block;
+    case k_bc5:       return &EncodeBc5Block;
+    case k_etc2Rgb:   return &EncodeEtc2RgbBlock;
+    case k_etc2Rgba:  return &EncodeEtc2RgbaBlock;
+    default:          return nullptr;
+    }
+  }
+
+  decode_block_func DoGetDecoder(compressed_format a_format)
+  {
+    switch (a_format)
+    {
+    case k_bc1:       return &DecodeBc1Block;
+    case k_bc3:       return &DecodeBc3Block;
+    case k_bc5:       return &DecodeBc5Block;
+    case k_etc2Rgb:   return &DecodeEtc2RgbBlock;
+    case k_etc2Rgba:  return &DecodeEtc2RgbaBlock;
+    default:          return nullptr;
+    }
+  }
+
+};
+
+const char*
+  GetFormatName(compressed_format a_format)
+{
+  switch (a_format)
+  {
+  case k_bc1:       return "BC1";
+  case k_bc3:       return "BC3";
+  case k_bc5:       return "BC5";
+  case k_etc2Rgb:   return "ETC2 RGB";
+  case k_etc2Rgba:  return "ETC2 RGBA";
+  default:          return "unknown";
+  }
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+  GetBlockSize(compressed_format a_format)
+{ return a_format == k_bc1 || a_format == k_etc2Rgb ? 8 : 16; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+  GetCompressedSize(compressed_format a_format, tl_int a_width, tl_int a_height)
+{
+  const tl_size numBlocksX = (tl_size)(a_width + g_blockDim - 1) / g_blockDim;
+  const tl_size numBlocksY = (tl_size)(a_height + g_blockDim - 1) / g_blockDim;
+  return numBlocksX * numBlocksY * GetBlockSize(a_format);
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+  GetNumChannels(compressed_format a_format)
+{
+  switch (a_format)
+  {
+  case k_bc5:       return 2;
+  case k_bc1:
+  case k_etc2Rgb:   return 3;
+  default:          return 4;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+u32
+  GetGlInternalFormat(compressed_format a_format, bool a_srgb)
+{
+  switch (a_format)
+  {
+  case k_bc1:
+    return a_srgb ? g_glCompressedSrgbS3tcDxt1 : g_glCompressedRgbS3tcDxt1;
+  case k_bc3:
+    return a_srgb ? g_glCompressedSrgbAlphaS3tcDxt5 : g_glCompressedRgbaS3tcDxt5;
+  case k_bc5:
+    return g_glCompressedRgRgtc2;
+  case k_etc2Rgb:
+    return a_srgb ? g_glCompressedSrgb8Etc2 : g_glCompressedRgb8Etc2;
+  case k_etc2Rgba:
+    return a_srgb ? g_glCompressedSrgb8Alpha8Etc2Eac : g_glCompressedRgba8Etc2Eac;
+  default:
+    return 0;
+  }
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Compression
+
+bool
+  CompressImage(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                const CompressSettings& a_settings, u8* a_out)
+{
+  const encode_block_func encode = DoGetEncoder(a_settings.m_format);
+  if (encode == nullptr || a_pixels == nullptr || a_out == nullptr ||
+      a_width <= 0 || a_height <= 0)
+  { return false; }
+
+  const bool    highQuality = a_settings.m_quality == k_qualityHigh;
+  const tl_size blockSize = GetBlockSize(a_settings.m_format);
+  const tl_int  numBlocksX = (a_width + g_blockDim - 1) / g_blockDim;
+  const int     numBlocksY = (a_height + g_blockDim - 1) / g_blockDim;
+  const tl_int  numThreads = core::tlMax(a_settings.m_numThreads, 1);
+
+  // high quality blocks take longer where the image is busy, so the rows
+  // are handed out one at a time
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads)
+  for (int by = 0; by < numBlocksY; ++by)
+  {
+    u8 block[g_blockPixelSize];
+    u8* out = a_out + (tl_size)by * numBlocksX * blockSize;
+
+    for (tl_int bx = 0; bx < numBlocksX; ++bx, out += blockSize)
+    {
+      for (tl_int y = 0; y < g_blockDim; ++y)
+      {
+        const tl_int sy = core::tlMin(by * g_blockDim + y, a_height - 1);
+        for (tl_int x = 0; x < g_blockDim; ++x)
+        {
+          const tl_int sx = core::tlMin(bx * g_blockDim + x, a_width - 1);
+          const u8* pixel = a_pixels + ((tl_size)sy * a_width + sx) * 4;
+
+          u8* dst = block + (y * g_blockDim + x) * 4;
+          dst[0] = pixel[0];
+          dst[1] = pixel[1];
+          dst[2] = pixel[2];
+          dst[3] = pixel[3];
+        }
+      }
+
+      encode(block, highQuality, out);
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  DecompressImage(const u8* a_data, tl_int a_width, tl_int a_height,
+                  compressed_format a_format, u8* a_pixels, tl_int a_numThreads)
+{
+  const decode_block_func decode = DoGetDecoder(a_format);
+  if (decode == nullptr || a_data == nullptr || a_pixels == nullptr ||
+      a_width <= 0 || a_height <= 0)
+  { return false; }
+
+  const tl_size blockSize = GetBlockSize(a_format);
+  const tl_int  numBlocksX = (a_width + g_blockDim - 1) / g_blockDim;
+  const int     numBlocksY = (a_height + g_blockDim - 1) / g_blockDim;
+  const tl_int  numThreads = core::tlMax(a_numThreads, 1);
+
+#pragma omp parallel for num_threads(numThreads)
+  for (int by = 0; by < numBlocksY; ++by)
+  {
+    u8 block[g_blockPixelSize];
+    const u8* in = a_data + (tl_size)by * numBlocksX * blockSize;
+
+    for (tl_int bx = 0; bx < numBlocksX; ++bx, in += blockSize)
+    {
+      decode(in, block);
+
+      const tl_int width = core::tlMin(g_blockDim, a_width - bx * g_blockDim);
+      const tl_int height = core::tlMin(g_blockDim, a_height - by * g_blockDim);
+
+      for (tl_int y = 0; y < height; ++y)
+      {
+        u8* dst = a_pixels +
+          ((tl_size)(by * g_blockDim + y) * a_width + bx * g_blockDim) * 4;
+        memcpy(dst, block + y * g_blockDim * 4, (tl_size)width * 4);
+      }
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+f64
+  GetPsnr(const u8* a_pixels, const u8* a_reference, tl_int a_width,
+          tl_int a_height, tl_int a_numChannels)
+{
+  const tl_size numPixels = (tl_size)a_width * a_height;
+
+  f64 sumSq = 0;
+  for (tl_size i = 0; i < numPixels; ++i)
+  {
+    for (tl_int c = 0; c < a_numChannels; ++c)
+    {
+      const f64 diff = (f64)a_pixels[i * 4 + c] - (f64)a_reference[i * 4 + c];
+      sumSq += diff * diff;
+    }
+  }
+
+  if (sumSq == 0 || numPixels == 0)
+  { return g_maxPsnr; }
+
+  const f64 mse = sumSq / (f64)(numPixels * a_numChannels);
+  return core::tlMin(10.0 * log10(255.0 * 255.0 / mse), g_maxPsnr);
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// CompressedTexture
+
+CompressedTexture::
+  CompressedTexture()
+  : m_format(k_bc1)
+  , m_srgb(false)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+CompressedTexture::
+  Compress(const u8* a_pixels, tl_int a_width, tl_int a_height,
+           const CompressSettings& a_settings)
+{
+  Clear();
+
+  if (a_width <= 0 || a_height <= 0)
+  { return false; }
+
+  m_format = a_settings.m_format;
+  m_srgb = a_settings.m_srgb;
+
+  DoAddLevel(a_width, a_height);
+  m_data.resize(m_levels[0].m_size);
+
+  if (CompressImage(a_pixels, a_width, a_height, a_settings, &m_data[0]) == false)
+  {
+    Clear();
+    return false;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+CompressedTexture::
+  Compress(const MipChain& a_mips, const CompressSettings& a_settings)
+{
+  Clear();
+
+  const PixelFormat& format = a_mips.GetFormat();
+  if (a_mips.GetNumLevels() == 0 || format.m_numChannels != 4 ||
+      format.m_bytesPerChannel != 1)
+  { return false; }
+
+  m_format = a_settings.m_format;
+  m_srgb = a_settings.m_srgb;
+
+  for (tl_size i = 0; i < a_mips.GetNumLevels(); ++i)
+  { DoAddLevel(a_mips.GetLevel(i).m_width, a_mips.GetLevel(i).m_height); }
+
+  const Level& last = m_levels.back();
+  m_data.resize(last.m_offset + last.m_size);
+
+  for (tl_size i = 0; i < m_levels.size(); ++i)
+  {
+    const Level& level = m_levels[i];
+    if (CompressImage(a_mips.GetLevelData(i), level.m_width, level.m_height,
+                      a_settings, &m_data[level.m_offset]) == false)
+    {
+      Clear();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+void
+CompressedTexture::
+  Clear()
+{
+  m_levels.clear();
+  m_data.clear();
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+CompressedTexture::
+  GetNumLevels() const
+{ return m_levels.size(); }
+
+// -----------------------------------------------------------------------
+
+const CompressedTexture::Level&
+CompressedTexture::
+  GetLevel(tl_size a_index) const
+{
+  TLOC_ASSERT(a_index < m_levels.size(), "Compressed level index out of range");
+  return m_levels[a_index];
+}
+
+// -----------------------------------------------------------------------
+
+const u8*
+CompressedTexture::
+  GetLevelData(tl_size a_index) const
+{ return &m_data[GetLevel(a_index).m_offset]; }
+
+// -----------------------------------------------------------------------
+
+u32
+CompressedTexture::
+  GetGlInternalFormat() const
+{ return ::GetGlInternalFormat(m_format, m_srgb); }
+
+// -----------------------------------------------------------------------
+
+void
+CompressedTexture::
+  DoAddLevel(tl_int a_width, tl_int a_height)
+{
+  Level level;
+  level.m_width = a_width;
+  level.m_height = a_height;
+  level.m_offset = m_levels.empty() ? 0
+                 : m_levels.back().m_offset + m_levels.back().m_size;
+  level.m_size = GetCompressedSize(m_format, a_width, a_height);
+  m_levels.push_back(level);
+}
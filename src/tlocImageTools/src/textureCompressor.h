@@ -0,0 +1,105 @@
+#ifndef _TLOC_IMAGE_TOOLS_TEXTURE_COMPRESSOR_H_
+#define _TLOC_IMAGE_TOOLS_TEXTURE_COMPRESSOR_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "resampler.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Block compressed texture formats. Every 4x4 block of pixels takes 8 or
+// 16 bytes, 4 to 8 times less than RGBA8, and stays compressed on the GPU.
+//
+// k_bc1        RGB, 8 bytes per block (desktop)
+// k_bc3        RGBA, BC1 colors with 8 bytes of alpha
+// k_bc5        two channels (the red and green of a normal map)
+// k_etc2Rgb    RGB, 8 bytes per block (OpenGL ES 3, mobile)
+// k_etc2Rgba   RGBA, ETC2 colors with 8 bytes of EAC alpha
+
+enum compressed_format { k_bc1, k_bc3, k_bc5, k_etc2Rgb, k_etc2Rgba };
+
+enum compression_quality { k_qualityFast, k_qualityHigh };
+
+struct CompressSettings
+{
+  CompressSettings();
+
+  compressed_format   m_format;
+  compression_quality m_quality;
+  bool                m_srgb;           // picks the sRGB GL format
+  tl_int              m_numThreads;     // rows of blocks are split across them
+};
+
+const char* GetFormatName(compressed_format a_format);
+tl_size     GetBlockSize(compressed_format a_format);
+tl_size     GetCompressedSize(compressed_format a_format,
+                              tl_int a_width, tl_int a_height);
+
+// the channels the format keeps (RGB, RGBA or RG), for GetPsnr()
+tl_int      GetNumChannels(compressed_format a_format);
+
+// the internalformat of glCompressedTexImage2D()
+u32         GetGlInternalFormat(compressed_format a_format, bool a_srgb);
+
+// ///////////////////////////////////////////////////////////////////////
+// Compression of 8 bit RGBA pixels (DecodedImage, gfx_med::Image). Images
+// that are not a multiple of 4 pixels repeat their last row and column in
+// the partial blocks. See EncodeBc1Block() and EncodeEtc2RgbBlock() for
+// what the fast and high quality modes do.
+
+bool  CompressImage(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                    const CompressSettings& a_settings, u8* a_out);
+
+// back to 8 bit RGBA, to measure the quality
+bool  DecompressImage(const u8* a_data, tl_int a_width, tl_int a_height,
+                      compressed_format a_format, u8* a_pixels,
+                      tl_int a_numThreads = 1);
+
+// Peak signal to noise ratio (dB) of the first a_numChannels channels of
+// two RGBA8 images, 99 when they are equal
+f64   GetPsnr(const u8* a_pixels, const u8* a_reference, tl_int a_width,
+              tl_int a_height, tl_int a_numChannels);
+
+// ///////////////////////////////////////////////////////////////////////
+// A compressed image or mip chain in one buffer, every level right after
+// the previous one. Each level is what glCompressedTexImage2D() takes with
+// GetGlInternalFormat() and the level's m_size.
+
+class CompressedTexture
+{
+public:
+  struct Level
+  {
+    tl_int    m_width;
+    tl_int    m_height;
+    tl_size   m_offset;             // in GetData()
+    tl_size   m_size;
+  };
+
+public:
+  CompressedTexture();
+
+  bool      Compress(const u8* a_pixels, tl_int a_width, tl_int a_height,
+                     const CompressSettings& a_settings);
+  // the chain has to be 8 bit RGBA
+  bool      Compress(const MipChain& a_mips, const CompressSettings& a_settings);
+  void      Clear();
+
+  tl_size   GetNumLevels() const;
+  const Level&  GetLevel(tl_size a_index) const;
+  const u8*     GetLevelData(tl_size a_index) const;
+  u32           GetGlInternalFormat() const;
+
+  TLOC_DECL_AND_DEF_GETTER(compressed_format, GetFormat, m_format);
+  TLOC_DECL_AND_DEF_GETTER(bool, IsSrgb, m_srgb);
+  TLOC_DECL_AND_DEF_GETTER(const tl_core_conts::Array<u8>&, GetData, m_data);
+
+private:
+  void      DoAddLevel(tl_int a_width, tl_int a_height);
+
+  compressed_format             m_format;
+  bool                          m_srgb;
+  tl_core_conts::Array<Level>   m_levels;
+  tl_core_conts::Array<u8>      m_data;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#include "textureStager.h"
+#include "imageView.h"
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// TextureStager
+
+TextureStager::
+  TextureStager()
+  : m_nextBuffer(0)
+  , m_numUpdates(0)
+  , m_bytesStaged(0)
+{
+  for (tl_int i = 0; i < k_numBuffers; ++i)
+  { m_buffers[i].m_size = 0; }
+}
+
+// -----------------------------------------------------------------------
+
+TextureStager::
+  ~TextureStager()
+{ }
+
+// -----------------------------------------------------------------------
+
+tl_size
+TextureStager::
+  Update(TrackedImage& a_image)
+{
+  const DirtyRegionTracker::rect_cont& rects = a_image.GetDirtyRegions().GetRects();
+  if (rects.empty())
+  { return 0; }
+
+  const tl_int   bufferIndex = m_nextBuffer;
+  StagingBuffer& buffer = m_buffers[bufferIndex];
+  m_nextBuffer = (m_nextBuffer + 1) % k_numBuffers;
+
+  tl_size size = 0;
+  buffer.m_regions.resize(rects.size());
+  for (tl_size i = 0; i < rects.size(); ++i)
+  {
+    buffer.m_regions[i].m_rect = rects[i];
+    buffer.m_regions[i].m_offset = size;
+    size += rects[i].GetArea() * 4;
+  }
+
+  if (buffer.m_data.size() < size)
+  { buffer.m_data.resize(size); }
+  buffer.m_size = size;
+
+  // only read from
+  const ImageView image(const_cast<u8*>(&a_image.GetPixels()[0]),
+                        a_image.GetWidth(), a_image.GetHeight(), PixelFormat());
+
+  for (tl_size i = 0; i < rects.size(); ++i)
+  {
+    const DirtyRect& r = rects[i];
+
+    // each region is packed in the buffer, rows right after each other
+    const ImageView region(&buffer.m_data[buffer.m_regions[i].m_offset],
+                           r.GetWidth(), r.GetHeight(), PixelFormat());
+    ConvertImage(image.GetSubView(r.m_x0, r.m_y0, r.GetWidth(), r.GetHeight()),
+                 region);
+  }
+
+  a_image.ClearDirty();
+
+  ++m_numUpdates;
+  m_bytesStaged += size;
+
+  DoUpload(bufferIndex, buffer);
+  return size;
+}
+
+// -----------------------------------------------------------------------
+
+const StagingBuffer&
+TextureStager::
+  GetBuffer(tl_int a_index) const
+{
+  TLOC_ASSERT(a_index >= 0 && a_index < k_numBuffers,
+              "Staging buffer index out of range");
+  return m_buffers[a_index];
+}
@@ -0,0 +1,73 @@
+#ifndef _TLOC_IMAGE_TOOLS_TEXTURE_STAGER_H_
+#define _TLOC_IMAGE_TOOLS_TEXTURE_STAGER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "dirtyRegions.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// The dirty regions of an image, copied out of it. Each region's rows are
+// packed one after the other from m_offset, the way glTexSubImage2D()
+// reads them with GL_UNPACK_ALIGNMENT 4 (RGBA8 rows are always a multiple
+// of 4 bytes).
+
+struct StagedRegion
+{
+  DirtyRect m_rect;
+  tl_size   m_offset;           // in StagingBuffer::m_data
+};
+
+struct StagingBuffer
+{
+  tl_core_conts::Array<u8>            m_data;
+  tl_core_conts::Array<StagedRegion>  m_regions;
+  tl_size                             m_size;     // bytes used in m_data
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Uploads the parts of a TrackedImage that changed, through two staging
+// buffers used in turn.
+//
+// Update() copies the dirty regions into the next buffer, passes it and its
+// index to DoUpload() and clears the image's dirty regions. The index lets
+// DoUpload() keep a GPU buffer per staging buffer (tlocTextureStream uses a
+// pixel unpack buffer each), so that filling one does not wait for the GPU
+// to finish reading the one of the previous frame. The buffers only grow,
+// after the first few frames nothing is allocated.
+//
+// DoUpload() is where the GPU comes in. Everything else runs without a GPU.
+
+class TextureStager
+{
+public:
+  enum { k_numBuffers = 2 };
+
+public:
+  TextureStager();
+  virtual ~TextureStager();
+
+  // returns the number of bytes staged, 0 when nothing changed (DoUpload()
+  // is not called then)
+  tl_size   Update(TrackedImage& a_image);
+
+  const StagingBuffer&  GetBuffer(tl_int a_index) const;
+
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetNextBuffer, m_nextBuffer);
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetNumUpdates, m_numUpdates);
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetBytesStaged, m_bytesStaged);
+
+protected:
+  virtual void  DoUpload(tl_int a_bufferIndex, const StagingBuffer& a_buffer) = 0;
+
+private:
+  TextureStager(const TextureStager&);
+  TextureStager& operator=(const TextureStager&);
+
+private:
+  StagingBuffer m_buffers[k_numBuffers];
+  tl_int        m_nextBuffer;
+  tl_size       m_numUpdates;
+  tl_size       m_bytesStaged;  // over all updates
+};
+
+#endif
@@ -0,0 +1,611 @@
+#include "cookedMesh.h"
+#include "meshlets.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace tloc;
+
+namespace {
+
+  const char    g_magic[4] = { 'T', 'L', 'M', 'C' };
+  const tl_size g_dataAlignment = 16;
+  const char    g_cookedExtension[] = ".tlmc";
+
+  u64   DoAlign(u64 a_offset)
+  { return ( (a_offset + g_dataAlignment - 1) / g_dataAlignment) * g_dataAlignment; }
+
+  // the streams are used in place, a misaligned (or past the end) offset
+  // would hand out misaligned pointers
+  bool  DoIsAlignedOffset(u64 a_offset, u64 a_fileSize)
+  { return a_offset % g_dataAlignment == 0 && a_offset <= a_fileSize; }
+
+  // -----------------------------------------------------------------------
+
+  bool  DoGetFileStats(const char* a_fileName, u64& a_size, u64& a_time)
+  {
+#if defined (TLOC_OS_WIN)
+    struct _stat64 info;
+    if (_stat64(a_fileName, &info) != 0)
+    { return false; }
+#else
+    struct stat info;
+    if (stat(a_fileName, &info) != 0)
+    { return false; }
+#endif
+
+    a_size = (u64)info.st_size;
+    a_time = (u64)info.st_mtime;
+    return true;
+  }
+
+  // -----------------------------------------------------------------------
+
+  // the groups of the mesh (a_names != nullptr) or of a LOD
+  void  DoGetCookedGroups(const tl_core_conts::Array<ObjGroup>& a_groups,
+                          tl_core_conts::Array<CookedMeshGroup>& a_out,
+                          tl_core_conts::Array<char>* a_names)
+  {
+    a_out.resize(a_groups.size());
+    tl_size nameOffset = 0;
+
+    for (tl_size i = 0; i < a_groups.size(); ++i)
+    {
+      const ObjGroup& group = a_groups[i];
+      a_out[i].m_firstTriangle = (u32)group.m_firstTriangle;
+      a_out[i].m_numTriangles = (u32)group.m_numTriangles;
+      a_out[i].m_nameOffset = (u32)nameOffset;
+      a_out[i].m_nameLength = (u32)group.m_name.length();
+      nameOffset += group.m_name.length() + 1;
+
+      if (a_names)
+      {
+        a_names->insert(a_names->end(), group.m_name.begin(), group.m_name.end());
+        a_names->push_back('\0');
+      }
+    }
+  }
+
+  // LOD indices are u32 in memory and written with the size of the mesh's
+  void  DoGetLodIndices(const tl_core_conts::Array<u32>& a_indices, 
+                        tl_size a_indexSize, tl_core_conts::Array<u8>& a_out)
+  {
+    a_out.resize(a_indices.size() * a_indexSize);
+    for (tl_size i = 0; i < a_indices.size(); ++i)
+    {
+      if (a_indexSize == sizeof(u16))
+      {
+        const u16 index = (u16)a_indices[i];
+        memcpy(&a_out[i * sizeof(u16)], &index, sizeof(u16));
+      }
+      else
+      { memcpy(&a_out[i * sizeof(u32)], &a_indices[i], sizeof(u32)); }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  bool  DoWrite(FILE* a_file, const void* a_data, u64 a_size, u64& a_offset)
+  {
+    const char padding[g_dataAlignment] = { 0 };
+    const u64 alignedOffset = DoAlign(a_offset);
+
+    if (alignedOffset > a_offset &&
+        fwrite(padding, 1, (tl_size)(alignedOffset - a_offset), a_file) != 
+        alignedOffset - a_offset)
+    { return false; }
+
+    a_offset = alignedOffset + a_size;
+
+    return a_size == 0 || 
+      fwrite(a_data, 1, (tl_size)a_size, a_file) == (tl_size)a_size;
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Source info
+
+u64
+  HashMeshSource(const char* a_data, tl_size a_size)
+{
+  // FNV-1a on 8 byte words, the file is only hashed to detect changes
+  u64 hash = 14695981039346656037ULL ^ (u64)a_size;
+
+  tl_size i = 0;
+  for (; i + sizeof(u64) <= a_size; i += sizeof(u64))
+  {
+    u64 word;
+    memcpy(&word, a_data + i, sizeof(word));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+
+  for (; i < a_size; ++i)
+  { hash = (hash ^ (u8)a_data[i]) * 1099511628211ULL; }
+
+  return hash ^ (hash >> 32);
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  GetMeshSourceInfo(const char* a_fileName, MeshSourceInfo& a_out, bool a_hash)
+{
+  a_out.m_hash = 0;
+  if (DoGetFileStats(a_fileName, a_out.m_size, a_out.m_time) == false)
+  { return false; }
+
+  if (a_hash == false)
+  { return true; }
+
+  MappedFile file;
+  if (file.Open(a_fileName) == false)
+  { return false; }
+
+  a_out.m_size = file.GetSize();
+  a_out.m_hash = HashMeshSource(file.GetData(), file.GetSize());
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+  WriteCookedMesh(const char* a_fileName, const IndexedMesh& a_mesh,
+                  const MeshSourceInfo& a_source, u32 a_flags, f32 a_lodMaxError)
+{
+  // group names are packed one after the other
+  tl_core_conts::Array<CookedMeshGroup> groups;
+  tl_core_conts::Array<char>            names;
+  DoGetCookedGroups(a_mesh.m_groups, groups, &names);
+
+  const void* indices = a_mesh.m_indices.empty()
+    ? (const void*)(a_mesh.m_shortIndices.empty() ? nullptr : &a_mesh.m_shortIndices[0])
+    : (const void*)&a_mesh.m_indices[0];
+
+  CookedMeshHeader header;
+  memset(&header, 0, sizeof(header));
+  for (tl_int i = 0; i < 4; ++i)
+  { header.m_magic[i] = g_magic[i]; }
+
+  header.m_version = CookedMeshHeader::k_version;
+  header.m_sourceSize = a_source.m_size;
+  header.m_sourceTime = a_source.m_time;
+  header.m_sourceHash = a_source.m_hash;
+  header.m_numVertices = (u32)a_mesh.m_vertices.size();
+  header.m_numIndices = (u32)a_mesh.GetNumIndices();
+  header.m_indexSize = (u32)a_mesh.GetIndexSize();
+  header.m_numGroups = (u32)groups.size();
+  header.m_flags = a_flags;
+  header.m_numLods = (u32)a_mesh.m_lods.size();
+  header.m_numMeshlets = (u32)a_mesh.m_meshlets.size();
+
+  const u64 vertexSize = header.m_numVertices * sizeof(MeshVertex);
+  const u64 indexSize = (u64)header.m_numIndices * header.m_indexSize;
+  const u64 groupSize = header.m_numGroups * sizeof(CookedMeshGroup);
+  const u64 meshletSize = header.m_numMeshlets * sizeof(Meshlet);
+  const u64 lodSize = header.m_numLods * sizeof(CookedMeshLod);
+
+  header.m_vertexOffset = DoAlign(sizeof(CookedMeshHeader));
+  header.m_indexOffset = DoAlign(header.m_vertexOffset + vertexSize);
+  header.m_groupOffset = DoAlign(header.m_indexOffset + indexSize);
+  header.m_meshletOffset = DoAlign(header.m_groupOffset + groupSize);
+  header.m_lodOffset = DoAlign(header.m_meshletOffset + meshletSize);
+
+  tl_core_conts::Array<CookedMeshLod> lods(header.m_numLods);
+  u64 offset = header.m_lodOffset + lodSize;
+  for (tl_size i = 0; i < lods.size(); ++i)
+  {
+    const MeshLod& lod = a_mesh.m_lods[i];
+    lods[i].m_ratio = lod.m_ratio;
+    lods[i].m_maxError = a_lodMaxError;
+    lods[i].m_error = lod.m_error;
+    lods[i].m_numIndices = (u32)lod.m_indices.size();
+    lods[i].m_indexOffset = DoAlign(offset);
+    lods[i].m_groupOffset = 
+      DoAlign(lods[i].m_indexOffset + lod.m_indices.size() * header.m_indexSize);
+    offset = lods[i].m_groupOffset + groupSize;
+  }
+
+  header.m_nameOffset = DoAlign(offset);
+  header.m_fileSize = header.m_nameOffset + names.size();
+
+  FILE* file = fopen(a_fileName, "wb");
+  if (file == nullptr)
+  { return false; }
+
+  offset = 0;
+  bool written = 
+    DoWrite(file, &header, sizeof(header), offset) &&
+    DoWrite(file, a_mesh.m_vertices.empty() ? nullptr : &a_mesh.m_vertices[0], 
+            vertexSize, offset) &&
+    DoWrite(file, indices, indexSize, offset) &&
+    DoWrite(file, groups.empty() ? nullptr : &groups[0], groupSize, offset) &&
+    DoWrite(file, a_mesh.m_meshlets.empty() ? nullptr : &a_mesh.m_meshlets[0], 
+            meshletSize, offset) &&
+    DoWrite(file, lods.empty() ? nullptr : &lods[0], lodSize, offset);
+
+  tl_core_conts::Array<CookedMeshGroup> lodGroups;
+  tl_core_conts::Array<u8>              lodIndices;
+  for (tl_size i = 0; i < lods.size() && written; ++i)
+  {
+    DoGetLodIndices(a_mesh.m_lods[i].m_indices, header.m_indexSize, lodIndices);
+    DoGetCookedGroups(a_mesh.m_lods[i].m_groups, lodGroups, nullptr);
+
+    written = 
+      lodGroups.size() == groups.size() &&
+      DoWrite(file, lodIndices.empty() ? nullptr : &lodIndices[0], 
+              lodIndices.size(), offset) &&
+      DoWrite(file, lodGroups.empty() ? nullptr : &lodGroups[0], groupSize, offset);
+  }
+
+  written = written &&
+    DoWrite(file, names.empty() ? nullptr : &names[0], names.size(), offset);
+
+  if (fclose(file) != 0)
+  { written = false; }
+
+  // a partial file would fail the size check, but do not leave it around
+  if (written == false)
+  { remove(a_fileName); }
+
+  return written;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// CookedMesh
+
+CookedMesh::
+  CookedMesh()
+  : m_header(nullptr)
+  , m_vertices(nullptr)
+  , m_indices(nullptr)
+  , m_groups(nullptr)
+  , m_meshlets(nullptr)
+  , m_lods(nullptr)
+  , m_names(nullptr)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+CookedMesh::
+  Open(const char* a_fileName)
+{
+  Close();
+
+  if (m_file.Open(a_fileName) == false)
+  { return false; }
+
+  const char*   data = m_file.GetData();
+  const u64     size = m_file.GetSize();
+
+  if (size < sizeof(CookedMeshHeader))
+  { Close(); return false; }
+
+  const CookedMeshHeader* header = 
+    reinterpret_cast<const CookedMeshHeader*>(data);
+
+  for (tl_int i = 0; i < 4; ++i)
+  {
+    if (header->m_magic[i] != g_magic[i])
+    { Close(); return false; }
+  }
+
+  const u64 vertexEnd = header->m_vertexOffset + 
+    (u64)header->m_numVertices * sizeof(MeshVertex);
+  const u64 indexEnd = header->m_indexOffset + 
+    (u64)header->m_numIndices * header->m_indexSize;
+  const u64 groupSize = (u64)header->m_numGroups * sizeof(CookedMeshGroup);
+  const u64 groupEnd = header->m_groupOffset + groupSize;
+  const u64 meshletEnd = header->m_meshletOffset + 
+    (u64)header->m_numMeshlets * sizeof(Meshlet);
+  const u64 lodEnd = header->m_lodOffset + 
+    (u64)header->m_numLods * sizeof(CookedMeshLod);
+
+  if (header->m_version != CookedMeshHeader::k_version ||
+      (header->m_indexSize != sizeof(u16) && header->m_indexSize != sizeof(u32)) ||
+      header->m_fileSize != size ||
+      DoIsAlignedOffset(header->m_vertexOffset, size) == false ||
+      DoIsAlignedOffset(header->m_indexOffset, size) == false ||
+      DoIsAlignedOffset(header->m_groupOffset, size) == false ||
+      DoIsAlignedOffset(header->m_meshletOffset, size) == false ||
+      DoIsAlignedOffset(header->m_lodOffset, size) == false ||
+      DoIsAlignedOffset(header->m_nameOffset, size) == false ||
+      header->m_vertexOffset < sizeof(CookedMeshHeader) ||
+      header->m_indexOffset < vertexEnd ||
+      header->m_groupOffset < indexEnd ||
+      header->m_meshletOffset < groupEnd ||
+      header->m_lodOffset < meshletEnd ||
+      header->m_nameOffset < lodEnd ||
+      header->m_nameOffset > size)
+  { Close(); return false; }
+
+  // pointer fix ups, the offsets are aligned (checked above)
+  m_header = header;
+  m_vertices = reinterpret_cast<const MeshVertex*>(data + header->m_vertexOffset);
+  m_indices = data + header->m_indexOffset;
+  m_groups = reinterpret_cast<const CookedMeshGroup*>(data + header->m_groupOffset);
+  m_meshlets = reinterpret_cast<const Meshlet*>(data + header->m_meshletOffset);
+  m_lods = reinterpret_cast<const CookedMeshLod*>(data + header->m_lodOffset);
+  m_names = data + header->m_nameOffset;
+
+  const u64 namesSize = size - header->m_nameOffset;
+  for (u32 i = 0; i < header->m_numGroups; ++i)
+  {
+    if ( (u64)m_groups[i].m_nameOffset + m_groups[i].m_nameLength >= namesSize ||
+         ((u64)m_groups[i].m_firstTriangle + m_groups[i].m_numTriangles) * 3 > 
+         header->m_numIndices)
+    { Close(); return false; }
+  }
+
+  for (u32 i = 0; i < header->m_numMeshlets; ++i)
+  {
+    if ( ((u64)m_meshlets[i].m_firstTriangle + m_meshlets[i].m_numTriangles) * 3 > 
+         header->m_numIndices)
+    { Close(); return false; }
+  }
+
+  for (u32 i = 0; i < header->m_numLods; ++i)
+  {
+    const CookedMeshLod& lod = m_lods[i];
+    if (DoIsAlignedOffset(lod.m_indexOffset, size) == false ||
+        DoIsAlignedOffset(lod.m_groupOffset, size) == false ||
+        lod.m_indexOffset < lodEnd ||
+        lod.m_indexOffset + (u64)lod.m_numIndices * header->m_indexSize > 
+        lod.m_groupOffset ||
+        lod.m_groupOffset + groupSize > header->m_nameOffset)
+    { Close(); return false; }
+
+    for (u32 g = 0; g < header->m_numGroups; ++g)
+    {
+      const CookedMeshGroup& group = GetLodGroup(i, g);
+      if ( ((u64)group.m_firstTriangle + group.m_numTriangles) * 3 > lod.m_numIndices)
+      { Close(); return false; }
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+void
+CookedMesh::
+  Close()
+{
+  m_file.Close();
+
+  m_header = nullptr;
+  m_vertices = nullptr;
+  m_indices = nullptr;
+  m_groups = nullptr;
+  m_meshlets = nullptr;
+  m_lods = nullptr;
+  m_names = nullptr;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+CookedMesh::
+  IsOpen() const
+{ return m_header != nullptr; }
+
+// -----------------------------------------------------------------------
+// The size and time are checked first, the source is only hashed (read)
+// if they match.
+
+bool
+CookedMesh::
+  IsUpToDate(const char* a_sourceFile) const
+{
+  if (IsOpen() == false)
+  { return false; }
+
+  MeshSourceInfo source;
+  if (GetMeshSourceInfo(a_sourceFile, source, false) == false ||
+      source.m_size != m_header->m_sourceSize ||
+      source.m_time != m_header->m_sourceTime)
+  { return false; }
+
+  return GetMeshSourceInfo(a_sourceFile, source) &&
+    source.m_size == m_header->m_sourceSize &&
+    source.m_hash == m_header->m_sourceHash;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetNumVertices() const
+{ return m_header ? m_header->m_numVertices : 0; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetNumIndices() const
+{ return m_header ? m_header->m_numIndices : 0; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetIndexSize() const
+{ return m_header ? m_header->m_indexSize : 0; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetNumGroups() const
+{ return m_header ? m_header->m_numGroups : 0; }
+
+// -----------------------------------------------------------------------
+
+const CookedMeshGroup&
+CookedMesh::
+  GetGroup(tl_size a_index) const
+{
+  TLOC_ASSERT(a_index < GetNumGroups(), "Index out of bounds");
+  return m_groups[a_index];
+}
+
+// -----------------------------------------------------------------------
+
+const char*
+CookedMesh::
+  GetGroupName(tl_size a_index) const
+{ return m_names + GetGroup(a_index).m_nameOffset; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetNumLods() const
+{ return m_header ? m_header->m_numLods : 0; }
+
+// -----------------------------------------------------------------------
+
+const CookedMeshLod&
+CookedMesh::
+  GetLod(tl_size a_lod) const
+{
+  TLOC_ASSERT(a_lod < GetNumLods(), "Index out of bounds");
+  return m_lods[a_lod];
+}
+
+// -----------------------------------------------------------------------
+
+const void*
+CookedMesh::
+  GetLodIndices(tl_size a_lod) const
+{ return m_file.GetData() + GetLod(a_lod).m_indexOffset; }
+
+// -----------------------------------------------------------------------
+// LOD groups have the names (and count) of the mesh groups
+
+const CookedMeshGroup&
+CookedMesh::
+  GetLodGroup(tl_size a_lod, tl_size a_index) const
+{
+  TLOC_ASSERT(a_index < GetNumGroups(), "Index out of bounds");
+  const CookedMeshGroup* groups = reinterpret_cast<const CookedMeshGroup*>
+    (m_file.GetData() + GetLod(a_lod).m_groupOffset);
+  return groups[a_index];
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+CookedMesh::
+  GetNumMeshlets() const
+{ return m_header ? m_header->m_numMeshlets : 0; }
+
+// ///////////////////////////////////////////////////////////////////////
+// Loading
+
+MeshCookSettings::
+  MeshCookSettings()
+  : m_numThreads(1)
+  , m_optimize(false)
+  , m_meshlets(false)
+  , m_lodMaxError(0.02f)
+{ }
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+  u32   DoGetFlags(const MeshCookSettings& a_settings)
+  {
+    u32 flags = 0;
+    if (a_settings.m_optimize)
+    { flags |= CookedMeshHeader::k_flagOptimized; }
+    if (a_settings.m_meshlets)
+    { flags |= CookedMeshHeader::k_flagMeshlets; }
+    return flags;
+  }
+
+  bool  DoHasSettings(const CookedMesh& a_mesh, const MeshCookSettings& a_settings)
+  {
+    if (a_mesh.GetHeader()->m_flags != DoGetFlags(a_settings) ||
+        a_mesh.GetNumLods() != a_settings.m_lodRatios.size())
+    { return false; }
+
+    for (tl_size i = 0; i < a_mesh.GetNumLods(); ++i)
+    {
+      if (a_mesh.GetLod(i).m_ratio != a_settings.m_lodRatios[i] ||
+          a_mesh.GetLod(i).m_maxError != a_settings.m_lodMaxError)
+      { return false; }
+    }
+
+    return true;
+  }
+
+};
+
+bool
+  LoadCookedMesh(const char* a_objFile, const MeshCookSettings& a_settings,
+                 CookedMesh& a_out, bool* a_cooked)
+{
+  const tl_core_str::String cookedFile = 
+    tl_core_str::String(a_objFile) + g_cookedExtension;
+
+  if (a_cooked)
+  { *a_cooked = false; }
+
+  if (a_out.Open(cookedFile.c_str()) && 
+      DoHasSettings(a_out, a_settings) &&
+      a_out.IsUpToDate(a_objFile))
+  { return true; }
+
+  a_out.Close();
+
+  MappedFile source;
+  if (source.Open(a_objFile) == false)
+  { return false; }
+
+  MeshSourceInfo sourceInfo;
+  if (GetMeshSourceInfo(a_objFile, sourceInfo, false) == false)
+  { return false; }
+  sourceInfo.m_size = source.GetSize();
+  sourceInfo.m_hash = HashMeshSource(source.GetData(), source.GetSize());
+
+  ObjMesh     mesh;
+  ObjParser   parser;
+  if (parser.ParseParallel(source.GetData(), source.GetSize(), mesh, 
+                           a_settings.m_numThreads) == false)
+  { return false; }
+
+  source.Close();
+
+  IndexedMesh indexed;
+  WeldMesh(mesh, indexed);
+
+  if (a_settings.m_lodRatios.empty() == false)
+  {
+    GenerateLods(indexed, &a_settings.m_lodRatios[0], a_settings.m_lodRatios.size(),
+                 a_settings.m_numThreads, a_settings.m_lodMaxError);
+  }
+
+  if (a_settings.m_optimize)
+  { OptimizeMesh(indexed); }
+
+  if (a_settings.m_meshlets)
+  { BuildMeshlets(indexed); }
+
+  if (WriteCookedMesh(cookedFile.c_str(), indexed, sourceInfo, 
+                      DoGetFlags(a_settings), 
+                      a_settings.m_lodMaxError) == false)
+  { return false; }
+
+  if (a_cooked)
+  { *a_cooked = true; }
+
+  return a_out.Open(cookedFile.c_str());
+}
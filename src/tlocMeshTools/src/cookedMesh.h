@@ -0,0 +1,156 @@
+#ifndef _TLOC_MESH_TOOLS_COOKED_MESH_H_
+#define _TLOC_MESH_TOOLS_COOKED_MESH_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+#include "mappedFile.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Cooked (binary) IndexedMesh. The header is followed by the vertex stream
+// (MeshVertex), the index stream (2 or 4 bytes per index), the groups, the
+// meshlets (Meshlet), the LOD table, the index stream and groups of every
+// LOD and the group names (null terminated), each starting on a 16 byte
+// boundary. LODs index the same vertices with the same index size and have
+// the same groups as the mesh. All offsets are from the start of the file,
+// values are little endian.
+//
+// The header records the size, modification time and hash of the OBJ file
+// it was cooked from, a cooked mesh is only used while all of them match.
+// k_flagOptimized is set if the mesh went through OptimizeMesh(),
+// k_flagMeshlets if it went through BuildMeshlets().
+
+struct CookedMeshHeader
+{
+  enum { k_version = 4 };
+  enum { k_flagOptimized = 1, k_flagMeshlets = 2 };
+
+  char  m_magic[4]; // "TLMC"
+  u32   m_version;
+  u64   m_sourceSize;
+  u64   m_sourceTime;
+  u64   m_sourceHash;
+  u32   m_numVertices;
+  u32   m_numIndices;
+  u32   m_indexSize;
+  u32   m_numGroups;
+  u32   m_flags;
+  u32   m_numLods;
+  u32   m_numMeshlets;
+  u32   m_reserved;
+  u64   m_vertexOffset;
+  u64   m_indexOffset;
+  u64   m_groupOffset;
+  u64   m_meshletOffset;
+  u64   m_lodOffset;
+  u64   m_nameOffset;
+  u64   m_fileSize;
+};
+
+struct CookedMeshGroup
+{
+  u32   m_firstTriangle;
+  u32   m_numTriangles;
+  u32   m_nameOffset;   // from CookedMeshHeader::m_nameOffset
+  u32   m_nameLength;
+};
+
+struct CookedMeshLod
+{
+  f32   m_ratio;
+  f32   m_maxError;     // the limit it was simplified with
+  f32   m_error;
+  u32   m_numIndices;
+  u64   m_indexOffset;
+  u64   m_groupOffset;
+};
+
+struct MeshSourceInfo
+{
+  u64   m_size;
+  u64   m_time;
+  u64   m_hash;
+};
+
+// a_hash = false skips reading the file, m_hash is then 0
+bool  GetMeshSourceInfo(const char* a_fileName, MeshSourceInfo& a_out, 
+                        bool a_hash = true);
+u64   HashMeshSource(const char* a_data, tl_size a_size);
+
+// a_lodMaxError is the limit the LODs of a_mesh were simplified with
+bool  WriteCookedMesh(const char* a_fileName, const IndexedMesh& a_mesh,
+                      const MeshSourceInfo& a_source, u32 a_flags = 0,
+                      f32 a_lodMaxError = 0.0f);
+
+// ///////////////////////////////////////////////////////////////////////
+// A cooked mesh used in place: Open() maps the file and only points into
+// the view, nothing is copied or decoded.
+
+class CookedMesh
+{
+public:
+  CookedMesh();
+
+  bool    Open(const char* a_fileName);
+  void    Close();
+
+  bool    IsOpen() const;
+  bool    IsUpToDate(const char* a_sourceFile) const;
+
+  tl_size GetNumVertices() const;
+  tl_size GetNumIndices() const;
+  tl_size GetIndexSize() const;
+  tl_size GetNumGroups() const;
+
+  const CookedMeshGroup&  GetGroup(tl_size a_index) const;
+  const char*             GetGroupName(tl_size a_index) const;
+
+  tl_size                 GetNumLods() const;
+  const CookedMeshLod&    GetLod(tl_size a_lod) const;
+  const void*             GetLodIndices(tl_size a_lod) const;
+  const CookedMeshGroup&  GetLodGroup(tl_size a_lod, tl_size a_index) const;
+
+  tl_size                 GetNumMeshlets() const;
+
+  TLOC_DECL_AND_DEF_GETTER(const CookedMeshHeader*, GetHeader, m_header);
+  TLOC_DECL_AND_DEF_GETTER(const MeshVertex*, GetVertices, m_vertices);
+  TLOC_DECL_AND_DEF_GETTER(const void*, GetIndices, m_indices);
+  TLOC_DECL_AND_DEF_GETTER(const Meshlet*, GetMeshlets, m_meshlets);
+
+private:
+  MappedFile              m_file;
+
+  const CookedMeshHeader* m_header;
+  const MeshVertex*       m_vertices;
+  const void*             m_indices;
+  const CookedMeshGroup*  m_groups;
+  const Meshlet*          m_meshlets;
+  const CookedMeshLod*    m_lods;
+  const char*             m_names;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// How LoadCookedMesh() cooks an OBJ file: parsed on m_numThreads threads,
+// welded, one LOD per ratio in m_lodRatios (see GenerateLods()), with
+// m_optimize optimized for the vertex cache, overdraw and vertex fetch and,
+// with m_meshlets, split into meshlets (see BuildMeshlets()).
+
+struct MeshCookSettings
+{
+  MeshCookSettings();
+
+  tl_int                      m_numThreads;
+  bool                        m_optimize;
+  bool                        m_meshlets;
+  tl_core_conts::Array<f32>   m_lodRatios;
+  f32                         m_lodMaxError;
+};
+
+// Uses <a_objFile>.tlmc if it is up to date and was cooked with the same
+// settings, otherwise the OBJ file is cooked and the cooked mesh written
+// for the next time. a_cooked (if given) is true if the OBJ file was parsed.
+
+bool  LoadCookedMesh(const char* a_objFile, const MeshCookSettings& a_settings,
+                     CookedMesh& a_out, bool* a_cooked = nullptr);
+
+#endif
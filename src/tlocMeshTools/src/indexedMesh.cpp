@@ -0,0 +1,173 @@
+#include "indexedMesh.h"
+
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  const u32 g_emptySlot = 0xFFFFFFFF;
+
+  u32   DoHash(u32 a_hash, u32 a_value)
+  { return (a_hash ^ a_value) * 16777619u; }
+
+  u32   DoHashVertex(const MeshVertex& a_vertex)
+  {
+    u32 words[sizeof(MeshVertex) / sizeof(u32)];
+    memcpy(words, &a_vertex, sizeof(words));
+
+    u32 hash = 2166136261u;
+    for (tl_size i = 0; i < sizeof(words) / sizeof(u32); ++i)
+    { hash = DoHash(hash, words[i]); }
+
+    // the multiply only moves bits up, mix the high bits back into the low
+    // ones the table slot is taken from (floats often end in zero bits)
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+  }
+
+  tl_size DoGetTableSize(tl_size a_numEntries)
+  {
+    tl_size size = 16;
+    while (size < a_numEntries * 2) { size *= 2; }
+    return size;
+  }
+
+  // -----------------------------------------------------------------------
+  // + 0.0f turns -0 into 0 so that both compare and hash the same
+
+  void  DoCopy(const f32* a_from, f32* a_to, tl_int a_count)
+  {
+    for (tl_int i = 0; i < a_count; ++i)
+    { a_to[i] = a_from[i] + 0.0f; }
+  }
+
+  void  DoGetVertex(const ObjMesh& a_mesh, const ObjCorner& a_corner,
+                    MeshVertex& a_out)
+  {
+    memset(&a_out, 0, sizeof(a_out));
+
+    DoCopy(&a_mesh.m_positions[a_corner.m_position * 3], a_out.m_position, 3);
+
+    if (a_corner.m_normal != ObjCorner::k_noIndex)
+    { DoCopy(&a_mesh.m_normals[a_corner.m_normal * 3], a_out.m_normal, 3); }
+
+    if (a_corner.m_texCoord != ObjCorner::k_noIndex)
+    { DoCopy(&a_mesh.m_texCoords[a_corner.m_texCoord * 2], a_out.m_texCoord, 2); }
+  }
+
+  // -----------------------------------------------------------------------
+
+  void  DoWeld(const ObjMesh& a_mesh, tl_size a_firstTriangle,
+               tl_size a_numTriangles, IndexedMesh& a_out)
+  {
+    a_out.Clear();
+
+    const tl_size cornerBegin = a_firstTriangle * 3;
+    const tl_size numCorners = a_numTriangles * 3;
+    const tl_size tableMask = DoGetTableSize(numCorners) - 1;
+
+    tl_core_conts::Array<u32> table(tableMask + 1, g_emptySlot);
+    a_out.m_indices.resize(numCorners);
+
+    MeshVertex vertex;
+    for (tl_size i = 0; i < numCorners; ++i)
+    {
+      DoGetVertex(a_mesh, a_mesh.m_corners[cornerBegin + i], vertex);
+
+      tl_size slot = DoHashVertex(vertex) & tableMask;
+      for (;;)
+      {
+        const u32 other = table[slot];
+        if (other == g_emptySlot)
+        {
+          table[slot] = (u32)a_out.m_vertices.size();
+          a_out.m_indices[i] = table[slot];
+          a_out.m_vertices.push_back(vertex);
+          break;
+        }
+
+        if (memcmp(&a_out.m_vertices[other], &vertex, sizeof(vertex)) == 0)
+        {
+          a_out.m_indices[i] = other;
+          break;
+        }
+
+        slot = (slot + 1) & tableMask;
+      }
+    }
+
+    if (a_out.m_vertices.size() < IndexedMesh::k_maxShortVertices)
+    {
+      a_out.m_shortIndices.resize(numCorners);
+      for (tl_size i = 0; i < numCorners; ++i)
+      { a_out.m_shortIndices[i] = (u16)a_out.m_indices[i]; }
+
+      a_out.m_indices.clear();
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// IndexedMesh
+
+void
+IndexedMesh::
+  Clear()
+{
+  m_vertices.clear();
+  m_shortIndices.clear();
+  m_indices.clear();
+  m_groups.clear();
+  m_lods.clear();
+  m_meshlets.clear();
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+IndexedMesh::
+  GetNumIndices() const
+{ return m_shortIndices.size() + m_indices.size(); }
+
+// -----------------------------------------------------------------------
+
+tl_size
+IndexedMesh::
+  GetIndexSize() const
+{ return m_indices.empty() ? sizeof(u16) : sizeof(u32); }
+
+// -----------------------------------------------------------------------
+
+tl_size
+IndexedMesh::
+  GetIndex(tl_size a_index) const
+{
+  return m_indices.empty() ? (tl_size)m_shortIndices[a_index]
+                           : (tl_size)m_indices[a_index];
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Welding
+
+void
+  WeldMesh(const ObjMesh& a_mesh, IndexedMesh& a_out)
+{
+  DoWeld(a_mesh, 0, a_mesh.GetNumTriangles(), a_out);
+  a_out.m_groups = a_mesh.m_groups;
+}
+
+// -----------------------------------------------------------------------
+
+void
+  WeldGroup(const ObjMesh& a_mesh, const ObjGroup& a_group,
+            IndexedMesh& a_out)
+{
+  DoWeld(a_mesh, a_group.m_firstTriangle, a_group.m_numTriangles, a_out);
+
+  a_out.m_groups.push_back(a_group);
+  a_out.m_groups.back().m_firstTriangle = 0;
+}
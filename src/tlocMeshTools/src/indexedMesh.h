@@ -0,0 +1,82 @@
+#ifndef _TLOC_MESH_TOOLS_INDEXED_MESH_H_
+#define _TLOC_MESH_TOOLS_INDEXED_MESH_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "objParser.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Same layout as gfx_t::Vert3fpnt (position, normal, texture coordinates)
+// so that the vertices can be copied into a vertex buffer as they are.
+
+struct MeshVertex
+{
+  f32   m_position[3];
+  f32   m_normal[3];
+  f32   m_texCoord[2];
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// A lower detail index list over the vertices of an IndexedMesh (see
+// GenerateLods()). It has the same groups as the mesh, some may be empty.
+
+struct MeshLod
+{
+  f32                               m_ratio;    // requested triangle ratio
+  f32                               m_error;    // relative to the mesh size
+  tl_core_conts::Array<u32>         m_indices;
+  tl_core_conts::Array<ObjGroup>    m_groups;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// A run of triangles of the index list that is culled as a whole (see
+// BuildMeshlets()). The bounding sphere holds every triangle and the cone
+// every triangle normal: m_coneCutoff is the sine of its half angle, or 2
+// if it opens to 90 degrees or more (the meshlet never faces away).
+
+struct Meshlet
+{
+  u32   m_firstTriangle;
+  u32   m_numTriangles;
+  f32   m_center[3];
+  f32   m_radius;
+  f32   m_coneAxis[3];
+  f32   m_coneCutoff;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Welded vertices with an index list (3 per triangle). Meshes with less
+// than 65535 vertices use 16 bit indices (0xFFFF is left for primitive
+// restart), m_indices is then empty. Triangles keep their order, so the
+// groups of the ObjMesh are valid triangle ranges of the index list.
+// m_lods (if any) go from the most to the least detailed. m_meshlets (if
+// any) cover the triangles of the mesh, not of its LODs.
+
+struct IndexedMesh
+{
+  enum { k_maxShortVertices = 0xFFFF };
+
+  void    Clear();
+
+  tl_size GetNumIndices() const;
+  tl_size GetIndexSize() const;     // 2 or 4 bytes
+  tl_size GetIndex(tl_size a_index) const;
+
+  tl_core_conts::Array<MeshVertex>  m_vertices;
+  tl_core_conts::Array<u16>         m_shortIndices;
+  tl_core_conts::Array<u32>         m_indices;
+  tl_core_conts::Array<ObjGroup>    m_groups;
+  tl_core_conts::Array<MeshLod>     m_lods;
+  tl_core_conts::Array<Meshlet>     m_meshlets;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Corners with exactly the same position, normal and texture coordinates
+// (-0 and 0 are the same) become one vertex. Missing normals and texture
+// coordinates are 0, like ObjLoader::GetUnpacked().
+
+void  WeldMesh(const ObjMesh& a_mesh, IndexedMesh& a_out);
+void  WeldGroup(const ObjMesh& a_mesh, const ObjGroup& a_group,
+                IndexedMesh& a_out);
+
+#endif
@@ -0,0 +1,275 @@
+#include "lodSelector.h"
+
+using namespace tloc;
+
+namespace {
+
+  // below this many instances per thread, starting the threads costs more
+  // than selecting the LODs
+  const tl_int g_minInstancesPerThread = 16 * 1024;
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// LodSelector
+
+LodSelector::
+  LodSelector()
+{ }
+
+// -----------------------------------------------------------------------
+
+void
+LodSelector::
+  SetThresholds(const f32* a_pixels, tl_size a_numThresholds, f32 a_hysteresis)
+{
+  m_coarserSq.resize(a_numThresholds);
+  m_finerSq.resize(a_numThresholds);
+
+  for (tl_size i = 0; i < a_numThresholds; ++i)
+  {
+    const f32 coarser = a_pixels[i] * (1.0f - a_hysteresis);
+    const f32 finer = a_pixels[i] * (1.0f + a_hysteresis);
+    m_coarserSq[i] = coarser * coarser;
+    m_finerSq[i] = finer * finer;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+LodSelector::
+  AddMesh(const IndexedMesh& a_mesh)
+{
+  uint_cont numTriangles;
+  numTriangles.push_back((u32)(a_mesh.GetNumIndices() / 3));
+  for (tl_size i = 0; i < a_mesh.m_lods.size(); ++i)
+  { numTriangles.push_back((u32)(a_mesh.m_lods[i].m_indices.size() / 3)); }
+
+  return DoAddMesh(numTriangles);
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+LodSelector::
+  AddMesh(const CookedMesh& a_mesh)
+{
+  uint_cont numTriangles;
+  numTriangles.push_back((u32)(a_mesh.GetNumIndices() / 3));
+  for (tl_size i = 0; i < a_mesh.GetNumLods(); ++i)
+  { numTriangles.push_back(a_mesh.GetLod(i).m_numIndices / 3); }
+
+  return DoAddMesh(numTriangles);
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+LodSelector::
+  DoAddMesh(const uint_cont& a_numTriangles)
+{
+  m_meshFirstLod.push_back((u32)m_meshTriangles.size());
+  m_meshNumLods.push_back((u32)a_numTriangles.size());
+  m_meshTriangles.insert(m_meshTriangles.end(), 
+                         a_numTriangles.begin(), a_numTriangles.end());
+
+  return m_meshNumLods.size() - 1;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+LodSelector::
+  AddInstance(tl_size a_mesh, const f32* a_center, f32 a_radius)
+{
+  TLOC_ASSERT(a_mesh < m_meshNumLods.size(), "Index out of bounds");
+
+  m_centerX.push_back(a_center[0]);
+  m_centerY.push_back(a_center[1]);
+  m_centerZ.push_back(a_center[2]);
+  m_radius.push_back(a_radius);
+  m_meshes.push_back((u32)a_mesh);
+  m_lods.push_back(0);
+
+  return m_lods.size() - 1;
+}
+
+// -----------------------------------------------------------------------
+
+void
+LodSelector::
+  SetBounds(tl_size a_instance, const f32* a_center, f32 a_radius)
+{
+  TLOC_ASSERT(a_instance < GetNumInstances(), "Index out of bounds");
+
+  m_centerX[a_instance] = a_center[0];
+  m_centerY[a_instance] = a_center[1];
+  m_centerZ[a_instance] = a_center[2];
+  m_radius[a_instance] = a_radius;
+}
+
+// -----------------------------------------------------------------------
+
+void
+LodSelector::
+  Clear()
+{
+  m_meshFirstLod.clear();
+  m_meshNumLods.clear();
+  m_meshTriangles.clear();
+
+  m_centerX.clear();
+  m_centerY.clear();
+  m_centerZ.clear();
+  m_radius.clear();
+  m_meshes.clear();
+  m_lods.clear();
+}
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+  struct SelectionData
+  {
+    f32         m_position[3];
+    f32         m_scaleSq;
+
+    const f32*  m_centerX;
+    const f32*  m_centerY;
+    const f32*  m_centerZ;
+    const f32*  m_radius;
+    const u32*  m_meshes;
+    u32*        m_lods;
+
+    const f32*  m_coarserSq;
+    const f32*  m_finerSq;
+    const u32*  m_meshLastLod;
+    const u32*  m_meshFirstLod;
+    const u32*  m_meshTriangles;
+  };
+
+  // Sizes are compared squared and multiplied through by the squared
+  // distance (diameter^2 * d^2 = 4 r^2 ppu^2), so there is no square root or
+  // division per instance. The sums are kept in locals (not in the shared
+  // variables of the parallel loop) so that the loop stays tight.
+  void  DoSelect(const SelectionData& a_data, tl_int a_begin, tl_int a_end,
+                 s64& a_numChanged, s64& a_numTriangles, s64& a_numSaved)
+  {
+    const f32 cameraX = a_data.m_position[0];
+    const f32 cameraY = a_data.m_position[1];
+    const f32 cameraZ = a_data.m_position[2];
+    const f32 scaleSq = a_data.m_scaleSq;
+
+    s64 numChanged = 0;
+    s64 numTriangles = 0;
+    s64 numSaved = 0;
+
+    for (tl_int i = a_begin; i < a_end; ++i)
+    {
+      const f32 dx = a_data.m_centerX[i] - cameraX;
+      const f32 dy = a_data.m_centerY[i] - cameraY;
+      const f32 dz = a_data.m_centerZ[i] - cameraZ;
+      const f32 distSq = dx * dx + dy * dy + dz * dz;
+      const f32 sizeDistSq = scaleSq * a_data.m_radius[i] * a_data.m_radius[i];
+
+      const u32 mesh = a_data.m_meshes[i];
+      const u32 lastLod = a_data.m_meshLastLod[mesh];
+      const u32 prevLod = a_data.m_lods[i];
+
+      u32 lod = core::tlMin(prevLod, lastLod);
+      while (lod < lastLod && sizeDistSq < a_data.m_coarserSq[lod] * distSq)
+      { ++lod; }
+      while (lod > 0 && sizeDistSq > a_data.m_finerSq[lod - 1] * distSq)
+      { --lod; }
+
+      if (lod != prevLod)
+      {
+        a_data.m_lods[i] = lod;
+        ++numChanged;
+      }
+
+      const u32* triangles = a_data.m_meshTriangles + a_data.m_meshFirstLod[mesh];
+      numTriangles += triangles[lod];
+      numSaved += triangles[0] - triangles[lod];
+    }
+
+    a_numChanged += numChanged;
+    a_numTriangles += numTriangles;
+    a_numSaved += numSaved;
+  }
+
+};
+
+LodSelectionStats
+LodSelector::
+  Select(const LodCamera& a_camera, tl_int a_numThreads)
+{
+  const tl_int  numInstances = (tl_int)GetNumInstances();
+  const u32     numThresholds = (u32)m_coarserSq.size();
+
+  // the last LOD of each mesh that has a threshold
+  uint_cont lastLods(m_meshNumLods.size());
+  for (tl_size i = 0; i < lastLods.size(); ++i)
+  { lastLods[i] = core::tlMin(m_meshNumLods[i] - 1, numThresholds); }
+
+  SelectionData data;
+  for (tl_int i = 0; i < 3; ++i)
+  { data.m_position[i] = a_camera.m_position[i]; }
+  data.m_scaleSq = 4.0f * a_camera.m_pixelsPerUnit * a_camera.m_pixelsPerUnit;
+
+  data.m_centerX = numInstances ? &m_centerX[0] : nullptr;
+  data.m_centerY = numInstances ? &m_centerY[0] : nullptr;
+  data.m_centerZ = numInstances ? &m_centerZ[0] : nullptr;
+  data.m_radius = numInstances ? &m_radius[0] : nullptr;
+  data.m_meshes = numInstances ? &m_meshes[0] : nullptr;
+  data.m_lods = numInstances ? &m_lods[0] : nullptr;
+
+  data.m_coarserSq = numThresholds ? &m_coarserSq[0] : nullptr;
+  data.m_finerSq = numThresholds ? &m_finerSq[0] : nullptr;
+  data.m_meshLastLod = lastLods.empty() ? nullptr : &lastLods[0];
+  data.m_meshFirstLod = m_meshFirstLod.empty() ? nullptr : &m_meshFirstLod[0];
+  data.m_meshTriangles = m_meshTriangles.empty() ? nullptr : &m_meshTriangles[0];
+
+  s64 numChanged = 0;
+  s64 numTriangles = 0;
+  s64 numSaved = 0;
+
+  // one contiguous range per thread, small selections stay on this thread
+  const tl_int numRanges = numInstances < g_minInstancesPerThread * 2 
+    ? 1 
+    : core::tlMin(a_numThreads, numInstances / g_minInstancesPerThread);
+
+#pragma omp parallel for schedule(static, 1) num_threads(numRanges) \
+  reduction(+:numChanged, numTriangles, numSaved)
+  for (tl_int range = 0; range < numRanges; ++range)
+  {
+    const tl_int begin = (tl_int)((s64)numInstances * range / numRanges);
+    const tl_int end = (tl_int)((s64)numInstances * (range + 1) / numRanges);
+    DoSelect(data, begin, end, numChanged, numTriangles, numSaved);
+  }
+
+  LodSelectionStats stats;
+  stats.m_numChanged = (tl_size)numChanged;
+  stats.m_numTriangles = (u64)numTriangles;
+  stats.m_numTrianglesSaved = (u64)numSaved;
+  return stats;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+LodSelector::
+  GetNumInstances() const
+{ return m_lods.size(); }
+
+// -----------------------------------------------------------------------
+
+u32
+LodSelector::
+  GetLod(tl_size a_instance) const
+{
+  TLOC_ASSERT(a_instance < GetNumInstances(), "Index out of bounds");
+  return m_lods[a_instance];
+}
@@ -0,0 +1,81 @@
+#ifndef _TLOC_MESH_TOOLS_LOD_SELECTOR_H_
+#define _TLOC_MESH_TOOLS_LOD_SELECTOR_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "cookedMesh.h"
+#include "indexedMesh.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// The view the LODs are selected for. m_pixelsPerUnit is the size in
+// pixels of one unit at a distance of one unit: 
+// viewportHeight / (2 * tan(verticalFov / 2)).
+
+struct LodCamera
+{
+  f32 m_position[3];
+  f32 m_pixelsPerUnit;
+};
+
+struct LodSelectionStats
+{
+  tl_size m_numChanged;
+  u64     m_numTriangles;
+  u64     m_numTrianglesSaved;  // compared to drawing every LOD 0
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Picks a LOD per instance from the diameter in pixels of its bounding
+// sphere. LOD i + 1 is used below a_pixels[i] (see SetThresholds()), an
+// instance with fewer LODs uses its last one.
+//
+// The bounds of the instances are kept in contiguous arrays, so a
+// selection pass only streams through a few floats per instance. An
+// instance only changes LOD once its size is a_hysteresis (a fraction)
+// past the threshold, which stops it popping back and forth at the edge.
+
+class LodSelector
+{
+public:
+  LodSelector();
+
+  void      SetThresholds(const f32* a_pixels, tl_size a_numThresholds, 
+                          f32 a_hysteresis = 0.1f);
+
+  tl_size   AddMesh(const IndexedMesh& a_mesh);
+  tl_size   AddMesh(const CookedMesh& a_mesh);
+  tl_size   AddInstance(tl_size a_mesh, const f32* a_center, f32 a_radius);
+  void      SetBounds(tl_size a_instance, const f32* a_center, f32 a_radius);
+  void      Clear();
+
+  LodSelectionStats Select(const LodCamera& a_camera, tl_int a_numThreads = 1);
+
+  tl_size   GetNumInstances() const;
+  u32       GetLod(tl_size a_instance) const;
+
+private:
+  typedef tl_core_conts::Array<f32>   float_cont;
+  typedef tl_core_conts::Array<u32>   uint_cont;
+
+  tl_size   DoAddMesh(const uint_cont& a_numTriangles);
+
+  // squared thresholds, with the hysteresis applied when going to a less
+  // (m_coarserSq) or more (m_finerSq) detailed LOD
+  float_cont  m_coarserSq;
+  float_cont  m_finerSq;
+
+  // per mesh: its first entry in m_meshTriangles and number of LODs
+  uint_cont   m_meshFirstLod;
+  uint_cont   m_meshNumLods;
+  uint_cont   m_meshTriangles;
+
+  // per instance
+  float_cont  m_centerX;
+  float_cont  m_centerY;
+  float_cont  m_centerZ;
+  float_cont  m_radius;
+  uint_cont   m_meshes;
+  uint_cont   m_lods;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "mappedFile.h"
+
+#if defined (TLOC_OS_WIN)
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+// ///////////////////////////////////////////////////////////////////////
+// MappedFile
+
+#if defined (TLOC_OS_WIN)
+
+MappedFile::
+  MappedFile()
+  : m_data(nullptr)
+  , m_size(0)
+  , m_file(INVALID_HANDLE_VALUE)
+  , m_mapping(nullptr)
+{ }
+
+#else
+
+MappedFile::
+  MappedFile()
+  : m_data(nullptr)
+  , m_size(0)
+  , m_file(-1)
+{ }
+
+#endif
+
+// -----------------------------------------------------------------------
+
+MappedFile::
+  ~MappedFile()
+{ Close(); }
+
+// -----------------------------------------------------------------------
+
+bool
+MappedFile::
+  Open(const char* a_fileName)
+{
+  Close();
+
+#if defined (TLOC_OS_WIN)
+  m_file = CreateFileA(a_fileName, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                       OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (m_file == INVALID_HANDLE_VALUE)
+  { return false; }
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(m_file, &size) == FALSE)
+  { Close(); return false; }
+
+  m_size = (tl_size)size.QuadPart;
+  if (m_size == 0)
+  { return true; }
+
+  m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (m_mapping == nullptr)
+  { Close(); return false; }
+
+  m_data = static_cast<const char*>
+    (MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+  if (m_data == nullptr)
+  { Close(); return false; }
+#else
+  m_file = open(a_fileName, O_RDONLY);
+  if (m_file < 0)
+  { return false; }
+
+  struct stat info;
+  if (fstat(m_file, &info) != 0)
+  { Close(); return false; }
+
+  m_size = (tl_size)info.st_size;
+  if (m_size == 0)
+  { return true; }
+
+  void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+  if (data == MAP_FAILED)
+  { Close(); return false; }
+
+  // the view is read front to back once
+  madvise(data, m_size, MADV_SEQUENTIAL);
+  m_data = static_cast<const char*>(data);
+#endif
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+void
+MappedFile::
+  Close()
+{
+#if defined (TLOC_OS_WIN)
+  if (m_data)
+  { UnmapViewOfFile(m_data); }
+  if (m_mapping)
+  { CloseHandle(m_mapping); }
+  if (m_file != INVALID_HANDLE_VALUE)
+  { CloseHandle(m_file); }
+
+  m_mapping = nullptr;
+  m_file = INVALID_HANDLE_VALUE;
+#else
+  if (m_data)
+  { munmap(const_cast<char*>(m_data), m_size); }
+  if (m_file >= 0)
+  { close(m_file); }
+
+  m_file = -1;
+#endif
+
+  m_data = nullptr;
+  m_size = 0;
+}
+
+// -----------------------------------------------------------------------
+
+const char*
+MappedFile::
+  GetData() const
+{ return m_data; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+MappedFile::
+  GetSize() const
+{ return m_size; }
@@ -0,0 +1,39 @@
+#ifndef _TLOC_MESH_TOOLS_MAPPED_FILE_H_
+#define _TLOC_MESH_TOOLS_MAPPED_FILE_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// Read only view of a whole file mapped into memory. The pages are loaded
+// by the OS as they are touched, so parsing straight from the view never
+// holds a second copy of the file.
+
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  bool        Open(const char* a_fileName);
+  void        Close();
+
+  const char* GetData() const;
+  tl_size     GetSize() const;
+
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+
+private:
+  const char* m_data;
+  tl_size     m_size;
+
+#if defined (TLOC_OS_WIN)
+  void*       m_file;
+  void*       m_mapping;
+#else
+  int         m_file;
+#endif
+};
+
+#endif
@@ -0,0 +1,570 @@
+#include "meshOptimizer.h"
+
+#include <cmath>
+
+using namespace tloc;
+
+namespace {
+
+  typedef tl_core_conts::Array<u32>       index_cont;
+
+  const u32 g_noVertex = 0xFFFFFFFF;
+
+  // -----------------------------------------------------------------------
+  // FIFO post-transform cache. A vertex is in the cache if less than
+  // m_size vertices were transformed after it. Reset() evicts everything.
+
+  class FifoCache
+  {
+  public:
+    FifoCache(tl_size a_numVertices, tl_size a_size)
+      : m_timeStamps(a_numVertices, 0)
+      , m_time(a_size + 1)
+      , m_size(a_size)
+    { }
+
+    bool  IsCached(u32 a_vertex) const
+    { return m_time - m_timeStamps[a_vertex] <= m_size; }
+
+    // returns true if the vertex had to be transformed
+    bool  Access(u32 a_vertex)
+    {
+      if (IsCached(a_vertex))
+      { return false; }
+
+      m_timeStamps[a_vertex] = m_time++;
+      return true;
+    }
+
+    void  Reset()
+    { m_time += m_size + 1; }
+
+    // number of vertices transformed since a_vertex was
+    tl_size GetAge(u32 a_vertex) const
+    { return m_time - m_timeStamps[a_vertex]; }
+
+  private:
+    tl_core_conts::Array<tl_size> m_timeStamps;
+    tl_size                       m_time;
+    tl_size                       m_size;
+  };
+
+  // -----------------------------------------------------------------------
+
+  void  DoGetIndices(const IndexedMesh& a_mesh, index_cont& a_out)
+  {
+    a_out.resize(a_mesh.GetNumIndices());
+    for (tl_size i = 0; i < a_out.size(); ++i)
+    { a_out[i] = (u32)a_mesh.GetIndex(i); }
+  }
+
+  void  DoSetIndices(const index_cont& a_indices, IndexedMesh& a_mesh)
+  {
+    if (a_mesh.m_indices.empty() == false)
+    { a_mesh.m_indices = a_indices; return; }
+
+    for (tl_size i = 0; i < a_indices.size(); ++i)
+    { a_mesh.m_shortIndices[i] = (u16)a_indices[i]; }
+  }
+
+  // an index list without groups is one range
+  typedef tl_core_conts::Array<ObjGroup>  group_cont;
+
+  tl_size DoGetNumRanges(const group_cont& a_groups)
+  { return a_groups.empty() ? 1 : a_groups.size(); }
+
+  void  DoGetRange(const index_cont& a_indices, const group_cont& a_groups, 
+                   tl_size a_range, tl_size& a_firstTriangle, 
+                   tl_size& a_numTriangles)
+  {
+    if (a_groups.empty())
+    {
+      a_firstTriangle = 0;
+      a_numTriangles = a_indices.size() / 3;
+      return;
+    }
+
+    a_firstTriangle = a_groups[a_range].m_firstTriangle;
+    a_numTriangles = a_groups[a_range].m_numTriangles;
+  }
+
+  // -----------------------------------------------------------------------
+  // Tipsify on a_numTriangles triangles. The arrays are sized for every
+  // vertex of the mesh and only the entries of the range are touched, so
+  // they are allocated once for all groups.
+
+  struct TipsifyScratch
+  {
+    explicit TipsifyScratch(tl_size a_numVertices)
+      : m_live(a_numVertices, 0)
+      , m_adjacencyBegin(a_numVertices, 0)
+      , m_adjacencyEnd(a_numVertices, 0)
+    { }
+
+    index_cont                m_live;
+    index_cont                m_adjacencyBegin;
+    index_cont                m_adjacencyEnd;
+    index_cont                m_adjacency;
+    index_cont                m_vertices;
+    index_cont                m_deadEnd;
+    index_cont                m_candidates;
+    tl_core_conts::Array<u8>  m_emitted;
+  };
+
+  void  DoTipsify(const u32* a_in, tl_size a_numTriangles, FifoCache& a_cache,
+                  tl_size a_cacheSize, TipsifyScratch& a_scratch, u32* a_out)
+  {
+    TipsifyScratch& s = a_scratch;
+
+    // vertex -> triangle adjacency, m_live is the number of triangles of a
+    // vertex that still have to be emitted
+    s.m_vertices.clear();
+    for (tl_size i = 0; i < a_numTriangles * 3; ++i)
+    {
+      if (s.m_live[a_in[i]]++ == 0)
+      { s.m_vertices.push_back(a_in[i]); }
+    }
+
+    u32 numAdjacent = 0;
+    for (tl_size i = 0; i < s.m_vertices.size(); ++i)
+    {
+      const u32 v = s.m_vertices[i];
+      s.m_adjacencyBegin[v] = numAdjacent;
+      s.m_adjacencyEnd[v] = numAdjacent;
+      numAdjacent += s.m_live[v];
+    }
+
+    s.m_adjacency.resize(numAdjacent);
+    for (tl_size i = 0; i < a_numTriangles * 3; ++i)
+    { s.m_adjacency[s.m_adjacencyEnd[a_in[i]]++] = (u32)(i / 3); }
+
+    s.m_emitted.clear();
+    s.m_emitted.resize(a_numTriangles, 0);
+    s.m_deadEnd.clear();
+
+    tl_size numEmitted = 0;
+    tl_size nextScan = 0;
+    u32     fanning = s.m_vertices.empty() ? g_noVertex : s.m_vertices[0];
+
+    while (fanning != g_noVertex)
+    {
+      // emit every remaining triangle around the fanning vertex
+      s.m_candidates.clear();
+      for (u32 a = s.m_adjacencyBegin[fanning]; a < s.m_adjacencyEnd[fanning]; ++a)
+      {
+        const u32 t = s.m_adjacency[a];
+        if (s.m_emitted[t])
+        { continue; }
+
+        for (tl_int j = 0; j < 3; ++j)
+        {
+          const u32 v = a_in[t * 3 + j];
+          a_out[numEmitted * 3 + j] = v;
+
+          s.m_deadEnd.push_back(v);
+          s.m_candidates.push_back(v);
+          --s.m_live[v];
+          a_cache.Access(v);
+        }
+
+        s.m_emitted[t] = 1;
+        ++numEmitted;
+      }
+
+      // the next fanning vertex is the candidate that will still be in the
+      // cache after its triangles are emitted and has been in it longest
+      fanning = g_noVertex;
+      tl_size bestPriority = 0;
+      for (tl_size i = 0; i < s.m_candidates.size(); ++i)
+      {
+        const u32 v = s.m_candidates[i];
+        if (s.m_live[v] == 0)
+        { continue; }
+
+        const tl_size age = a_cache.GetAge(v);
+        const tl_size priority = age + 2 * s.m_live[v] <= a_cacheSize ? age + 1 : 1;
+        if (priority > bestPriority)
+        {
+          bestPriority = priority;
+          fanning = v;
+        }
+      }
+
+      // dead end: the most recent vertex with triangles left, or any
+      while (fanning == g_noVertex && s.m_deadEnd.empty() == false)
+      {
+        const u32 v = s.m_deadEnd.back();
+        s.m_deadEnd.pop_back();
+        if (s.m_live[v] > 0)
+        { fanning = v; }
+      }
+
+      for (; fanning == g_noVertex && nextScan < s.m_vertices.size(); ++nextScan)
+      {
+        if (s.m_live[s.m_vertices[nextScan]] > 0)
+        { fanning = s.m_vertices[nextScan]; }
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Overdraw
+
+  struct Cluster
+  {
+    tl_size   m_firstTriangle;
+    tl_size   m_numTriangles;
+    f32       m_sortKey;
+  };
+
+  void  DoGetTriangle(const IndexedMesh& a_mesh, const u32* a_triangle,
+                      f32* a_centroid, f32* a_normal)
+  {
+    const f32* p0 = a_mesh.m_vertices[a_triangle[0]].m_position;
+    const f32* p1 = a_mesh.m_vertices[a_triangle[1]].m_position;
+    const f32* p2 = a_mesh.m_vertices[a_triangle[2]].m_position;
+
+    const f32 e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    const f32 e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+    // not normalized: twice the area, so sums are area weighted
+    a_normal[0] = e0[1] * e1[2] - e0[2] * e1[1];
+    a_normal[1] = e0[2] * e1[0] - e0[0] * e1[2];
+    a_normal[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+    for (tl_int i = 0; i < 3; ++i)
+    { a_centroid[i] = (p0[i] + p1[i] + p2[i]) / 3.0f; }
+  }
+
+  // clusters facing outwards (from the centroid of the range) come first
+  void  DoSetSortKeys(const IndexedMesh& a_mesh, const u32* a_indices,
+                      tl_core_conts::Array<Cluster>& a_clusters)
+  {
+    f32 rangeCentroid[3] = { 0, 0, 0 };
+    f32 rangeArea = 0;
+
+    tl_core_conts::Array<f32> clusterData(a_clusters.size() * 7, 0.0f);
+    for (tl_size c = 0; c < a_clusters.size(); ++c)
+    {
+      f32* centroid = &clusterData[c * 7];
+      f32* normal = centroid + 3;
+      f32& area = centroid[6];
+
+      const Cluster& cluster = a_clusters[c];
+      for (tl_size t = 0; t < cluster.m_numTriangles; ++t)
+      {
+        f32 triCentroid[3], triNormal[3];
+        DoGetTriangle(a_mesh, a_indices + (cluster.m_firstTriangle + t) * 3, 
+                      triCentroid, triNormal);
+
+        const f32 triArea = sqrtf(triNormal[0] * triNormal[0] + 
+          triNormal[1] * triNormal[1] + triNormal[2] * triNormal[2]);
+
+        for (tl_int i = 0; i < 3; ++i)
+        {
+          centroid[i] += triCentroid[i] * triArea;
+          normal[i] += triNormal[i];
+          rangeCentroid[i] += triCentroid[i] * triArea;
+        }
+        area += triArea;
+        rangeArea += triArea;
+      }
+    }
+
+    for (tl_int i = 0; i < 3; ++i)
+    { rangeCentroid[i] = rangeArea > 0 ? rangeCentroid[i] / rangeArea : 0; }
+
+    for (tl_size c = 0; c < a_clusters.size(); ++c)
+    {
+      const f32* centroid = &clusterData[c * 7];
+      const f32* normal = centroid + 3;
+      const f32  area = centroid[6];
+      const f32  normalLength = 
+        sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+      f32 key = 0;
+      if (area > 0 && normalLength > 0)
+      {
+        for (tl_int i = 0; i < 3; ++i)
+        { key += (centroid[i] / area - rangeCentroid[i]) * normal[i]; }
+        key /= normalLength;
+      }
+
+      a_clusters[c].m_sortKey = key;
+    }
+  }
+
+  // stable merge sort, largest key first
+  void  DoSortClusters(tl_core_conts::Array<Cluster>& a_clusters)
+  {
+    tl_core_conts::Array<Cluster> temp(a_clusters.size());
+
+    for (tl_size width = 1; width < a_clusters.size(); width *= 2)
+    {
+      for (tl_size begin = 0; begin < a_clusters.size(); begin += width * 2)
+      {
+        const tl_size mid = core::tlMin(begin + width, a_clusters.size());
+        const tl_size end = core::tlMin(begin + width * 2, a_clusters.size());
+
+        tl_size left = begin, right = mid, out = begin;
+        while (left < mid && right < end)
+        {
+          temp[out++] = a_clusters[right].m_sortKey > a_clusters[left].m_sortKey 
+            ? a_clusters[right++] : a_clusters[left++];
+        }
+        while (left < mid)  { temp[out++] = a_clusters[left++]; }
+        while (right < end) { temp[out++] = a_clusters[right++]; }
+      }
+
+      a_clusters.swap(temp);
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Hard boundaries are triangles that miss the cache with all three
+  // vertices. Each hard cluster is split again as soon as the ACMR of the
+  // part so far is within a_threshold of the ACMR of the whole cluster.
+
+  void  DoGetClusters(const u32* a_indices, tl_size a_numTriangles, 
+                      FifoCache& a_cache, f32 a_threshold,
+                      tl_core_conts::Array<Cluster>& a_clusters)
+  {
+    index_cont hardBoundaries;
+    a_cache.Reset();
+    for (tl_size t = 0; t < a_numTriangles; ++t)
+    {
+      tl_int misses = 0;
+      for (tl_int j = 0; j < 3; ++j)
+      { misses += a_cache.Access(a_indices[t * 3 + j]) ? 1 : 0; }
+
+      if (t == 0 || misses == 3)
+      { hardBoundaries.push_back((u32)t); }
+    }
+    hardBoundaries.push_back((u32)a_numTriangles);
+
+    a_clusters.clear();
+    for (tl_size h = 0; h + 1 < hardBoundaries.size(); ++h)
+    {
+      const tl_size begin = hardBoundaries[h];
+      const tl_size end = hardBoundaries[h + 1];
+
+      tl_size misses = 0;
+      a_cache.Reset();
+      for (tl_size t = begin; t < end; ++t)
+      {
+        for (tl_int j = 0; j < 3; ++j)
+        { misses += a_cache.Access(a_indices[t * 3 + j]) ? 1 : 0; }
+      }
+
+      const f32 targetAcmr = (f32)misses / (f32)(end - begin) * a_threshold;
+
+      Cluster cluster;
+      cluster.m_firstTriangle = begin;
+      cluster.m_sortKey = 0;
+
+      misses = 0;
+      a_cache.Reset();
+      for (tl_size t = begin; t < end; ++t)
+      {
+        for (tl_int j = 0; j < 3; ++j)
+        { misses += a_cache.Access(a_indices[t * 3 + j]) ? 1 : 0; }
+
+        const tl_size numTriangles = t + 1 - cluster.m_firstTriangle;
+        if (t + 1 == end || (f32)misses / (f32)numTriangles <= targetAcmr)
+        {
+          cluster.m_numTriangles = numTriangles;
+          a_clusters.push_back(cluster);
+
+          cluster.m_firstTriangle = t + 1;
+          misses = 0;
+          a_cache.Reset();
+        }
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // The optimizations on one index list (the mesh or a LOD)
+
+  void  DoOptimizeVertexCache(index_cont& a_indices, const group_cont& a_groups,
+                              tl_size a_numVertices, tl_size a_cacheSize)
+  {
+    index_cont optimized(a_indices.size());
+
+    FifoCache      cache(a_numVertices, a_cacheSize);
+    TipsifyScratch scratch(a_numVertices);
+
+    for (tl_size r = 0; r < DoGetNumRanges(a_groups); ++r)
+    {
+      tl_size firstTriangle, numTriangles;
+      DoGetRange(a_indices, a_groups, r, firstTriangle, numTriangles);
+
+      if (numTriangles > 0)
+      {
+        DoTipsify(&a_indices[firstTriangle * 3], numTriangles, cache, a_cacheSize,
+                  scratch, &optimized[firstTriangle * 3]);
+      }
+    }
+
+    a_indices.swap(optimized);
+  }
+
+  void  DoOptimizeOverdraw(const IndexedMesh& a_mesh, index_cont& a_indices, 
+                           const group_cont& a_groups, f32 a_threshold, 
+                           tl_size a_cacheSize)
+  {
+    FifoCache cache(a_mesh.m_vertices.size(), a_cacheSize);
+
+    tl_core_conts::Array<Cluster> clusters;
+    index_cont                    sorted;
+
+    for (tl_size r = 0; r < DoGetNumRanges(a_groups); ++r)
+    {
+      tl_size firstTriangle, numTriangles;
+      DoGetRange(a_indices, a_groups, r, firstTriangle, numTriangles);
+      if (numTriangles == 0)
+      { continue; }
+
+      u32* rangeIndices = &a_indices[firstTriangle * 3];
+
+      DoGetClusters(rangeIndices, numTriangles, cache, a_threshold, clusters);
+      if (clusters.size() < 2)
+      { continue; }
+
+      DoSetSortKeys(a_mesh, rangeIndices, clusters);
+      DoSortClusters(clusters);
+
+      sorted.clear();
+      for (tl_size c = 0; c < clusters.size(); ++c)
+      {
+        const u32* begin = rangeIndices + clusters[c].m_firstTriangle * 3;
+        sorted.insert(sorted.end(), begin, begin + clusters[c].m_numTriangles * 3);
+      }
+
+      for (tl_size i = 0; i < sorted.size(); ++i)
+      { rangeIndices[i] = sorted[i]; }
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Statistics
+
+VertexCacheStats
+  AnalyzeVertexCache(const IndexedMesh& a_mesh, tl_size a_cacheSize)
+{
+  VertexCacheStats stats;
+  stats.m_numTransformed = 0;
+
+  FifoCache cache(a_mesh.m_vertices.size(), a_cacheSize);
+  for (tl_size i = 0; i < a_mesh.GetNumIndices(); ++i)
+  {
+    if (cache.Access( (u32)a_mesh.GetIndex(i)))
+    { ++stats.m_numTransformed; }
+  }
+
+  const tl_size numTriangles = a_mesh.GetNumIndices() / 3;
+  stats.m_acmr = numTriangles 
+    ? (f32)stats.m_numTransformed / (f32)numTriangles : 0.0f;
+  stats.m_atvr = a_mesh.m_vertices.empty() 
+    ? 0.0f : (f32)stats.m_numTransformed / (f32)a_mesh.m_vertices.size();
+
+  return stats;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Optimizations
+
+void
+  OptimizeVertexCache(IndexedMesh& a_mesh, tl_size a_cacheSize)
+{
+  index_cont indices;
+  DoGetIndices(a_mesh, indices);
+  DoOptimizeVertexCache(indices, a_mesh.m_groups, a_mesh.m_vertices.size(), 
+                        a_cacheSize);
+  DoSetIndices(indices, a_mesh);
+  a_mesh.m_meshlets.clear();
+
+  for (tl_size i = 0; i < a_mesh.m_lods.size(); ++i)
+  {
+    MeshLod& lod = a_mesh.m_lods[i];
+    DoOptimizeVertexCache(lod.m_indices, lod.m_groups, a_mesh.m_vertices.size(), 
+                          a_cacheSize);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+  OptimizeOverdraw(IndexedMesh& a_mesh, f32 a_threshold, tl_size a_cacheSize)
+{
+  index_cont indices;
+  DoGetIndices(a_mesh, indices);
+  DoOptimizeOverdraw(a_mesh, indices, a_mesh.m_groups, a_threshold, a_cacheSize);
+  DoSetIndices(indices, a_mesh);
+  a_mesh.m_meshlets.clear();
+
+  for (tl_size i = 0; i < a_mesh.m_lods.size(); ++i)
+  {
+    MeshLod& lod = a_mesh.m_lods[i];
+    DoOptimizeOverdraw(a_mesh, lod.m_indices, lod.m_groups, a_threshold, 
+                       a_cacheSize);
+  }
+}
+
+// -----------------------------------------------------------------------
+// Unused vertices are kept (at the end). LODs only use vertices of the
+// mesh, so the mesh decides the order.
+
+void
+  OptimizeVertexFetch(IndexedMesh& a_mesh)
+{
+  index_cont indices;
+  DoGetIndices(a_mesh, indices);
+
+  index_cont remap(a_mesh.m_vertices.size(), g_noVertex);
+  tl_core_conts::Array<MeshVertex> vertices;
+  vertices.reserve(a_mesh.m_vertices.size());
+
+  for (tl_size i = 0; i < indices.size(); ++i)
+  {
+    u32& newIndex = remap[indices[i]];
+    if (newIndex == g_noVertex)
+    {
+      newIndex = (u32)vertices.size();
+      vertices.push_back(a_mesh.m_vertices[indices[i]]);
+    }
+
+    indices[i] = newIndex;
+  }
+
+  for (tl_size v = 0; v < remap.size(); ++v)
+  {
+    if (remap[v] == g_noVertex)
+    {
+      remap[v] = (u32)vertices.size();
+      vertices.push_back(a_mesh.m_vertices[v]);
+    }
+  }
+
+  a_mesh.m_vertices.swap(vertices);
+  DoSetIndices(indices, a_mesh);
+
+  for (tl_size i = 0; i < a_mesh.m_lods.size(); ++i)
+  {
+    index_cont& lodIndices = a_mesh.m_lods[i].m_indices;
+    for (tl_size j = 0; j < lodIndices.size(); ++j)
+    { lodIndices[j] = remap[lodIndices[j]]; }
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+  OptimizeMesh(IndexedMesh& a_mesh, tl_size a_cacheSize)
+{
+  OptimizeVertexCache(a_mesh, a_cacheSize);
+  OptimizeOverdraw(a_mesh, 1.05f, a_cacheSize);
+  OptimizeVertexFetch(a_mesh);
+}
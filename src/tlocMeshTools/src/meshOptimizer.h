@@ -0,0 +1,49 @@
+#ifndef _TLOC_MESH_TOOLS_MESH_OPTIMIZER_H_
+#define _TLOC_MESH_TOOLS_MESH_OPTIMIZER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Post-transform vertex cache statistics of the index list, simulated with
+// a FIFO cache of a_cacheSize vertices:
+//
+//   ACMR: transformed vertices per triangle (0.5 is the best possible for
+//         a regular grid, 3 is every vertex transformed every time)
+//   ATVR: transformed vertices per vertex (1 is the best possible)
+
+struct VertexCacheStats
+{
+  f32       m_acmr;
+  f32       m_atvr;
+  tl_size   m_numTransformed;
+};
+
+VertexCacheStats  AnalyzeVertexCache(const IndexedMesh& a_mesh, 
+                                     tl_size a_cacheSize = 16);
+
+// ///////////////////////////////////////////////////////////////////////
+// Optimizations of the mesh and its LODs. Every one of them keeps the
+// triangles of a group within the group (groups stay valid triangle
+// ranges), only the order changes. OptimizeVertexCache() and
+// OptimizeOverdraw() clear the meshlets, which would no longer be triangle
+// ranges.
+//
+// OptimizeVertexCache: reorders the triangles for the post-transform cache
+//   (Tipsify, Sander et al. 2007).
+// OptimizeOverdraw: splits the triangles into clusters at cache restarts
+//   and where the ACMR of the cluster is within a_threshold of the whole
+//   cluster, then draws the clusters that face outwards first. The ACMR
+//   gets at most a_threshold times worse.
+// OptimizeVertexFetch: orders the vertices by first use, which has to be
+//   done last since it depends on the triangle order.
+// OptimizeMesh: all of the above, in that order.
+
+void  OptimizeVertexCache(IndexedMesh& a_mesh, tl_size a_cacheSize = 16);
+void  OptimizeOverdraw(IndexedMesh& a_mesh, f32 a_threshold = 1.05f, 
+                       tl_size a_cacheSize = 16);
+void  OptimizeVertexFetch(IndexedMesh& a_mesh);
+void  OptimizeMesh(IndexedMesh& a_mesh, tl_size a_cacheSize = 16);
+
+#endif
@@ -0,0 +1,754 @@
+#include "meshSimplifier.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  typedef tl_core_conts::Array<u32>       index_cont;
+
+  const u32 g_noVertex = 0xFFFFFFFF;
+  const u32 g_multiple = 0xFFFFFFFE;
+
+  // border and seam edges are this much harder to move away from
+  const f64 g_edgeWeight = 10.0;
+
+  // a pass collapses edges up to this much more than the error of the
+  // edge that would reach the target if every collapse was taken
+  const f32 g_passErrorScale = 1.5f;
+
+  enum { k_manifold = 0, k_border, k_seam, k_locked };
+
+  // -----------------------------------------------------------------------
+  // Quadric of the (weighted) squared distance to a set of planes
+
+  struct Quadric
+  {
+    f64   m_a00, m_a11, m_a22, m_a10, m_a20, m_a21;
+    f64   m_b0, m_b1, m_b2;
+    f64   m_c;
+    f64   m_weight;
+  };
+
+  void  DoAddPlane(Quadric& a_q, const f64* a_normal, f64 a_distance, f64 a_weight)
+  {
+    const f64 a = a_normal[0], b = a_normal[1], c = a_normal[2], d = a_distance;
+    const f64 w = a_weight;
+
+    a_q.m_a00 += w * a * a;  a_q.m_a11 += w * b * b;  a_q.m_a22 += w * c * c;
+    a_q.m_a10 += w * b * a;  a_q.m_a20 += w * c * a;  a_q.m_a21 += w * c * b;
+    a_q.m_b0  += w * a * d;  a_q.m_b1  += w * b * d;  a_q.m_b2  += w * c * d;
+    a_q.m_c   += w * d * d;
+    a_q.m_weight += w;
+  }
+
+  void  DoAdd(Quadric& a_q, const Quadric& a_other)
+  {
+    a_q.m_a00 += a_other.m_a00;  a_q.m_a11 += a_other.m_a11;  a_q.m_a22 += a_other.m_a22;
+    a_q.m_a10 += a_other.m_a10;  a_q.m_a20 += a_other.m_a20;  a_q.m_a21 += a_other.m_a21;
+    a_q.m_b0  += a_other.m_b0;   a_q.m_b1  += a_other.m_b1;   a_q.m_b2  += a_other.m_b2;
+    a_q.m_c   += a_other.m_c;
+    a_q.m_weight += a_other.m_weight;
+  }
+
+  // average squared distance
+  f32   DoGetError(const Quadric& a_q, const f32* a_pos)
+  {
+    const f64 x = a_pos[0], y = a_pos[1], z = a_pos[2];
+
+    const f64 r =
+      x * (a_q.m_a00 * x + 2 * (a_q.m_a10 * y + a_q.m_a20 * z + a_q.m_b0)) +
+      y * (a_q.m_a11 * y + 2 * (a_q.m_a21 * z + a_q.m_b1)) +
+      z * (a_q.m_a22 * z + 2 * a_q.m_b2) + a_q.m_c;
+
+    return a_q.m_weight > 0 ? (f32)(fabs(r) / a_q.m_weight) : 0.0f;
+  }
+
+  // -----------------------------------------------------------------------
+
+  void  DoCross(const f32* a_a, const f32* a_b, f32* a_out)
+  {
+    a_out[0] = a_a[1] * a_b[2] - a_a[2] * a_b[1];
+    a_out[1] = a_a[2] * a_b[0] - a_a[0] * a_b[2];
+    a_out[2] = a_a[0] * a_b[1] - a_a[1] * a_b[0];
+  }
+
+  f32   DoDot(const f32* a_a, const f32* a_b)
+  { return a_a[0] * a_b[0] + a_a[1] * a_b[1] + a_a[2] * a_b[2]; }
+
+  void  DoGetNormal(const f32* a_p0, const f32* a_p1, const f32* a_p2, f32* a_out)
+  {
+    const f32 e0[3] = { a_p1[0] - a_p0[0], a_p1[1] - a_p0[1], a_p1[2] - a_p0[2] };
+    const f32 e1[3] = { a_p2[0] - a_p0[0], a_p2[1] - a_p0[1], a_p2[2] - a_p0[2] };
+    DoCross(e0, e1, a_out);
+  }
+
+  // -----------------------------------------------------------------------
+
+  u32   DoHashPosition(const f32* a_pos)
+  {
+    u32 hash = 2166136261u;
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      // + 0.0f turns -0 into 0 so that both hash the same
+      const f32 value = a_pos[i] + 0.0f;
+      u32 bits;
+      memcpy(&bits, &value, sizeof(bits));
+      hash = (hash ^ bits) * 16777619u;
+    }
+
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    return hash;
+  }
+
+  tl_size DoGetTableSize(tl_size a_numEntries)
+  {
+    tl_size size = 16;
+    while (size < a_numEntries * 2) { size *= 2; }
+    return size;
+  }
+
+  // -----------------------------------------------------------------------
+  // Sorts a_order by the (non negative) errors, two 16 bit radix passes on
+  // the float bits
+
+  void  DoSortByError(const tl_core_conts::Array<f32>& a_errors, index_cont& a_order)
+  {
+    const tl_size count = a_errors.size();
+
+    index_cont keys(count), temp(count);
+    for (tl_size i = 0; i < count; ++i)
+    { memcpy(&keys[i], &a_errors[i], sizeof(u32)); }
+
+    a_order.resize(count);
+    for (tl_size i = 0; i < count; ++i)
+    { a_order[i] = (u32)i; }
+
+    index_cont histogram(1 << 16);
+    for (u32 shift = 0; shift < 32; shift += 16)
+    {
+      for (tl_size i = 0; i < histogram.size(); ++i)
+      { histogram[i] = 0; }
+
+      for (tl_size i = 0; i < count; ++i)
+      { ++histogram[(keys[i] >> shift) & 0xFFFF]; }
+
+      u32 sum = 0;
+      for (tl_size i = 0; i < histogram.size(); ++i)
+      {
+        const u32 bucket = histogram[i];
+        histogram[i] = sum;
+        sum += bucket;
+      }
+
+      for (tl_size i = 0; i < count; ++i)
+      {
+        const u32 index = a_order[i];
+        temp[histogram[(keys[index] >> shift) & 0xFFFF]++] = index;
+      }
+
+      a_order.swap(temp);
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Everything that does not change between LODs: positions scaled to the
+  // unit cube, vertices sharing a position (m_remap is the first vertex
+  // with the position, m_wedge a circular list through the others), the
+  // kind of every vertex, open edge loops and the initial quadrics.
+
+  class Simplifier
+  {
+  public:
+    Simplifier(const IndexedMesh& a_mesh, f32 a_maxNormalAngle);
+
+    void  Simplify(f32 a_ratio, f32 a_maxError, MeshLod& a_out) const;
+
+  private:
+    void  DoWeldPositions();
+    void  DoClassifyVertices();
+    void  DoComputeQuadrics();
+
+    bool  DoCanCollapse(u32 a_from, u32 a_to, const index_cont& a_loop,
+                        const index_cont& a_loopBack) const;
+    bool  DoHasFlips(u32 a_from, u32 a_to, const index_cont& a_indices,
+                     const index_cont& a_triangleBegin,
+                     const index_cont& a_triangles) const;
+
+  private:
+    const IndexedMesh&          m_mesh;
+    tl_size                     m_numVertices;
+    f32                         m_minNormalDot;
+
+    tl_core_conts::Array<f32>   m_positions;
+    index_cont                  m_remap;
+    index_cont                  m_wedge;
+    index_cont                  m_loop;
+    index_cont                  m_loopBack;
+    tl_core_conts::Array<u8>    m_kinds;
+
+    index_cont                  m_indices;
+    index_cont                  m_triangleGroups;
+    tl_size                     m_numGroups;
+
+    tl_core_conts::Array<Quadric> m_quadrics;
+  };
+
+  // -----------------------------------------------------------------------
+
+  Simplifier::
+    Simplifier(const IndexedMesh& a_mesh, f32 a_maxNormalAngle)
+    : m_mesh(a_mesh)
+    , m_numVertices(a_mesh.m_vertices.size())
+    , m_minNormalDot(cosf(a_maxNormalAngle * 3.14159265f / 180.0f))
+  {
+    // positions in the unit cube, errors are relative to the mesh size
+    f32 minPos[3] = { 0, 0, 0 };
+    f32 extent = 0;
+    for (tl_size v = 0; v < m_numVertices; ++v)
+    {
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        const f32 p = a_mesh.m_vertices[v].m_position[i];
+        if (v == 0 || p < minPos[i]) { minPos[i] = p; }
+      }
+    }
+    for (tl_size v = 0; v < m_numVertices; ++v)
+    {
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        const f32 size = a_mesh.m_vertices[v].m_position[i] - minPos[i];
+        if (size > extent) { extent = size; }
+      }
+    }
+
+    const f32 scale = extent > 0 ? 1.0f / extent : 1.0f;
+    m_positions.resize(m_numVertices * 3);
+    for (tl_size v = 0; v < m_numVertices; ++v)
+    {
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        m_positions[v * 3 + i] =
+          (a_mesh.m_vertices[v].m_position[i] - minPos[i]) * scale;
+      }
+    }
+
+    m_indices.resize(a_mesh.GetNumIndices());
+    for (tl_size i = 0; i < m_indices.size(); ++i)
+    { m_indices[i] = (u32)a_mesh.GetIndex(i); }
+
+    // a mesh without groups is one group
+    m_numGroups = a_mesh.m_groups.empty() ? 1 : a_mesh.m_groups.size();
+    m_triangleGroups.resize(m_indices.size() / 3, 0);
+    for (tl_size g = 0; g < a_mesh.m_groups.size(); ++g)
+    {
+      const ObjGroup& group = a_mesh.m_groups[g];
+      for (tl_size t = 0; t < group.m_numTriangles; ++t)
+      { m_triangleGroups[group.m_firstTriangle + t] = (u32)g; }
+    }
+
+    DoWeldPositions();
+    DoClassifyVertices();
+    DoComputeQuadrics();
+  }
+
+  // -----------------------------------------------------------------------
+
+  void
+  Simplifier::
+    DoWeldPositions()
+  {
+    const tl_size tableMask = DoGetTableSize(m_numVertices) - 1;
+    index_cont table(tableMask + 1, g_noVertex);
+
+    m_remap.resize(m_numVertices);
+    m_wedge.resize(m_numVertices);
+
+    for (u32 v = 0; v < (u32)m_numVertices; ++v)
+    {
+      const f32* pos = &m_positions[v * 3];
+      tl_size slot = DoHashPosition(pos) & tableMask;
+      for (;;)
+      {
+        const u32 other = table[slot];
+        if (other == g_noVertex)
+        {
+          table[slot] = v;
+          m_remap[v] = v;
+          m_wedge[v] = v;
+          break;
+        }
+
+        if (memcmp(&m_positions[other * 3], pos, sizeof(f32) * 3) == 0)
+        {
+          m_remap[v] = other;
+          m_wedge[v] = m_wedge[other];
+          m_wedge[other] = v;
+          break;
+        }
+
+        slot = (slot + 1) & tableMask;
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Open edges are found on vertices (not positions), so attribute seams
+  // show up as open edges on both sides.
+
+  void
+  Simplifier::
+    DoClassifyVertices()
+  {
+    const tl_size numIndices = m_indices.size();
+
+    // outgoing half edges of every vertex
+    index_cont edgeBegin(m_numVertices + 1, 0), edgeEnd(m_numVertices), edges(numIndices);
+    for (tl_size i = 0; i < numIndices; ++i)
+    { ++edgeBegin[m_indices[i] + 1]; }
+    for (tl_size v = 0; v < m_numVertices; ++v)
+    { edgeBegin[v + 1] += edgeBegin[v]; }
+
+    for (tl_size v = 0; v < m_numVertices; ++v)
+    { edgeEnd[v] = edgeBegin[v]; }
+    for (tl_size t = 0; t < numIndices; t += 3)
+    {
+      for (tl_int e = 0; e < 3; ++e)
+      {
+        const u32 from = m_indices[t + e];
+        edges[edgeEnd[from]++] = m_indices[t + (e + 1) % 3];
+      }
+    }
+
+    m_loop.resize(m_numVertices, g_noVertex);
+    m_loopBack.resize(m_numVertices, g_noVertex);
+
+    for (u32 from = 0; from < (u32)m_numVertices; ++from)
+    {
+      for (u32 e = edgeBegin[from]; e < edgeBegin[from + 1]; ++e)
+      {
+        const u32 to = edges[e];
+
+        bool hasOpposite = false;
+        for (u32 o = edgeBegin[to]; o < edgeBegin[to + 1] && hasOpposite == false; ++o)
+        { hasOpposite = edges[o] == from; }
+
+        if (hasOpposite == false)
+        {
+          m_loop[from] = m_loop[from] == g_noVertex ? to : g_multiple;
+          m_loopBack[to] = m_loopBack[to] == g_noVertex ? from : g_multiple;
+        }
+      }
+    }
+
+    // vertices used by several groups keep the groups closed
+    index_cont positionGroups(m_numVertices, g_noVertex);
+    for (tl_size i = 0; i < numIndices; ++i)
+    {
+      u32& group = positionGroups[m_remap[m_indices[i]]];
+      const u32 triangleGroup = m_triangleGroups[i / 3];
+      group = group == g_noVertex || group == triangleGroup ? triangleGroup : g_multiple;
+    }
+
+    m_kinds.resize(m_numVertices, k_locked);
+    for (u32 v = 0; v < (u32)m_numVertices; ++v)
+    {
+      if (m_remap[v] != v)
+      { continue; }
+
+      u8 kind = k_locked;
+      const u32 loop = m_loop[v], loopBack = m_loopBack[v];
+
+      if (positionGroups[v] == g_multiple)
+      { kind = k_locked; }
+      else if (m_wedge[v] == v)
+      {
+        if (loop == g_noVertex && loopBack == g_noVertex)
+        { kind = k_manifold; }
+        else if (loop < g_multiple && loopBack < g_multiple &&
+                 loop != v && loopBack != v)
+        { kind = k_border; }
+      }
+      else if (m_wedge[m_wedge[v]] == v)
+      {
+        // both sides of the seam have one open edge in and out, running
+        // along the same positions in opposite directions
+        const u32 w = m_wedge[v];
+        const u32 wLoop = m_loop[w], wLoopBack = m_loopBack[w];
+
+        if (loop < g_multiple && loopBack < g_multiple &&
+            wLoop < g_multiple && wLoopBack < g_multiple &&
+            m_remap[loop] == m_remap[wLoopBack] &&
+            m_remap[loopBack] == m_remap[wLoop])
+        { kind = k_seam; }
+      }
+
+      u32 w = v;
+      do
+      {
+        m_kinds[w] = kind;
+        w = m_wedge[w];
+      } while (w != v);
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  void
+  Simplifier::
+    DoComputeQuadrics()
+  {
+    Quadric zero;
+    memset(&zero, 0, sizeof(zero));
+    m_quadrics.resize(m_numVertices, zero);
+
+    for (tl_size t = 0; t < m_indices.size(); t += 3)
+    {
+      const f32* p[3];
+      for (tl_int i = 0; i < 3; ++i)
+      { p[i] = &m_positions[m_indices[t + i] * 3]; }
+
+      f32 normal[3];
+      DoGetNormal(p[0], p[1], p[2], normal);
+
+      const f32 length = sqrtf(DoDot(normal, normal));
+      if (length <= 0)
+      { continue; }
+
+      const f64 n[3] = { normal[0] / length, normal[1] / length, normal[2] / length };
+      const f64 d = -(n[0] * p[0][0] + n[1] * p[0][1] + n[2] * p[0][2]);
+
+      // weighted by area
+      for (tl_int i = 0; i < 3; ++i)
+      { DoAddPlane(m_quadrics[m_remap[m_indices[t + i]]], n, d, length * 0.5); }
+
+      // planes through open edges, perpendicular to the triangle
+      for (tl_int e = 0; e < 3; ++e)
+      {
+        const u32 from = m_indices[t + e];
+        const u32 to = m_indices[t + (e + 1) % 3];
+        if (m_loop[from] != to ||
+            (m_kinds[from] != k_border && m_kinds[from] != k_seam))
+        { continue; }
+
+        const f32* p0 = &m_positions[from * 3];
+        const f32* p1 = &m_positions[to * 3];
+        const f32 edge[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+
+        f32 perpendicular[3];
+        DoCross(edge, normal, perpendicular);
+
+        const f32 perpendicularLength = sqrtf(DoDot(perpendicular, perpendicular));
+        if (perpendicularLength <= 0)
+        { continue; }
+
+        const f64 pn[3] = { perpendicular[0] / perpendicularLength,
+                            perpendicular[1] / perpendicularLength,
+                            perpendicular[2] / perpendicularLength };
+        const f64 pd = -(pn[0] * p0[0] + pn[1] * p0[1] + pn[2] * p0[2]);
+        const f64 weight = DoDot(edge, edge) * g_edgeWeight;
+
+        DoAddPlane(m_quadrics[m_remap[from]], pn, pd, weight);
+        DoAddPlane(m_quadrics[m_remap[to]], pn, pd, weight);
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Borders and seams only collapse along their own edges, onto a vertex
+  // of the same kind. Manifold vertices collapse onto anything.
+
+  bool
+  Simplifier::
+    DoCanCollapse(u32 a_from, u32 a_to, const index_cont& a_loop,
+                  const index_cont& a_loopBack) const
+  {
+    const u8 from = m_kinds[a_from];
+    const u8 to = m_kinds[a_to];
+
+    if (from == k_manifold)
+    { return true; }
+
+    if (from == k_border || from == k_seam)
+    { return to == from && (a_loop[a_from] == a_to || a_loopBack[a_from] == a_to); }
+
+    return false;
+  }
+
+  // -----------------------------------------------------------------------
+  // True if moving a_from onto a_to turns a triangle around a_from by more
+  // than the maximum normal angle (or flips it)
+
+  bool
+  Simplifier::
+    DoHasFlips(u32 a_from, u32 a_to, const index_cont& a_indices,
+               const index_cont& a_triangleBegin, const index_cont& a_triangles) const
+  {
+    const u32 fromPosition = m_remap[a_from];
+    const u32 toPosition = m_remap[a_to];
+
+    for (u32 i = a_triangleBegin[fromPosition]; i < a_triangleBegin[fromPosition + 1]; ++i)
+    {
+      const u32* triangle = &a_indices[a_triangles[i] * 3];
+
+      tl_int moved = -1;
+      bool   collapses = false;
+      for (tl_int j = 0; j < 3; ++j)
+      {
+        const u32 position = m_remap[triangle[j]];
+        if (position == fromPosition) { moved = j; }
+        if (position == toPosition)   { collapses = true; }
+      }
+
+      if (collapses || moved < 0)
+      { continue; }
+
+      const f32* p[3];
+      for (tl_int j = 0; j < 3; ++j)
+      { p[j] = &m_positions[triangle[j] * 3]; }
+
+      f32 before[3], after[3];
+      DoGetNormal(p[0], p[1], p[2], before);
+
+      p[moved] = &m_positions[a_to * 3];
+      DoGetNormal(p[0], p[1], p[2], after);
+
+      const f32 dot = DoDot(before, after);
+      const f32 lengths = sqrtf(DoDot(before, before) * DoDot(after, after));
+      if (dot <= 0 || dot < m_minNormalDot * lengths)
+      { return true; }
+    }
+
+    return false;
+  }
+
+  // -----------------------------------------------------------------------
+  // Every pass picks the cheapest collapse of every edge, sorts them and
+  // takes them in order, at most one per vertex, then removes the
+  // triangles that became degenerate.
+
+  void
+  Simplifier::
+    Simplify(f32 a_ratio, f32 a_maxError, MeshLod& a_out) const
+  {
+    index_cont  indices(m_indices);
+    index_cont  triangleGroups(m_triangleGroups);
+    index_cont  loop(m_loop), loopBack(m_loopBack);
+    tl_core_conts::Array<Quadric> quadrics(m_quadrics);
+
+    const tl_size numTriangles = indices.size() / 3;
+    const tl_size targetTriangles = (tl_size)(numTriangles * a_ratio);
+    const f32     maxError = a_maxError * a_maxError;
+
+    index_cont                  triangleBegin(m_numVertices + 1), triangleEnd(m_numVertices);
+    index_cont                  triangles;
+    index_cont                  collapseFrom, collapseTo, order;
+    tl_core_conts::Array<f32>   collapseErrors;
+    index_cont                  collapseRemap(m_numVertices);
+    tl_core_conts::Array<u8>    locked(m_numVertices);
+
+    f32 resultError = 0;
+
+    while (indices.size() / 3 > targetTriangles)
+    {
+      const tl_size currentTriangles = indices.size() / 3;
+
+      // triangles around every position
+      for (tl_size i = 0; i < triangleBegin.size(); ++i)
+      { triangleBegin[i] = 0; }
+      for (tl_size i = 0; i < indices.size(); ++i)
+      { ++triangleBegin[m_remap[indices[i]] + 1]; }
+      for (tl_size v = 0; v < m_numVertices; ++v)
+      {
+        triangleBegin[v + 1] += triangleBegin[v];
+        triangleEnd[v] = triangleBegin[v];
+      }
+
+      triangles.resize(indices.size());
+      for (tl_size i = 0; i < indices.size(); ++i)
+      { triangles[triangleEnd[m_remap[indices[i]]]++] = (u32)(i / 3); }
+
+      // the cheaper direction of every edge that can collapse
+      collapseFrom.clear();
+      collapseTo.clear();
+      collapseErrors.clear();
+      for (tl_size t = 0; t < indices.size(); t += 3)
+      {
+        for (tl_int e = 0; e < 3; ++e)
+        {
+          const u32 i0 = indices[t + e];
+          const u32 i1 = indices[t + (e + 1) % 3];
+          const u32 r0 = m_remap[i0], r1 = m_remap[i1];
+
+          // inner edges are seen from both triangles, open ones only once
+          if (r0 == r1 || (r0 > r1 && loop[i0] != i1))
+          { continue; }
+
+          const bool canForward = DoCanCollapse(i0, i1, loop, loopBack);
+          const bool canBackward = DoCanCollapse(i1, i0, loop, loopBack);
+          if (canForward == false && canBackward == false)
+          { continue; }
+
+          const f32 forward = canForward
+            ? DoGetError(quadrics[r0], &m_positions[i1 * 3]) : 0.0f;
+          const f32 backward = canBackward
+            ? DoGetError(quadrics[r1], &m_positions[i0 * 3]) : 0.0f;
+
+          const bool useForward = canForward && (canBackward == false || forward <= backward);
+          collapseFrom.push_back(useForward ? i0 : i1);
+          collapseTo.push_back(useForward ? i1 : i0);
+          collapseErrors.push_back(useForward ? forward : backward);
+        }
+      }
+
+      if (collapseErrors.empty())
+      { break; }
+
+      DoSortByError(collapseErrors, order);
+
+      // a manifold collapse removes two triangles
+      const tl_size triangleGoal = currentTriangles - targetTriangles;
+      const tl_size edgeGoal = triangleGoal / 2;
+      const f32 passError = edgeGoal < order.size()
+        ? collapseErrors[order[edgeGoal]] * g_passErrorScale : maxError;
+
+      for (u32 v = 0; v < (u32)m_numVertices; ++v)
+      {
+        collapseRemap[v] = v;
+        locked[v] = 0;
+      }
+
+      tl_size removed = 0;
+      tl_size numCollapses = 0;
+      for (tl_size c = 0; c < order.size() && removed < triangleGoal; ++c)
+      {
+        const u32 from = collapseFrom[order[c]];
+        const u32 to = collapseTo[order[c]];
+        const f32 error = collapseErrors[order[c]];
+
+        if (error > maxError || error > passError)
+        { break; }
+
+        const u32 r0 = m_remap[from], r1 = m_remap[to];
+        if (locked[r0] || locked[r1])
+        { continue; }
+
+        if (DoHasFlips(from, to, indices, triangleBegin, triangles))
+        { continue; }
+
+        DoAdd(quadrics[r1], quadrics[r0]);
+
+        collapseRemap[from] = to;
+        if (m_kinds[from] == k_seam)
+        {
+          // the other side of the seam goes the same way
+          const u32 sibling = m_wedge[from];
+          collapseRemap[sibling] = loop[from] == to ? loopBack[sibling] : loop[sibling];
+        }
+
+        locked[r0] = 1;
+        locked[r1] = 1;
+
+        removed += m_kinds[from] == k_border ? 1 : 2;
+        ++numCollapses;
+
+        if (error > resultError)
+        { resultError = error; }
+      }
+
+      if (numCollapses == 0)
+      { break; }
+
+      // edge loops skip the vertices that collapsed
+      for (u32 v = 0; v < (u32)m_numVertices; ++v)
+      {
+        if (loop[v] < g_multiple)
+        {
+          const u32 target = collapseRemap[loop[v]];
+          loop[v] = target == v ? loop[loop[v]] : target;
+        }
+        if (loopBack[v] < g_multiple)
+        {
+          const u32 target = collapseRemap[loopBack[v]];
+          loopBack[v] = target == v ? loopBack[loopBack[v]] : target;
+        }
+      }
+
+      tl_size numKept = 0;
+      for (tl_size t = 0; t < indices.size() / 3; ++t)
+      {
+        const u32 a = collapseRemap[indices[t * 3 + 0]];
+        const u32 b = collapseRemap[indices[t * 3 + 1]];
+        const u32 c = collapseRemap[indices[t * 3 + 2]];
+        const u32 ra = m_remap[a], rb = m_remap[b], rc = m_remap[c];
+
+        if (ra == rb || rb == rc || rc == ra)
+        { continue; }
+
+        indices[numKept * 3 + 0] = a;
+        indices[numKept * 3 + 1] = b;
+        indices[numKept * 3 + 2] = c;
+        triangleGroups[numKept] = triangleGroups[t];
+        ++numKept;
+      }
+
+      indices.resize(numKept * 3);
+      triangleGroups.resize(numKept);
+    }
+
+    // triangles stayed in order, so the groups are still contiguous
+    a_out.m_ratio = a_ratio;
+    a_out.m_error = sqrtf(resultError);
+    a_out.m_indices.swap(indices);
+    a_out.m_groups.clear();
+
+    if (m_mesh.m_groups.empty())
+    { return; }
+
+    a_out.m_groups = m_mesh.m_groups;
+    for (tl_size g = 0; g < a_out.m_groups.size(); ++g)
+    { a_out.m_groups[g].m_numTriangles = 0; }
+
+    for (tl_size t = 0; t < triangleGroups.size(); ++t)
+    { ++a_out.m_groups[triangleGroups[t]].m_numTriangles; }
+
+    tl_size firstTriangle = 0;
+    for (tl_size g = 0; g < a_out.m_groups.size(); ++g)
+    {
+      a_out.m_groups[g].m_firstTriangle = firstTriangle;
+      firstTriangle += a_out.m_groups[g].m_numTriangles;
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Simplification
+
+void
+  SimplifyMesh(const IndexedMesh& a_mesh, f32 a_ratio, MeshLod& a_out,
+               f32 a_maxError, f32 a_maxNormalAngle)
+{
+  const Simplifier simplifier(a_mesh, a_maxNormalAngle);
+  simplifier.Simplify(a_ratio, a_maxError, a_out);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  GenerateLods(IndexedMesh& a_mesh, const f32* a_ratios, tl_size a_numRatios,
+               tl_int a_numThreads, f32 a_maxError, f32 a_maxNormalAngle)
+{
+  a_mesh.m_lods.clear();
+  a_mesh.m_lods.resize(a_numRatios);
+
+  const Simplifier simplifier(a_mesh, a_maxNormalAngle);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(a_numThreads)
+  for (tl_int i = 0; i < (tl_int)a_numRatios; ++i)
+  { simplifier.Simplify(a_ratios[i], a_maxError, a_mesh.m_lods[i]); }
+}
@@ -0,0 +1,32 @@
+#ifndef _TLOC_MESH_TOOLS_MESH_SIMPLIFIER_H_
+#define _TLOC_MESH_TOOLS_MESH_SIMPLIFIER_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Quadric error edge collapse (Garland and Heckbert 1997) that only
+// removes triangles: vertices collapse onto one of their neighbours, so a
+// LOD is an index list over the vertices of the mesh.
+//
+// - UV and normal seams (two vertices at one position) only collapse along
+//   the seam, both sides together. Open borders only collapse along the
+//   border. Vertices with more than two attribute sets, or used by more
+//   than one group, do not move.
+// - A collapse is rejected if it turns the normal of a triangle by more
+//   than a_maxNormalAngle degrees, or costs more than a_maxError (relative
+//   to the largest extent of the mesh). The LOD then stops short of the
+//   requested ratio.
+
+void  SimplifyMesh(const IndexedMesh& a_mesh, f32 a_ratio, MeshLod& a_out,
+                   f32 a_maxError = 0.02f, f32 a_maxNormalAngle = 45.0f);
+
+// Replaces a_mesh.m_lods with one LOD per ratio (most detailed first). The
+// LODs are simplified from the mesh independently, on a_numThreads threads.
+
+void  GenerateLods(IndexedMesh& a_mesh, const f32* a_ratios, tl_size a_numRatios,
+                   tl_int a_numThreads = 1, f32 a_maxError = 0.02f,
+                   f32 a_maxNormalAngle = 45.0f);
+
+#endif
@@ -0,0 +1,510 @@
+#include "meshlets.h"
+
+#include <cmath>
+
+using namespace tloc;
+
+namespace {
+
+  typedef tl_core_conts::Array<u32>       index_cont;
+  typedef tl_core_conts::Array<f32>       float_cont;
+
+  const u32 g_none = 0xFFFFFFFF;
+
+  // cone cutoff of meshlets that never face away (see Meshlet)
+  const f32 g_noCone = 2.0f;
+
+  f32   DoDot(const f32* a, const f32* b)
+  { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; }
+
+  f32   DoLength(const f32* a)
+  { return sqrt(DoDot(a, a)); }
+
+  // -----------------------------------------------------------------------
+  // Meshlets of one mesh. The arrays are sized for the whole mesh and
+  // stamped with the meshlet being built, so nothing is cleared between
+  // meshlets or groups.
+
+  class MeshletBuilder
+  {
+  public:
+    MeshletBuilder(const IndexedMesh& a_mesh, const index_cont& a_indices);
+
+    void  BuildGroup(tl_size a_firstTriangle, tl_size a_numTriangles,
+                     tl_size a_maxTriangles, index_cont& a_outIndices,
+                     tl_core_conts::Array<Meshlet>& a_outMeshlets);
+
+  private:
+    void  DoAddTriangle(u32 a_triangle, u32 a_meshlet, index_cont& a_outIndices);
+    u32   DoGetNextTriangle(u32 a_meshlet) const;
+    void  DoGetBounds(const index_cont& a_indices, Meshlet& a_meshlet) const;
+
+    const IndexedMesh&  m_mesh;
+    const index_cont&   m_indices;
+
+    // unit normals (0 for degenerate triangles) and centroids
+    float_cont  m_normals;
+    float_cont  m_centroids;
+
+    // triangles around each vertex
+    index_cont  m_vertexFirst;
+    index_cont  m_vertexTriangles;
+
+    tl_core_conts::Array<u8>  m_used;
+    index_cont  m_candidateOf;
+    index_cont  m_vertexOf;
+
+    // the meshlet being built
+    index_cont  m_candidates;
+    tl_size     m_groupBegin;
+    tl_size     m_groupEnd;
+    tl_size     m_numTriangles;
+    f32         m_centroidSum[3];
+    f32         m_normalSum[3];
+  };
+
+  // -----------------------------------------------------------------------
+
+  MeshletBuilder::
+    MeshletBuilder(const IndexedMesh& a_mesh, const index_cont& a_indices)
+    : m_mesh(a_mesh)
+    , m_indices(a_indices)
+    , m_normals(a_indices.size(), 0.0f)
+    , m_centroids(a_indices.size(), 0.0f)
+    , m_vertexFirst(a_mesh.m_vertices.size() + 1, 0)
+    , m_vertexTriangles(a_indices.size(), 0)
+    , m_used(a_indices.size() / 3, 0)
+    , m_candidateOf(a_indices.size() / 3, g_none)
+    , m_vertexOf(a_mesh.m_vertices.size(), g_none)
+    , m_groupBegin(0)
+    , m_groupEnd(0)
+    , m_numTriangles(0)
+  {
+    const tl_size numTriangles = a_indices.size() / 3;
+
+    for (tl_size t = 0; t < numTriangles; ++t)
+    {
+      const f32* p0 = a_mesh.m_vertices[a_indices[t * 3 + 0]].m_position;
+      const f32* p1 = a_mesh.m_vertices[a_indices[t * 3 + 1]].m_position;
+      const f32* p2 = a_mesh.m_vertices[a_indices[t * 3 + 2]].m_position;
+
+      const f32 e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      const f32 e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+
+      f32* normal = &m_normals[t * 3];
+      normal[0] = e0[1] * e1[2] - e0[2] * e1[1];
+      normal[1] = e0[2] * e1[0] - e0[0] * e1[2];
+      normal[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+      const f32 length = DoLength(normal);
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        normal[i] = length > 0.0f ? normal[i] / length : 0.0f;
+        m_centroids[t * 3 + i] = (p0[i] + p1[i] + p2[i]) / 3.0f;
+      }
+    }
+
+    // counting sort of the corners by vertex
+    for (tl_size i = 0; i < a_indices.size(); ++i)
+    { ++m_vertexFirst[a_indices[i] + 1]; }
+    for (tl_size v = 0; v < a_mesh.m_vertices.size(); ++v)
+    { m_vertexFirst[v + 1] += m_vertexFirst[v]; }
+
+    index_cont next(a_mesh.m_vertices.size());
+    for (tl_size v = 0; v < next.size(); ++v)
+    { next[v] = m_vertexFirst[v]; }
+    for (tl_size i = 0; i < a_indices.size(); ++i)
+    { m_vertexTriangles[next[a_indices[i]]++] = (u32)(i / 3); }
+  }
+
+  // -----------------------------------------------------------------------
+
+  void
+  MeshletBuilder::
+    DoAddTriangle(u32 a_triangle, u32 a_meshlet, index_cont& a_outIndices)
+  {
+    m_used[a_triangle] = 1;
+    ++m_numTriangles;
+
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      m_centroidSum[i] += m_centroids[a_triangle * 3 + i];
+      m_normalSum[i] += m_normals[a_triangle * 3 + i];
+    }
+
+    for (tl_int corner = 0; corner < 3; ++corner)
+    {
+      const u32 vertex = m_indices[a_triangle * 3 + corner];
+      a_outIndices.push_back(vertex);
+
+      if (m_vertexOf[vertex] == a_meshlet)
+      { continue; }
+      m_vertexOf[vertex] = a_meshlet;
+
+      for (u32 i = m_vertexFirst[vertex]; i < m_vertexFirst[vertex + 1]; ++i)
+      {
+        const u32 triangle = m_vertexTriangles[i];
+        if (triangle < m_groupBegin || triangle >= m_groupEnd ||
+            m_used[triangle] || m_candidateOf[triangle] == a_meshlet)
+        { continue; }
+
+        m_candidateOf[triangle] = a_meshlet;
+        m_candidates.push_back(triangle);
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // The candidate that shares the most vertices with the meshlet, ties go
+  // to the closest one, distances grow as the normal turns away.
+
+  u32
+  MeshletBuilder::
+    DoGetNextTriangle(u32 a_meshlet) const
+  {
+    f32 center[3];
+    for (tl_int i = 0; i < 3; ++i)
+    { center[i] = m_centroidSum[i] / (f32)m_numTriangles; }
+
+    const f32 normalLength = DoLength(m_normalSum);
+    f32 axis[3] = { 0.0f, 0.0f, 0.0f };
+    if (normalLength > 0.0f)
+    {
+      for (tl_int i = 0; i < 3; ++i)
+      { axis[i] = m_normalSum[i] / normalLength; }
+    }
+
+    u32     best = g_none;
+    tl_int  bestShared = 0;
+    f32     bestScore = 0.0f;
+
+    for (tl_size i = 0; i < m_candidates.size(); ++i)
+    {
+      const u32 triangle = m_candidates[i];
+      if (m_used[triangle])
+      { continue; }
+
+      tl_int shared = 0;
+      for (tl_int corner = 0; corner < 3; ++corner)
+      {
+        if (m_vertexOf[m_indices[triangle * 3 + corner]] == a_meshlet)
+        { ++shared; }
+      }
+
+      const f32* centroid = &m_centroids[triangle * 3];
+      const f32 offset[3] = 
+      { centroid[0] - center[0], centroid[1] - center[1], centroid[2] - center[2] };
+
+      const f32 score = 
+        DoDot(offset, offset) * (2.0f - DoDot(&m_normals[triangle * 3], axis));
+
+      if (best == g_none || shared > bestShared ||
+          (shared == bestShared && score < bestScore))
+      {
+        best = triangle;
+        bestShared = shared;
+        bestScore = score;
+      }
+    }
+
+    return best;
+  }
+
+  // -----------------------------------------------------------------------
+  // The sphere is centered on the bounding box of the vertices, the cone on
+  // the average normal.
+
+  void
+  MeshletBuilder::
+    DoGetBounds(const index_cont& a_indices, Meshlet& a_meshlet) const
+  {
+    const u32* indices = &a_indices[a_meshlet.m_firstTriangle * 3];
+    const tl_size numIndices = a_meshlet.m_numTriangles * 3;
+
+    f32 boxMin[3];
+    f32 boxMax[3];
+    for (tl_int i = 0; i < 3; ++i)
+    { boxMin[i] = boxMax[i] = m_mesh.m_vertices[indices[0]].m_position[i]; }
+
+    for (tl_size c = 1; c < numIndices; ++c)
+    {
+      const f32* position = m_mesh.m_vertices[indices[c]].m_position;
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        boxMin[i] = core::tlMin(boxMin[i], position[i]);
+        boxMax[i] = core::tlMax(boxMax[i], position[i]);
+      }
+    }
+
+    for (tl_int i = 0; i < 3; ++i)
+    { a_meshlet.m_center[i] = (boxMin[i] + boxMax[i]) * 0.5f; }
+
+    f32 radiusSq = 0.0f;
+    for (tl_size c = 0; c < numIndices; ++c)
+    {
+      const f32* position = m_mesh.m_vertices[indices[c]].m_position;
+      const f32 offset[3] = 
+      { position[0] - a_meshlet.m_center[0], position[1] - a_meshlet.m_center[1], 
+        position[2] - a_meshlet.m_center[2] };
+      radiusSq = core::tlMax(radiusSq, DoDot(offset, offset));
+    }
+    a_meshlet.m_radius = sqrt(radiusSq);
+
+    const f32 normalLength = DoLength(m_normalSum);
+    for (tl_int i = 0; i < 3; ++i)
+    { 
+      a_meshlet.m_coneAxis[i] = 
+        normalLength > 0.0f ? m_normalSum[i] / normalLength : 0.0f; 
+    }
+
+    f32 minDot = 1.0f;
+    for (u32 t = 0; t < a_meshlet.m_numTriangles; ++t)
+    {
+      // degenerate triangles are never seen, their (0) normal is skipped
+      const f32* p0 = m_mesh.m_vertices[indices[t * 3 + 0]].m_position;
+      const f32* p1 = m_mesh.m_vertices[indices[t * 3 + 1]].m_position;
+      const f32* p2 = m_mesh.m_vertices[indices[t * 3 + 2]].m_position;
+
+      const f32 e0[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      const f32 e1[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      const f32 normal[3] = 
+      { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2],
+        e0[0] * e1[1] - e0[1] * e1[0] };
+
+      const f32 length = DoLength(normal);
+      if (length > 0.0f)
+      { minDot = core::tlMin(minDot, DoDot(normal, a_meshlet.m_coneAxis) / length); }
+    }
+
+    a_meshlet.m_coneCutoff = normalLength > 0.0f && minDot > 0.0f 
+      ? sqrt(1.0f - minDot * minDot) 
+      : g_noCone;
+  }
+
+  // -----------------------------------------------------------------------
+  // A new meshlet starts next to the last one if it can, otherwise at the
+  // first unused triangle, so the meshlets follow the triangle order.
+
+  void
+  MeshletBuilder::
+    BuildGroup(tl_size a_firstTriangle, tl_size a_numTriangles,
+               tl_size a_maxTriangles, index_cont& a_outIndices,
+               tl_core_conts::Array<Meshlet>& a_outMeshlets)
+  {
+    m_groupBegin = a_firstTriangle;
+    m_groupEnd = a_firstTriangle + a_numTriangles;
+    m_candidates.clear();
+
+    tl_size next = m_groupBegin;
+    for (;;)
+    {
+      u32 seed = g_none;
+      for (tl_size i = 0; i < m_candidates.size() && seed == g_none; ++i)
+      {
+        if (m_used[m_candidates[i]] == 0)
+        { seed = m_candidates[i]; }
+      }
+
+      while (seed == g_none && next < m_groupEnd && m_used[next])
+      { ++next; }
+      if (seed == g_none && next == m_groupEnd)
+      { break; }
+      if (seed == g_none)
+      { seed = (u32)next; }
+
+      const u32 meshletIndex = (u32)a_outMeshlets.size();
+
+      Meshlet meshlet;
+      meshlet.m_firstTriangle = (u32)(a_outIndices.size() / 3);
+
+      m_candidates.clear();
+      m_numTriangles = 0;
+      for (tl_int i = 0; i < 3; ++i)
+      { m_centroidSum[i] = m_normalSum[i] = 0.0f; }
+
+      DoAddTriangle(seed, meshletIndex, a_outIndices);
+      while (m_numTriangles < a_maxTriangles)
+      {
+        const u32 triangle = DoGetNextTriangle(meshletIndex);
+        if (triangle == g_none)
+        { break; }
+        DoAddTriangle(triangle, meshletIndex, a_outIndices);
+      }
+
+      meshlet.m_numTriangles = (u32)m_numTriangles;
+      DoGetBounds(a_outIndices, meshlet);
+      a_outMeshlets.push_back(meshlet);
+
+      // used candidates are dropped so the seed search stays short
+      tl_size numCandidates = 0;
+      for (tl_size i = 0; i < m_candidates.size(); ++i)
+      {
+        if (m_used[m_candidates[i]] == 0)
+        { m_candidates[numCandidates++] = m_candidates[i]; }
+      }
+      m_candidates.resize(numCandidates);
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Building
+
+void
+  BuildMeshlets(IndexedMesh& a_mesh, tl_size a_maxTriangles)
+{
+  a_mesh.m_meshlets.clear();
+
+  index_cont indices(a_mesh.GetNumIndices());
+  for (tl_size i = 0; i < indices.size(); ++i)
+  { indices[i] = (u32)a_mesh.GetIndex(i); }
+
+  if (indices.empty() || a_maxTriangles == 0)
+  { return; }
+
+  MeshletBuilder builder(a_mesh, indices);
+
+  index_cont meshletIndices;
+  meshletIndices.reserve(indices.size());
+
+  if (a_mesh.m_groups.empty())
+  {
+    builder.BuildGroup(0, indices.size() / 3, a_maxTriangles, meshletIndices, 
+                       a_mesh.m_meshlets);
+  }
+
+  for (tl_size i = 0; i < a_mesh.m_groups.size(); ++i)
+  {
+    const ObjGroup& group = a_mesh.m_groups[i];
+    builder.BuildGroup(group.m_firstTriangle, group.m_numTriangles, 
+                       a_maxTriangles, meshletIndices, a_mesh.m_meshlets);
+  }
+
+  if (a_mesh.m_indices.empty() == false)
+  { a_mesh.m_indices.swap(meshletIndices); return; }
+
+  for (tl_size i = 0; i < meshletIndices.size(); ++i)
+  { a_mesh.m_shortIndices[i] = (u16)meshletIndices[i]; }
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Culling
+
+void
+  GetFrustumPlanes(const f32* a_viewProjection, f32 a_planes[6][4])
+{
+  // row i of the matrix is a_viewProjection[i], [i + 4], [i + 8], [i + 12]
+  const f32* m = a_viewProjection;
+  for (tl_int plane = 0; plane < 6; ++plane)
+  {
+    const tl_int  row = plane / 2;
+    const f32     sign = (plane % 2) ? -1.0f : 1.0f;
+
+    for (tl_int i = 0; i < 4; ++i)
+    { a_planes[plane][i] = m[3 + i * 4] + sign * m[row + i * 4]; }
+
+    const f32 length = DoLength(a_planes[plane]);
+    if (length > 0.0f)
+    {
+      for (tl_int i = 0; i < 4; ++i)
+      { a_planes[plane][i] /= length; }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+// Every point v of the sphere (seen from the camera) is at most
+// asin(cutoff) from the axis if axis.d - r > cutoff * (|d| + r), where d
+// goes from the camera to the center. Every normal is within the cone, so
+// no normal is then more than 90 degrees from v: all triangles face away.
+
+MeshletCullStats
+  CullMeshlets(const Meshlet* a_meshlets, tl_size a_numMeshlets,
+               const MeshletView& a_view, 
+               tl_core_conts::Array<TriangleRange>& a_out)
+{
+  MeshletCullStats stats = { 0, 0, 0, 0 };
+  a_out.clear();
+
+  for (tl_size i = 0; i < a_numMeshlets; ++i)
+  {
+    const Meshlet& meshlet = a_meshlets[i];
+
+    const f32 toCenter[3] = 
+    { meshlet.m_center[0] - a_view.m_position[0], 
+      meshlet.m_center[1] - a_view.m_position[1],
+      meshlet.m_center[2] - a_view.m_position[2] };
+
+    if (DoDot(toCenter, meshlet.m_coneAxis) - meshlet.m_radius > 
+        meshlet.m_coneCutoff * (DoLength(toCenter) + meshlet.m_radius))
+    { ++stats.m_numBackfacing; continue; }
+
+    bool outside = false;
+    for (tl_int plane = 0; plane < 6 && outside == false; ++plane)
+    {
+      const f32* p = a_view.m_planes[plane];
+      outside = DoDot(p, meshlet.m_center) + p[3] < -meshlet.m_radius;
+    }
+
+    if (outside)
+    { ++stats.m_numOutside; continue; }
+
+    ++stats.m_numVisible;
+    stats.m_numTriangles += meshlet.m_numTriangles;
+
+    if (a_out.empty() == false && 
+        a_out.back().m_firstTriangle + a_out.back().m_numTriangles == 
+        meshlet.m_firstTriangle)
+    { a_out.back().m_numTriangles += meshlet.m_numTriangles; }
+    else
+    {
+      TriangleRange range = { meshlet.m_firstTriangle, meshlet.m_numTriangles };
+      a_out.push_back(range);
+    }
+  }
+
+  return stats;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+  CountVisibleTriangles(const IndexedMesh& a_mesh, const MeshletView& a_view,
+                        tl_size a_firstTriangle, tl_size a_numTriangles)
+{
+  tl_size numVisible = 0;
+  const tl_size end = a_firstTriangle + a_numTriangles;
+
+  for (tl_size t = a_firstTriangle; t < end; ++t)
+  {
+    const f32* p[3];
+    for (tl_int corner = 0; corner < 3; ++corner)
+    { p[corner] = a_mesh.m_vertices[a_mesh.GetIndex(t * 3 + corner)].m_position; }
+
+    const f32 e0[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+    const f32 e1[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+    const f32 normal[3] = 
+    { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2],
+      e0[0] * e1[1] - e0[1] * e1[0] };
+    const f32 toCamera[3] = 
+    { a_view.m_position[0] - p[0][0], a_view.m_position[1] - p[0][1], 
+      a_view.m_position[2] - p[0][2] };
+
+    if (DoDot(normal, toCamera) <= 0.0f)
+    { continue; }
+
+    bool outside = false;
+    for (tl_int plane = 0; plane < 6 && outside == false; ++plane)
+    {
+      const f32* n = a_view.m_planes[plane];
+      outside = DoDot(n, p[0]) + n[3] < 0.0f && DoDot(n, p[1]) + n[3] < 0.0f &&
+                DoDot(n, p[2]) + n[3] < 0.0f;
+    }
+
+    if (outside == false)
+    { ++numVisible; }
+  }
+
+  return numVisible;
+}
@@ -0,0 +1,62 @@
+#ifndef _TLOC_MESH_TOOLS_MESHLETS_H_
+#define _TLOC_MESH_TOOLS_MESHLETS_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Splits the triangles of every group into meshlets of at most
+// a_maxTriangles triangles and reorders the index list so that each one is
+// a triangle range (within its group, groups stay valid). A meshlet grows
+// from a seed over neighbouring triangles, preferring the ones that share
+// the most vertices, are closest and face the same way, so that the bounds
+// are tight and the cone narrow.
+//
+// Build the meshlets after OptimizeVertexCache() and OptimizeOverdraw(),
+// which reorder the triangles and drop the meshlets.
+
+void  BuildMeshlets(IndexedMesh& a_mesh, tl_size a_maxTriangles = 128);
+
+// ///////////////////////////////////////////////////////////////////////
+// Culling. The planes of the view frustum point inwards (a point p is
+// inside if n.p + d >= 0 for all six), m_position is the camera.
+
+struct MeshletView
+{
+  f32   m_position[3];
+  f32   m_planes[6][4];
+};
+
+struct TriangleRange
+{
+  u32   m_firstTriangle;
+  u32   m_numTriangles;
+};
+
+struct MeshletCullStats
+{
+  tl_size m_numVisible;
+  tl_size m_numBackfacing;
+  tl_size m_numOutside;
+  tl_size m_numTriangles;   // in the visible meshlets
+};
+
+// a_viewProjection is column major (as math_t::Mat4f), clip = M * p
+void  GetFrustumPlanes(const f32* a_viewProjection, f32 a_planes[6][4]);
+
+// Replaces a_out with the triangle ranges of the visible meshlets, in
+// order, neighbouring meshlets merged into one range. The tests are
+// conservative: a culled meshlet has no triangle that faces the camera and
+// is inside the frustum.
+MeshletCullStats  CullMeshlets(const Meshlet* a_meshlets, tl_size a_numMeshlets,
+                               const MeshletView& a_view,
+                               tl_core_conts::Array<TriangleRange>& a_out);
+
+// Brute force reference: the triangles of the range that face the camera
+// and do not have all three corners outside the same plane. Culling is
+// conservative if the visible ranges have as many as the whole mesh.
+tl_size CountVisibleTriangles(const IndexedMesh& a_mesh, const MeshletView& a_view,
+                              tl_size a_firstTriangle, tl_size a_numTriangles);
+
+#endif
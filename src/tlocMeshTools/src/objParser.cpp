@@ -0,0 +1,689 @@
+#include "objParser.h"
+
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  // exactly representable as doubles
+  const f64 g_pow10[] =
+  {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const tl_int g_maxPow10 = 22;
+  const tl_int g_maxMantissaDigits = 19;
+
+  // chunks are handed out dynamically, smaller ones are not worth a thread
+  const tl_int  g_chunksPerThread = 4;
+  const tl_size g_minChunkSize = 1024 * 1024;
+
+  enum { k_position = 0, k_texCoord, k_normal, k_numAttributes };
+
+  s32&  DoGetCornerIndex(ObjCorner& a_corner, tl_int a_attribute)
+  {
+    switch(a_attribute)
+    {
+    case k_position: return a_corner.m_position;
+    case k_texCoord: return a_corner.m_texCoord;
+    default:         return a_corner.m_normal;
+    }
+  }
+
+  tl_size DoGetCount(const ObjMesh& a_mesh, tl_int a_attribute)
+  {
+    switch(a_attribute)
+    {
+    case k_position: return a_mesh.m_positions.size() / 3;
+    case k_texCoord: return a_mesh.m_texCoords.size() / 2;
+    default:         return a_mesh.m_normals.size() / 3;
+    }
+  }
+
+  template <typename T>
+  void  DoCopyInto(const tl_core_conts::Array<T>& a_from, 
+                   tl_core_conts::Array<T>& a_to, tl_size a_offset)
+  {
+    if (a_from.empty() == false)
+    { memcpy(&a_to[a_offset], &a_from[0], a_from.size() * sizeof(T)); }
+  }
+
+  bool  DoIsSpace(char a_c)
+  { return a_c == ' ' || a_c == '\t'; }
+
+  bool  DoIsDigit(char a_c)
+  { return a_c >= '0' && a_c <= '9'; }
+
+  const char* DoSkipSpaces(const char* a_begin, const char* a_end)
+  {
+    while (a_begin < a_end && DoIsSpace(*a_begin)) { ++a_begin; }
+    return a_begin;
+  }
+
+  // -----------------------------------------------------------------------
+  // Up to 19 significant digits are accumulated in an integer and scaled by
+  // a power of ten once, which is exact enough for f32 results.
+
+  const char* DoParseFloat(const char* a_begin, const char* a_end, f32& a_out)
+  {
+    const char* p = a_begin;
+
+    bool negative = false;
+    if (p < a_end && (*p == '-' || *p == '+'))
+    { negative = *p == '-'; ++p; }
+
+    u64    mantissa = 0;
+    tl_int numDigits = 0;
+    tl_int exponent = 0;
+    bool   hasDigits = false;
+
+    for (; p < a_end && DoIsDigit(*p); ++p)
+    {
+      hasDigits = true;
+      if (numDigits < g_maxMantissaDigits)
+      {
+        mantissa = mantissa * 10 + (u64)(*p - '0');
+        if (mantissa != 0) { ++numDigits; }
+      }
+      else
+      { ++exponent; }
+    }
+
+    if (p < a_end && *p == '.')
+    {
+      for (++p; p < a_end && DoIsDigit(*p); ++p)
+      {
+        hasDigits = true;
+        if (numDigits < g_maxMantissaDigits)
+        {
+          mantissa = mantissa * 10 + (u64)(*p - '0');
+          if (mantissa != 0) { ++numDigits; }
+          --exponent;
+        }
+      }
+    }
+
+    if (hasDigits == false)
+    { return nullptr; }
+
+    if (p < a_end && (*p == 'e' || *p == 'E'))
+    {
+      const char* e = p + 1;
+
+      bool negativeExp = false;
+      if (e < a_end && (*e == '-' || *e == '+'))
+      { negativeExp = *e == '-'; ++e; }
+
+      if (e < a_end && DoIsDigit(*e))
+      {
+        tl_int exp = 0;
+        for (; e < a_end && DoIsDigit(*e); ++e)
+        {
+          if (exp < 10000) { exp = exp * 10 + (*e - '0'); }
+        }
+
+        exponent += negativeExp ? -exp : exp;
+        p = e;
+      }
+    }
+
+    f64 value = (f64)mantissa;
+    if (mantissa != 0)
+    {
+      for (; exponent > g_maxPow10; exponent -= g_maxPow10)
+      { value *= g_pow10[g_maxPow10]; }
+      for (; exponent < -g_maxPow10; exponent += g_maxPow10)
+      { value /= g_pow10[g_maxPow10]; }
+
+      value = exponent < 0 ? value / g_pow10[-exponent] : value * g_pow10[exponent];
+    }
+
+    a_out = (f32)(negative ? -value : value);
+    return p;
+  }
+
+  // -----------------------------------------------------------------------
+
+  const char* DoParseInt(const char* a_begin, const char* a_end, s32& a_out)
+  {
+    const char* p = a_begin;
+
+    bool negative = false;
+    if (p < a_end && (*p == '-' || *p == '+'))
+    { negative = *p == '-'; ++p; }
+
+    if (p == a_end || DoIsDigit(*p) == false)
+    { return nullptr; }
+
+    s64 value = 0;
+    for (; p < a_end && DoIsDigit(*p); ++p)
+    {
+      value = value * 10 + (*p - '0');
+      if (value > 0x7FFFFFFF)
+      { return nullptr; }
+    }
+
+    a_out = (s32)(negative ? -value : value);
+    return p;
+  }
+
+  // -----------------------------------------------------------------------
+
+  bool  DoParseFloats(const char* a_begin, const char* a_end, tl_int a_count,
+                      tl_core_conts::Array<f32>& a_out)
+  {
+    const char* p = a_begin;
+    for (tl_int i = 0; i < a_count; ++i)
+    {
+      f32 value;
+      p = DoParseFloat(DoSkipSpaces(p, a_end), a_end, value);
+      if (p == nullptr)
+      { return false; }
+
+      a_out.push_back(value);
+    }
+
+    return true;
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// ObjMesh
+
+void
+ObjMesh::
+  Clear()
+{
+  m_positions.clear();
+  m_texCoords.clear();
+  m_normals.clear();
+  m_corners.clear();
+  m_groups.clear();
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+ObjMesh::
+  GetNumPositions() const
+{ return m_positions.size() / 3; }
+
+// -----------------------------------------------------------------------
+
+tl_size
+ObjMesh::
+  GetNumTriangles() const
+{ return m_corners.size() / 3; }
+
+// ///////////////////////////////////////////////////////////////////////
+// ObjParser
+
+ObjParser::
+  ObjParser()
+  : m_mesh(nullptr)
+  , m_line(0)
+  , m_errorLine(0)
+  , m_chunkMode(false)
+{
+  for (tl_int i = 0; i < k_numAttributes; ++i)
+  { m_neededCount[i] = 0; }
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  Parse(const char* a_data, tl_size a_size, ObjMesh& a_mesh)
+{
+  Begin(a_mesh);
+  if (DoParseLines(a_data, a_data + a_size) == false)
+  { return false; }
+
+  return End();
+}
+
+// -----------------------------------------------------------------------
+
+void
+ObjParser::
+  Begin(ObjMesh& a_mesh)
+{
+  m_mesh = &a_mesh;
+  m_mesh->Clear();
+  m_carry.clear();
+  m_line = 0;
+  m_errorLine = 0;
+  m_chunkMode = false;
+  m_relativeSlots.clear();
+
+  for (tl_int i = 0; i < k_numAttributes; ++i)
+  { m_neededCount[i] = 0; }
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  ParseChunk(const char* a_data, tl_size a_size)
+{
+  TLOC_ASSERT(m_mesh, "Begin() was not called");
+
+  if (m_errorLine != 0)
+  { return false; }
+
+  const char* p = a_data;
+  const char* end = a_data + a_size;
+
+  // finish the line cut by the previous chunk
+  if (m_carry.empty() == false)
+  {
+    const char* newLine = static_cast<const char*>(memchr(p, '\n', a_size));
+    const char* carryEnd = newLine ? newLine : end;
+
+    const tl_size carrySize = m_carry.size();
+    m_carry.resize(carrySize + (carryEnd - p));
+    memcpy(&m_carry[0] + carrySize, p, carryEnd - p);
+
+    if (newLine == nullptr)
+    { return true; }
+
+    if (DoParseLines(&m_carry[0], &m_carry[0] + m_carry.size()) == false)
+    { return false; }
+
+    m_carry.clear();
+    p = newLine + 1;
+  }
+
+  const char* lastLineEnd = end;
+  while (lastLineEnd > p && lastLineEnd[-1] != '\n') { --lastLineEnd; }
+
+  if (DoParseLines(p, lastLineEnd) == false)
+  { return false; }
+
+  if (lastLineEnd < end)
+  {
+    m_carry.resize(end - lastLineEnd);
+    memcpy(&m_carry[0], lastLineEnd, end - lastLineEnd);
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  End()
+{
+  TLOC_ASSERT(m_mesh, "Begin() was not called");
+
+  if (m_errorLine == 0 && m_carry.empty() == false)
+  { DoParseLines(&m_carry[0], &m_carry[0] + m_carry.size()); }
+  m_carry.clear();
+
+  tl_core_conts::Array<ObjGroup>& groups = m_mesh->m_groups;
+  if (groups.empty() == false)
+  {
+    groups.back().m_numTriangles =
+      m_mesh->GetNumTriangles() - groups.back().m_firstTriangle;
+  }
+
+  tl_size numGroups = 0;
+  for (tl_size i = 0; i < groups.size(); ++i)
+  {
+    if (groups[i].m_numTriangles > 0)
+    { groups[numGroups++] = groups[i]; }
+  }
+  groups.resize(numGroups);
+
+  m_mesh = nullptr;
+  return m_errorLine == 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  DoParseLines(const char* a_begin, const char* a_end)
+{
+  const char* p = a_begin;
+  while (p < a_end)
+  {
+    const char* newLine = static_cast<const char*>(memchr(p, '\n', a_end - p));
+    const char* lineEnd = newLine ? newLine : a_end;
+
+    ++m_line;
+    if (DoParseLine(p, lineEnd) == false)
+    {
+      m_errorLine = m_line;
+      return false;
+    }
+
+    p = lineEnd + 1;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  DoParseLine(const char* a_begin, const char* a_end)
+{
+  if (a_end > a_begin && a_end[-1] == '\r')
+  { --a_end; }
+
+  const char* p = DoSkipSpaces(a_begin, a_end);
+  if (p == a_end || *p == '#')
+  { return true; }
+
+  const char  c0 = *p;
+  const char  c1 = p + 1 < a_end ? p[1] : ' ';
+  const char  c2 = p + 2 < a_end ? p[2] : ' ';
+
+  if (c0 == 'v')
+  {
+    if (DoIsSpace(c1))
+    { return DoParseFloats(p + 1, a_end, 3, m_mesh->m_positions); }
+    if (c1 == 't' && DoIsSpace(c2))
+    { return DoParseFloats(p + 2, a_end, 2, m_mesh->m_texCoords); }
+    if (c1 == 'n' && DoIsSpace(c2))
+    { return DoParseFloats(p + 2, a_end, 3, m_mesh->m_normals); }
+  }
+  else if (c0 == 'f' && DoIsSpace(c1))
+  { return DoParseFace(p + 1, a_end); }
+  else if ( (c0 == 'o' || c0 == 'g') && DoIsSpace(c1))
+  { DoBeginGroup(p + 1, a_end); }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+// Corners are v, v/vt, v//vn or v/vt/vn. Polygons are split into a fan.
+
+bool
+ObjParser::
+  DoParseFace(const char* a_begin, const char* a_end)
+{
+  m_polygon.clear();
+  m_polygonRelative.clear();
+
+  const char* p = DoSkipSpaces(a_begin, a_end);
+  while (p < a_end)
+  {
+    ObjCorner corner;
+    corner.m_texCoord = ObjCorner::k_noIndex;
+    corner.m_normal = ObjCorner::k_noIndex;
+
+    u8 relative = 0;
+
+    s32 index;
+    p = DoParseInt(p, a_end, index);
+    if (p == nullptr || DoResolveIndex(index, k_position, corner.m_position) == false)
+    { return false; }
+    if (index < 0) { relative |= 1 << k_position; }
+
+    if (p < a_end && *p == '/')
+    {
+      ++p;
+      if (p < a_end && *p != '/')
+      {
+        p = DoParseInt(p, a_end, index);
+        if (p == nullptr || DoResolveIndex(index, k_texCoord, corner.m_texCoord) == false)
+        { return false; }
+        if (index < 0) { relative |= 1 << k_texCoord; }
+      }
+
+      if (p < a_end && *p == '/')
+      {
+        p = DoParseInt(p + 1, a_end, index);
+        if (p == nullptr || DoResolveIndex(index, k_normal, corner.m_normal) == false)
+        { return false; }
+        if (index < 0) { relative |= 1 << k_normal; }
+      }
+    }
+
+    if (p < a_end && DoIsSpace(*p) == false)
+    { return false; }
+
+    m_polygon.push_back(corner);
+    m_polygonRelative.push_back(relative);
+    p = DoSkipSpaces(p, a_end);
+  }
+
+  if (m_polygon.size() < 3)
+  { return false; }
+
+  // in chunk mode leading faces belong to the group of a previous chunk
+  if (m_mesh->m_groups.empty() && m_chunkMode == false)
+  { DoBeginGroup(a_end, a_end); }
+
+  for (tl_size i = 1; i + 1 < m_polygon.size(); ++i)
+  {
+    const tl_size fan[3] = { 0, i, i + 1 };
+    for (tl_int j = 0; j < 3; ++j)
+    {
+      if (m_chunkMode && m_polygonRelative[fan[j]] != 0)
+      {
+        const u32 slot = (u32)m_mesh->m_corners.size() * k_numAttributes;
+        for (tl_int attribute = 0; attribute < k_numAttributes; ++attribute)
+        {
+          if (m_polygonRelative[fan[j]] & (1 << attribute))
+          { m_relativeSlots.push_back(slot + attribute); }
+        }
+      }
+
+      m_mesh->m_corners.push_back(m_polygon[fan[j]]);
+    }
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+// OBJ indices are 1 based, negative ones are relative to the end. In chunk
+// mode the attributes of the previous chunks are unknown: positive indices
+// are kept as they are and negative ones relative to the chunk, the count
+// they need from the previous chunks is checked when merging.
+
+bool
+ObjParser::
+  DoResolveIndex(s32 a_index, tl_int a_attribute, s32& a_out)
+{
+  if (a_index == 0)
+  { return false; }
+
+  const s64 count = (s64)DoGetCount(*m_mesh, a_attribute);
+  const s64 index = a_index > 0 ? (s64)a_index - 1 : count + a_index;
+
+  if (m_chunkMode)
+  {
+    const s64 needed = index < 0 ? -index : index - count + 1;
+    if (needed > m_neededCount[a_attribute])
+    { m_neededCount[a_attribute] = needed; }
+  }
+  else if (index < 0 || index >= count)
+  { return false; }
+
+  a_out = (s32)index;
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+void
+ObjParser::
+  DoBeginGroup(const char* a_begin, const char* a_end)
+{
+  tl_core_conts::Array<ObjGroup>& groups = m_mesh->m_groups;
+  const tl_size numTriangles = m_mesh->GetNumTriangles();
+
+  if (groups.empty() == false)
+  { groups.back().m_numTriangles = numTriangles - groups.back().m_firstTriangle; }
+
+  const char* nameBegin = DoSkipSpaces(a_begin, a_end);
+  const char* nameEnd = a_end;
+  while (nameEnd > nameBegin && DoIsSpace(nameEnd[-1])) { --nameEnd; }
+
+  ObjGroup group;
+  group.m_name = tl_core_str::String(nameBegin, nameEnd);
+  group.m_firstTriangle = numTriangles;
+  group.m_numTriangles = 0;
+
+  groups.push_back(group);
+}
+
+// -----------------------------------------------------------------------
+
+bool
+ObjParser::
+  ParseParallel(const char* a_data, tl_size a_size, ObjMesh& a_mesh, 
+                tl_int a_numThreads)
+{
+  const tl_int numChunks = core::tlMin(a_numThreads * g_chunksPerThread, 
+                                       (tl_int)(a_size / g_minChunkSize));
+  if (a_numThreads <= 1 || numChunks <= 1)
+  { return Parse(a_data, a_size, a_mesh); }
+
+  // chunk c is [chunkBegin[c], chunkBegin[c + 1]) and starts on a new line
+  tl_core_conts::Array<tl_size> chunkBegin(numChunks + 1, a_size);
+  chunkBegin[0] = 0;
+  for (tl_int c = 1; c < numChunks; ++c)
+  {
+    const tl_size split = core::tlMax( (a_size / numChunks) * c, chunkBegin[c - 1]);
+    const char* newLine = 
+      static_cast<const char*>(memchr(a_data + split, '\n', a_size - split));
+
+    chunkBegin[c] = newLine ? (tl_size)(newLine - a_data) + 1 : a_size;
+  }
+
+  tl_core_conts::Array<ObjParser> chunks(numChunks);
+  tl_core_conts::Array<ObjMesh>   meshes(numChunks);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(a_numThreads)
+  for (tl_int c = 0; c < numChunks; ++c)
+  {
+    ObjParser& chunk = chunks[c];
+    chunk.DoBeginChunk(meshes[c]);
+    chunk.DoParseLines(a_data + chunkBegin[c], a_data + chunkBegin[c + 1]);
+    chunk.m_mesh = nullptr;
+  }
+
+  if (DoMergeChunks(&chunks[0], &meshes[0], numChunks, a_mesh, a_numThreads))
+  { return true; }
+
+  return Parse(a_data, a_size, a_mesh);
+}
+
+// -----------------------------------------------------------------------
+
+void
+ObjParser::
+  DoBeginChunk(ObjMesh& a_mesh)
+{
+  Begin(a_mesh);
+  m_chunkMode = true;
+}
+
+// -----------------------------------------------------------------------
+// Chunks are appended in file order. Returns false if a chunk failed or
+// references attributes that do not exist (yet).
+
+bool
+ObjParser::
+  DoMergeChunks(ObjParser* a_chunks, ObjMesh* a_meshes, tl_int a_numChunks,
+                ObjMesh& a_mesh, tl_int a_numThreads)
+{
+  a_mesh.Clear();
+
+  // attribute counts and corners of the chunks before chunk c
+  tl_core_conts::Array<tl_size> prefix( (a_numChunks + 1) * k_numAttributes, 0);
+  tl_core_conts::Array<tl_size> cornerPrefix(a_numChunks + 1, 0);
+
+  for (tl_int c = 0; c < a_numChunks; ++c)
+  {
+    if (a_chunks[c].m_errorLine != 0)
+    { return false; }
+
+    for (tl_int attribute = 0; attribute < k_numAttributes; ++attribute)
+    {
+      const tl_size before = prefix[c * k_numAttributes + attribute];
+      if (a_chunks[c].m_neededCount[attribute] > (s64)before)
+      { return false; }
+
+      prefix[(c + 1) * k_numAttributes + attribute] = 
+        before + DoGetCount(a_meshes[c], attribute);
+    }
+
+    cornerPrefix[c + 1] = cornerPrefix[c] + a_meshes[c].m_corners.size();
+  }
+
+  const tl_size* total = &prefix[a_numChunks * k_numAttributes];
+  a_mesh.m_positions.resize(total[k_position] * 3);
+  a_mesh.m_texCoords.resize(total[k_texCoord] * 2);
+  a_mesh.m_normals.resize(total[k_normal] * 3);
+  a_mesh.m_corners.resize(cornerPrefix[a_numChunks]);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(a_numThreads)
+  for (tl_int c = 0; c < a_numChunks; ++c)
+  {
+    const ObjMesh& chunk = a_meshes[c];
+    const tl_size* before = &prefix[c * k_numAttributes];
+
+    DoCopyInto(chunk.m_positions, a_mesh.m_positions, before[k_position] * 3);
+    DoCopyInto(chunk.m_texCoords, a_mesh.m_texCoords, before[k_texCoord] * 2);
+    DoCopyInto(chunk.m_normals, a_mesh.m_normals, before[k_normal] * 3);
+    DoCopyInto(chunk.m_corners, a_mesh.m_corners, cornerPrefix[c]);
+
+    const tl_core_conts::Array<u32>& slots = a_chunks[c].m_relativeSlots;
+    for (tl_size i = 0; i < slots.size(); ++i)
+    {
+      const tl_int attribute = slots[i] % k_numAttributes;
+      ObjCorner& corner = a_mesh.m_corners[cornerPrefix[c] + slots[i] / k_numAttributes];
+      DoGetCornerIndex(corner, attribute) += (s32)before[attribute];
+    }
+  }
+
+  // faces before the first group of a chunk continue the last group, or
+  // start the unnamed one like Parse() does
+  tl_core_conts::Array<ObjGroup>& groups = a_mesh.m_groups;
+  for (tl_int c = 0; c < a_numChunks; ++c)
+  {
+    const ObjMesh& chunk = a_meshes[c];
+    const tl_size  firstTriangle = cornerPrefix[c] / 3;
+    const tl_size  numLeading = chunk.m_groups.empty() 
+      ? chunk.GetNumTriangles() : chunk.m_groups[0].m_firstTriangle;
+
+    if (numLeading > 0 && groups.empty())
+    {
+      ObjGroup group;
+      group.m_firstTriangle = firstTriangle;
+      group.m_numTriangles = 0;
+      groups.push_back(group);
+    }
+
+    for (tl_size g = 0; g < chunk.m_groups.size(); ++g)
+    {
+      groups.push_back(chunk.m_groups[g]);
+      groups.back().m_firstTriangle += firstTriangle;
+    }
+  }
+
+  tl_size numGroups = 0;
+  for (tl_size g = 0; g < groups.size(); ++g)
+  {
+    const tl_size end = g + 1 < groups.size() 
+      ? groups[g + 1].m_firstTriangle : a_mesh.GetNumTriangles();
+
+    groups[g].m_numTriangles = end - groups[g].m_firstTriangle;
+    if (groups[g].m_numTriangles > 0)
+    { groups[numGroups++] = groups[g]; }
+  }
+  groups.resize(numGroups);
+
+  return true;
+}
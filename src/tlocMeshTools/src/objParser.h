@@ -0,0 +1,99 @@
+#ifndef _TLOC_MESH_TOOLS_OBJ_PARSER_H_
+#define _TLOC_MESH_TOOLS_OBJ_PARSER_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// A parsed OBJ file. Attributes are kept as flat float arrays exactly as
+// they appear in the file, faces are triangulated (as a fan) into corners
+// that index them. Groups start at every 'o' or 'g' line, like
+// gfx_med::ObjLoader, empty groups are dropped.
+
+struct ObjCorner
+{
+  enum { k_noIndex = -1 };
+
+  s32   m_position;
+  s32   m_texCoord;   // k_noIndex if the face has no texture coordinates
+  s32   m_normal;     // k_noIndex if the face has no normals
+};
+
+struct ObjGroup
+{
+  tl_core_str::String   m_name;
+  tl_size               m_firstTriangle;
+  tl_size               m_numTriangles;
+};
+
+struct ObjMesh
+{
+  void    Clear();
+
+  tl_size GetNumPositions() const;
+  tl_size GetNumTriangles() const;
+
+  tl_core_conts::Array<f32>         m_positions;  // xyz
+  tl_core_conts::Array<f32>         m_texCoords;  // uv
+  tl_core_conts::Array<f32>         m_normals;    // xyz
+  tl_core_conts::Array<ObjCorner>   m_corners;    // 3 per triangle
+  tl_core_conts::Array<ObjGroup>    m_groups;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Parses OBJ text without copying it: Parse() works on a whole file in
+// memory (e.g. a MappedFile view) and ParseChunk() on a stream read in
+// pieces, where only a line cut by the end of a chunk is carried over.
+// Lines are never turned into strings and numbers are parsed by hand.
+// Unsupported statements (mtllib, usemtl, s, ...) are skipped.
+//
+// ParseParallel() splits the file at line boundaries and parses the chunks
+// on a_numThreads threads. Positive indices are global already, negative
+// ones are relative to the chunk and fixed up when the chunks are merged in
+// order, so the result (groups and face order included) is identical to
+// Parse(). Files with errors are parsed again serially to report the line.
+
+class ObjParser
+{
+public:
+  ObjParser();
+
+  bool    Parse(const char* a_data, tl_size a_size, ObjMesh& a_mesh);
+  bool    ParseParallel(const char* a_data, tl_size a_size, ObjMesh& a_mesh,
+                        tl_int a_numThreads);
+
+  void    Begin(ObjMesh& a_mesh);
+  bool    ParseChunk(const char* a_data, tl_size a_size);
+  bool    End();
+
+  // line of the first error (1 based), 0 if there was none
+  TLOC_DECL_AND_DEF_GETTER(tl_size, GetErrorLine, m_errorLine);
+
+private:
+  bool    DoParseLines(const char* a_begin, const char* a_end);
+  bool    DoParseLine(const char* a_begin, const char* a_end);
+  bool    DoParseFace(const char* a_begin, const char* a_end);
+  void    DoBeginGroup(const char* a_begin, const char* a_end);
+  bool    DoResolveIndex(s32 a_index, tl_int a_attribute, s32& a_out);
+
+  void    DoBeginChunk(ObjMesh& a_mesh);
+  bool    DoMergeChunks(ObjParser* a_chunks, ObjMesh* a_meshes, 
+                        tl_int a_numChunks, ObjMesh& a_mesh, tl_int a_numThreads);
+
+private:
+  ObjMesh*                          m_mesh;
+  tl_core_conts::Array<char>        m_carry;
+  tl_core_conts::Array<ObjCorner>   m_polygon;
+
+  tl_size   m_line;
+  tl_size   m_errorLine;
+
+  // chunk mode (ParseParallel): the attribute counts the previous chunks
+  // must have for the indices to be valid, and the corner slots
+  // (corner * 3 + attribute) that hold chunk relative indices
+  bool                              m_chunkMode;
+  s64                               m_neededCount[3];
+  tl_core_conts::Array<u8>          m_polygonRelative;
+  tl_core_conts::Array<u32>         m_relativeSlots;
+};
+
+#endif
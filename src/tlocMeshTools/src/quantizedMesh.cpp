@@ -0,0 +1,518 @@
+#include "quantizedMesh.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || \
+    (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+# define TLOC_MESH_TOOLS_SSE2
+# include <emmintrin.h>
+#endif
+
+using namespace tloc;
+
+namespace {
+
+  // vertices are converted this many at a time, through arrays that stay
+  // in the L1 cache
+  const tl_size g_blockSize = 64;
+
+  const f32 g_radiansToDegrees = 57.2957795f;
+
+  u32   DoGetBits(f32 a_value)
+  {
+    u32 bits;
+    memcpy(&bits, &a_value, sizeof(bits));
+    return bits;
+  }
+
+  f32   DoGetFloat(u32 a_bits)
+  {
+    f32 value;
+    memcpy(&value, &a_bits, sizeof(value));
+    return value;
+  }
+
+  // a_mask is all ones or all zeros (see DoGetMask())
+  u32   DoSelect(u32 a_mask, u32 a_true, u32 a_false)
+  { return (a_true & a_mask) | (a_false & ~a_mask); }
+
+  u32   DoGetMask(bool a_condition)
+  { return 0u - (u32)a_condition; }
+
+  // ternaries on floats keep the compiler from vectorizing, masks do not
+  f32   DoMax(f32 a, f32 b)
+  { return DoGetFloat(DoSelect(DoGetMask(a > b), DoGetBits(a), DoGetBits(b))); }
+
+  // a_value with the sign of a_sign
+  f32   DoCopySign(f32 a_value, f32 a_sign)
+  {
+    return DoGetFloat((DoGetBits(a_value) & 0x7FFFFFFFu) | 
+                      (DoGetBits(a_sign) & 0x80000000u));
+  }
+
+  // -----------------------------------------------------------------------
+  // Half floats (after F. Giesen's float_to_half_fast3_rtne and
+  // half_to_float). Every case is computed and one selected with masks, so
+  // that there are no branches in the loops.
+
+  void  DoEncodeHalfs(const f32* a_in, tl_size a_count, u16* a_out)
+  {
+    const u32 infinity = 255u << 23;
+    const u32 halfOverflow = (127u + 16u) << 23;
+    const u32 denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+    const u32 smallestNormal = 113u << 23;
+
+    for (tl_size i = 0; i < a_count; ++i)
+    {
+      const u32 bits = DoGetBits(a_in[i]);
+      const u32 sign = bits & 0x80000000u;
+      const u32 value = bits ^ sign;
+
+      const u32 overflow = DoSelect(DoGetMask(value > infinity), 0x7E00u, 0x7C00u);
+      const u32 denorm = 
+        DoGetBits(DoGetFloat(value) + DoGetFloat(denormMagic)) - denormMagic;
+      const u32 mantissaOdd = (value >> 13) & 1u;
+      const u32 normal = 
+        (value + ((u32)(15 - 127) << 23) + 0xFFFu + mantissaOdd) >> 13;
+
+      const u32 half = DoSelect(DoGetMask(value >= halfOverflow), overflow, 
+        DoSelect(DoGetMask(value < smallestNormal), denorm, normal));
+      a_out[i] = (u16)(half | (sign >> 16));
+    }
+  }
+
+  void  DoDecodeHalfs(const u16* a_in, tl_size a_count, f32* a_out)
+  {
+    const u32 shiftedExponent = 0x7C00u << 13;
+    const f32 magic = DoGetFloat(113u << 23);
+
+    for (tl_size i = 0; i < a_count; ++i)
+    {
+      const u32 half = a_in[i];
+      const u32 shifted = (half & 0x7FFFu) << 13;
+      const u32 exponent = shiftedExponent & shifted;
+      const u32 bits = shifted + ((127u - 15u) << 23);
+
+      const u32 infNan = bits + ((128u - 16u) << 23);
+      const u32 denorm = DoGetBits(DoGetFloat(bits + (1u << 23)) - magic);
+
+      const u32 value = DoSelect(DoGetMask(exponent == shiftedExponent), infNan,
+        DoSelect(DoGetMask(exponent == 0), denorm, bits));
+      a_out[i] = DoGetFloat(value | ((half & 0x8000u) << 16));
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Octahedral normals, rounded to a_max steps per unit
+
+  void  DoEncodeOctahedral(const f32* a_x, const f32* a_y, const f32* a_z,
+                           tl_size a_count, f32 a_max, s32* a_u, s32* a_v)
+  {
+    for (tl_size i = 0; i < a_count; ++i)
+    {
+      const f32 length = fabsf(a_x[i]) + fabsf(a_y[i]) + fabsf(a_z[i]);
+      const f32 scale = 1.0f / DoMax(length, 1e-20f);
+
+      const f32 x = a_x[i] * scale;
+      const f32 y = a_y[i] * scale;
+
+      // the lower half folds over the diagonals
+      const u32 lower = DoGetMask(a_z[i] < 0.0f);
+      const f32 foldedX = DoCopySign(1.0f - fabsf(y), x);
+      const f32 foldedY = DoCopySign(1.0f - fabsf(x), y);
+
+      const f32 u = DoGetFloat(DoSelect(lower, DoGetBits(foldedX), DoGetBits(x)));
+      const f32 v = DoGetFloat(DoSelect(lower, DoGetBits(foldedY), DoGetBits(y)));
+
+      a_u[i] = (s32)(u * a_max + DoCopySign(0.5f, u));
+      a_v[i] = (s32)(v * a_max + DoCopySign(0.5f, v));
+    }
+  }
+
+  // The sqrtf below sets errno on negative input, so compilers only
+  // vectorize the loop with -fno-math-errno (GCC, Clang) or /fp:fast (MSVC).
+  // With SSE2 four normals are decoded at a time with the same operations
+  // in the same order, the results are identical to the scalar loop.
+
+  void  DoDecodeOctahedral(const s32* a_u, const s32* a_v, tl_size a_count,
+                           f32 a_max, f32* a_x, f32* a_y, f32* a_z)
+  {
+    const f32 invMax = 1.0f / a_max;
+
+    tl_size i = 0;
+
+#if defined (TLOC_MESH_TOOLS_SSE2)
+    const __m128 invMax4 = _mm_set1_ps(invMax);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 signBit = _mm_castsi128_ps(_mm_set1_epi32( (int)0x80000000u));
+
+    for (; i + 4 <= a_count; i += 4)
+    {
+      const __m128 u = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_u + i))), invMax4), 
+        minusOne);
+      const __m128 v = _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_v + i))), invMax4), 
+        minusOne);
+
+      const __m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_andnot_ps(signBit, u)), 
+                                  _mm_andnot_ps(signBit, v));
+      const __m128 t = _mm_max_ps(_mm_xor_ps(z, signBit), zero);
+
+      // t is positive, so copysign(t, u) is t with the sign bit of u
+      const __m128 x = _mm_sub_ps(u, _mm_or_ps(t, _mm_and_ps(u, signBit)));
+      const __m128 y = _mm_sub_ps(v, _mm_or_ps(t, _mm_and_ps(v, signBit)));
+
+      const __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), 
+                                                    _mm_mul_ps(y, y)), 
+                                         _mm_mul_ps(z, z));
+      const __m128 scale = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+
+      _mm_storeu_ps(a_x + i, _mm_mul_ps(x, scale));
+      _mm_storeu_ps(a_y + i, _mm_mul_ps(y, scale));
+      _mm_storeu_ps(a_z + i, _mm_mul_ps(z, scale));
+    }
+#endif
+
+    for (; i < a_count; ++i)
+    {
+      // snorm values of -max - 1 (-128, -32768) are -1 as well
+      const f32 u = DoMax((f32)a_u[i] * invMax, -1.0f);
+      const f32 v = DoMax((f32)a_v[i] * invMax, -1.0f);
+
+      const f32 z = 1.0f - fabsf(u) - fabsf(v);
+      const f32 t = DoMax(-z, 0.0f);
+      const f32 x = u - DoCopySign(t, u);
+      const f32 y = v - DoCopySign(t, v);
+
+      const f32 scale = 1.0f / sqrtf(x * x + y * y + z * z);
+      a_x[i] = x * scale;
+      a_y[i] = y * scale;
+      a_z[i] = z * scale;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  void  DoQuantizePositions(const f32* a_in, tl_size a_count, f32 a_offset, 
+                            f32 a_invScale, u16* a_out)
+  {
+    for (tl_size i = 0; i < a_count; ++i)
+    {
+      const f32 q = (a_in[i] - a_offset) * a_invScale + 0.5f;
+      a_out[i] = (u16)(q < 0.0f ? 0.0f : q > 65535.0f ? 65535.0f : q);
+    }
+  }
+
+  void  DoDequantizePositions(const u16* a_in, tl_size a_count, f32 a_offset, 
+                              f32 a_scale, f32* a_out)
+  {
+    for (tl_size i = 0; i < a_count; ++i)
+    { a_out[i] = a_offset + (f32)a_in[i] * a_scale; }
+  }
+
+  // -----------------------------------------------------------------------
+  // Both formats only differ in the normal type (s8 or s16)
+
+  struct VertexBlock
+  {
+    f32   m_position[3][g_blockSize];
+    f32   m_normal[3][g_blockSize];
+    f32   m_texCoord[2][g_blockSize];
+
+    u16   m_quantizedPosition[3][g_blockSize];
+    s32   m_octahedral[2][g_blockSize];
+    u16   m_halfTexCoord[2][g_blockSize];
+  };
+
+  template <typename T_Vertex, typename T_Normal>
+  void  DoQuantizeVertices(const MeshVertex* a_in, tl_size a_count,
+                           const PositionQuantization& a_quantization,
+                           T_Vertex* a_out)
+  {
+    const f32 normalMax = (f32)((1 << (sizeof(T_Normal) * 8 - 1)) - 1);
+
+    VertexBlock block;
+    for (tl_size begin = 0; begin < a_count; begin += g_blockSize)
+    {
+      const tl_size count = core::tlMin(g_blockSize, a_count - begin);
+      const MeshVertex* in = a_in + begin;
+      T_Vertex* out = a_out + begin;
+
+      for (tl_size i = 0; i < count; ++i)
+      {
+        for (tl_int c = 0; c < 3; ++c)
+        {
+          block.m_position[c][i] = in[i].m_position[c];
+          block.m_normal[c][i] = in[i].m_normal[c];
+        }
+        block.m_texCoord[0][i] = in[i].m_texCoord[0];
+        block.m_texCoord[1][i] = in[i].m_texCoord[1];
+      }
+
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        const f32 scale = a_quantization.m_scale[c];
+        DoQuantizePositions(block.m_position[c], count, a_quantization.m_offset[c],
+                            scale > 0.0f ? 1.0f / scale : 0.0f, 
+                            block.m_quantizedPosition[c]);
+      }
+
+      DoEncodeOctahedral(block.m_normal[0], block.m_normal[1], block.m_normal[2],
+                         count, normalMax, block.m_octahedral[0], 
+                         block.m_octahedral[1]);
+      DoEncodeHalfs(block.m_texCoord[0], count, block.m_halfTexCoord[0]);
+      DoEncodeHalfs(block.m_texCoord[1], count, block.m_halfTexCoord[1]);
+
+      memset(out, 0, count * sizeof(T_Vertex));
+      for (tl_size i = 0; i < count; ++i)
+      {
+        for (tl_int c = 0; c < 3; ++c)
+        { out[i].m_position[c] = block.m_quantizedPosition[c][i]; }
+        out[i].m_normal[0] = (T_Normal)block.m_octahedral[0][i];
+        out[i].m_normal[1] = (T_Normal)block.m_octahedral[1][i];
+        out[i].m_texCoord[0] = block.m_halfTexCoord[0][i];
+        out[i].m_texCoord[1] = block.m_halfTexCoord[1][i];
+      }
+    }
+  }
+
+  template <typename T_Vertex, typename T_Normal>
+  void  DoDequantizeVertices(const T_Vertex* a_in, tl_size a_count,
+                             const PositionQuantization& a_quantization,
+                             MeshVertex* a_out)
+  {
+    const f32 normalMax = (f32)((1 << (sizeof(T_Normal) * 8 - 1)) - 1);
+
+    VertexBlock block;
+    for (tl_size begin = 0; begin < a_count; begin += g_blockSize)
+    {
+      const tl_size count = core::tlMin(g_blockSize, a_count - begin);
+      const T_Vertex* in = a_in + begin;
+      MeshVertex* out = a_out + begin;
+
+      for (tl_size i = 0; i < count; ++i)
+      {
+        for (tl_int c = 0; c < 3; ++c)
+        { block.m_quantizedPosition[c][i] = in[i].m_position[c]; }
+        block.m_octahedral[0][i] = in[i].m_normal[0];
+        block.m_octahedral[1][i] = in[i].m_normal[1];
+        block.m_halfTexCoord[0][i] = in[i].m_texCoord[0];
+        block.m_halfTexCoord[1][i] = in[i].m_texCoord[1];
+      }
+
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        DoDequantizePositions(block.m_quantizedPosition[c], count, 
+                              a_quantization.m_offset[c], 
+                              a_quantization.m_scale[c], block.m_position[c]);
+      }
+
+      DoDecodeOctahedral(block.m_octahedral[0], block.m_octahedral[1], count, 
+                         normalMax, block.m_normal[0], block.m_normal[1], 
+                         block.m_normal[2]);
+      DoDecodeHalfs(block.m_halfTexCoord[0], count, block.m_texCoord[0]);
+      DoDecodeHalfs(block.m_halfTexCoord[1], count, block.m_texCoord[1]);
+
+      for (tl_size i = 0; i < count; ++i)
+      {
+        for (tl_int c = 0; c < 3; ++c)
+        {
+          out[i].m_position[c] = block.m_position[c][i];
+          out[i].m_normal[c] = block.m_normal[c][i];
+        }
+        out[i].m_texCoord[0] = block.m_texCoord[0][i];
+        out[i].m_texCoord[1] = block.m_texCoord[1][i];
+      }
+    }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Quantization
+
+PositionQuantization
+  GetPositionQuantization(const MeshVertex* a_vertices, tl_size a_numVertices)
+{
+  PositionQuantization quantization;
+  if (a_numVertices == 0)
+  {
+    for (tl_int c = 0; c < 3; ++c)
+    { quantization.m_offset[c] = quantization.m_scale[c] = 0.0f; }
+    return quantization;
+  }
+
+  f32 boxMin[3];
+  f32 boxMax[3];
+  for (tl_int c = 0; c < 3; ++c)
+  { boxMin[c] = boxMax[c] = a_vertices[0].m_position[c]; }
+
+  for (tl_size i = 1; i < a_numVertices; ++i)
+  {
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      boxMin[c] = core::tlMin(boxMin[c], a_vertices[i].m_position[c]);
+      boxMax[c] = core::tlMax(boxMax[c], a_vertices[i].m_position[c]);
+    }
+  }
+
+  for (tl_int c = 0; c < 3; ++c)
+  {
+    quantization.m_offset[c] = boxMin[c];
+    quantization.m_scale[c] = (boxMax[c] - boxMin[c]) / 65535.0f;
+  }
+
+  return quantization;
+}
+
+// -----------------------------------------------------------------------
+
+void
+  QuantizeVertices(const MeshVertex* a_in, tl_size a_count,
+                   const PositionQuantization& a_quantization,
+                   QuantizedVertex8* a_out)
+{ DoQuantizeVertices<QuantizedVertex8, s8>(a_in, a_count, a_quantization, a_out); }
+
+void
+  QuantizeVertices(const MeshVertex* a_in, tl_size a_count,
+                   const PositionQuantization& a_quantization,
+                   QuantizedVertex16* a_out)
+{ DoQuantizeVertices<QuantizedVertex16, s16>(a_in, a_count, a_quantization, a_out); }
+
+// -----------------------------------------------------------------------
+
+void
+  DequantizeVertices(const QuantizedVertex8* a_in, tl_size a_count,
+                     const PositionQuantization& a_quantization,
+                     MeshVertex* a_out)
+{ DoDequantizeVertices<QuantizedVertex8, s8>(a_in, a_count, a_quantization, a_out); }
+
+void
+  DequantizeVertices(const QuantizedVertex16* a_in, tl_size a_count,
+                     const PositionQuantization& a_quantization,
+                     MeshVertex* a_out)
+{ DoDequantizeVertices<QuantizedVertex16, s16>(a_in, a_count, a_quantization, a_out); }
+
+// -----------------------------------------------------------------------
+
+void
+  EncodeHalfs(const f32* a_in, tl_size a_count, u16* a_out)
+{ DoEncodeHalfs(a_in, a_count, a_out); }
+
+void
+  DecodeHalfs(const u16* a_in, tl_size a_count, f32* a_out)
+{ DoDecodeHalfs(a_in, a_count, a_out); }
+
+// ///////////////////////////////////////////////////////////////////////
+// Error
+
+QuantizationError
+  GetQuantizationError(const MeshVertex* a_reference, const MeshVertex* a_vertices,
+                       tl_size a_count)
+{
+  QuantizationError error = { 0.0f, 0.0f, 0.0f };
+  if (a_count == 0)
+  { return error; }
+
+  const PositionQuantization bounds = GetPositionQuantization(a_reference, a_count);
+  const f32 extent = core::tlMax(bounds.m_scale[0], 
+    core::tlMax(bounds.m_scale[1], bounds.m_scale[2])) * 65535.0f;
+
+  f32 minNormalDot = 1.0f;
+  for (tl_size i = 0; i < a_count; ++i)
+  {
+    const MeshVertex& reference = a_reference[i];
+    const MeshVertex& vertex = a_vertices[i];
+
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      error.m_position = core::tlMax(error.m_position, 
+        fabsf(reference.m_position[c] - vertex.m_position[c]));
+    }
+
+    for (tl_int c = 0; c < 2; ++c)
+    {
+      error.m_texCoord = core::tlMax(error.m_texCoord, 
+        fabsf(reference.m_texCoord[c] - vertex.m_texCoord[c]));
+    }
+
+    const f32* a = reference.m_normal;
+    const f32* b = vertex.m_normal;
+    const f32 lengths = sqrtf((a[0] * a[0] + a[1] * a[1] + a[2] * a[2]) * 
+                             (b[0] * b[0] + b[1] * b[1] + b[2] * b[2]));
+    if (lengths > 0.0f)
+    {
+      minNormalDot = core::tlMin(minNormalDot, 
+        (a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / lengths);
+    }
+  }
+
+  error.m_position = extent > 0.0f ? error.m_position / extent : 0.0f;
+  error.m_normalDegrees = 
+    acosf(core::tlMax(core::tlMin(minNormalDot, 1.0f), -1.0f)) * g_radiansToDegrees;
+
+  return error;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// Layout
+
+tl_size
+  GetVertexSize(vertex_format a_format)
+{
+  if (a_format == k_vertexQuantized8)
+  { return sizeof(QuantizedVertex8); }
+  if (a_format == k_vertexQuantized16)
+  { return sizeof(QuantizedVertex16); }
+  return sizeof(MeshVertex);
+}
+
+// -----------------------------------------------------------------------
+
+void
+  GetVertexAttributes(vertex_format a_format, VertexAttribute a_out[3])
+{
+  VertexAttribute& position = a_out[0];
+  VertexAttribute& normal = a_out[1];
+  VertexAttribute& texCoord = a_out[2];
+
+  position.m_numComponents = 3;
+  normal.m_numComponents = a_format == k_vertexFloat ? 3 : 2;
+  texCoord.m_numComponents = 2;
+
+  if (a_format == k_vertexQuantized8)
+  {
+    position.m_offset = (u32)offsetof(QuantizedVertex8, m_position);
+    normal.m_offset = (u32)offsetof(QuantizedVertex8, m_normal);
+    texCoord.m_offset = (u32)offsetof(QuantizedVertex8, m_texCoord);
+    normal.m_type = VertexAttribute::k_s8;
+  }
+  else if (a_format == k_vertexQuantized16)
+  {
+    position.m_offset = (u32)offsetof(QuantizedVertex16, m_position);
+    normal.m_offset = (u32)offsetof(QuantizedVertex16, m_normal);
+    texCoord.m_offset = (u32)offsetof(QuantizedVertex16, m_texCoord);
+    normal.m_type = VertexAttribute::k_s16;
+  }
+  else
+  {
+    position.m_offset = (u32)offsetof(MeshVertex, m_position);
+    normal.m_offset = (u32)offsetof(MeshVertex, m_normal);
+    texCoord.m_offset = (u32)offsetof(MeshVertex, m_texCoord);
+    position.m_type = normal.m_type = texCoord.m_type = VertexAttribute::k_float;
+    position.m_normalized = normal.m_normalized = texCoord.m_normalized = false;
+    return;
+  }
+
+  // positions are scaled and offset in the vertex shader
+  position.m_type = VertexAttribute::k_u16;
+  position.m_normalized = false;
+  normal.m_normalized = true;
+  texCoord.m_type = VertexAttribute::k_half;
+  texCoord.m_normalized = false;
+}
@@ -0,0 +1,111 @@
+#ifndef _TLOC_MESH_TOOLS_QUANTIZED_MESH_H_
+#define _TLOC_MESH_TOOLS_QUANTIZED_MESH_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Compact versions of MeshVertex (32 bytes):
+//
+//   position: 16 bit unsigned normalized per axis, 
+//             position = m_offset + q * m_scale (PositionQuantization)
+//   normal:   octahedral encoding in 2 signed normalized 8 or 16 bit values
+//             (Cigolle et al. 2014), decoded with
+//             n = (x, y, 1 - |x| - |y|), t = max(-n.z, 0),
+//             n.xy -= sign(n.xy) * t, normalize(n)
+//   texture coordinates: half floats
+//
+// Attributes start on a multiple of their component size so that they can
+// be bound straight from a vertex buffer (see GetVertexAttributes()).
+
+struct QuantizedVertex8   // 12 bytes
+{
+  u16   m_position[3];
+  s8    m_normal[2];
+  u16   m_texCoord[2];
+};
+
+struct QuantizedVertex16  // 16 bytes
+{
+  u16   m_position[3];
+  u16   m_padding;
+  s16   m_normal[2];
+  u16   m_texCoord[2];
+};
+
+struct PositionQuantization
+{
+  f32   m_offset[3];
+  f32   m_scale[3];
+};
+
+// The bounding box of the positions mapped to [0, 65535] on each axis
+PositionQuantization  GetPositionQuantization(const MeshVertex* a_vertices, 
+                                              tl_size a_numVertices);
+
+// ///////////////////////////////////////////////////////////////////////
+// Encoding and decoding of a_count vertices (or values). The work is done
+// in blocks of straight, branch free loops over separate arrays of each
+// component, which the compiler can turn into SIMD code. Normal decoding
+// (the one loop with a square root) uses SSE2 where available. Missing (0)
+// normals decode as (0, 0, 1).
+
+void  QuantizeVertices(const MeshVertex* a_in, tl_size a_count,
+                       const PositionQuantization& a_quantization,
+                       QuantizedVertex8* a_out);
+void  QuantizeVertices(const MeshVertex* a_in, tl_size a_count,
+                       const PositionQuantization& a_quantization,
+                       QuantizedVertex16* a_out);
+
+void  DequantizeVertices(const QuantizedVertex8* a_in, tl_size a_count,
+                         const PositionQuantization& a_quantization,
+                         MeshVertex* a_out);
+void  DequantizeVertices(const QuantizedVertex16* a_in, tl_size a_count,
+                         const PositionQuantization& a_quantization,
+                         MeshVertex* a_out);
+
+// round to nearest even, overflow to infinity
+void  EncodeHalfs(const f32* a_in, tl_size a_count, u16* a_out);
+void  DecodeHalfs(const u16* a_in, tl_size a_count, f32* a_out);
+
+// ///////////////////////////////////////////////////////////////////////
+// Largest differences between two sets of vertices: position (relative to
+// the largest extent of a_reference), normal (in degrees, vertices
+// without a normal are skipped) and texture coordinates.
+
+struct QuantizationError
+{
+  f32   m_position;
+  f32   m_normalDegrees;
+  f32   m_texCoord;
+};
+
+QuantizationError GetQuantizationError(const MeshVertex* a_reference,
+                                       const MeshVertex* a_vertices,
+                                       tl_size a_count);
+
+// ///////////////////////////////////////////////////////////////////////
+// Vertex buffer layout, in the order position, normal, texture coordinates.
+
+struct VertexAttribute
+{
+  enum type { k_float, k_half, k_u16, k_s16, k_s8 };
+
+  u32   m_offset;
+  u32   m_numComponents;
+  type  m_type;
+  bool  m_normalized;
+};
+
+enum vertex_format
+{
+  k_vertexFloat = 0,    // MeshVertex
+  k_vertexQuantized8,   // QuantizedVertex8
+  k_vertexQuantized16,  // QuantizedVertex16
+};
+
+tl_size GetVertexSize(vertex_format a_format);
+void    GetVertexAttributes(vertex_format a_format, VertexAttribute a_out[3]);
+
+#endif
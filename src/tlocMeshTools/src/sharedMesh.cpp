@@ -0,0 +1,172 @@
+#include "sharedMesh.h"
+
+#include "mappedFile.h"
+#include "objParser.h"
+
+#include <tlocCore/smart_ptr/tloc_smart_ptr.inl.h>
+
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// SharedMesh
+
+SharedMesh::
+  SharedMesh()
+  : m_buffer(0)
+  , m_release(nullptr)
+  , m_userData(nullptr)
+{ }
+
+// -----------------------------------------------------------------------
+
+SharedMesh::
+  ~SharedMesh()
+{
+  if (m_release && m_buffer != 0)
+  { m_release(m_buffer, m_userData); }
+}
+
+// -----------------------------------------------------------------------
+
+shared_mesh_sptr
+SharedMesh::
+  Create(IndexedMesh& a_mesh)
+{
+  shared_mesh_sptr mesh = core_sptr::MakeShared<SharedMesh>();
+
+  IndexedMesh& data = mesh->m_mesh;
+  data.m_vertices.swap(a_mesh.m_vertices);
+  data.m_shortIndices.swap(a_mesh.m_shortIndices);
+  data.m_indices.swap(a_mesh.m_indices);
+  data.m_groups.swap(a_mesh.m_groups);
+  data.m_lods.swap(a_mesh.m_lods);
+  data.m_meshlets.swap(a_mesh.m_meshlets);
+  a_mesh.Clear();
+
+  return mesh;
+}
+
+// -----------------------------------------------------------------------
+
+void
+SharedMesh::
+  SetBuffer(u32 a_buffer, release_function a_release, void* a_userData)
+{
+  TLOC_ASSERT(m_buffer == 0, "The mesh already has a buffer");
+
+  m_buffer = a_buffer;
+  m_release = a_release;
+  m_userData = a_userData;
+}
+
+// ///////////////////////////////////////////////////////////////////////
+// MeshCache
+
+shared_mesh_sptr
+MeshCache::
+  Find(const char* a_name) const
+{
+  for (tl_size i = 0; i < m_names.size(); ++i)
+  {
+    if (strcmp(m_names[i].c_str(), a_name) == 0)
+    { return m_meshes[i]; }
+  }
+
+  return shared_mesh_sptr();
+}
+
+// -----------------------------------------------------------------------
+
+shared_mesh_sptr
+MeshCache::
+  Add(const char* a_name, IndexedMesh& a_mesh)
+{
+  const shared_mesh_sptr mesh = SharedMesh::Create(a_mesh);
+
+  for (tl_size i = 0; i < m_names.size(); ++i)
+  {
+    if (strcmp(m_names[i].c_str(), a_name) == 0)
+    {
+      m_meshes[i] = mesh;
+      return mesh;
+    }
+  }
+
+  m_names.push_back(tl_core_str::String(a_name));
+  m_meshes.push_back(mesh);
+  return mesh;
+}
+
+// -----------------------------------------------------------------------
+
+shared_mesh_sptr
+MeshCache::
+  Load(const char* a_objFile, tl_int a_numThreads)
+{
+  const shared_mesh_sptr cached = Find(a_objFile);
+  if (cached.get())
+  { return cached; }
+
+  MappedFile file;
+  if (file.Open(a_objFile) == false)
+  { return shared_mesh_sptr(); }
+
+  ObjMesh   objMesh;
+  ObjParser parser;
+  if (parser.ParseParallel(file.GetData(), file.GetSize(), objMesh,
+                           a_numThreads) == false)
+  { return shared_mesh_sptr(); }
+
+  file.Close();
+
+  IndexedMesh mesh;
+  WeldMesh(objMesh, mesh);
+
+  return Add(a_objFile, mesh);
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+MeshCache::
+  Purge()
+{
+  tl_size numKept = 0;
+  for (tl_size i = 0; i < m_meshes.size(); ++i)
+  {
+    if (m_meshes[i].use_count() == 1)
+    { continue; }
+
+    if (numKept != i)
+    {
+      m_names[numKept] = m_names[i];
+      m_meshes[numKept] = m_meshes[i];
+    }
+    ++numKept;
+  }
+
+  const tl_size numDropped = m_meshes.size() - numKept;
+  m_names.resize(numKept);
+  m_meshes.resize(numKept);
+
+  return numDropped;
+}
+
+// -----------------------------------------------------------------------
+
+void
+MeshCache::
+  Clear()
+{
+  m_names.clear();
+  m_meshes.clear();
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+MeshCache::
+  GetNumMeshes() const
+{ return m_meshes.size(); }
@@ -0,0 +1,86 @@
+#ifndef _TLOC_MESH_TOOLS_SHARED_MESH_H_
+#define _TLOC_MESH_TOOLS_SHARED_MESH_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include "indexedMesh.h"
+
+class SharedMesh;
+
+typedef tloc::core_sptr::SharedPtr<SharedMesh>  shared_mesh_sptr;
+
+// ///////////////////////////////////////////////////////////////////////
+// Mesh data shared by every instance that draws it. The vertices, indices,
+// groups, LODs and meshlets are set once by Create() and never change
+// after that, so any number of instances (on any thread) read the same
+// copy. An instance only holds a shared_mesh_sptr, the mesh is destroyed
+// with the last one. Like every other SharedPtr the references are copied
+// and dropped on the thread that owns them, only the mesh data is shared
+// across threads.
+//
+// The renderer creates the GPU buffer once, for the first instance, and
+// stores it with SetBuffer(). a_release (if given) is called with it when
+// the mesh is destroyed.
+
+class SharedMesh
+{
+public:
+  typedef void (*release_function)(u32 a_buffer, void* a_userData);
+
+public:
+  // takes the data of a_mesh, which is left empty
+  static shared_mesh_sptr Create(IndexedMesh& a_mesh);
+
+  // an empty mesh, see Create()
+  SharedMesh();
+  ~SharedMesh();
+
+  void    SetBuffer(u32 a_buffer, release_function a_release = nullptr,
+                    void* a_userData = nullptr);
+
+  TLOC_DECL_AND_DEF_GETTER(const IndexedMesh&, GetMesh, m_mesh);
+  TLOC_DECL_AND_DEF_GETTER(u32, GetBuffer, m_buffer);
+
+private:
+  SharedMesh(const SharedMesh&);
+  SharedMesh& operator=(const SharedMesh&);
+
+private:
+  IndexedMesh       m_mesh;
+
+  u32               m_buffer;     // 0 until SetBuffer()
+  release_function  m_release;
+  void*             m_userData;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Hands out one SharedMesh per name (usually the file it was loaded from),
+// so every request for the same mesh shares its data and GPU buffer. The
+// cache holds a reference to each mesh, Purge() drops the meshes nothing
+// else references anymore.
+
+class MeshCache
+{
+public:
+  // the mesh with this name, null if there is none
+  shared_mesh_sptr  Find(const char* a_name) const;
+
+  // takes the data of a_mesh (see SharedMesh::Create()), an existing mesh
+  // with this name is replaced
+  shared_mesh_sptr  Add(const char* a_name, IndexedMesh& a_mesh);
+
+  // the mesh of the OBJ file, parsed and welded (see WeldMesh()) the first
+  // time, null if it could not be loaded
+  shared_mesh_sptr  Load(const char* a_objFile, tl_int a_numThreads = 1);
+
+  tl_size           Purge();    // returns the number of meshes dropped
+  void              Clear();
+
+  tl_size           GetNumMeshes() const;
+
+private:
+  tl_core_conts::Array<tl_core_str::String>   m_names;
+  tl_core_conts::Array<shared_mesh_sptr>      m_meshes;
+};
+
+#endif
@@ -0,0 +1,282 @@
+#include <tlocCore/tloc_core.h>
+#include <tlocCore/tloc_core.inl.h>
+
+#include <tlocDistanceField/src/rawDistanceField.h>
+
+#include "testHarness.h"
+
+#include <tlocCore/containers/tlocArray.inl.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// Round trips of the .tldf files: fields are written to disk the way
+// tlocUtilsDFGenerator writes them and read back through
+// GetRawDistanceFieldHeader.
+
+namespace {
+
+  const char* g_tempFile = "tlocTests.tldf";
+
+  typedef core_conts::Array<u8>   byte_cont;
+  typedef core_conts::Array<f32>  distance_cont;
+
+  // a disc of radius a_width / 4 in the middle of every slice, slices move
+  // the disc along x so that they differ
+  distance_cont DoMakeField(tl_int a_width, tl_int a_height, tl_int a_depth)
+  {
+    distance_cont field;
+    for (tl_int z = 0; z < a_depth; ++z)
+    {
+      for (tl_int y = 0; y < a_height; ++y)
+      {
+        for (tl_int x = 0; x < a_width; ++x)
+        {
+          const f32 dx = (f32)(x - a_width / 2 - z);
+          const f32 dy = (f32)(y - a_height / 2);
+          field.push_back(sqrtf(dx * dx + dy * dy) - (f32)a_width * 0.25f);
+        }
+      }
+    }
+    return field;
+  }
+
+  // header padded to m_dataOffset, then the samples
+  bool  DoWriteFile(const RawDistanceFieldHeader& a_header,
+                    const void* a_samples, tl_size a_samplesSize)
+  {
+    FILE* file = fopen(g_tempFile, "wb");
+    if (file == nullptr)
+    { return false; }
+
+    byte_cont padded(a_header.m_dataOffset, 0);
+    memcpy(&padded[0], &a_header, sizeof(a_header));
+
+    const bool written =
+      fwrite(&padded[0], 1, padded.size(), file) == padded.size() &&
+      fwrite(a_samples, 1, a_samplesSize, file) == a_samplesSize;
+    fclose(file);
+
+    return written;
+  }
+
+  bool  DoReadFile(byte_cont& a_out)
+  {
+    FILE* file = fopen(g_tempFile, "rb");
+    if (file == nullptr)
+    { return false; }
+
+    a_out.clear();
+    u8 buffer[4096];
+    for (tl_size numRead = fread(buffer, 1, sizeof(buffer), file); numRead > 0;
+         numRead = fread(buffer, 1, sizeof(buffer), file))
+    { a_out.insert(a_out.end(), buffer, buffer + numRead); }
+
+    fclose(file);
+    remove(g_tempFile);
+
+    return a_out.empty() == false;
+  }
+
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+void
+TestEncoding()
+{
+  const f32 range = 8.0f;
+
+  // one step of the u16 encoding is 2 * range / 65535
+  const f32 maxError = range / 65535.0f;
+  for (f32 d = -range; d <= range; d += 0.037f)
+  {
+    const f32 decoded = DecodeDistanceU16(EncodeDistanceU16(d, range), range);
+    TLOC_TEST_CHECK(fabsf(decoded - d) <= maxError * 1.01f);
+  }
+
+  TLOC_TEST_CHECK(EncodeDistanceU16(-range, range) == 0);
+  TLOC_TEST_CHECK(EncodeDistanceU16(range, range) == 65535);
+  TLOC_TEST_CHECK(EncodeDistanceU16(-range * 3.0f, range) == 0);
+  TLOC_TEST_CHECK(EncodeDistanceU16(range * 3.0f, range) == 65535);
+  TLOC_TEST_CHECK(EncodeDistanceU16(0.0f, range) == 32768);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestRoundTripU16()
+{
+  const tl_int width = 37, height = 23, depth = 1;
+  const f32    range = 6.0f;
+
+  const distance_cont field = DoMakeField(width, height, depth);
+
+  core_conts::Array<u16> samples;
+  for (tl_size i = 0; i < field.size(); ++i)
+  { samples.push_back(EncodeDistanceU16(field[i], range)); }
+
+  const auto header = MakeRawDistanceFieldHeader
+    (RawDistanceFieldHeader::k_formatU16, width, height, range);
+  TLOC_TEST_CHECK(header.m_dataOffset % 16 == 0);
+  TLOC_TEST_CHECK
+    (DoWriteFile(header, &samples[0], samples.size() * sizeof(u16)));
+
+  byte_cont file;
+  TLOC_TEST_CHECK(DoReadFile(file));
+
+  const RawDistanceFieldHeader* read =
+    GetRawDistanceFieldHeader(file.empty() ? nullptr : &file[0], file.size());
+  TLOC_TEST_CHECK(read != nullptr);
+  if (read == nullptr)
+  { return; }
+
+  TLOC_TEST_CHECK(read->m_version == RawDistanceFieldHeader::k_version);
+  TLOC_TEST_CHECK(read->m_format == RawDistanceFieldHeader::k_formatU16);
+  TLOC_TEST_CHECK(read->m_width == (u32)width);
+  TLOC_TEST_CHECK(read->m_height == (u32)height);
+  TLOC_TEST_CHECK(read->m_range == range);
+  TLOC_TEST_CHECK(GetRawDistanceFieldDepth(read) == (u32)depth);
+
+  const u16* readSamples =
+    static_cast<const u16*>(GetRawDistanceFieldSamples(read));
+
+  // distances outside the range are clamped
+  const f32 maxError = range / 65535.0f * 1.01f;
+  tl_size numWrong = 0;
+  for (tl_size i = 0; i < field.size(); ++i)
+  {
+    const f32 expected = core::Clamp(field[i], -range, range);
+    const f32 decoded = DecodeDistanceU16(readSamples[i], read->m_range);
+    if (readSamples[i] != samples[i] || fabsf(decoded - expected) > maxError)
+    { ++numWrong; }
+  }
+  TLOC_TEST_CHECK(numWrong == 0);
+
+  // truncated by one sample
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&file[0], file.size() - 1) == nullptr);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestRoundTripF32()
+{
+  const tl_int width = 16, height = 12, depth = 5;
+  const f32    range = 4.0f;
+
+  const distance_cont field = DoMakeField(width, height, depth);
+
+  const auto header = MakeRawDistanceFieldHeader
+    (RawDistanceFieldHeader::k_formatF32, width, height, range, depth);
+  TLOC_TEST_CHECK(DoWriteFile(header, &field[0], field.size() * sizeof(f32)));
+
+  byte_cont file;
+  TLOC_TEST_CHECK(DoReadFile(file));
+
+  const RawDistanceFieldHeader* read =
+    GetRawDistanceFieldHeader(file.empty() ? nullptr : &file[0], file.size());
+  TLOC_TEST_CHECK(read != nullptr);
+  if (read == nullptr)
+  { return; }
+
+  TLOC_TEST_CHECK(read->m_format == RawDistanceFieldHeader::k_formatF32);
+  TLOC_TEST_CHECK(GetRawDistanceFieldDepth(read) == (u32)depth);
+  TLOC_TEST_CHECK(file.size() == read->m_dataOffset +
+                            field.size() * sizeof(f32));
+
+  // f32 samples are stored as is
+  TLOC_TEST_CHECK(memcmp(GetRawDistanceFieldSamples(read), &field[0],
+                                   field.size() * sizeof(f32)) == 0);
+
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&file[0], file.size() - 1) == nullptr);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestVersion1()
+{
+  const tl_int width = 20, height = 10;
+  const f32    range = 3.0f;
+
+  const distance_cont field = DoMakeField(width, height, 1);
+
+  // version 1 had a reserved field, written as 0, where m_depth is now
+  auto header = MakeRawDistanceFieldHeader
+    (RawDistanceFieldHeader::k_formatF32, width, height, range);
+  header.m_version = RawDistanceFieldHeader::k_versionNoDepth;
+  header.m_depth = 0;
+  TLOC_TEST_CHECK(DoWriteFile(header, &field[0], field.size() * sizeof(f32)));
+
+  byte_cont file;
+  TLOC_TEST_CHECK(DoReadFile(file));
+
+  const RawDistanceFieldHeader* read =
+    GetRawDistanceFieldHeader(file.empty() ? nullptr : &file[0], file.size());
+  TLOC_TEST_CHECK(read != nullptr);
+  if (read == nullptr)
+  { return; }
+
+  TLOC_TEST_CHECK(GetRawDistanceFieldDepth(read) == 1);
+  TLOC_TEST_CHECK(memcmp(GetRawDistanceFieldSamples(read), &field[0],
+                                   field.size() * sizeof(f32)) == 0);
+
+  // a version 2 file must not have a depth of 0
+  byte_cont badDepth = file;
+  reinterpret_cast<RawDistanceFieldHeader*>(&badDepth[0])->m_version =
+    RawDistanceFieldHeader::k_version;
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&badDepth[0], badDepth.size()) == nullptr);
+
+  byte_cont badVersion = file;
+  reinterpret_cast<RawDistanceFieldHeader*>(&badVersion[0])->m_version = 3;
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&badVersion[0], badVersion.size()) == nullptr);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestInvalid()
+{
+  const auto header = MakeRawDistanceFieldHeader
+    (RawDistanceFieldHeader::k_formatU16, 4, 4, 1.0f);
+
+  byte_cont file(header.m_dataOffset + 4 * 4 * sizeof(u16), 0);
+  memcpy(&file[0], &header, sizeof(header));
+  TLOC_TEST_CHECK(GetRawDistanceFieldHeader(&file[0], file.size()) != nullptr);
+
+  TLOC_TEST_CHECK(GetRawDistanceFieldHeader(nullptr, file.size()) == nullptr);
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&file[0], sizeof(RawDistanceFieldHeader) - 1) == nullptr);
+
+  byte_cont badMagic = file;
+  badMagic[3] = 'X';
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&badMagic[0], badMagic.size()) == nullptr);
+
+  byte_cont badFormat = file;
+  reinterpret_cast<RawDistanceFieldHeader*>(&badFormat[0])->m_format = 7;
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&badFormat[0], badFormat.size()) == nullptr);
+
+  // the samples would overlap the header
+  byte_cont badOffset = file;
+  reinterpret_cast<RawDistanceFieldHeader*>(&badOffset[0])->m_dataOffset = 8;
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&badOffset[0], badOffset.size()) == nullptr);
+
+  // the samples would be misaligned, even though the file is long enough
+  byte_cont misaligned = file;
+  misaligned.push_back(0);
+  reinterpret_cast<RawDistanceFieldHeader*>(&misaligned[0])->m_dataOffset += 1;
+  TLOC_TEST_CHECK
+    (GetRawDistanceFieldHeader(&misaligned[0], misaligned.size()) == nullptr);
+}
@@ -0,0 +1,352 @@
+#include <tlocCore/tloc_core.h>
+#include <tlocCore/tloc_core.inl.h>
+
+#include <tlocImageTools/src/dirtyRegions.h>
+#include <tlocImageTools/src/textureStager.h>
+
+#include "testHarness.h"
+
+#include <tlocCore/containers/tlocArray.inl.h>
+
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// Checks of the tlocImageTools bookkeeping that runs without a GPU.
+
+namespace {
+
+  typedef DirtyRegionTracker::rect_cont   rect_cont;
+
+  bool  DoContains(const DirtyRect& a_rect, tl_int a_x, tl_int a_y)
+  {
+    return a_x >= a_rect.m_x0 && a_x < a_rect.m_x1 &&
+           a_y >= a_rect.m_y0 && a_y < a_rect.m_y1;
+  }
+
+  bool  DoEquals(const DirtyRect& a_rect, tl_int a_x0, tl_int a_y0,
+                 tl_int a_x1, tl_int a_y1)
+  {
+    return a_rect.m_x0 == a_x0 && a_rect.m_y0 == a_y0 &&
+           a_rect.m_x1 == a_x1 && a_rect.m_y1 == a_y1;
+  }
+
+  // the rectangles are inside the image, do not overlap, and cover every
+  // pixel of a_marked (one bool per pixel)
+  bool  DoIsConsistent(const DirtyRegionTracker& a_tracker,
+                       const core_conts::Array<bool>& a_marked)
+  {
+    const rect_cont& rects = a_tracker.GetRects();
+    if (rects.size() > a_tracker.GetMaxRects())
+    { return false; }
+
+    const tl_int width = a_tracker.GetWidth();
+    const tl_int height = a_tracker.GetHeight();
+
+    core_conts::Array<u8> count((tl_size)width * height, 0);
+    for (tl_size i = 0; i < rects.size(); ++i)
+    {
+      const DirtyRect& r = rects[i];
+      if (r.m_x0 < 0 || r.m_y0 < 0 || r.m_x1 > width || r.m_y1 > height ||
+          r.m_x0 >= r.m_x1 || r.m_y0 >= r.m_y1)
+      { return false; }
+
+      for (tl_int y = r.m_y0; y < r.m_y1; ++y)
+      {
+        for (tl_int x = r.m_x0; x < r.m_x1; ++x)
+        {
+          if (++count[(tl_size)y * width + x] > 1)
+          { return false; }
+        }
+      }
+    }
+
+    for (tl_size i = 0; i < a_marked.size(); ++i)
+    {
+      if (a_marked[i] && count[i] == 0)
+      { return false; }
+    }
+
+    return true;
+  }
+
+  // a small LCG, the same sequence on every platform
+  tl_int  DoRandom(u32& a_state, tl_int a_max)
+  {
+    a_state = a_state * 1664525u + 1013904223u;
+    return (tl_int)((a_state >> 8) % (u32)a_max);
+  }
+
+  // -----------------------------------------------------------------------
+  // Stages into the buffers without uploading, keeps the last buffer used
+
+  class CopyingStager
+    : public TextureStager
+  {
+  public:
+    CopyingStager()
+      : m_lastBuffer(-1)
+    { }
+
+    tl_int m_lastBuffer;
+
+  protected:
+    void  DoUpload(tl_int a_bufferIndex, const StagingBuffer& )
+    { m_lastBuffer = a_bufferIndex; }
+  };
+
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+void
+TestMerging()
+{
+  DirtyRegionTracker tracker;
+  tracker.Reset(64, 64);
+
+  // sharing an edge
+  tracker.MarkDirty(0, 0, 4, 4);
+  tracker.MarkDirty(4, 0, 4, 4);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(DoEquals(tracker.GetRects()[0], 0, 0, 8, 4));
+
+  // overlapping
+  tracker.MarkDirty(6, 2, 4, 4);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(DoEquals(tracker.GetRects()[0], 0, 0, 10, 6));
+
+  // inside, nothing changes
+  tracker.MarkDirty(1, 1, 2, 2);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(tracker.GetDirtyArea() == 60);
+
+  // sharing only a corner
+  tracker.MarkDirty(10, 6, 4, 4);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 2);
+  TLOC_TEST_CHECK(tracker.GetDirtyArea() == 76);
+
+  // apart
+  tracker.MarkDirty(40, 40, 1, 1);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 3);
+
+  // bridging the last two grows one rectangle that takes both in
+  tracker.MarkDirty(10, 10, 31, 30);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 2);
+  TLOC_TEST_CHECK(tracker.GetDirtyArea() == 60 + 31 * 35);
+
+  // row by row, pixel by pixel: one rectangle
+  tracker.Clear();
+  TLOC_TEST_CHECK(tracker.IsDirty() == false);
+  for (tl_int y = 20; y < 28; ++y)
+  {
+    for (tl_int x = 8; x < 24; ++x)
+    { tracker.MarkPixel(x, y); }
+  }
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(DoEquals(tracker.GetRects()[0], 8, 20, 24, 28));
+
+  tracker.MarkAll();
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(tracker.GetDirtyArea() == 64 * 64);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestClipping()
+{
+  DirtyRegionTracker tracker;
+  tracker.Reset(32, 16);
+
+  tracker.MarkDirty(-5, -5, 10, 10);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 1);
+  TLOC_TEST_CHECK(DoEquals(tracker.GetRects()[0], 0, 0, 5, 5));
+
+  tracker.MarkDirty(30, 14, 10, 10);
+  TLOC_TEST_CHECK(tracker.GetRects().size() == 2);
+  TLOC_TEST_CHECK(DoEquals(tracker.GetRects()[1], 30, 14, 32, 16));
+
+  // outside or empty, nothing is marked
+  tracker.Clear();
+  tracker.MarkDirty(32, 0, 4, 4);
+  tracker.MarkDirty(0, -4, 4, 4);
+  tracker.MarkDirty(4, 4, 0, 4);
+  tracker.MarkDirty(4, 4, -3, 4);
+  tracker.MarkPixel(-1, 0);
+  tracker.MarkPixel(0, 16);
+  TLOC_TEST_CHECK(tracker.IsDirty() == false);
+
+  // the image clips what it is written to the same way
+  TrackedImage image;
+  image.Create(32, 16, nullptr);
+  image.ClearDirty();
+
+  const u8 red[4] = { 255, 0, 0, 255 };
+  image.Fill(28, -2, 8, 4, red);
+  TLOC_TEST_CHECK(image.GetDirtyRegions().GetRects().size() == 1);
+  TLOC_TEST_CHECK(DoEquals(image.GetDirtyRegions().GetRects()[0],
+                                  28, 0, 32, 2));
+  TLOC_TEST_CHECK(memcmp(image.GetPixel(31, 1), red, 4) == 0);
+  TLOC_TEST_CHECK(image.GetPixel(27, 1)[0] == 0);
+  TLOC_TEST_CHECK(image.GetPixel(31, 2)[0] == 0);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestMaxRects()
+{
+  const tl_int size = 128;
+
+  for (tl_size maxRects = 1; maxRects <= 16; maxRects *= 2)
+  {
+    DirtyRegionTracker tracker(maxRects);
+    tracker.Reset(size, size);
+
+    core_conts::Array<bool> marked((tl_size)size * size, false);
+
+    u32 state = 1234;
+    for (tl_int i = 0; i < 200; ++i)
+    {
+      const tl_int x = DoRandom(state, size + 16) - 8;
+      const tl_int y = DoRandom(state, size + 16) - 8;
+      const tl_int w = DoRandom(state, 24) + 1;
+      const tl_int h = DoRandom(state, 24) + 1;
+
+      tracker.MarkDirty(x, y, w, h);
+
+      for (tl_int py = core::tlMax(y, 0); py < core::tlMin(y + h, size); ++py)
+      {
+        for (tl_int px = core::tlMax(x, 0); px < core::tlMin(x + w, size); ++px)
+        { marked[(tl_size)py * size + px] = true; }
+      }
+
+      TLOC_TEST_CHECK(tracker.GetRects().size() <= maxRects);
+    }
+
+    TLOC_TEST_CHECK(DoIsConsistent(tracker, marked));
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestStrokes()
+{
+  const tl_int size = 1024;
+
+  // a diagonal stroke touches its pixels by the corners only, with room
+  // for a rectangle per pixel only those pixels are dirty
+  {
+    DirtyRegionTracker tracker(size);
+    tracker.Reset(size, size);
+
+    for (tl_int i = 0; i < size; ++i)
+    { tracker.MarkPixel(i, i); }
+
+    TLOC_TEST_CHECK(tracker.GetRects().size() == (tl_size)size);
+    TLOC_TEST_CHECK(tracker.GetDirtyArea() == (tl_size)size);
+  }
+
+  // with the default 8 rectangles the stroke is split in several boxes
+  // instead of its bounding box
+  {
+    DirtyRegionTracker tracker;
+    tracker.Reset(size, size);
+
+    core_conts::Array<bool> marked((tl_size)size * size, false);
+    for (tl_int i = 0; i < size; ++i)
+    {
+      tracker.MarkPixel(i, i);
+      marked[(tl_size)i * size + i] = true;
+    }
+
+    TLOC_TEST_CHECK(tracker.GetRects().size() == 8);
+    TLOC_TEST_CHECK(tracker.GetDirtyArea() < (tl_size)size * size / 4);
+    TLOC_TEST_CHECK(DoIsConsistent(tracker, marked));
+  }
+
+  // a sparse stroke, a pixel every few rows and columns
+  {
+    DirtyRegionTracker tracker(64);
+    tracker.Reset(size, size);
+
+    core_conts::Array<bool> marked((tl_size)size * size, false);
+    tl_size numPixels = 0;
+    for (tl_int x = 0; x < size; x += 16)
+    {
+      const tl_int y = 100 + x / 3;
+      tracker.MarkPixel(x, y);
+      marked[(tl_size)y * size + x] = true;
+      ++numPixels;
+    }
+
+    TLOC_TEST_CHECK(tracker.GetRects().size() == numPixels);
+    TLOC_TEST_CHECK(tracker.GetDirtyArea() == numPixels);
+    TLOC_TEST_CHECK(DoIsConsistent(tracker, marked));
+  }
+
+  // a line drawn in runs of pixels (a shallow slope), each run is one
+  // rectangle and the runs only touch by their corners
+  {
+    DirtyRegionTracker tracker(size);
+    tracker.Reset(size, size);
+
+    for (tl_int x = 0; x < 256; ++x)
+    { tracker.MarkPixel(x, x / 4); }
+
+    TLOC_TEST_CHECK(tracker.GetRects().size() == 64);
+    TLOC_TEST_CHECK(tracker.GetDirtyArea() == 256);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestStaging()
+{
+  const tl_int size = 64;
+
+  TrackedImage image;
+  image.Create(size, size, nullptr);
+
+  CopyingStager stager;
+
+  // the new image is staged whole
+  TLOC_TEST_CHECK(stager.Update(image) == (tl_size)size * size * 4);
+  TLOC_TEST_CHECK(image.GetDirtyRegions().IsDirty() == false);
+  TLOC_TEST_CHECK(stager.Update(image) == 0);
+  TLOC_TEST_CHECK(stager.GetNumUpdates() == 1);
+
+  u8 block[8 * 4 * 4];
+  for (tl_size i = 0; i < sizeof(block); ++i)
+  { block[i] = (u8)(i * 3 + 1); }
+
+  const u8 white[4] = { 255, 255, 255, 255 };
+  image.SetPixels(10, 20, 8, 4, block, 8);
+  image.SetPixel(50, 50, white);
+
+  const tl_int previousBuffer = stager.m_lastBuffer;
+  TLOC_TEST_CHECK(stager.Update(image) == (8 * 4 + 1) * 4);
+  TLOC_TEST_CHECK(stager.m_lastBuffer != previousBuffer);
+
+  // every region holds the pixels of its rectangle, rows packed
+  const StagingBuffer& buffer = stager.GetBuffer(stager.m_lastBuffer);
+  TLOC_TEST_CHECK(buffer.m_regions.size() == 2);
+
+  for (tl_size i = 0; i < buffer.m_regions.size(); ++i)
+  {
+    const DirtyRect& r = buffer.m_regions[i].m_rect;
+    const u8* staged = &buffer.m_data[buffer.m_regions[i].m_offset];
+
+    for (tl_int y = r.m_y0; y < r.m_y1; ++y)
+    {
+      for (tl_int x = r.m_x0; x < r.m_x1; ++x, staged += 4)
+      { TLOC_TEST_CHECK(memcmp(staged, image.GetPixel(x, y), 4) == 0); }
+    }
+
+    TLOC_TEST_CHECK(DoContains(r, 10, 20) || DoContains(r, 50, 50));
+  }
+}
@@ -0,0 +1,73 @@
+#include <tlocCore/tloc_core.h>
+
+#include "testHarness.h"
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// Runs the tests of every library, the exit code is the number of failed
+// tests.
+
+tl_int g_numChecksFailed = 0;
+
+// distanceFieldTests.cpp
+void  TestEncoding();
+void  TestRoundTripU16();
+void  TestRoundTripF32();
+void  TestVersion1();
+void  TestInvalid();
+
+// imageToolsTests.cpp
+void  TestMerging();
+void  TestClipping();
+void  TestMaxRects();
+void  TestStrokes();
+void  TestStaging();
+
+// meshToolsTests.cpp
+void  TestMeshletBuild();
+void  TestMeshletCulling();
+void  TestQuantization();
+void  TestSharedMesh();
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+int TLOC_MAIN(int , char *[])
+{
+  typedef void (*test_func)();
+
+  const struct { const char* m_name; test_func m_test; } tests[] =
+  {
+    { "DistanceField.Encoding", &TestEncoding },
+    { "DistanceField.RoundTripU16", &TestRoundTripU16 },
+    { "DistanceField.RoundTripF32", &TestRoundTripF32 },
+    { "DistanceField.Version1", &TestVersion1 },
+    { "DistanceField.Invalid", &TestInvalid },
+
+    { "ImageTools.Merging", &TestMerging },
+    { "ImageTools.Clipping", &TestClipping },
+    { "ImageTools.MaxRects", &TestMaxRects },
+    { "ImageTools.Strokes", &TestStrokes },
+    { "ImageTools.Staging", &TestStaging },
+
+    { "MeshTools.MeshletBuild", &TestMeshletBuild },
+    { "MeshTools.MeshletCulling", &TestMeshletCulling },
+    { "MeshTools.Quantization", &TestQuantization },
+    { "MeshTools.SharedMesh", &TestSharedMesh },
+  };
+  const tl_size numTests = sizeof(tests) / sizeof(tests[0]);
+
+  tl_int numFailed = 0;
+  for (tl_size i = 0; i < numTests; ++i)
+  {
+    const tl_int checksFailed = g_numChecksFailed;
+    printf("\n%s", tests[i].m_name);
+    tests[i].m_test();
+
+    if (g_numChecksFailed != checksFailed)
+    { ++numFailed; }
+  }
+
+  printf("\n\n%d of %d tests failed\n", numFailed, (tl_int)numTests);
+  return numFailed;
+}
@@ -0,0 +1,532 @@
+#include <tlocCore/tloc_core.h>
+#include <tlocCore/tloc_core.inl.h>
+
+#include <tlocMeshTools/src/indexedMesh.h>
+#include <tlocMeshTools/src/meshlets.h>
+#include <tlocMeshTools/src/quantizedMesh.h>
+#include <tlocMeshTools/src/sharedMesh.h>
+
+#include "testHarness.h"
+
+#include <tlocCore/containers/tlocArray.inl.h>
+#include <tlocCore/smart_ptr/tloc_smart_ptr.inl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace tloc;
+
+// ///////////////////////////////////////////////////////////////////////
+// Checks of tlocMeshTools on generated meshes.
+
+namespace {
+
+  typedef core_conts::Array<TriangleRange>  range_cont;
+
+  const f32 g_pi = 3.14159265f;
+
+  // deterministic, the checks must not depend on the run
+  u32   DoNextRandom(u32& a_state)
+  {
+    a_state = a_state * 1664525u + 1013904223u;
+    return a_state >> 8;
+  }
+
+  f32   DoRandom(u32& a_state, f32 a_min, f32 a_max)
+  { return a_min + (a_max - a_min) * (f32)(DoNextRandom(a_state) % 65536) / 65535.0f; }
+
+  void  DoAddVertex(IndexedMesh& a_mesh, f32 a_x, f32 a_y, f32 a_z)
+  {
+    MeshVertex vertex = { { a_x, a_y, a_z }, { 0, 0, 0 }, { 0, 0 } };
+    a_mesh.m_vertices.push_back(vertex);
+  }
+
+  // two triangles per cell of a (a_numX + 1) x (a_numY + 1) vertex grid
+  // starting at a_firstVertex
+  void  DoAddGridTriangles(IndexedMesh& a_mesh, tl_size a_firstVertex,
+                           tl_size a_numX, tl_size a_numY)
+  {
+    for (tl_size y = 0; y < a_numY; ++y)
+    {
+      for (tl_size x = 0; x < a_numX; ++x)
+      {
+        const u16 v0 = (u16)(a_firstVertex + x + y * (a_numX + 1));
+        const u16 v1 = (u16)(v0 + 1);
+        const u16 v2 = (u16)(v0 + a_numX + 1);
+        const u16 v3 = (u16)(v2 + 1);
+
+        const u16 triangles[6] = { v0, v2, v1, v1, v2, v3 };
+        a_mesh.m_shortIndices.insert(a_mesh.m_shortIndices.end(),
+                                     triangles, triangles + 6);
+      }
+    }
+  }
+
+  // a bumpy sphere (so that the meshlet cones differ) above a wavy ground
+  // plane, one group each
+  void  DoMakeScene(IndexedMesh& a_mesh)
+  {
+    a_mesh.Clear();
+
+    const tl_size numRings = 48, numSegments = 64;
+    for (tl_size ring = 0; ring <= numRings; ++ring)
+    {
+      const f32 theta = g_pi * (f32)ring / numRings;
+      for (tl_size segment = 0; segment <= numSegments; ++segment)
+      {
+        const f32 phi = 2.0f * g_pi * (f32)segment / numSegments;
+        const f32 r = 1.0f + 0.15f * sinf(5.0f * theta) * sinf(4.0f * phi);
+        DoAddVertex(a_mesh, r * sinf(theta) * cosf(phi), 2.0f + r * cosf(theta),
+                    r * sinf(theta) * sinf(phi));
+      }
+    }
+
+    ObjGroup sphere;
+    sphere.m_name = "sphere";
+    sphere.m_firstTriangle = 0;
+    DoAddGridTriangles(a_mesh, 0, numSegments, numRings);
+    sphere.m_numTriangles = a_mesh.m_shortIndices.size() / 3;
+    a_mesh.m_groups.push_back(sphere);
+
+    const tl_size groundFirst = a_mesh.m_vertices.size();
+    const tl_size groundSize = 40;
+    for (tl_size y = 0; y <= groundSize; ++y)
+    {
+      for (tl_size x = 0; x <= groundSize; ++x)
+      {
+        const f32 px = -4.0f + 8.0f * (f32)x / groundSize;
+        const f32 pz = -4.0f + 8.0f * (f32)y / groundSize;
+        DoAddVertex(a_mesh, px, 0.3f * sinf(px * 2.0f) * cosf(pz * 1.5f), pz);
+      }
+    }
+
+    ObjGroup ground;
+    ground.m_name = "ground";
+    ground.m_firstTriangle = sphere.m_numTriangles;
+    DoAddGridTriangles(a_mesh, groundFirst, groundSize, groundSize);
+    ground.m_numTriangles =
+      a_mesh.m_shortIndices.size() / 3 - ground.m_firstTriangle;
+    a_mesh.m_groups.push_back(ground);
+  }
+
+  // column major view projection, 60 degree vertical field of view, square
+  // viewport (same as the one of tlocUtilsMeshCooker)
+  void  DoGetViewProjection(const f32* a_eye, const f32* a_target,
+                            f32 a_near, f32 a_far, f32* a_out)
+  {
+    f32 forward[3] = { a_target[0] - a_eye[0], a_target[1] - a_eye[1],
+                       a_target[2] - a_eye[2] };
+    f32 length = sqrtf(forward[0] * forward[0] + forward[1] * forward[1] +
+                       forward[2] * forward[2]);
+    for (tl_int i = 0; i < 3; ++i)
+    { forward[i] /= length; }
+
+    const bool vertical = fabsf(forward[1]) > 0.99f;
+    const f32 up[3] = { 0.0f, vertical ? 0.0f : 1.0f, vertical ? 1.0f : 0.0f };
+
+    f32 side[3] = { forward[1] * up[2] - forward[2] * up[1],
+                    forward[2] * up[0] - forward[0] * up[2],
+                    forward[0] * up[1] - forward[1] * up[0] };
+    length = sqrtf(side[0] * side[0] + side[1] * side[1] + side[2] * side[2]);
+    for (tl_int i = 0; i < 3; ++i)
+    { side[i] /= length; }
+
+    const f32 realUp[3] = { side[1] * forward[2] - side[2] * forward[1],
+                            side[2] * forward[0] - side[0] * forward[2],
+                            side[0] * forward[1] - side[1] * forward[0] };
+
+    f32 view[16] = { 0 };
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      view[i * 4 + 0] = side[i];
+      view[i * 4 + 1] = realUp[i];
+      view[i * 4 + 2] = -forward[i];
+      view[12] -= side[i] * a_eye[i];
+      view[13] -= realUp[i] * a_eye[i];
+      view[14] += forward[i] * a_eye[i];
+    }
+    view[15] = 1.0f;
+
+    const f32 focal = 1.0f / tanf(0.5236f);
+    f32 projection[16] = { 0 };
+    projection[0] = focal;
+    projection[5] = focal;
+    projection[10] = (a_far + a_near) / (a_near - a_far);
+    projection[11] = -1.0f;
+    projection[14] = 2.0f * a_far * a_near / (a_near - a_far);
+
+    for (tl_int column = 0; column < 4; ++column)
+    {
+      for (tl_int row = 0; row < 4; ++row)
+      {
+        f32 sum = 0.0f;
+        for (tl_int k = 0; k < 4; ++k)
+        { sum += projection[k * 4 + row] * view[column * 4 + k]; }
+        a_out[column * 4 + row] = sum;
+      }
+    }
+  }
+
+  // cameras all around and inside the scene, looking at points near its
+  // middle
+  void  DoMakeView(u32& a_random, MeshletView& a_view)
+  {
+    const f32 distances[] = { 0.5f, 1.4f, 2.5f, 6.0f, 12.0f };
+    const f32 distance = distances[DoNextRandom(a_random) % 5];
+
+    f32 direction[3];
+    f32 lengthSq = 0.0f;
+    do
+    {
+      lengthSq = 0.0f;
+      for (tl_int i = 0; i < 3; ++i)
+      {
+        direction[i] = DoRandom(a_random, -1.0f, 1.0f);
+        lengthSq += direction[i] * direction[i];
+      }
+    } while (lengthSq < 0.01f || lengthSq > 1.0f);
+
+    const f32 center[3] = { 0.0f, 1.0f, 0.0f };
+    f32 target[3];
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      a_view.m_position[i] = center[i] + direction[i] / sqrtf(lengthSq) * distance;
+      target[i] = center[i] + DoRandom(a_random, -1.5f, 1.5f);
+    }
+
+    f32 viewProjection[16];
+    DoGetViewProjection(a_view.m_position, target, 0.01f, 50.0f, viewProjection);
+    GetFrustumPlanes(viewProjection, a_view.m_planes);
+  }
+
+  // visible triangles (brute force) that the culled meshlets dropped
+  tl_size DoCountCulledVisible(const IndexedMesh& a_mesh,
+                               const MeshletView& a_view, range_cont& a_ranges)
+  {
+    CullMeshlets(&a_mesh.m_meshlets[0], a_mesh.m_meshlets.size(), a_view,
+                 a_ranges);
+
+    const tl_size numVisible =
+      CountVisibleTriangles(a_mesh, a_view, 0, a_mesh.GetNumIndices() / 3);
+
+    tl_size numKept = 0;
+    for (tl_size i = 0; i < a_ranges.size(); ++i)
+    {
+      numKept += CountVisibleTriangles(a_mesh, a_view, a_ranges[i].m_firstTriangle,
+                                       a_ranges[i].m_numTriangles);
+    }
+
+    return numVisible - numKept;
+  }
+
+  struct Triangle
+  {
+    bool operator<(const Triangle& a_other) const
+    { return std::lexicographical_compare(m_corners, m_corners + 3,
+                                          a_other.m_corners, a_other.m_corners + 3); }
+    bool operator==(const Triangle& a_other) const
+    { return std::equal(m_corners, m_corners + 3, a_other.m_corners); }
+
+    tl_size m_corners[3];
+  };
+
+  // the triangles of a group, rotated to start at the smallest index (which
+  // keeps the winding) and sorted
+  core_conts::Array<Triangle> DoGetTriangles(const IndexedMesh& a_mesh,
+                                             const ObjGroup& a_group)
+  {
+    core_conts::Array<Triangle> triangles;
+    for (tl_size t = a_group.m_firstTriangle;
+         t < a_group.m_firstTriangle + a_group.m_numTriangles; ++t)
+    {
+      Triangle triangle;
+      for (tl_int corner = 0; corner < 3; ++corner)
+      { triangle.m_corners[corner] = a_mesh.GetIndex(t * 3 + corner); }
+
+      std::rotate(triangle.m_corners,
+        std::min_element(triangle.m_corners, triangle.m_corners + 3),
+        triangle.m_corners + 3);
+      triangles.push_back(triangle);
+    }
+
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  }
+
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+void
+TestMeshletBuild()
+{
+  IndexedMesh mesh;
+  DoMakeScene(mesh);
+
+  core_conts::Array<Triangle> before[2] =
+  { DoGetTriangles(mesh, mesh.m_groups[0]), DoGetTriangles(mesh, mesh.m_groups[1]) };
+
+  const tl_size maxTriangles = 64;
+  BuildMeshlets(mesh, maxTriangles);
+  TLOC_TEST_CHECK(mesh.m_meshlets.empty() == false);
+
+  // the triangles are only reordered within their group
+  for (tl_size g = 0; g < 2; ++g)
+  { TLOC_TEST_CHECK(DoGetTriangles(mesh, mesh.m_groups[g]) == before[g]); }
+
+  // the meshlets cover every triangle once, in order, without crossing a group
+  tl_size next = 0;
+  for (tl_size i = 0; i < mesh.m_meshlets.size(); ++i)
+  {
+    const Meshlet& meshlet = mesh.m_meshlets[i];
+    TLOC_TEST_CHECK(meshlet.m_firstTriangle == next);
+    TLOC_TEST_CHECK(meshlet.m_numTriangles > 0 &&
+                          meshlet.m_numTriangles <= maxTriangles);
+    next = meshlet.m_firstTriangle + meshlet.m_numTriangles;
+
+    const tl_size groupEnd = mesh.m_groups[0].m_numTriangles;
+    TLOC_TEST_CHECK(meshlet.m_firstTriangle >= groupEnd || next <= groupEnd);
+
+    // the bounding sphere holds every corner
+    bool inside = true;
+    for (tl_size t = meshlet.m_firstTriangle; t < next; ++t)
+    {
+      for (tl_int corner = 0; corner < 3; ++corner)
+      {
+        const f32* p = mesh.m_vertices[mesh.GetIndex(t * 3 + corner)].m_position;
+        const f32 d[3] = { p[0] - meshlet.m_center[0], p[1] - meshlet.m_center[1],
+                           p[2] - meshlet.m_center[2] };
+        inside &= sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) <=
+                  meshlet.m_radius * 1.0001f + 1e-5f;
+      }
+    }
+    TLOC_TEST_CHECK(inside);
+  }
+  TLOC_TEST_CHECK(next == mesh.GetNumIndices() / 3);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestMeshletCulling()
+{
+  IndexedMesh mesh;
+  DoMakeScene(mesh);
+  BuildMeshlets(mesh);
+
+  const tl_size numTriangles = mesh.GetNumIndices() / 3;
+
+  u32        random = 12345;
+  range_cont ranges;
+
+  tl_size numLost = 0;
+  tl_size numCulledViews = 0;
+  for (tl_int view = 0; view < 256; ++view)
+  {
+    MeshletView meshletView;
+    DoMakeView(random, meshletView);
+
+    numLost += DoCountCulledVisible(mesh, meshletView, ranges);
+
+    // the ranges are in order, apart and inside the mesh
+    tl_size keptTriangles = 0;
+    for (tl_size i = 0; i < ranges.size(); ++i)
+    {
+      TLOC_TEST_CHECK(i == 0 || ranges[i].m_firstTriangle >
+        ranges[i - 1].m_firstTriangle + ranges[i - 1].m_numTriangles);
+      TLOC_TEST_CHECK(ranges[i].m_firstTriangle + ranges[i].m_numTriangles <=
+                            numTriangles);
+      keptTriangles += ranges[i].m_numTriangles;
+    }
+
+    if (keptTriangles < numTriangles)
+    { ++numCulledViews; }
+  }
+
+  // conservative, and the views cull something (or the check is void)
+  TLOC_TEST_CHECK(numLost == 0);
+  TLOC_TEST_CHECK(numCulledViews > 128);
+
+  // with the cones turned around, front facing meshlets are culled: the
+  // check above has to notice
+  for (tl_size i = 0; i < mesh.m_meshlets.size(); ++i)
+  {
+    Meshlet& meshlet = mesh.m_meshlets[i];
+    if (meshlet.m_coneCutoff <= 1.0f)
+    {
+      for (tl_int axis = 0; axis < 3; ++axis)
+      { meshlet.m_coneAxis[axis] = -meshlet.m_coneAxis[axis]; }
+    }
+  }
+
+  numLost = 0;
+  random = 12345;
+  for (tl_int view = 0; view < 256; ++view)
+  {
+    MeshletView meshletView;
+    DoMakeView(random, meshletView);
+    numLost += DoCountCulledVisible(mesh, meshletView, ranges);
+  }
+  TLOC_TEST_CHECK(numLost > 0);
+}
+
+// -----------------------------------------------------------------------
+
+void
+TestQuantization()
+{
+  // random unit normals, odd count so that the SSE2 decode has a tail
+  const tl_size numVertices = 4099;
+
+  u32 random = 777;
+  core_conts::Array<MeshVertex> vertices(numVertices);
+  for (tl_size i = 0; i < numVertices; ++i)
+  {
+    MeshVertex& vertex = vertices[i];
+    f32 lengthSq = 0.0f;
+    do
+    {
+      lengthSq = 0.0f;
+      for (tl_int c = 0; c < 3; ++c)
+      {
+        vertex.m_normal[c] = DoRandom(random, -1.0f, 1.0f);
+        lengthSq += vertex.m_normal[c] * vertex.m_normal[c];
+      }
+    } while (lengthSq < 0.01f || lengthSq > 1.0f);
+
+    for (tl_int c = 0; c < 3; ++c)
+    {
+      vertex.m_normal[c] /= sqrtf(lengthSq);
+      vertex.m_position[c] = DoRandom(random, -10.0f, 10.0f);
+    }
+    vertex.m_texCoord[0] = DoRandom(random, 0.0f, 1.0f);
+    vertex.m_texCoord[1] = DoRandom(random, 0.0f, 1.0f);
+  }
+
+  // the axes and diagonals (folded edges of the octahedron) decode exactly
+  const f32 axes[6][3] = 
+  { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+  for (tl_int i = 0; i < 6; ++i)
+  {
+    for (tl_int c = 0; c < 3; ++c)
+    { vertices[i].m_normal[c] = axes[i][c]; }
+  }
+
+  const PositionQuantization quantization =
+    GetPositionQuantization(&vertices[0], numVertices);
+
+  core_conts::Array<MeshVertex> decoded(numVertices);
+
+  core_conts::Array<QuantizedVertex8> quantized8(numVertices);
+  QuantizeVertices(&vertices[0], numVertices, quantization, &quantized8[0]);
+  DequantizeVertices(&quantized8[0], numVertices, quantization, &decoded[0]);
+
+  const QuantizationError error8 =
+    GetQuantizationError(&vertices[0], &decoded[0], numVertices);
+  TLOC_TEST_CHECK(error8.m_position < 1.0f / 65535.0f);
+  TLOC_TEST_CHECK(error8.m_normalDegrees < 1.0f);
+  TLOC_TEST_CHECK(error8.m_texCoord < 1.0f / 2048.0f);
+
+  for (tl_int i = 0; i < 6; ++i)
+  {
+    for (tl_int c = 0; c < 3; ++c)
+    { TLOC_TEST_CHECK(decoded[i].m_normal[c] == axes[i][c]); }
+  }
+
+  core_conts::Array<QuantizedVertex16> quantized16(numVertices);
+  QuantizeVertices(&vertices[0], numVertices, quantization, &quantized16[0]);
+  DequantizeVertices(&quantized16[0], numVertices, quantization, &decoded[0]);
+
+  const QuantizationError error16 =
+    GetQuantizationError(&vertices[0], &decoded[0], numVertices);
+  TLOC_TEST_CHECK(error16.m_normalDegrees < 0.05f);
+
+  // decoded normals are unit length, missing ones decode as (0, 0, 1)
+  bool unitLength = true;
+  for (tl_size i = 0; i < numVertices; ++i)
+  {
+    const f32* n = decoded[i].m_normal;
+    unitLength &= fabsf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2] - 1.0f) < 1e-5f;
+  }
+  TLOC_TEST_CHECK(unitLength);
+
+  QuantizedVertex16 missing;
+  memset(&missing, 0, sizeof(missing));
+  DequantizeVertices(&missing, 1, quantization, &decoded[0]);
+  TLOC_TEST_CHECK(decoded[0].m_normal[0] == 0.0f &&
+                        decoded[0].m_normal[1] == 0.0f &&
+                        decoded[0].m_normal[2] == 1.0f);
+
+  // every half float survives the round trip (NaNs stay NaNs)
+  core_conts::Array<u16> halfs(65536);
+  for (tl_size i = 0; i < halfs.size(); ++i)
+  { halfs[i] = (u16)i; }
+
+  core_conts::Array<f32> floats(halfs.size());
+  core_conts::Array<u16> encoded(halfs.size());
+  DecodeHalfs(&halfs[0], halfs.size(), &floats[0]);
+  EncodeHalfs(&floats[0], floats.size(), &encoded[0]);
+
+  tl_size numWrong = 0;
+  for (tl_size i = 0; i < halfs.size(); ++i)
+  {
+    const bool isNaN = (halfs[i] & 0x7C00u) == 0x7C00u && (halfs[i] & 0x3FFu) != 0;
+    if (isNaN ? floats[i] == floats[i] : encoded[i] != halfs[i])
+    { ++numWrong; }
+  }
+  TLOC_TEST_CHECK(numWrong == 0);
+}
+
+// -----------------------------------------------------------------------
+
+namespace {
+
+  void  DoCountRelease(u32 a_buffer, void* a_userData)
+  {
+    TLOC_TEST_CHECK(a_buffer == 7);
+    ++*static_cast<tl_int*>(a_userData);
+  }
+
+};
+
+void
+TestSharedMesh()
+{
+  IndexedMesh mesh;
+  DoMakeScene(mesh);
+  const tl_size numIndices = mesh.GetNumIndices();
+
+  MeshCache cache;
+  shared_mesh_sptr scene = cache.Add("scene", mesh);
+  TLOC_TEST_CHECK(mesh.GetNumIndices() == 0);
+  TLOC_TEST_CHECK(scene->GetMesh().GetNumIndices() == numIndices);
+  TLOC_TEST_CHECK(cache.Find("scene") == scene);
+  TLOC_TEST_CHECK(cache.Find("other").get() == nullptr);
+
+  tl_int numReleased = 0;
+  scene->SetBuffer(7, &DoCountRelease, &numReleased);
+
+  // every instance shares the one mesh, the cache holds a reference too
+  {
+    core_conts::Array<shared_mesh_sptr> instances(100, scene);
+    TLOC_TEST_CHECK(scene.use_count() == 102);
+    TLOC_TEST_CHECK(instances[99]->GetBuffer() == 7);
+  }
+  TLOC_TEST_CHECK(scene.use_count() == 2);
+
+  TLOC_TEST_CHECK(cache.Purge() == 0);
+  TLOC_TEST_CHECK(cache.GetNumMeshes() == 1);
+
+  // replacing the mesh keeps the old one alive for its instances
+  DoMakeScene(mesh);
+  TLOC_TEST_CHECK(cache.Add("scene", mesh) != scene);
+  TLOC_TEST_CHECK(cache.GetNumMeshes() == 1);
+  TLOC_TEST_CHECK(numReleased == 0);
+
+  scene.reset();
+  TLOC_TEST_CHECK(numReleased == 1);
+
+  TLOC_TEST_CHECK(cache.Purge() == 1);
+  TLOC_TEST_CHECK(cache.GetNumMeshes() == 0);
+}
@@ -0,0 +1,21 @@
+#ifndef _TLOC_TESTS_TEST_HARNESS_H_
+#define _TLOC_TESTS_TEST_HARNESS_H_
+
+#include <tlocCore/tloc_core.h>
+
+#include <cstdio>
+
+// ///////////////////////////////////////////////////////////////////////
+// The checks of every tests file. A failed check is printed and counted,
+// a test fails if any of its checks did (see main.cpp).
+
+extern tl_int g_numChecksFailed;
+
+#define TLOC_TEST_CHECK(_expr_)\
+  if ( (_expr_) == false )\
+  {\
+    printf("\n  %s(%d): CHECK(%s) failed", __FILE__, __LINE__, #_expr_);\
+    ++g_numChecksFailed;\
+  }
+
+#endif
@@ -0,0 +1,8 @@
+#------------------------------------------------------------------------------
+# This file is included AFTER CMake adds the executable/library. Any operations
+# you want to perform that are done after the project has been created, can
+# be performed in this file.
+
+# the executable returns non-zero when a check fails
+add_test(NAME ${SOLUTION_CURRENT_PROJECT_NAME}
+         COMMAND ${SOLUTION_CURRENT_PROJECT_NAME})
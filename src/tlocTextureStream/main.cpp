@@ -7,6 +7,10 @@
 
 #include <gameAssetsPath.h>
 
+#include <tlocImageTools/src/dirtyRegions.h>
+#include <tlocImageTools/src/imageView.h>
+#include <tlocImageTools/src/textureStager.h>
+
 #include <tlocCore/smart_ptr/tloc_smart_ptr.inl.h>
 #include <tlocCore/containers/tlocArray.inl.h>
 
@@ -17,6 +21,9 @@ namespace {
   const tl_int g_imgRows = 100;
   const tl_int g_imgCols = 100;
 
+  // the part of the image that changes every frame
+  const tl_int g_noiseSize = 20;
+
   // We need a material to attach to our entity (which we have not yet created).
   // NOTE: The quad render system expects a few shader variables to be declared
   //       and used by the shader (i.e. not compiled out). See the listed
@@ -56,6 +63,76 @@ public:
 };
 TLOC_DEF_TYPE(WindowCallback);
 
+// ///////////////////////////////////////////////////////////////////////
+// Sends the parts of the image that changed to the texture, one
+// glTexSubImage2D() per dirty region, where TextureObject::Update() would
+// send the whole image every frame.
+//
+// Each staging buffer has its own pixel unpack buffer. Its storage is
+// orphaned before the new regions are copied in, so the copy does not wait
+// for the GPU to finish reading the previous frame, and glTexSubImage2D()
+// reads from offsets into it instead of blocking on client memory. Without
+// pixel unpack buffers (OpenGL ES 2.0) the regions are sent from client
+// memory.
+
+class TextureUploader
+  : public TextureStager
+{
+public:
+  explicit TextureUploader(gfx_gl::texture_object_vptr a_to)
+    : m_to(a_to)
+  {
+#if defined (GL_PIXEL_UNPACK_BUFFER)
+    glGenBuffers(k_numBuffers, m_pbos);
+#endif
+  }
+
+  ~TextureUploader()
+  {
+#if defined (GL_PIXEL_UNPACK_BUFFER)
+    glDeleteBuffers(k_numBuffers, m_pbos);
+#endif
+  }
+
+protected:
+  void  DoUpload(tl_int a_bufferIndex, const StagingBuffer& a_buffer)
+  {
+    gfx_gl::TextureObject::Bind bind(*m_to);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+#if defined (GL_PIXEL_UNPACK_BUFFER)
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pbos[a_bufferIndex]);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, a_buffer.m_size, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, a_buffer.m_size, &a_buffer.m_data[0]);
+
+    const u8* base = nullptr;
+#else
+    TLOC_UNUSED(a_bufferIndex);
+    const u8* base = &a_buffer.m_data[0];
+#endif
+
+    for (tl_size i = 0; i < a_buffer.m_regions.size(); ++i)
+    {
+      const DirtyRect& rect = a_buffer.m_regions[i].m_rect;
+      glTexSubImage2D(GL_TEXTURE_2D, 0, rect.m_x0, rect.m_y0,
+                      rect.GetWidth(), rect.GetHeight(), GL_RGBA,
+                      GL_UNSIGNED_BYTE, base + a_buffer.m_regions[i].m_offset);
+    }
+
+#if defined (GL_PIXEL_UNPACK_BUFFER)
+    // other uploads read client memory again
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+#endif
+  }
+
+private:
+  gfx_gl::texture_object_vptr m_to;
+
+#if defined (GL_PIXEL_UNPACK_BUFFER)
+  GLuint                      m_pbos[k_numBuffers];
+#endif
+};
+
 int TLOC_MAIN(int argc, char *argv[])
 {
   TLOC_UNUSED_2(argc, argv);
@@ -104,22 +181,30 @@ int TLOC_MAIN(int argc, char *argv[])
   gfx_cs::MaterialSystem    matSys(eventMgr.get(), entityMgr.get());
 
   // -----------------------------------------------------------------------
-  // add noise
+  // add noise to an a_size x a_size block of the image, the image records
+  // the block as dirty
 
   TL_NESTED_FUNC_BEGIN(AddNoise) 
-    void AddNoise(gfx_med::image_rgba_vptr a_ptr)
+    void AddNoise(TrackedImage& a_img, tl_int a_size)
   {
-    for (tl_int row = 0; row < g_imgRows; ++row)
+    const tl_int x0 =
+      core_rng::g_defaultRNG.GetRandomInteger(0, g_imgCols - a_size + 1);
+    const tl_int y0 =
+      core_rng::g_defaultRNG.GetRandomInteger(0, g_imgRows - a_size + 1);
+
+    // the noise is written a row at a time and copied into the image in
+    // one go, rather than pixel by pixel
+    core_conts::Array<u8> block((tl_size)a_size * a_size * 4);
+    const ImageView view(&block[0], a_size, a_size, PixelFormat());
+
+    for (tl_int row = 0; row < a_size; ++row)
     {
-      for (tl_int col = 0; col < g_imgCols; ++col)
-      {
-        tl_float r = core_rng::g_defaultRNG.GetRandomFloat(0.0f, 1.0f);
-        tl_float g = core_rng::g_defaultRNG.GetRandomFloat(0.0f, 1.0f);
-        tl_float b = core_rng::g_defaultRNG.GetRandomFloat(0.0f, 1.0f);
-        tl_float a = core_rng::g_defaultRNG.GetRandomFloat(0.0f, 1.0f);
-        a_ptr->SetPixel(row, col, gfx_med::image_rgba::color_type(r, g, b, a));
-      }
+      u8* rgba = view.GetRow(row);
+      for (tl_int i = 0; i < a_size * 4; ++i)
+      { rgba[i] = (u8)core_rng::g_defaultRNG.GetRandomInteger(0, 256); }
     }
+
+    a_img.SetPixels(x0, y0, a_size, a_size, view.GetData(), a_size);
   }
   TL_NESTED_FUNC_END();
 
@@ -134,6 +219,14 @@ int TLOC_MAIN(int argc, char *argv[])
   gfx_gl::texture_object_vso to;
   to->Initialize(*rgba);
 
+  // The pixels we stream live in a TrackedImage, which remembers the parts
+  // that changed. The uploader only sends those to the texture.
+  TrackedImage    streamed;
+  TextureUploader uploader(to.get());
+
+  streamed.Create(g_imgCols, g_imgRows, nullptr);
+  TL_NESTED_CALL(AddNoise)( streamed, g_imgRows );
+
   gfx_gl::uniform_vso u_to;
   u_to->SetName("s_texture").SetValueAs(*to);
 
@@ -162,8 +255,8 @@ int TLOC_MAIN(int argc, char *argv[])
     while (win.GetEvent(evt))
     { }
 
-    TL_NESTED_CALL(AddNoise)( rgba.get() );
-    to->Update(*rgba);
+    TL_NESTED_CALL(AddNoise)( streamed, g_noiseSize );
+    uploader.Update(streamed);
 
     renderer->ApplyRenderSettings();
     quadSys.ProcessActiveEntities();
@@ -174,6 +267,8 @@ int TLOC_MAIN(int argc, char *argv[])
 
   //------------------------------------------------------------------------
   // Exiting
+  TLOC_LOG_CORE_INFO() << "Uploaded " << uploader.GetBytesStaged()
+    << " bytes in " << uploader.GetNumUpdates() << " updates";
   TLOC_LOG_CORE_INFO() << "Existing normally from sample";
 
   return 0;
@@ -15,8 +15,17 @@ set(SOLUTION_ASSETS_PATH
 
 # Dependent project is compiled after dependency
 set(SOLUTION_PROJECT_DEPENDENCIES
+  tlocImageTools
   )
 
 # Libraries that the executable needs to link against
 set(SOLUTION_EXECUTABLE_LINK_LIBRARIES
+  tlocImageTools
   )
+
+# tlocImageTools uses OpenMP
+find_package(OpenMP)
+if (OPENMP_FOUND)
+  set (CMAKE_C_FLAGS "${CMAKE_C_FLAGS} ${OpenMP_C_FLAGS}")
+  set (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} ${OpenMP_CXX_FLAGS}")
+endif()
@@ -0,0 +1,589 @@
+#include "glyphOutline.h"
+
+using namespace tloc;
+
+namespace {
+
+  // -----------------------------------------------------------------------
+  // Reads the big endian values of a TrueType font at offsets that come from
+  // the file itself. Every read is checked against the end of the data (the
+  // file, or the glyph being read): past it the read returns 0 and the
+  // reader fails, so a truncated or malformed font fails to load instead of
+  // reading out of bounds.
+
+  class FontReader
+  {
+  public:
+    FontReader(const u8* a_data, tl_size a_end)
+      : m_data(a_data)
+      , m_end(a_end)
+      , m_failed(false)
+    { }
+
+    bool  IsInside(tl_size a_offset, tl_size a_numBytes)
+    {
+      if (a_offset > m_end || a_numBytes > m_end - a_offset)
+      { m_failed = true; }
+      return m_failed == false;
+    }
+
+    u32   ReadU8(tl_size a_offset)
+    { return IsInside(a_offset, 1) ? m_data[a_offset] : 0; }
+
+    u32   ReadU16(tl_size a_offset)
+    {
+      return IsInside(a_offset, 2)
+        ? (u32(m_data[a_offset]) << 8) | u32(m_data[a_offset + 1])
+        : 0;
+    }
+
+    s32   ReadS16(tl_size a_offset)
+    { return (s32)(s16)ReadU16(a_offset); }
+
+    u32   ReadU32(tl_size a_offset)
+    { return (ReadU16(a_offset) << 16) | ReadU16(a_offset + 2); }
+
+    f64   ReadF2Dot14(tl_size a_offset)
+    { return (f64)ReadS16(a_offset) / 16384.0; }
+
+    bool  HasFailed() const
+    { return m_failed; }
+
+  private:
+    const u8* m_data;
+    tl_size   m_end;
+    bool      m_failed;
+  };
+
+  // composite glyph flags
+  const u32 g_argsAreWords    = 0x0001;
+  const u32 g_argsAreXYValues = 0x0002;
+  const u32 g_haveScale       = 0x0008;
+  const u32 g_moreComponents  = 0x0020;
+  const u32 g_haveXYScale     = 0x0040;
+  const u32 g_haveTwoByTwo    = 0x0080;
+
+  // simple glyph flags
+  const u8  g_onCurve         = 0x01;
+  const u8  g_xShort          = 0x02;
+  const u8  g_yShort          = 0x04;
+  const u8  g_repeat          = 0x08;
+  const u8  g_xSameOrPositive = 0x10;
+  const u8  g_ySameOrPositive = 0x20;
+
+  const tl_int g_maxCompositeDepth = 8;
+
+  // -----------------------------------------------------------------------
+
+  OutlinePoint
+    DoMidPoint(const OutlinePoint& a, const OutlinePoint& b)
+  { return OutlinePoint( (a.m_x + b.m_x) * 0.5, (a.m_y + b.m_y) * 0.5 ); }
+
+  // -----------------------------------------------------------------------
+  // Converts one TrueType contour (on and off curve points) to edges. Two
+  // consecutive off curve points have an implied on curve point between them.
+
+  void
+    DoAddContour(const core_conts::Array<OutlinePoint>& a_points,
+                 const core_conts::Array<u8>& a_flags,
+                 tl_int a_begin, tl_int a_end, GlyphOutline& a_outline)
+  {
+    const tl_int numPoints = a_end - a_begin + 1;
+    if (numPoints < 2)
+    { return; }
+
+    core_conts::Array<OutlinePoint> points;
+    core_conts::Array<bool>         onCurve;
+
+    for (tl_int i = 0; i < numPoints; ++i)
+    {
+      const tl_int curr = a_begin + i;
+      const tl_int next = a_begin + (i + 1) % numPoints;
+
+      const bool currOn = (a_flags[curr] & g_onCurve) != 0;
+      const bool nextOn = (a_flags[next] & g_onCurve) != 0;
+
+      points.push_back(a_points[curr]);
+      onCurve.push_back(currOn);
+
+      if (currOn == false && nextOn == false)
+      {
+        points.push_back(DoMidPoint(a_points[curr], a_points[next]));
+        onCurve.push_back(true);
+      }
+    }
+
+    const tl_int numExpanded = core_utils::CastNumber<tl_int>(points.size());
+
+    tl_int start = 0;
+    while (start < numExpanded && onCurve[start] == false)
+    { ++start; }
+
+    if (start == numExpanded)
+    { return; }
+
+    OutlineContour contour;
+
+    tl_int i = 0;
+    while (i < numExpanded)
+    {
+      const tl_int curr = (start + i) % numExpanded;
+      const tl_int next = (start + i + 1) % numExpanded;
+
+      OutlineEdge edge;
+      edge.m_p[0] = points[curr];
+
+      if (onCurve[next])
+      {
+        edge.m_p[1] = points[next];
+        edge.m_numPoints = 2;
+        i += 1;
+      }
+      else
+      {
+        edge.m_p[1] = points[next];
+        edge.m_p[2] = points[(start + i + 2) % numExpanded];
+        edge.m_numPoints = 3;
+        i += 2;
+      }
+
+      const OutlinePoint& first = edge.m_p[0];
+      const OutlinePoint& last = edge.m_p[edge.m_numPoints - 1];
+      const bool degenerate = first.m_x == last.m_x && first.m_y == last.m_y &&
+        (edge.m_numPoints == 2 ||
+         (edge.m_p[1].m_x == first.m_x && edge.m_p[1].m_y == first.m_y));
+
+      if (degenerate == false)
+      { contour.m_edges.push_back(edge); }
+    }
+
+    if (contour.m_edges.empty() == false)
+    { a_outline.m_contours.push_back(contour); }
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// TrueTypeFont
+
+TrueTypeFont::
+  TrueTypeFont()
+  : m_cmapOffset(0)
+  , m_glyfOffset(0)
+  , m_locaOffset(0)
+  , m_hmtxOffset(0)
+  , m_cmapFormat(0)
+  , m_numGlyphs(0)
+  , m_numHMetrics(0)
+  , m_unitsPerEm(0)
+  , m_longLoca(false)
+{ }
+
+// -----------------------------------------------------------------------
+
+bool
+TrueTypeFont::
+  Initialize(const core_str::String& a_fileContents)
+{
+  m_data = a_fileContents;
+
+  FontReader file(DoGetData(), m_data.length());
+
+  if (file.ReadU32(0) != 0x00010000)
+  { return false; }
+
+  tl_size headOffset = 0, maxpOffset = 0, hheaOffset = 0;
+
+  const u32 numTables = file.ReadU16(4);
+  if (file.IsInside(12, numTables * 16) == false)
+  { return false; }
+
+  for (u32 i = 0; i < numTables; ++i)
+  {
+    const tl_size record = 12 + i * 16;
+    const u32     tag = file.ReadU32(record);
+    const tl_size offset = file.ReadU32(record + 8);
+
+    if      (tag == 0x636D6170) { m_cmapOffset = offset; } // cmap
+    else if (tag == 0x676C7966) { m_glyfOffset = offset; } // glyf
+    else if (tag == 0x6C6F6361) { m_locaOffset = offset; } // loca
+    else if (tag == 0x686D7478) { m_hmtxOffset = offset; } // hmtx
+    else if (tag == 0x68656164) { headOffset = offset; }   // head
+    else if (tag == 0x6D617870) { maxpOffset = offset; }   // maxp
+    else if (tag == 0x68686561) { hheaOffset = offset; }   // hhea
+  }
+
+  if (m_cmapOffset == 0 || m_glyfOffset == 0 || m_locaOffset == 0 ||
+      headOffset == 0 || maxpOffset == 0)
+  { return false; }
+
+  m_unitsPerEm  = (tl_int)file.ReadU16(headOffset + 18);
+  m_longLoca    = file.ReadS16(headOffset + 50) != 0;
+  m_numGlyphs   = (tl_int)file.ReadU16(maxpOffset + 4);
+  m_numHMetrics = hheaOffset ? (tl_int)file.ReadU16(hheaOffset + 34) : 0;
+
+  if (file.HasFailed() || m_unitsPerEm == 0)
+  { return false; }
+
+  // prefer the full unicode map (format 12), fall back to BMP (format 4)
+  const u32 numSubtables = file.ReadU16(m_cmapOffset + 2);
+  tl_size   subtable = 0;
+  for (u32 i = 0; i < numSubtables && file.HasFailed() == false; ++i)
+  {
+    const tl_size record = m_cmapOffset + 4 + i * 8;
+    const u32     platform = file.ReadU16(record);
+    const u32     encoding = file.ReadU16(record + 2);
+    const tl_size offset = m_cmapOffset + file.ReadU32(record + 4);
+    const u32     format = file.ReadU16(offset);
+
+    const bool isUnicode = platform == 0 || (platform == 3 && (encoding == 1 || encoding == 10));
+    if (isUnicode == false)
+    { continue; }
+
+    if (format == 12 || (format == 4 && m_cmapFormat != 12))
+    {
+      subtable = offset;
+      m_cmapFormat = (tl_int)format;
+    }
+  }
+
+  // the header of the chosen map, the entries are checked as they are read
+  const tl_size headerSize = m_cmapFormat == 12 ? 16 : 14;
+  if (file.HasFailed() || subtable == 0 ||
+      file.IsInside(subtable, headerSize) == false)
+  { return false; }
+
+  // the index of the glyph after the last one is read from loca as well
+  const tl_size locaSize = (m_numGlyphs + 1) * (m_longLoca ? 4 : 2);
+  if (file.IsInside(m_locaOffset, locaSize) == false)
+  { return false; }
+
+  m_cmapOffset = subtable;
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+TrueTypeFont::
+  GetUnitsPerEm() const
+{ return m_unitsPerEm; }
+
+// -----------------------------------------------------------------------
+
+tl_int
+TrueTypeFont::
+  GetGlyphIndex(u32 a_charCode) const
+{
+  FontReader file(DoGetData(), m_data.length());
+
+  if (m_cmapFormat == 12)
+  {
+    const u32 numGroups = file.ReadU32(m_cmapOffset + 12);
+    for (u32 i = 0; i < numGroups && file.HasFailed() == false; ++i)
+    {
+      const tl_size group = m_cmapOffset + 16 + (tl_size)i * 12;
+      const u32 startChar = file.ReadU32(group);
+      const u32 endChar = file.ReadU32(group + 4);
+      const u32 startGlyph = file.ReadU32(group + 8);
+
+      if (file.HasFailed() == false &&
+          a_charCode >= startChar && a_charCode <= endChar)
+      { return (tl_int)(startGlyph + (a_charCode - startChar)); }
+    }
+    return 0;
+  }
+
+  if (a_charCode > 0xFFFF)
+  { return 0; }
+
+  const u32     segCountX2 = file.ReadU16(m_cmapOffset + 6);
+  const tl_size endCodes = m_cmapOffset + 14;
+  const tl_size startCodes = endCodes + segCountX2 + 2;
+  const tl_size idDeltas = startCodes + segCountX2;
+  const tl_size idRangeOffsets = idDeltas + segCountX2;
+
+  for (u32 seg = 0; seg < segCountX2; seg += 2)
+  {
+    if (a_charCode > file.ReadU16(endCodes + seg))
+    { continue; }
+
+    const u32 startCode = file.ReadU16(startCodes + seg);
+    if (a_charCode < startCode)
+    { return 0; }
+
+    const u32 idDelta = file.ReadU16(idDeltas + seg);
+    const u32 idRangeOffset = file.ReadU16(idRangeOffsets + seg);
+
+    if (idRangeOffset == 0)
+    { return file.HasFailed() ? 0 : (tl_int)( (a_charCode + idDelta) & 0xFFFF ); }
+
+    const u32 glyph = file.ReadU16(idRangeOffsets + seg + idRangeOffset +
+                                   (a_charCode - startCode) * 2);
+    return glyph == 0 || file.HasFailed()
+      ? 0 : (tl_int)( (glyph + idDelta) & 0xFFFF );
+  }
+
+  return 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+TrueTypeFont::
+  GetGlyphOutline(tl_int a_glyphIndex, GlyphOutline& a_outline) const
+{
+  a_outline = GlyphOutline();
+
+  if (a_glyphIndex < 0 || a_glyphIndex >= m_numGlyphs)
+  { return false; }
+
+  if (m_hmtxOffset != 0 && m_numHMetrics > 0)
+  {
+    FontReader file(DoGetData(), m_data.length());
+
+    const tl_int metric = core::tlMin(a_glyphIndex, m_numHMetrics - 1);
+    a_outline.m_advance = (tl_int)file.ReadU16(m_hmtxOffset + metric * 4);
+    if (file.HasFailed())
+    { return false; }
+  }
+
+  return DoGetGlyphOutline(a_glyphIndex, a_outline, 0);
+}
+
+// -----------------------------------------------------------------------
+
+bool
+TrueTypeFont::
+  DoGetGlyphOutline(tl_int a_glyphIndex, GlyphOutline& a_outline,
+                    tl_int a_depth) const
+{
+  FontReader file(DoGetData(), m_data.length());
+
+  tl_size glyphBegin, glyphEnd;
+  if (m_longLoca)
+  {
+    glyphBegin = file.ReadU32(m_locaOffset + a_glyphIndex * 4);
+    glyphEnd = file.ReadU32(m_locaOffset + a_glyphIndex * 4 + 4);
+  }
+  else
+  {
+    glyphBegin = file.ReadU16(m_locaOffset + a_glyphIndex * 2) * 2;
+    glyphEnd = file.ReadU16(m_locaOffset + a_glyphIndex * 2 + 2) * 2;
+  }
+
+  if (file.HasFailed() || glyphEnd < glyphBegin)
+  { return false; }
+
+  // empty glyph (e.g. space)
+  if (glyphBegin == glyphEnd)
+  { return true; }
+
+  // from here on nothing is read past the end of the glyph
+  const tl_size glyph = m_glyfOffset + glyphBegin;
+  if (file.IsInside(glyph, glyphEnd - glyphBegin) == false)
+  { return false; }
+
+  FontReader data(DoGetData(), m_glyfOffset + glyphEnd);
+
+  const s32 numContours = data.ReadS16(glyph);
+
+  if (a_depth == 0)
+  {
+    a_outline.m_xMin = data.ReadS16(glyph + 2);
+    a_outline.m_yMin = data.ReadS16(glyph + 4);
+    a_outline.m_xMax = data.ReadS16(glyph + 6);
+    a_outline.m_yMax = data.ReadS16(glyph + 8);
+  }
+
+  if (data.HasFailed())
+  { return false; }
+
+  // -----------------------------------------------------------------------
+  // composite glyph: the outlines of other glyphs, transformed
+
+  if (numContours < 0)
+  {
+    if (a_depth >= g_maxCompositeDepth)
+    { return false; }
+
+    tl_size curr = glyph + 10;
+    u32     flags = g_moreComponents;
+
+    while (flags & g_moreComponents)
+    {
+      flags = data.ReadU16(curr);
+      const tl_int component = (tl_int)data.ReadU16(curr + 2);
+      curr += 4;
+
+      f64 dx = 0, dy = 0;
+      if (flags & g_argsAreWords)
+      {
+        dx = data.ReadS16(curr);
+        dy = data.ReadS16(curr + 2);
+        curr += 4;
+      }
+      else
+      {
+        dx = (s8)data.ReadU8(curr);
+        dy = (s8)data.ReadU8(curr + 1);
+        curr += 2;
+      }
+
+      // point matching is not supported, the component is not offset
+      if ( (flags & g_argsAreXYValues) == 0)
+      { dx = dy = 0; }
+
+      f64 a = 1, b = 0, c = 0, d = 1;
+      if (flags & g_haveScale)
+      {
+        a = d = data.ReadF2Dot14(curr);
+        curr += 2;
+      }
+      else if (flags & g_haveXYScale)
+      {
+        a = data.ReadF2Dot14(curr);
+        d = data.ReadF2Dot14(curr + 2);
+        curr += 4;
+      }
+      else if (flags & g_haveTwoByTwo)
+      {
+        a = data.ReadF2Dot14(curr);
+        b = data.ReadF2Dot14(curr + 2);
+        c = data.ReadF2Dot14(curr + 4);
+        d = data.ReadF2Dot14(curr + 6);
+        curr += 8;
+      }
+
+      GlyphOutline componentOutline;
+      if (data.HasFailed() || component < 0 || component >= m_numGlyphs ||
+          DoGetGlyphOutline(component, componentOutline, a_depth + 1) == false)
+      { return false; }
+
+      for (tl_size i = 0; i < componentOutline.m_contours.size(); ++i)
+      {
+        OutlineContour& contour = componentOutline.m_contours[i];
+        for (tl_size j = 0; j < contour.m_edges.size(); ++j)
+        {
+          OutlineEdge& edge = contour.m_edges[j];
+          for (tl_int k = 0; k < edge.m_numPoints; ++k)
+          {
+            const OutlinePoint p = edge.m_p[k];
+            edge.m_p[k] = OutlinePoint(a * p.m_x + c * p.m_y + dx,
+                                       b * p.m_x + d * p.m_y + dy);
+          }
+        }
+        a_outline.m_contours.push_back(contour);
+      }
+    }
+
+    return true;
+  }
+
+  // -----------------------------------------------------------------------
+  // simple glyph
+
+  // the contours end at increasing points
+  core_conts::Array<tl_int> endPoints;
+  for (s32 i = 0; i < numContours; ++i)
+  {
+    const tl_int endPoint = (tl_int)data.ReadU16(glyph + 10 + i * 2);
+    if (data.HasFailed() || (i > 0 && endPoint <= endPoints.back()))
+    { return false; }
+
+    endPoints.push_back(endPoint);
+  }
+
+  if (endPoints.empty())
+  { return true; }
+
+  const tl_int numPoints = endPoints.back() + 1;
+  const tl_size instructionLength = data.ReadU16(glyph + 10 + numContours * 2);
+
+  tl_size curr = glyph + 12 + numContours * 2 + instructionLength;
+
+  core_conts::Array<u8> flags;
+  while ( (tl_int)flags.size() < numPoints && data.HasFailed() == false)
+  {
+    const u8 flag = (u8)data.ReadU8(curr++);
+    flags.push_back(flag);
+
+    if (flag & g_repeat)
+    {
+      const u32 repeatCount = data.ReadU8(curr++);
+      for (u32 i = 0; i < repeatCount; ++i)
+      { flags.push_back(flag); }
+    }
+  }
+
+  if (data.HasFailed())
+  { return false; }
+
+  // numPoints must fit what is left of the glyph: the coordinates take 0,
+  // 1 or 2 bytes each depending on their flag
+  tl_size coordinateSize = 0;
+  for (tl_int i = 0; i < numPoints; ++i)
+  {
+    if (flags[i] & g_xShort) { coordinateSize += 1; }
+    else if ( (flags[i] & g_xSameOrPositive) == 0) { coordinateSize += 2; }
+
+    if (flags[i] & g_yShort) { coordinateSize += 1; }
+    else if ( (flags[i] & g_ySameOrPositive) == 0) { coordinateSize += 2; }
+  }
+
+  if (data.IsInside(curr, coordinateSize) == false)
+  { return false; }
+
+  core_conts::Array<OutlinePoint> points(numPoints);
+
+  s32 x = 0;
+  for (tl_int i = 0; i < numPoints; ++i)
+  {
+    if (flags[i] & g_xShort)
+    {
+      const s32 delta = (s32)data.ReadU8(curr++);
+      x += (flags[i] & g_xSameOrPositive) ? delta : -delta;
+    }
+    else if ( (flags[i] & g_xSameOrPositive) == 0)
+    {
+      x += data.ReadS16(curr);
+      curr += 2;
+    }
+    points[i].m_x = (f64)x;
+  }
+
+  s32 y = 0;
+  for (tl_int i = 0; i < numPoints; ++i)
+  {
+    if (flags[i] & g_yShort)
+    {
+      const s32 delta = (s32)data.ReadU8(curr++);
+      y += (flags[i] & g_ySameOrPositive) ? delta : -delta;
+    }
+    else if ( (flags[i] & g_ySameOrPositive) == 0)
+    {
+      y += data.ReadS16(curr);
+      curr += 2;
+    }
+    points[i].m_y = (f64)y;
+  }
+
+  if (data.HasFailed())
+  { return false; }
+
+  tl_int begin = 0;
+  for (tl_size i = 0; i < endPoints.size(); ++i)
+  {
+    DoAddContour(points, flags, begin, endPoints[i], a_outline);
+    begin = endPoints[i] + 1;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+const u8*
+TrueTypeFont::
+  DoGetData() const
+{ return reinterpret_cast<const u8*>(m_data.c_str()); }
@@ -0,0 +1,109 @@
+#ifndef _TLOC_UTILS_DF_GLYPH_OUTLINE_H_
+#define _TLOC_UTILS_DF_GLYPH_OUTLINE_H_
+
+#include <tlocCore/tloc_core.h>
+
+// ///////////////////////////////////////////////////////////////////////
+// Glyph outlines in font units. Every edge is either a line (2 points) or a
+// quadratic bezier (3 points), which is all that TrueType glyphs contain.
+
+struct OutlinePoint
+{
+  OutlinePoint()
+    : m_x(0), m_y(0)
+  { }
+
+  OutlinePoint(f64 a_x, f64 a_y)
+    : m_x(a_x), m_y(a_y)
+  { }
+
+  f64 m_x;
+  f64 m_y;
+};
+
+struct OutlineEdge
+{
+  enum
+  {
+    k_black   = 0,
+    k_red     = 1,
+    k_green   = 2,
+    k_yellow  = 3,
+    k_blue    = 4,
+    k_magenta = 5,
+    k_cyan    = 6,
+    k_white   = 7,
+  };
+
+  OutlineEdge()
+    : m_numPoints(0)
+    , m_color(k_white)
+  { }
+
+  OutlinePoint  m_p[3];
+  tl_int        m_numPoints;
+  u32           m_color;
+};
+
+typedef tl_core_conts::Array<OutlineEdge>     outline_edge_cont;
+
+struct OutlineContour
+{
+  outline_edge_cont m_edges;
+};
+
+typedef tl_core_conts::Array<OutlineContour>  outline_contour_cont;
+
+struct GlyphOutline
+{
+  GlyphOutline()
+    : m_xMin(0), m_yMin(0), m_xMax(0), m_yMax(0), m_advance(0)
+  { }
+
+  outline_contour_cont  m_contours;
+
+  tl_int  m_xMin;
+  tl_int  m_yMin;
+  tl_int  m_xMax;
+  tl_int  m_yMax;
+  tl_int  m_advance;
+};
+
+// ///////////////////////////////////////////////////////////////////////
+// Reads glyph outlines straight out of the 'glyf' table of a TrueType font.
+// gfx_med::Font only hands out rasterized glyphs, which is exactly what the
+// MSDF generator is trying to avoid. CFF based OpenType fonts ('OTTO') are
+// not supported.
+
+class TrueTypeFont
+{
+public:
+  TrueTypeFont();
+
+  bool    Initialize(const tl_core_str::String& a_fileContents);
+
+  tl_int  GetUnitsPerEm() const;
+  tl_int  GetGlyphIndex(u32 a_charCode) const;
+  bool    GetGlyphOutline(tl_int a_glyphIndex, GlyphOutline& a_outline) const;
+
+private:
+  bool    DoGetGlyphOutline(tl_int a_glyphIndex, GlyphOutline& a_outline,
+                            tl_int a_depth) const;
+
+  const u8* DoGetData() const;
+
+private:
+  tl_core_str::String   m_data;
+
+  tl_size   m_cmapOffset;
+  tl_size   m_glyfOffset;
+  tl_size   m_locaOffset;
+  tl_size   m_hmtxOffset;
+  tl_int    m_cmapFormat;
+  tl_int    m_numGlyphs;
+  tl_int    m_numHMetrics;
+  tl_int    m_unitsPerEm;
+  bool      m_longLoca;
+};
+
+#endif
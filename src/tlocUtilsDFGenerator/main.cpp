@@ -8,223 +8,1851 @@
 
 #include <gameAssetsPath.h>
 
+#include <tlocDistanceField/src/distanceField.h>
+#include <tlocDistanceField/src/rawDistanceField.h>
+#include <tlocDistanceField/src/distanceVolume.h>
+
+#include "glyphOutline.h"
+#include "msdfGenerator.h"
+
 #include <tlocCore/smart_ptr/tloc_smart_ptr.inl.h>
 #include <tlocCore/containers/tlocArray.inl.h>
 
-#include <omp.h>
+#include <omp.h>
+
+#include <sys/stat.h>
+
+#if defined (TLOC_OS_WIN)
+# include <io.h>
+#else
+# include <dirent.h>
+#endif
+
+using namespace tloc;
+
+namespace {
+
+  core_io::Path g_inFile("invalid_filename");
+  core_io::Path g_outFile("sdf_out.png");
+
+  tl_int g_numOpenMPThreads = 4;
+  bool   g_bench = false;
+
+  // per image output (progress bar and per phase bench), off in batch mode
+  bool   g_perImageOutput = true;
+};
+
+class WindowCallback
+{
+public:
+  WindowCallback()
+    : m_endProgram(false)
+  { }
+
+  core_dispatch::Event 
+    OnWindowEvent(const gfx_win::WindowEvent& a_event)
+  {
+    if (a_event.m_type == gfx_win::WindowEvent::close)
+    { m_endProgram = true; }
+
+    return core_dispatch::f_event::Continue();
+  }
+
+  bool  m_endProgram;
+};
+TLOC_DEF_TYPE(WindowCallback);
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+gfx_t::Color
+EncodeDistanceToColor(tl_float a_distance)
+{
+  return gfx_t::Color(a_distance, 0.0f, 0.0f, 1.0f);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+namespace {
+
+  typedef core_conts::Array<u8>       coverage_cont;
+  typedef core_conts::Array<tl_int>   index_cont;
+
+  const tl_int g_noSite = -1;
+
+};
+
+// Box filters the source image once with a summed area table and thresholds
+// the result against a_inCol. Every source pixel ends up as 1 (inside) or 0
+// (outside) so that the kernel loops only ever read a flat byte buffer. The
+// box is (2 * half + 1) pixels wide where half is derived from the ratio
+// between the source and the SDF dimensions.
+//
+// a_sat comes in with the row sums of the first channel filled in, the table
+// has an extra row and column of zeros so that box sums do not need special
+// cases at the borders. u32 may wrap on very large images but the box sums
+// remain exact because they are computed modulo 2^32 as well.
+
+coverage_cont
+GetCoverageFromRowSums(core_conts::Array<u32>& a_sat, 
+                       tl_int imgWidth, tl_int imgHeight,
+                       tl_float widthRatio, tl_float heightRatio, 
+                       bool a_invert, gfx_t::Color a_inCol)
+{
+  const tl_int halfWidth = core::tlMax((tl_int)(widthRatio + 0.5f) - 1, 0);
+  const tl_int halfHeight = core::tlMax((tl_int)(heightRatio + 0.5f) - 1, 0);
+
+  const tl_int satWidth = imgWidth + 1;
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int x = 1; x < satWidth; ++x)
+  {
+    for (tl_int y = 2; y <= imgHeight; ++y)
+    { a_sat[x + y * satWidth] += a_sat[x + (y - 1) * satWidth]; }
+  }
+
+  const tl_int threshold = a_inCol[0];
+
+  coverage_cont coverage(imgWidth * imgHeight, 0);
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int y = 0; y < imgHeight; ++y)
+  {
+    const tl_int y0 = core::tlMax(y - halfHeight, 0);
+    const tl_int y1 = core::tlMin(y + halfHeight, imgHeight - 1) + 1;
+
+    for (tl_int x = 0; x < imgWidth; ++x)
+    {
+      const tl_int x0 = core::tlMax(x - halfWidth, 0);
+      const tl_int x1 = core::tlMin(x + halfWidth, imgWidth - 1) + 1;
+
+      const u32 sum = a_sat[x1 + y1 * satWidth] - a_sat[x0 + y1 * satWidth] -
+                      a_sat[x1 + y0 * satWidth] + a_sat[x0 + y0 * satWidth];
+      const u32 count = (u32)( (x1 - x0) * (y1 - y0) );
+
+      tl_int avgColor = (tl_int)(sum / count);
+      if (a_invert) { avgColor = 255 - avgColor; }
+
+      coverage[x + y * imgWidth] = avgColor >= threshold ? 1 : 0;
+    }
+  }
+
+  return coverage;
+}
+
+coverage_cont
+GetCoverageFromImg(const gfx_med::image_sptr& a_charImg, 
+                   tl_float widthRatio, tl_float heightRatio, 
+                   bool a_invert, gfx_t::Color a_inCol)
+{
+  const auto imgWidth = core_utils::CastNumber<tl_int>(a_charImg->GetWidth());
+  const auto imgHeight = core_utils::CastNumber<tl_int>(a_charImg->GetHeight());
+
+  const tl_int satWidth = imgWidth + 1;
+  core_conts::Array<u32> sat(satWidth * (imgHeight + 1), 0);
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int y = 0; y < imgHeight; ++y)
+  {
+    u32 rowSum = 0;
+    for (tl_int x = 0; x < imgWidth; ++x)
+    {
+      rowSum += a_charImg->GetPixel(x, y)[0];
+      sat[(x + 1) + (y + 1) * satWidth] = rowSum;
+    }
+  }
+
+  return GetCoverageFromRowSums(sat, imgWidth, imgHeight, widthRatio, 
+                                heightRatio, a_invert, a_inCol);
+}
+
+// Same as GetCoverageFromImg for a single channel 8 bit buffer, used by band
+// mode which never holds more than a window of rows.
+
+coverage_cont
+GetCoverageFromGray(const u8* a_values, tl_int imgWidth, tl_int imgHeight,
+                    tl_float widthRatio, tl_float heightRatio, 
+                    bool a_invert, gfx_t::Color a_inCol)
+{
+  const tl_int satWidth = imgWidth + 1;
+  core_conts::Array<u32> sat(satWidth * (imgHeight + 1), 0);
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int y = 0; y < imgHeight; ++y)
+  {
+    const u8* row = a_values + y * imgWidth;
+
+    u32 rowSum = 0;
+    for (tl_int x = 0; x < imgWidth; ++x)
+    {
+      rowSum += row[x];
+      sat[(x + 1) + (y + 1) * satWidth] = rowSum;
+    }
+  }
+
+  return GetCoverageFromRowSums(sat, imgWidth, imgHeight, widthRatio, 
+                                heightRatio, a_invert, a_inCol);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+gfx_t::Color
+EncodeSDFPixel(math_t::Vec2f32 a_vecToEdge, tl_float a_disToEdge,
+               tl_float a_kernelSize)
+{
+  using namespace math;
+
+  auto vec = math_t::Vec4f32(a_vecToEdge, a_disToEdge, a_kernelSize);
+  auto sdfColor = gfx_t::f_color::Encode
+    (vec, MakeRangef<f32, p_range::Inclusive>().Get(-a_kernelSize, a_kernelSize));
+
+  return gfx_t::Color(sdfColor);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Where the SDF pixels go. RGBA keeps the direction and the distance encoded
+// with EncodeSDFPixel (saved as PNG), the raw formats keep only the signed
+// distance at 16 or 32 bits and are saved uncompressed with a small header
+// (see rawDistanceField.h).
+
+namespace {
+
+  const tl_int g_formatRGBA = 0;
+
+  // the header is padded up to its data offset
+  bool
+    DoWriteRawHeader(FILE* a_file, tl_int a_format, tl_int a_width, 
+                     tl_int a_height, tl_int a_kernelSize, tl_int a_depth = 1)
+  {
+    const auto header = MakeRawDistanceFieldHeader
+      ( (u32)a_format, (u32)a_width, (u32)a_height, (f32)a_kernelSize, (u32)a_depth);
+
+    core_conts::Array<u8> padded(header.m_dataOffset, 0);
+    memcpy(&padded[0], &header, sizeof(header));
+
+    return fwrite(&padded[0], 1, padded.size(), a_file) == padded.size();
+  }
+
+};
+
+class SDFOutput
+{
+public:
+  SDFOutput()
+    : m_format(g_formatRGBA)
+    , m_width(0)
+    , m_height(0)
+    , m_kernelSize(0)
+  { }
+
+  void
+    Create(tl_int a_width, tl_int a_height, tl_int a_format, tl_int a_kernelSize)
+  {
+    m_format = a_format;
+    m_width = a_width;
+    m_height = a_height;
+    m_kernelSize = a_kernelSize;
+
+    if (m_format == RawDistanceFieldHeader::k_formatU16)
+    { m_u16.resize(a_width * a_height, 0); }
+    else if (m_format == RawDistanceFieldHeader::k_formatF32)
+    { m_f32.resize(a_width * a_height, 0.0f); }
+    else
+    {
+      m_image = core_sptr::MakeShared<gfx_med::Image>();
+      m_image->Create(core_ds::MakeTuple(a_width, a_height), gfx_t::Color::COLOR_BLACK);
+    }
+  }
+
+  void
+    SetPixel(tl_int a_x, tl_int a_y, math_t::Vec2f32 a_vecToEdge, 
+             tl_float a_disToEdge)
+  {
+    const auto kernelSizef32 = (tl_float)m_kernelSize;
+
+    if (m_format == RawDistanceFieldHeader::k_formatU16)
+    { m_u16[a_x + a_y * m_width] = EncodeDistanceU16(a_disToEdge, kernelSizef32); }
+    else if (m_format == RawDistanceFieldHeader::k_formatF32)
+    { m_f32[a_x + a_y * m_width] = a_disToEdge; }
+    else
+    { m_image->SetPixel(a_x, a_y, EncodeSDFPixel(a_vecToEdge, a_disToEdge, kernelSizef32)); }
+  }
+
+  // the samples only (RGBA8, u16 or f32), top row first
+  bool
+    WriteSamples(FILE* a_file) const
+  {
+    const tl_size numSamples = m_width * m_height;
+
+    if (m_format == RawDistanceFieldHeader::k_formatU16)
+    { return numSamples == 0 || fwrite(&m_u16[0], sizeof(u16), numSamples, a_file) == numSamples; }
+    if (m_format == RawDistanceFieldHeader::k_formatF32)
+    { return numSamples == 0 || fwrite(&m_f32[0], sizeof(f32), numSamples, a_file) == numSamples; }
+
+    core_conts::Array<u8> row(m_width * 4);
+    for (tl_int y = 0; y < m_height; ++y)
+    {
+      for (tl_int x = 0; x < m_width; ++x)
+      {
+        const auto color = m_image->GetPixel(x, y);
+        for (tl_int i = 0; i < 4; ++i)
+        { row[x * 4 + i] = color[i]; }
+      }
+
+      if (fwrite(&row[0], 1, row.size(), a_file) != row.size())
+      { return false; }
+    }
+
+    return true;
+  }
+
+  // PNG for RGBA, header and samples for the raw formats
+  bool
+    Save(const core_str::String& a_fileName) const
+  {
+    if (m_format == g_formatRGBA)
+    { 
+      return gfx_med::f_image_loader::SaveImage
+        (*m_image, core_io::Path(a_fileName)) == ErrorSuccess; 
+    }
+
+    FILE* file = fopen(a_fileName.c_str(), "wb");
+    if (file == nullptr)
+    { return false; }
+
+    const bool saved = 
+      DoWriteRawHeader(file, m_format, m_width, m_height, m_kernelSize) && 
+      WriteSamples(file);
+    fclose(file);
+
+    return saved;
+  }
+
+  TLOC_DECL_AND_DEF_GETTER(gfx_med::image_sptr, GetImage, m_image);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetFormat, m_format);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetWidth, m_width);
+  TLOC_DECL_AND_DEF_GETTER(tl_int, GetHeight, m_height);
+
+private:
+  gfx_med::image_sptr     m_image;
+  core_conts::Array<u16>  m_u16;
+  core_conts::Array<f32>  m_f32;
+
+  tl_int  m_format;
+  tl_int  m_width;
+  tl_int  m_height;
+  tl_int  m_kernelSize;
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+// Prints the progress bar. Only ever called from one thread.
+
+void
+PrintProgress(tl_int a_done, tl_int a_total)
+{
+  if (g_perImageOutput == false)
+  { return; }
+
+  const tl_int numDashes = (tl_int) ( (f32) a_done * 100.0f / (f32) a_total );
+
+  core_str::String dashes;
+  for (tl_int i = 0; i < numDashes; ++i)
+  { dashes += "-"; }
+
+  for (tl_int i = numDashes; i < 100; ++i)
+  { dashes += " "; }
+
+  printf("\r0%%|%s|100%%", dashes.c_str());
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+// Reads a counter that other threads bump with omp atomic. OpenMP 2.0 (MSVC)
+// has no atomic read, so there the flush is the best we can do.
+
+tl_int
+ReadProgress(tl_int& a_counter)
+{
+  tl_int done;
+#if defined (_OPENMP) && _OPENMP >= 201107
+# pragma omp atomic read
+  done = a_counter;
+#else
+# pragma omp flush
+  done = a_counter;
+#endif
+  return done;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+void
+PrintBench(const char* a_phase, core_time::Timer& a_timer, tl_size a_numPixels)
+{
+  if (g_bench == false || g_perImageOutput == false)
+  { return; }
+
+  const f64 seconds = a_timer.ElapsedSeconds();
+  const f64 mpix = (f64)a_numPixels / 1000000.0;
+
+  printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", a_phase, seconds, 
+         seconds > 0 ? mpix / seconds : 0.0);
+
+  a_timer.Reset();
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// The brute force kernel visits the taps of a circular kernel sorted by
+// distance (see tlocDistanceField), the output is processed in tiles.
+
+namespace {
+
+  const tl_int g_tileSize = 32;
+
+  // -----------------------------------------------------------------------
+  // a_imgRow and a_imgCol are in coverage space, which is the full source
+  // image or a band of it (with a halo of at least a kernel)
+
+  void
+    DoSetSDFPixel(const coverage_cont& a_coverage, const KernelTaps& a_taps,
+                  tl_int a_imgRow, tl_int a_imgCol, 
+                  tl_int a_imgWidth, tl_int a_imgHeight, tl_int a_kernelSize,
+                  SDFOutput& a_sdf, tl_int a_row, tl_int a_col)
+  {
+    const auto kernelSizef32 = (tl_float)a_kernelSize;
+    const bool isInColor = a_coverage[a_imgRow + a_imgCol * a_imgWidth] == 1;
+
+    const bool checkBounds = 
+      a_imgRow - a_kernelSize < 0 || a_imgCol - a_kernelSize < 0 ||
+      a_imgRow + a_kernelSize >= a_imgWidth || a_imgCol + a_kernelSize >= a_imgHeight;
+
+    auto  disToEdge = kernelSizef32;
+    auto  vecToPixel = isInColor ? math_t::Vec2f32(-kernelSizef32) : math_t::Vec2f32(kernelSizef32);
+
+    const auto closestTap = FindClosestEdgeTap
+      (a_coverage, a_taps, a_imgRow, a_imgCol, a_imgWidth, a_imgHeight, checkBounds);
+
+    // an edge exactly at the kernel radius is not closer than the default
+    if (closestTap != KernelTaps::k_noTap && a_taps.m_distance[closestTap] < kernelSizef32)
+    {
+      vecToPixel[0] = (tl_float) a_taps.m_x[closestTap];
+      vecToPixel[1] = (tl_float) a_taps.m_y[closestTap];
+      disToEdge = a_taps.m_distance[closestTap];
+    }
+
+    disToEdge = isInColor ? -disToEdge : disToEdge;
+    a_sdf.SetPixel(a_row, a_col, vecToPixel, disToEdge);
+  }
+
+};
+
+void
+GetSDFFromCharImage(gfx_med::image_sptr a_charImg, SDFOutput& a_sdf, 
+                    tl_int a_kernelSize, bool a_invert = false,
+                    gfx_t::Color a_inCol = gfx_t::Color(240, 240, 240, 255), 
+                    gfx_t::Color a_outCol = gfx_t::Color(0, 0, 0, 255))
+{
+  TLOC_UNUSED(a_outCol);
+
+  const tl_int kernelSize = a_kernelSize;
+
+  const auto imgWidth = core_utils::CastNumber<tl_int>(a_charImg->GetWidth());
+  const auto imgHeight = core_utils::CastNumber<tl_int>(a_charImg->GetHeight());
+
+  const auto sdfImgWidth = a_sdf.GetWidth();
+  const auto sdfImgHeight = a_sdf.GetHeight();
+
+  const auto widthRatio = (tl_float) imgWidth / (tl_float) sdfImgWidth;
+  const auto heightRatio = (tl_float) imgHeight / (tl_float) sdfImgHeight;
+
+  core_time::Timer benchTimer;
+
+  const auto coverage = 
+    GetCoverageFromImg(a_charImg, widthRatio, heightRatio, a_invert, a_inCol);
+  PrintBench("coverage", benchTimer, imgWidth * imgHeight);
+
+  const auto taps = GetSortedKernelTaps(kernelSize, imgWidth);
+
+  // -----------------------------------------------------------------------
+  // the output is split into tiles that are handed out dynamically, each
+  // tile touches a small window of the coverage buffer
+
+  const tl_int numTilesX = (sdfImgWidth + g_tileSize - 1) / g_tileSize;
+  const tl_int numTilesY = (sdfImgHeight + g_tileSize - 1) / g_tileSize;
+  const tl_int numTiles = numTilesX * numTilesY;
+
+  if (g_perImageOutput)
+  { printf("\n0%%|                                                                                                    |100%%"); }
+
+  tl_int tilesDone = 0;
+
+#pragma omp parallel for schedule(dynamic, 1) shared(tilesDone) num_threads(g_numOpenMPThreads)
+  for (tl_int tile = 0; tile < numTiles; ++tile)
+  {
+    const tl_int rowBegin = (tile % numTilesX) * g_tileSize;
+    const tl_int colBegin = (tile / numTilesX) * g_tileSize;
+    const tl_int rowEnd = core::tlMin(rowBegin + g_tileSize, sdfImgWidth);
+    const tl_int colEnd = core::tlMin(colBegin + g_tileSize, sdfImgHeight);
+
+    for (tl_int col = colBegin; col < colEnd; col++)
+    {
+      for (tl_int row = rowBegin; row < rowEnd; row++)
+      {
+        const auto imgRow = (tl_int) ( (tl_float) row * widthRatio );
+        const auto imgCol = (tl_int) ( (tl_float) col * heightRatio );
+
+        DoSetSDFPixel(coverage, taps, imgRow, imgCol, imgWidth, imgHeight, 
+                      kernelSize, a_sdf, row, col);
+      }
+    }
+
+    // one atomic add per tile, only the master thread draws the progress bar
+#pragma omp atomic
+    tilesDone++;
+
+    if (omp_get_thread_num() == 0)
+    {
+      PrintProgress(ReadProgress(tilesDone), numTiles);
+    }
+  }
+
+  PrintProgress(numTiles, numTiles);
+  PrintBench("distance", benchTimer, sdfImgWidth * sdfImgHeight);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Exact euclidean distance transform (Felzenszwalb and Huttenlocher). The
+// transform is separable: the first pass finds the closest site in every
+// column, the second pass finds the lower envelope of the parabolas formed by
+// those column distances in every row. Both passes are linear in the number
+// of pixels and do not depend on the kernel size.
+
+namespace {
+
+  typedef core_conts::Array<f64>      envelope_cont;
+
+  const f64    g_envelopeInf = 1e20;
+
+  // -----------------------------------------------------------------------
+  // For every pixel in a_mask that is NOT a_siteValue, finds the closest pixel
+  // that IS a_siteValue and stores its index (x + y * width) in a_nearest.
+
+  void
+    DoFindNearestSites(const coverage_cont& a_mask,
+                       tl_int a_width, tl_int a_height, u8 a_siteValue,
+                       index_cont& a_nearest)
+  {
+    // closest site in the same column (y index only)
+    index_cont colSite(a_width * a_height, g_noSite);
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+    for (tl_int x = 0; x < a_width; ++x)
+    {
+      tl_int lastSite = g_noSite;
+      for (tl_int y = 0; y < a_height; ++y)
+      {
+        if (a_mask[x + y * a_width] == a_siteValue) { lastSite = y; }
+        colSite[x + y * a_width] = lastSite;
+      }
+
+      lastSite = g_noSite;
+      for (tl_int y = a_height - 1; y >= 0; --y)
+      {
+        if (a_mask[x + y * a_width] == a_siteValue) { lastSite = y; }
+        if (lastSite == g_noSite) { continue; }
+
+        const tl_int prevSite = colSite[x + y * a_width];
+        if (prevSite == g_noSite || lastSite - y < y - prevSite)
+        { colSite[x + y * a_width] = lastSite; }
+      }
+    }
+
+#pragma omp parallel num_threads(g_numOpenMPThreads)
+    {
+      index_cont    v(a_width);
+      envelope_cont z(a_width + 1);
+      envelope_cont f(a_width);
+
+#pragma omp for
+      for (tl_int y = 0; y < a_height; ++y)
+      {
+        const tl_int rowBegin = y * a_width;
+
+        // build the lower envelope out of the columns that have a site
+        tl_int k = -1;
+        for (tl_int q = 0; q < a_width; ++q)
+        {
+          const tl_int siteY = colSite[rowBegin + q];
+          if (siteY == g_noSite) { continue; }
+
+          f[q] = (f64)( (siteY - y) * (siteY - y) );
+
+          f64 s = 0;
+          while (k >= 0)
+          {
+            const tl_int vk = v[k];
+            s = ( (f[q] + (f64)(q * q)) - (f[vk] + (f64)(vk * vk)) ) /
+                (f64)(2 * q - 2 * vk);
+            if (s > z[k]) { break; }
+            --k;
+          }
+
+          ++k;
+          v[k] = q;
+          z[k] = k == 0 ? -g_envelopeInf : s;
+          z[k + 1] = g_envelopeInf;
+        }
+
+        if (k < 0)
+        {
+          for (tl_int q = 0; q < a_width; ++q)
+          { a_nearest[rowBegin + q] = g_noSite; }
+          continue;
+        }
+
+        // sample the envelope
+        tl_int j = 0;
+        for (tl_int q = 0; q < a_width; ++q)
+        {
+          while (z[j + 1] < (f64)q) { ++j; }
+
+          if (a_mask[rowBegin + q] == a_siteValue) { continue; }
+
+          const tl_int siteX = v[j];
+          a_nearest[rowBegin + q] = siteX + colSite[rowBegin + siteX] * a_width;
+        }
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  void
+    DoSetSDFPixelEDT(const coverage_cont& a_mask, const index_cont& a_nearest,
+                     tl_int a_imgRow, tl_int a_imgCol, tl_int a_imgWidth,
+                     tl_int a_kernelSize, 
+                     SDFOutput& a_sdf, tl_int a_row, tl_int a_col)
+  {
+    const auto kernelSizef32 = (tl_float)a_kernelSize;
+    const auto index = a_imgRow + a_imgCol * a_imgWidth;
+
+    const bool isInColor = a_mask[index] == 1;
+
+    auto  disToEdge = kernelSizef32;
+    auto  vecToPixel = isInColor ? math_t::Vec2f32(-kernelSizef32) : math_t::Vec2f32(kernelSizef32);
+
+    const auto site = a_nearest[index];
+    if (site != g_noSite)
+    {
+      const tl_int kRow = (site % a_imgWidth) - a_imgRow;
+      const tl_int kCol = (site / a_imgWidth) - a_imgCol;
+
+      // we want a circular kernel, an edge exactly at the kernel radius is
+      // not closer than the default
+      if (kRow * kRow + kCol * kCol < a_kernelSize * a_kernelSize)
+      {
+        using math_utils::Pythagoras;
+        auto p = Pythagoras(Pythagoras::base((tl_float) math::Abs(kRow)),
+                            Pythagoras::opposite((tl_float) math::Abs(kCol)));
+
+        vecToPixel[0] = (tl_float) kRow;
+        vecToPixel[1] = (tl_float) kCol;
+        disToEdge = p.GetSide<Pythagoras::hypotenuse>();
+      }
+    }
+
+    disToEdge = isInColor ? -disToEdge : disToEdge;
+    a_sdf.SetPixel(a_row, a_col, vecToPixel, disToEdge);
+  }
+
+};
+
+void
+GetSDFFromCharImageEDT(gfx_med::image_sptr a_charImg, SDFOutput& a_sdf,
+                       tl_int a_kernelSize, bool a_invert = false,
+                       gfx_t::Color a_inCol = gfx_t::Color(240, 240, 240, 255))
+{
+  const auto imgWidth = core_utils::CastNumber<tl_int>(a_charImg->GetWidth());
+  const auto imgHeight = core_utils::CastNumber<tl_int>(a_charImg->GetHeight());
+
+  const auto sdfImgWidth = a_sdf.GetWidth();
+  const auto sdfImgHeight = a_sdf.GetHeight();
+
+  const auto widthRatio = (tl_float) imgWidth / (tl_float) sdfImgWidth;
+  const auto heightRatio = (tl_float) imgHeight / (tl_float) sdfImgHeight;
+
+  core_time::Timer benchTimer;
+
+  // -----------------------------------------------------------------------
+  // classify the source pixels, shared with the brute force kernel
+
+  const auto mask = 
+    GetCoverageFromImg(a_charImg, widthRatio, heightRatio, a_invert, a_inCol);
+  PrintBench("coverage", benchTimer, imgWidth * imgHeight);
+
+  // -----------------------------------------------------------------------
+  // inside pixels look for the closest outside pixel and vice versa
+
+  index_cont nearest(imgWidth * imgHeight, g_noSite);
+  DoFindNearestSites(mask, imgWidth, imgHeight, 0, nearest);
+  DoFindNearestSites(mask, imgWidth, imgHeight, 1, nearest);
+  PrintBench("distance", benchTimer, imgWidth * imgHeight);
+
+  // -----------------------------------------------------------------------
+  // sample the distance field at the SDF resolution
+
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int row = 0; row < sdfImgWidth; row++)
+  {
+    for (tl_int col = 0; col < sdfImgHeight; col++)
+    {
+      const auto imgRow = (tl_int) ( (tl_float) row * widthRatio );
+      const auto imgCol = (tl_int) ( (tl_float) col * heightRatio );
+
+      DoSetSDFPixelEDT(mask, nearest, imgRow, imgCol, imgWidth, a_kernelSize,
+                       a_sdf, row, col);
+    }
+  }
+
+  PrintBench("sample", benchTimer, sdfImgWidth * sdfImgHeight);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+struct SDFSettings
+{
+  SDFSettings()
+    : m_width(0)
+    , m_kernelSize(10)
+    , m_invert(false)
+    , m_useEDT(false)
+    , m_format(g_formatRGBA)
+  { }
+
+  tl_int  m_width; // 0 keeps the source dimensions
+  tl_int  m_kernelSize;
+  bool    m_invert;
+  bool    m_useEDT;
+  tl_int  m_format; // g_formatRGBA or a RawDistanceFieldHeader format
+};
+
+void
+GetSDF(const gfx_med::image_sptr& a_img, const SDFSettings& a_settings, 
+       SDFOutput& a_sdf)
+{
+  auto sdfDim = a_img->GetDimensions(); 
+  if (a_settings.m_width > 0)
+  {
+    sdfDim = gfx_t::f_dimension::ModifyAndKeepRatioX
+      (a_img->GetDimensions(), a_settings.m_width);
+  }
+
+  a_sdf.Create(core_utils::CastNumber<tl_int>(sdfDim[0]), 
+               core_utils::CastNumber<tl_int>(sdfDim[1]), 
+               a_settings.m_format, a_settings.m_kernelSize);
+
+  if (a_settings.m_useEDT)
+  { GetSDFFromCharImageEDT(a_img, a_sdf, a_settings.m_kernelSize, a_settings.m_invert); }
+  else
+  { GetSDFFromCharImage(a_img, a_sdf, a_settings.m_kernelSize, a_settings.m_invert); }
+}
+
+// always RGBA, used by the batch and atlas modes
+gfx_med::image_sptr
+GetSDF(const gfx_med::image_sptr& a_img, const SDFSettings& a_settings)
+{
+  SDFSettings settings = a_settings;
+  settings.m_format = g_formatRGBA;
+
+  SDFOutput sdf;
+  GetSDF(a_img, settings, sdf);
+
+  return sdf.GetImage();
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Streaming mode for masks that do not fit in memory. The source is read in
+// horizontal bands with a halo of (kernel + box filter) rows above and below
+// and the output is written band by band, so memory use depends on the band
+// height and the image width only. ImageLoaderPng and SaveImage work on whole
+// images, the input is therefore an 8 bit binary PGM and the output a PAM
+// (RGBA) or one of the raw formats. All of them are trivial to stream.
+
+namespace {
+
+  // reads one ASCII value of a PNM header, skipping whitespace and comments
+  bool
+    DoReadPnmValue(FILE* a_file, tl_int& a_value)
+  {
+    tl_int c = fgetc(a_file);
+    while (c == '#' || c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    {
+      if (c == '#')
+      { while (c != EOF && c != '\n') { c = fgetc(a_file); } }
+      c = fgetc(a_file);
+    }
+
+    if (c < '0' || c > '9')
+    { return false; }
+
+    // the single whitespace after the value is consumed as well
+    a_value = 0;
+    while (c >= '0' && c <= '9')
+    {
+      a_value = a_value * 10 + (c - '0');
+      c = fgetc(a_file);
+    }
+
+    return true;
+  }
+
+};
+
+tl_int
+GetSDFStreamed(const core_str::String& a_inFile, const core_str::String& a_outFile,
+               const SDFSettings& a_settings, tl_int a_bandHeight,
+               gfx_t::Color a_inCol = gfx_t::Color(240, 240, 240, 255))
+{
+  FILE* inFile = fopen(a_inFile.c_str(), "rb");
+  if (inFile == nullptr)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not load " << a_inFile;
+    return 1;
+  }
+
+  tl_int imgWidth = 0, imgHeight = 0, maxValue = 0;
+  const bool isPgm = fgetc(inFile) == 'P' && fgetc(inFile) == '5' &&
+    DoReadPnmValue(inFile, imgWidth) && DoReadPnmValue(inFile, imgHeight) &&
+    DoReadPnmValue(inFile, maxValue) && maxValue == 255 && 
+    imgWidth > 0 && imgHeight > 0;
+
+  if (isPgm == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << a_inFile << " is not an 8 bit binary PGM";
+    fclose(inFile);
+    return 1;
+  }
+
+  tl_int sdfImgWidth = imgWidth;
+  tl_int sdfImgHeight = imgHeight;
+  if (a_settings.m_width > 0)
+  {
+    const auto sdfDim = gfx_t::f_dimension::ModifyAndKeepRatioX
+      (core_ds::MakeTuple( (tl_size)imgWidth, (tl_size)imgHeight), a_settings.m_width);
+    sdfImgWidth = core_utils::CastNumber<tl_int>(sdfDim[0]);
+    sdfImgHeight = core_utils::CastNumber<tl_int>(sdfDim[1]);
+  }
+
+  FILE* outFile = fopen(a_outFile.c_str(), "wb");
+  if (outFile == nullptr)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not create " << a_outFile;
+    fclose(inFile);
+    return 1;
+  }
+
+  if (a_settings.m_format == g_formatRGBA)
+  {
+    fprintf(outFile, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\n"
+                     "TUPLTYPE RGB_ALPHA\nENDHDR\n", sdfImgWidth, sdfImgHeight);
+  }
+  else if (DoWriteRawHeader(outFile, a_settings.m_format, sdfImgWidth, 
+                            sdfImgHeight, a_settings.m_kernelSize) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not write " << a_outFile;
+    fclose(inFile);
+    fclose(outFile);
+    return 1;
+  }
+
+  const auto widthRatio = (tl_float) imgWidth / (tl_float) sdfImgWidth;
+  const auto heightRatio = (tl_float) imgHeight / (tl_float) sdfImgHeight;
+
+  // same box size as GetCoverageFromImg
+  const tl_int kernelSize = a_settings.m_kernelSize;
+  const tl_int halfHeight = core::tlMax((tl_int)(heightRatio + 0.5f) - 1, 0);
+  const tl_int halo = kernelSize + halfHeight;
+
+  const auto taps = GetSortedKernelTaps(kernelSize, imgWidth);
+
+  // source rows [windowBegin, windowEnd) of the input file
+  core_conts::Array<u8> window;
+  core_conts::Array<u8> skippedRow(imgWidth);
+  SDFOutput             sdfBand;
+  tl_int                windowBegin = 0, windowEnd = 0;
+
+  bool readFailed = false;
+  bool writeFailed = false;
+
+  if (g_perImageOutput)
+  { printf("\n"); PrintProgress(0, sdfImgHeight); }
+
+  for (tl_int bandBegin = 0; 
+       bandBegin < sdfImgHeight && readFailed == false && writeFailed == false; 
+       bandBegin += a_bandHeight)
+  {
+    const tl_int bandEnd = core::tlMin(bandBegin + a_bandHeight, sdfImgHeight);
+
+    const tl_int srcBegin = 
+      core::tlMax( (tl_int)( (tl_float)bandBegin * heightRatio ) - halo, 0);
+    const tl_int srcEnd = 
+      core::tlMin( (tl_int)( (tl_float)(bandEnd - 1) * heightRatio ) + 1 + halo, imgHeight);
+
+    // -----------------------------------------------------------------------
+    // slide the window: keep the rows shared with the previous band, skip the
+    // rows no band needs and read the new ones
+
+    tl_int readBegin = srcBegin;
+    if (windowEnd > srcBegin)
+    {
+      const tl_int numKept = windowEnd - srcBegin;
+      memmove(&window[0], &window[(srcBegin - windowBegin) * imgWidth], 
+              numKept * imgWidth);
+      readBegin = windowEnd;
+    }
+
+    for (tl_int row = windowEnd; row < srcBegin; ++row)
+    { readFailed |= fread(&skippedRow[0], 1, imgWidth, inFile) != (tl_size)imgWidth; }
+
+    window.resize( (srcEnd - srcBegin) * imgWidth);
+
+    const tl_size numBytes = (srcEnd - readBegin) * imgWidth;
+    if (numBytes > 0)
+    {
+      readFailed |= fread(&window[(readBegin - srcBegin) * imgWidth], 1, 
+                          numBytes, inFile) != numBytes;
+    }
+
+    windowBegin = srcBegin;
+    windowEnd = srcEnd;
+
+    // -----------------------------------------------------------------------
+    // the coverage and EDT passes run on the window as a (short) image
+
+    const tl_int bandImgHeight = srcEnd - srcBegin;
+
+    const auto coverage = GetCoverageFromGray
+      (&window[0], imgWidth, bandImgHeight, widthRatio, heightRatio, 
+       a_settings.m_invert, a_inCol);
+
+    index_cont nearest;
+    if (a_settings.m_useEDT)
+    {
+      nearest.resize(imgWidth * bandImgHeight, g_noSite);
+      DoFindNearestSites(coverage, imgWidth, bandImgHeight, 0, nearest);
+      DoFindNearestSites(coverage, imgWidth, bandImgHeight, 1, nearest);
+    }
+
+    // -----------------------------------------------------------------------
+    // the halo holds every pixel within a kernel of the band, the result is
+    // identical to processing the whole image at once
+
+    sdfBand.Create(sdfImgWidth, bandEnd - bandBegin, a_settings.m_format, kernelSize);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(g_numOpenMPThreads)
+    for (tl_int col = bandBegin; col < bandEnd; col++)
+    {
+      const auto imgCol = (tl_int) ( (tl_float) col * heightRatio ) - srcBegin;
+
+      for (tl_int row = 0; row < sdfImgWidth; row++)
+      {
+        const auto imgRow = (tl_int) ( (tl_float) row * widthRatio );
+
+        if (a_settings.m_useEDT)
+        {
+          DoSetSDFPixelEDT(coverage, nearest, imgRow, imgCol, imgWidth, 
+                           kernelSize, sdfBand, row, col - bandBegin);
+        }
+        else
+        {
+          DoSetSDFPixel(coverage, taps, imgRow, imgCol, imgWidth, bandImgHeight,
+                        kernelSize, sdfBand, row, col - bandBegin);
+        }
+      }
+    }
+
+    writeFailed |= sdfBand.WriteSamples(outFile) == false;
+    PrintProgress(bandEnd, sdfImgHeight);
+  }
+
+  fclose(inFile);
+  fclose(outFile);
+
+  if (readFailed)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << a_inFile << " is truncated";
+    return 1;
+  }
+
+  if (writeFailed)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not write " << a_outFile;
+    return 1;
+  }
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Batch mode
+
+namespace {
+
+  typedef core_conts::Array<core_io::Path>        path_cont;
+  typedef core_conts::Array<gfx_med::image_sptr>  image_cont;
+  typedef core_conts::Array<core_str::String>     name_cont;
+
+  const tl_int g_atlasPadding = 1;
+
+};
+
+void
+GetPngFilesInFolder(const core_str::String& a_folder, path_cont& a_out)
+{
+#if defined (TLOC_OS_WIN)
+  _finddata_t fileInfo;
+  const core_str::String filter = a_folder + "/*.png";
+
+  const intptr_t handle = _findfirst(filter.c_str(), &fileInfo);
+  if (handle == -1)
+  { return; }
+
+  do
+  {
+    if ( (fileInfo.attrib & _A_SUBDIR) == 0)
+    { a_out.push_back(core_io::Path(a_folder + "/" + fileInfo.name)); }
+  } while (_findnext(handle, &fileInfo) == 0);
+
+  _findclose(handle);
+#else
+  DIR* dir = opendir(a_folder.c_str());
+  if (dir == nullptr)
+  { return; }
+
+  while (dirent* entry = readdir(dir))
+  {
+    const char* ext = strrchr(entry->d_name, '.');
+    if (ext && strcmp(ext, ".png") == 0)
+    { a_out.push_back(core_io::Path(a_folder + "/" + entry->d_name)); }
+  }
+
+  closedir(dir);
+#endif
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+bool
+FolderExists(const core_str::String& a_folder)
+{
+#if defined (TLOC_OS_WIN)
+  struct _stat info;
+  return _stat(a_folder.c_str(), &info) == 0 && (info.st_mode & _S_IFDIR) != 0;
+#else
+  struct stat info;
+  return stat(a_folder.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// A manifest lists one PNG per line. Empty lines and lines starting with '#'
+// are ignored.
+
+bool
+GetPngFilesFromManifest(const core_io::Path& a_manifest, path_cont& a_out)
+{
+  core_io::FileIO_ReadA file(a_manifest);
+  if (file.Open() != ErrorSuccess)
+  { return false; }
+
+  core_str::String contents;
+  file.GetContents(contents);
+
+  tl_size lineBegin = 0;
+  while (lineBegin < contents.length())
+  {
+    tl_size lineEnd = lineBegin;
+    while (lineEnd < contents.length() && contents[lineEnd] != '\n')
+    { ++lineEnd; }
+
+    tl_size trimmedEnd = lineEnd;
+    while (trimmedEnd > lineBegin && 
+           (contents[trimmedEnd - 1] == '\r' || contents[trimmedEnd - 1] == ' '))
+    { --trimmedEnd; }
+
+    if (trimmedEnd > lineBegin && contents[lineBegin] != '#')
+    {
+      a_out.push_back(core_io::Path
+        (contents.substr(lineBegin, trimmedEnd - lineBegin)));
+    }
+
+    lineBegin = lineEnd + 1;
+  }
+
+  return true;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Shelf packer: images are sorted by height and placed left to right, a new
+// shelf is started when the current one is full. The atlas width is the
+// smallest power of two that can hold all images in a square-ish layout.
+// The metadata uses the SpriteSheetPacker format (name = x y w h) so that the
+// atlas can be loaded with gfx_med::SpriteLoader_SpriteSheetPacker.
+
+bool
+SaveAtlas(const image_cont& a_sdfs, const name_cont& a_names, 
+          gfx_t::Color a_background, const core_str::String& a_atlasFile)
+{
+  const tl_int numImages = core_utils::CastNumber<tl_int>(a_sdfs.size());
+
+  index_cont order;
+  tl_size    totalArea = 0;
+  tl_int     maxWidth = 0;
+  for (tl_int i = 0; i < numImages; ++i)
+  {
+    if (a_sdfs[i] == nullptr) { continue; }
+
+    order.push_back(i);
+
+    const auto w = core_utils::CastNumber<tl_int>(a_sdfs[i]->GetWidth()) + g_atlasPadding;
+    const auto h = core_utils::CastNumber<tl_int>(a_sdfs[i]->GetHeight()) + g_atlasPadding;
+    totalArea += w * h;
+    maxWidth = core::tlMax(maxWidth, w);
+  }
+
+  if (order.empty())
+  { return false; }
+
+  // insertion sort, tallest first
+  for (tl_size i = 1; i < order.size(); ++i)
+  {
+    const tl_int curr = order[i];
+    tl_size j = i;
+    while (j > 0 && a_sdfs[order[j - 1]]->GetHeight() < a_sdfs[curr]->GetHeight())
+    { order[j] = order[j - 1]; --j; }
+    order[j] = curr;
+  }
+
+  tl_int atlasWidth = 1;
+  while (atlasWidth < maxWidth || (tl_size)(atlasWidth * atlasWidth) < totalArea)
+  { atlasWidth *= 2; }
+
+  index_cont posX(numImages, 0);
+  index_cont posY(numImages, 0);
+
+  tl_int shelfX = 0, shelfY = 0, shelfHeight = 0;
+  for (tl_size i = 0; i < order.size(); ++i)
+  {
+    const auto& img = a_sdfs[order[i]];
+    const auto w = core_utils::CastNumber<tl_int>(img->GetWidth()) + g_atlasPadding;
+    const auto h = core_utils::CastNumber<tl_int>(img->GetHeight()) + g_atlasPadding;
+
+    if (shelfX + w > atlasWidth)
+    {
+      shelfY += shelfHeight;
+      shelfX = 0;
+      shelfHeight = 0;
+    }
+
+    posX[order[i]] = shelfX;
+    posY[order[i]] = shelfY;
+
+    shelfX += w;
+    shelfHeight = core::tlMax(shelfHeight, h);
+  }
+
+  const tl_int atlasHeight = shelfY + shelfHeight;
+
+  gfx_med::Image atlas;
+  atlas.Create(core_ds::MakeTuple(atlasWidth, atlasHeight), a_background);
+
+  const tl_int numPacked = core_utils::CastNumber<tl_int>(order.size());
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(g_numOpenMPThreads)
+  for (tl_int i = 0; i < numPacked; ++i)
+  {
+    const auto& img = a_sdfs[order[i]];
+    const tl_int ox = posX[order[i]];
+    const tl_int oy = posY[order[i]];
+
+    for (tl_size y = 0; y < img->GetHeight(); ++y)
+    {
+      for (tl_size x = 0; x < img->GetWidth(); ++x)
+      { atlas.SetPixel(ox + x, oy + y, img->GetPixel(x, y)); }
+    }
+  }
+
+  if (gfx_med::f_image_loader::SaveImage(atlas, core_io::Path(a_atlasFile)) != ErrorSuccess)
+  { return false; }
+
+  core_str::String metadata;
+  for (tl_int i = 0; i < numImages; ++i)
+  {
+    if (a_sdfs[i] == nullptr) { continue; }
+
+    metadata += core_str::Format("%s = %d %d %d %d\n", 
+      a_names[i].c_str(), posX[i], posY[i], 
+      (tl_int)a_sdfs[i]->GetWidth(), (tl_int)a_sdfs[i]->GetHeight());
+  }
+
+  core_io::FileIO_WriteA metaFile(core_io::Path(a_atlasFile + ".txt"));
+  if (metaFile.Open() != ErrorSuccess)
+  { return false; }
+
+  return metaFile.Write(metadata) == ErrorSuccess;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Outputs (and atlas entries) are named after the input's file name only, two
+// inputs with the same name in different folders would overwrite each other.
+
+bool
+CheckUniqueNames(const path_cont& a_inFiles, const name_cont& a_names)
+{
+  for (tl_size i = 0; i < a_names.size(); ++i)
+  {
+    for (tl_size j = i + 1; j < a_names.size(); ++j)
+    {
+      if (a_names[i] == a_names[j])
+      {
+        TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << a_inFiles[i] << " and " 
+          << a_inFiles[j] << " would both be written as " << a_names[i];
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Every thread runs the full decode -> SDF -> encode pipeline on its own
+// image, so the three stages of different images overlap. The per image
+// OpenMP regions are nested and therefore run on the calling thread only.
+
+tl_int
+ProcessBatch(const path_cont& a_inFiles, const SDFSettings& a_settings,
+             const core_str::String& a_outFolder, 
+             const core_str::String& a_atlasFile)
+{
+  const bool   packAtlas = a_atlasFile.length() > 0;
+  const tl_int numFiles = core_utils::CastNumber<tl_int>(a_inFiles.size());
+
+  if (packAtlas == false && FolderExists(a_outFolder) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Output folder " << a_outFolder 
+      << " does not exist";
+    return 1;
+  }
+
+  name_cont names;
+  for (tl_int i = 0; i < numFiles; ++i)
+  { names.push_back(a_inFiles[i].GetFileNameWithoutExtension()); }
+
+  if (CheckUniqueNames(a_inFiles, names) == false)
+  { return 1; }
+
+  image_cont sdfs(packAtlas ? numFiles : 0);
+
+  tl_int numDone = 0;
+  tl_int numFailed = 0;
+
+  f64    decodeSec = 0, sdfSec = 0, encodeSec = 0;
+  f64    numSrcPixels = 0, numSdfPixels = 0;
+
+  g_perImageOutput = false;
+
+  core_time::Timer batchTimer;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(g_numOpenMPThreads)
+  for (tl_int i = 0; i < numFiles; ++i)
+  {
+    core_time::Timer stageTimer;
+
+    gfx_med::ImageLoaderPng il;
+    if (il.Load(a_inFiles[i]) == ErrorFailure)
+    {
+#pragma omp critical
+      { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not load " << a_inFiles[i]; }
+
+#pragma omp atomic
+      numFailed++;
+      continue;
+    }
+
+    const f64 decodeTime = stageTimer.ElapsedSeconds();
+    stageTimer.Reset();
+
+    auto_cref imgPtr = il.GetImage();
+    auto sdfImg = GetSDF(imgPtr, a_settings);
+
+    const f64 sdfTime = stageTimer.ElapsedSeconds();
+    stageTimer.Reset();
+
+    if (packAtlas)
+    { sdfs[i] = sdfImg; }
+    else
+    {
+      core_io::Path outFile(core_str::Format("%s/%s_sdf.png", a_outFolder.c_str(),
+        names[i].c_str()));
+      if (gfx_med::f_image_loader::SaveImage(*sdfImg, outFile) != ErrorSuccess)
+      {
+#pragma omp critical
+        { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save " << outFile; }
+
+#pragma omp atomic
+        numFailed++;
+        continue;
+      }
+    }
+
+    const f64 encodeTime = stageTimer.ElapsedSeconds();
+
+#pragma omp atomic
+    decodeSec += decodeTime;
+#pragma omp atomic
+    sdfSec += sdfTime;
+#pragma omp atomic
+    encodeSec += encodeTime;
+#pragma omp atomic
+    numSrcPixels += (f64)(imgPtr->GetWidth() * imgPtr->GetHeight());
+#pragma omp atomic
+    numSdfPixels += (f64)(sdfImg->GetWidth() * sdfImg->GetHeight());
+#pragma omp atomic
+    numDone++;
+
+    if (omp_get_thread_num() == 0)
+    {
+      printf("\r%d/%d images", ReadProgress(numDone), numFiles);
+    }
+  }
+
+  printf("\r%d/%d images", numFiles - numFailed, numFiles);
+
+  if (packAtlas)
+  {
+    // the background is 'outside' at the maximum distance
+    const auto kernelSizef32 = (tl_float)a_settings.m_kernelSize;
+    const auto background = 
+      EncodeSDFPixel(math_t::Vec2f32(kernelSizef32), kernelSizef32, kernelSizef32);
+
+    core_time::Timer atlasTimer;
+    if (SaveAtlas(sdfs, names, background, a_atlasFile) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save atlas " << a_atlasFile;
+      return 1;
+    }
+    encodeSec += atlasTimer.ElapsedSeconds();
+  }
+
+  const f64 totalSec = batchTimer.ElapsedSeconds();
+  printf("\nTime to process %d images: %f sec", numFiles, totalSec);
+
+  if (g_bench)
+  {
+    // stage times are summed over all threads
+    printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", "decode", decodeSec, 
+           decodeSec > 0 ? numSrcPixels / 1000000.0 / decodeSec : 0.0);
+    printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", "sdf", sdfSec, 
+           sdfSec > 0 ? numSdfPixels / 1000000.0 / sdfSec : 0.0);
+    printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", "encode", encodeSec, 
+           encodeSec > 0 ? numSdfPixels / 1000000.0 / encodeSec : 0.0);
+    printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", "total", totalSec, 
+           totalSec > 0 ? numSdfPixels / 1000000.0 / totalSec : 0.0);
+  }
+
+  return numFailed > 0 ? 1 : 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Font mode: multi-channel SDFs computed from the glyph outlines instead of a
+// rasterized image, glyphs are spread over the threads. Every glyph is
+// rendered at a_size pixels per em with a_range pixels of padding. Next to
+// the atlas, <atlas>.glyphs.txt lists the advance and the offset from the pen
+// position (on the baseline) to the top left corner of each sprite.
+
+tl_int
+GenerateFontAtlas(const core_io::Path& a_fontFile, const core_str::String& a_glyphs,
+                  tl_int a_size, tl_int a_range, const core_str::String& a_atlasFile)
+{
+  core_io::FileIO_ReadB rb(a_fontFile);
+  if (rb.Open() != ErrorSuccess)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not load " << a_fontFile;
+    return 1;
+  }
+
+  core_str::String fontContents;
+  rb.GetContents(fontContents);
+
+  TrueTypeFont font;
+  if (font.Initialize(fontContents) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << a_fontFile << " is not a TrueType "
+      << "font (OpenType fonts with CFF outlines are not supported)";
+    return 1;
+  }
+
+  const tl_int numGlyphs = core_utils::CastNumber<tl_int>(a_glyphs.length());
+  const f64    scale = (f64)a_size / (f64)font.GetUnitsPerEm();
+  const f64    range = (f64)a_range;
+
+  core_conts::Array<GlyphOutline> outlines(numGlyphs);
+  image_cont                      msdfs(numGlyphs);
+
+  tl_int numDone = 0;
+  f64    numPixels = 0;
+
+  core_time::Timer msdfTimer;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(g_numOpenMPThreads)
+  for (tl_int i = 0; i < numGlyphs; ++i)
+  {
+    GlyphOutline& outline = outlines[i];
+
+    const u32 charCode = (u8)a_glyphs[i];
+    if (font.GetGlyphOutline(font.GetGlyphIndex(charCode), outline) &&
+        outline.m_contours.empty() == false)
+    {
+      ColorOutlineEdges(outline);
+
+      // the extra pixel covers the fractional part of the bounding box
+      const tl_int width = 
+        (tl_int)( (outline.m_xMax - outline.m_xMin) * scale) + 1 + 2 * a_range;
+      const tl_int height = 
+        (tl_int)( (outline.m_yMax - outline.m_yMin) * scale) + 1 + 2 * a_range;
+
+      msdf_cont pixels;
+      GenerateMSDF(outline, scale, -outline.m_xMin + range / scale, 
+                   -outline.m_yMin + range / scale, range, width, height, pixels);
+
+      auto msdfImg = core_sptr::MakeShared<gfx_med::Image>();
+      msdfImg->Create(core_ds::MakeTuple(width, height), gfx_t::Color::COLOR_BLACK);
+
+      for (tl_int y = 0; y < height; ++y)
+      {
+        for (tl_int x = 0; x < width; ++x)
+        {
+          const u8* p = &pixels[(x + y * width) * 4];
+          msdfImg->SetPixel(x, y, gfx_t::Color(p[0], p[1], p[2], p[3]));
+        }
+      }
+
+      msdfs[i] = msdfImg;
+
+#pragma omp atomic
+      numPixels += (f64)(width * height);
+    }
+
+#pragma omp atomic
+    numDone++;
+
+    if (omp_get_thread_num() == 0)
+    {
+      PrintProgress(ReadProgress(numDone), numGlyphs);
+    }
+  }
+
+  PrintProgress(numGlyphs, numGlyphs);
 
-using namespace tloc;
+  const f64 msdfSec = msdfTimer.ElapsedSeconds();
+  printf("\nTime to calculate MSDF for %d glyphs: %f sec", numGlyphs, msdfSec);
 
-namespace {
+  if (g_bench)
+  {
+    printf("\n[bench] %-10s %10.4f sec %10.2f MP/s", "msdf", msdfSec, 
+           msdfSec > 0 ? numPixels / 1000000.0 / msdfSec : 0.0);
+  }
 
-  core_io::Path g_inFile("invalid_filename");
-  core_io::Path g_outFile("sdf_out.png");
+  name_cont         names;
+  core_str::String  metrics("# name = advance offsetX offsetY (pixels)\n");
+  for (tl_int i = 0; i < numGlyphs; ++i)
+  {
+    const GlyphOutline& outline = outlines[i];
 
-  tl_int g_numOpenMPThreads = 4;
-};
+    names.push_back(core_str::Format("char_%u", (u32)(u8)a_glyphs[i]));
 
-class WindowCallback
-{
-public:
-  WindowCallback()
-    : m_endProgram(false)
-  { }
+    const f64 offsetX = outline.m_xMin * scale - range;
+    const f64 offsetY = msdfs[i] 
+      ? outline.m_yMin * scale - range + (f64)msdfs[i]->GetHeight() 
+      : 0.0;
 
-  core_dispatch::Event 
-    OnWindowEvent(const gfx_win::WindowEvent& a_event)
+    metrics += core_str::Format("%s = %.3f %.3f %.3f\n", names.back().c_str(),
+      outline.m_advance * scale, offsetX, offsetY);
+  }
+
+  // the background is 'outside' at the maximum distance on all channels
+  if (SaveAtlas(msdfs, names, gfx_t::Color::COLOR_WHITE, a_atlasFile) == false)
   {
-    if (a_event.m_type == gfx_win::WindowEvent::close)
-    { m_endProgram = true; }
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save atlas " << a_atlasFile;
+    return 1;
+  }
 
-    return core_dispatch::f_event::Continue();
+  core_io::FileIO_WriteA metricsFile(core_io::Path(a_atlasFile + ".glyphs.txt"));
+  if (metricsFile.Open() != ErrorSuccess || metricsFile.Write(metrics) != ErrorSuccess)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save glyph metrics for " 
+      << a_atlasFile;
+    return 1;
   }
 
-  bool  m_endProgram;
-};
-TLOC_DEF_TYPE(WindowCallback);
+  return 0;
+}
 
 // xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Mesh mode: a signed distance volume baked from all the groups of an OBJ
+// mesh (see distanceVolume.h). The longest side of the mesh bounds gets
+// a_resolution voxels minus a_range voxels of padding on each side. u16 and
+// f32 write a .tldf volume (distances in voxels), rgba builds an Image3D with
+// the surface normal in RGB and the distance in A and writes its Z slices
+// stacked in one PNG (width x height * depth), see tlocVolumetric.
+// <file>.txt holds the origin and the voxel size that map world positions
+// to voxels.
 
 gfx_t::Color
-EncodeDistanceToColor(tl_float a_distance)
+EncodeVolumeVoxel(const f32 a_normal[3], tl_float a_distance, tl_float a_range)
 {
-  return gfx_t::Color(a_distance, 0.0f, 0.0f, 1.0f);
+  using namespace math;
+
+  auto vec = math_t::Vec4f32(a_normal[0] * a_range, a_normal[1] * a_range, 
+                             a_normal[2] * a_range, a_distance);
+  auto voxelColor = gfx_t::f_color::Encode
+    (vec, MakeRangef<f32, p_range::Inclusive>().Get(-a_range, a_range));
+
+  return gfx_t::Color(voxelColor);
 }
 
-// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// -----------------------------------------------------------------------
 
-gfx_t::Color
-GetAverageColorFromImg(const gfx_med::image_sptr& a_charImg, tl_int currRow, tl_int currCol,
-tl_float widthRatio, tl_float heightRatio)
-{
-  const tl_float startingRow = core::Clamp(currRow - ( widthRatio - 1.0f ), 0.0f, (tl_float) a_charImg->GetWidth());
-  const tl_float startingCol = core::Clamp(currCol - ( heightRatio - 1.0f ), 0.0f, (tl_float) a_charImg->GetHeight());
+namespace {
+
+  // normalized central differences, one sided at the borders
+  void
+    DoGetVolumeNormal(const dv_volume_cont& a_volume, const tl_int a_dim[3],
+                      tl_int a_x, tl_int a_y, tl_int a_z, f32 a_normal[3])
+  {
+    const tl_int pos[3] = { a_x, a_y, a_z };
+    const tl_int stride[3] = { 1, a_dim[0], a_dim[0] * a_dim[1] };
+    const tl_int index = a_x + a_y * stride[1] + a_z * stride[2];
+
+    f32 length = 0.0f;
+    for (tl_int axis = 0; axis < 3; ++axis)
+    {
+      const tl_int prev = pos[axis] > 0 ? index - stride[axis] : index;
+      const tl_int next = pos[axis] < a_dim[axis] - 1 ? index + stride[axis] : index;
+
+      a_normal[axis] = a_volume[next] - a_volume[prev];
+      length += a_normal[axis] * a_normal[axis];
+    }
 
-  const tl_float endingRow = core::Clamp(currRow + ( widthRatio - 1.0f ), 0.0f, (tl_float) a_charImg->GetWidth());
-  const tl_float endingCol = core::Clamp(currCol + ( heightRatio - 1.0f ), 0.0f, (tl_float) a_charImg->GetHeight());
+    length = sqrt(length);
+    for (tl_int axis = 0; axis < 3; ++axis)
+    { a_normal[axis] = length > 0.0f ? a_normal[axis] / length : 0.0f; }
+  }
+
+};
 
-  tl_int avgColor = a_charImg->GetPixel(currRow, currCol)[0];
+// -----------------------------------------------------------------------
+// Encodes every Z slice of a baked volume (see EncodeVolumeVoxel) and copies
+// them into a_out. The slices are kept in a_slices for saving.
 
-  tl_int avgCount = 0;
+void
+GetVolumeImage(const dv_volume_cont& a_volume, const tl_int a_dim[3], 
+               tl_float a_range, image_cont& a_slices, gfx_med::Image3D& a_out)
+{
+  a_slices.resize(a_dim[2]);
 
-  for (tl_int row = (tl_int)startingRow; row < (tl_int)endingRow; ++row)
+#pragma omp parallel for num_threads(g_numOpenMPThreads)
+  for (tl_int z = 0; z < a_dim[2]; ++z)
   {
-    for (tl_int col = (tl_int)startingCol; col < (tl_int)endingCol; ++col)
+    auto slice = core_sptr::MakeShared<gfx_med::Image>();
+    slice->Create(core_ds::MakeTuple(a_dim[0], a_dim[1]), gfx_t::Color::COLOR_WHITE);
+
+    for (tl_int y = 0; y < a_dim[1]; ++y)
     {
-      if (row == currRow && col == currCol)
-      { continue; }
+      for (tl_int x = 0; x < a_dim[0]; ++x)
+      {
+        f32 normal[3];
+        DoGetVolumeNormal(a_volume, a_dim, x, y, z, normal);
 
-      avgColor += a_charImg->GetPixel(row, col)[0];
-      avgCount++;
+        const f32 distance = a_volume[x + (y + (tl_size)z * a_dim[1]) * a_dim[0]];
+        slice->SetPixel(x, y, EncodeVolumeVoxel(normal, distance, a_range));
+      }
     }
+
+    a_slices[z] = slice;
   }
 
-  if (avgCount > 0)
-  { avgColor = avgColor / (tl_int) ( avgCount + 1 ); }
+  a_out.Create(core_ds::MakeTuple(a_dim[0], a_dim[1], a_dim[2]), 
+               gfx_t::Color::COLOR_WHITE);
+  for (tl_int z = 0; z < a_dim[2]; ++z)
+  { a_out.SetImage(0, 0, z, *a_slices[z]); }
+}
 
-  auto avgColorU8 = core_utils::CastNumber<u8>(avgColor);
+tl_int
+GenerateMeshVolume(const core_io::Path& a_meshFile, tl_int a_resolution,
+                   tl_int a_range, tl_int a_format, const core_str::String& a_volumeFile)
+{
+  core_io::FileIO_ReadA objFile(a_meshFile);
+  if (objFile.Open() != ErrorSuccess)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not load " << a_meshFile;
+    return 1;
+  }
 
-  return gfx_t::Color(avgColorU8, avgColorU8, avgColorU8, avgColorU8);
-}
+  core_str::String objFileContents;
+  objFile.GetContents(objFileContents);
 
-// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+  gfx_med::ObjLoader objLoader;
+  if (objLoader.Init(objFileContents) != ErrorSuccess)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Parsing errors in " << a_meshFile;
+    return 1;
+  }
 
-gfx_med::image_sptr
-GetSDFFromCharImage(gfx_med::image_sptr a_charImg, gfx_t::Dimension2 a_sdfDim, 
-                    tl_int a_kernelSize, bool a_invert = false,
-                    gfx_t::Color a_inCol = gfx_t::Color(240, 240, 240, 255), 
-                    gfx_t::Color a_outCol = gfx_t::Color(0, 0, 0, 255))
-{
-  const tl_int kernelSize = a_kernelSize;
+  dv_triangle_cont triangles;
+  for (tl_size g = 0; g < objLoader.GetNumGroups(); ++g)
+  {
+    gfx_med::ObjLoader::vert_cont_type vertices;
+    objLoader.GetUnpacked(vertices, g);
+
+    for (auto itr = vertices.begin(), itrEnd = vertices.end(); itr != itrEnd; ++itr)
+    {
+      const auto pos = itr->GetPosition();
+      triangles.push_back(pos[0]);
+      triangles.push_back(pos[1]);
+      triangles.push_back(pos[2]);
+    }
+  }
 
-  auto sdfImg = core_sptr::MakeShared<gfx_med::Image>();
-  sdfImg->Create(a_sdfDim, gfx_t::Color::COLOR_BLACK);
+  core_time::Timer benchTimer;
 
-  const auto imgWidth = core_utils::CastNumber<tl_int>(a_charImg->GetWidth());
-  const auto imgHeight = core_utils::CastNumber<tl_int>(a_charImg->GetHeight());
+  TriangleBVH bvh;
+  bvh.Initialize(triangles);
+  if (bvh.GetNumTriangles() == 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << a_meshFile << " does not have any triangles";
+    return 1;
+  }
 
-  const auto sdfImgWidth = core_utils::CastNumber<tl_int>(sdfImg->GetWidth());
-  const auto sdfImgHeight = core_utils::CastNumber<tl_int>(sdfImg->GetHeight());
+  PrintBench("bvh", benchTimer, bvh.GetNumTriangles());
 
-  const auto widthRatio = (tl_float) imgWidth / (tl_float) sdfImgWidth;
-  const auto heightRatio = (tl_float) imgHeight / (tl_float) sdfImgHeight;
+  // -----------------------------------------------------------------------
+  // grid, centered on the mesh
 
-  const auto outColor = a_outCol;
-  const auto inColor = a_inCol;
+  f32 boundsMin[3], boundsMax[3];
+  bvh.GetBounds(boundsMin, boundsMax);
 
-  printf("\n0%%|                                                                                                    |100%%");
+  f32 maxExtent = 0.0f;
+  for (tl_int axis = 0; axis < 3; ++axis)
+  { maxExtent = core::tlMax(maxExtent, boundsMax[axis] - boundsMin[axis]); }
 
-  tl_int dashCount = 0;
+  const tl_int interior = core::tlMax(a_resolution - 2 * a_range, 1);
+  const f32    voxelSize = maxExtent > 0.0f ? maxExtent / (f32)interior : 1.0f;
 
-#pragma omp parallel for shared(dashCount) num_threads(g_numOpenMPThreads)
-  for (tl_int row = 0; row < sdfImgWidth; row++)
+  tl_int dim[3];
+  f32    origin[3];
+  for (tl_int axis = 0; axis < 3; ++axis)
   {
-    for (tl_int col = 0; col < sdfImgHeight; col++)
-    {
-#pragma omp atomic
-      dashCount++;
+    const f32 extent = boundsMax[axis] - boundsMin[axis];
+    dim[axis] = core::tlMin( (tl_int)ceil(extent / voxelSize), interior) + 2 * a_range;
+    dim[axis] = core::tlMax(dim[axis], 1);
 
-      const auto imgRow = (tl_int) ( (tl_float) row * widthRatio );
-      const auto imgCol = (tl_int) ( (tl_float) col * heightRatio );
-      auto currCol = GetAverageColorFromImg(a_charImg, imgRow, imgCol, widthRatio, heightRatio);
+    origin[axis] = (boundsMin[axis] + boundsMax[axis]) * 0.5f - 
+                   (f32)dim[axis] * voxelSize * 0.5f;
+  }
 
-      if (a_invert) { currCol = gfx_t::Color::COLOR_WHITE - currCol; }
+  const tl_size numVoxels = (tl_size)dim[0] * dim[1] * dim[2];
 
-      const bool isInColor = currCol[0] >= inColor[0];
+  // -----------------------------------------------------------------------
+  // bake
 
-      const auto kernelSizef32 = (tl_float)kernelSize;
-      auto  disToEdge = kernelSizef32;
+  omp_set_num_threads(g_numOpenMPThreads);
 
-      auto  vecToPixel = isInColor ? math_t::Vec2f32(-kernelSizef32) : math_t::Vec2f32(kernelSizef32);
-      bool  disFromInside = false;
+  core_time::Timer bakeTimer;
 
-      for (tl_int kRow = -kernelSize; kRow <= kernelSize; ++kRow)
-      {
-        for (tl_int kCol = -kernelSize; kCol <= kernelSize; ++kCol)
-        {
-          if (imgRow + kRow < 0 || imgCol + kCol < 0) { continue; }
-          if (imgRow + kRow >= imgWidth || imgCol + kCol >= imgHeight) { continue; }
-          //if (kRow == 0 && kCol == 0) { continue; }
+  dv_volume_cont volume;
+  BakeDistanceVolume(bvh, origin, voxelSize, dim[0], dim[1], dim[2], volume);
 
-          const auto destRow = core::Clamp(imgRow + kRow, 0, imgWidth - 1);
-          const auto destCol = core::Clamp(imgCol + kCol, 0, imgHeight - 1);
-          const auto destColor = GetAverageColorFromImg(a_charImg, destRow, destCol, widthRatio, heightRatio);
+  printf("\nTime to bake a %dx%dx%d volume from %d triangles: %f sec", 
+         dim[0], dim[1], dim[2], bvh.GetNumTriangles(), bakeTimer.ElapsedSeconds());
 
-          const auto xDisInPixels = math::Abs(kRow);
-          const auto yDisInPixels = math::Abs(kCol);
+  benchTimer.Reset();
+  PrintBench("bake", bakeTimer, numVoxels);
 
-          using math_utils::Pythagoras;
-          auto p = Pythagoras(Pythagoras::base((tl_float) xDisInPixels),
-                              Pythagoras::opposite((tl_float) yDisInPixels));
-          auto eucDis = p.GetSide<Pythagoras::hypotenuse>();
+  // -----------------------------------------------------------------------
+  // save
 
-          // we want a circular kernel
-          if (eucDis > kernelSize)
-          {
-            //eucDis = kernelSize;
-            continue;
-          }
+  bool saved = false;
+  if (a_format == g_formatRGBA)
+  {
+    image_cont       slices;
+    gfx_med::Image3D volumeImage;
+    GetVolumeImage(volume, dim, (tl_float)a_range, slices, volumeImage);
 
-          // if currCol is white (inside of the font color)
-          if (isInColor)
-          {
-            disFromInside = true;
-
-            // if the destination color is NOT white
-            if (destColor[0] < inColor[0])
-            { 
-              if (eucDis < disToEdge)
-              {
-                vecToPixel[0] = (tl_float) kRow;
-                vecToPixel[1] = (tl_float) kCol;
-              }
-              disToEdge = core::tlMin(eucDis, disToEdge);
-            }
-          }
-          else // we consider anything not pure white to be black
-          {
-            disFromInside = false;
-
-            // if the destination color is white
-            if (destColor[0] >= inColor[0])
-            { 
-              if (eucDis < disToEdge)
-              {
-                vecToPixel[0] = (tl_float) kRow;
-                vecToPixel[1] = (tl_float) kCol;
-              }
-              disToEdge = core::tlMin(eucDis, disToEdge);
-            }
-          }
-        }
+    gfx_med::Image stacked;
+    stacked.Create(core_ds::MakeTuple(dim[0], dim[1] * dim[2]), gfx_t::Color::COLOR_WHITE);
+
+    for (tl_int z = 0; z < dim[2]; ++z)
+    {
+      for (tl_int y = 0; y < dim[1]; ++y)
+      {
+        for (tl_int x = 0; x < dim[0]; ++x)
+        { stacked.SetPixel(x, y + z * dim[1], slices[z]->GetPixel(x, y)); }
       }
+    }
+
+    saved = gfx_med::f_image_loader::SaveImage
+      (stacked, core_io::Path(a_volumeFile)) == ErrorSuccess;
+  }
+  else
+  {
+    FILE* file = fopen(a_volumeFile.c_str(), "wb");
+    if (file != nullptr)
+    {
+      saved = DoWriteRawHeader(file, a_format, dim[0], dim[1], a_range, dim[2]);
 
-      using namespace math;
+      if (a_format == RawDistanceFieldHeader::k_formatU16)
+      {
+        core_conts::Array<u16> samples(numVoxels);
+        for (tl_size i = 0; i < numVoxels; ++i)
+        { samples[i] = EncodeDistanceU16(volume[i], (f32)a_range); }
 
-      disToEdge = disFromInside ? -disToEdge : disToEdge;
-      auto vec = math_t::Vec4f32(vecToPixel, disToEdge, kernelSizef32);
-      auto sdfColor = gfx_t::f_color::Encode(vec, MakeRangef<f32, p_range::Inclusive>().Get(-kernelSizef32, kernelSizef32));
+        saved = saved && 
+          fwrite(&samples[0], sizeof(u16), numVoxels, file) == numVoxels;
+      }
+      else
+      {
+        saved = saved && 
+          fwrite(&volume[0], sizeof(f32), numVoxels, file) == numVoxels;
+      }
 
-      sdfImg->SetPixel(row, col, gfx_t::Color(sdfColor));
+      fclose(file);
     }
+  }
 
-#pragma omp critical
+  if (saved == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save " << a_volumeFile;
+    return 1;
+  }
+
+  PrintBench("encode", benchTimer, numVoxels);
+
+  core_str::String metadata = core_str::Format
+    ("origin = %f %f %f\nvoxel_size = %f\ndimensions = %d %d %d\n",
+     origin[0], origin[1], origin[2], voxelSize, dim[0], dim[1], dim[2]);
+
+  core_io::FileIO_WriteA metaFile(core_io::Path(a_volumeFile + ".txt"));
+  if (metaFile.Open() != ErrorSuccess || metaFile.Write(metadata) != ErrorSuccess)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save volume metadata for " 
+      << a_volumeFile;
+    return 1;
+  }
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Incremental update benchmark: random 32x32 edits are stamped onto a
+// 2048x2048 mask (as fog of war or destructible terrain would) and only the
+// region of the DistanceField within a kernel of each edit is recomputed.
+
+namespace {
+
+  const tl_int g_benchMaskSize = 2048;
+  const tl_int g_benchStampSize = 32;
+  const tl_int g_benchNumBlobs = 4096;
+
+  void
+    DoStamp(DistanceField& a_df, tl_int a_x, tl_int a_y, tl_int a_size, 
+            bool a_inside)
+  {
+    const tl_int xEnd = core::tlMin(a_x + a_size, a_df.GetWidth());
+    const tl_int yEnd = core::tlMin(a_y + a_size, a_df.GetHeight());
+
+    for (tl_int y = a_y; y < yEnd; ++y)
     {
-      const f32 total = (f32)sdfImgWidth * (f32)sdfImgHeight;
-      const tl_int numDashes = (tl_int) ( (f32) dashCount * 100.0f / total );
+      for (tl_int x = a_x; x < xEnd; ++x)
+      { a_df.SetMaskValue(x, y, a_inside); }
+    }
+  }
+
+};
+
+tl_int
+BenchIncrementalSDF(tl_int a_numEdits, tl_int a_kernelSize)
+{
+  if (a_numEdits <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "--bench-dirty requires a positive number of edits";
+    return 1;
+  }
 
-      core_str::String dashes;
-      for (tl_int i = 0; i < numDashes; ++i)
-      { dashes += "-"; }
+  const tl_int size = g_benchMaskSize;
 
-      for (tl_int i = numDashes; i < 100; ++i)
-      { dashes += " "; }
+  // a mask with random blobs so that there are edges everywhere
+  df_mask_cont mask(size * size, 0);
+  for (tl_int i = 0; i < g_benchNumBlobs; ++i)
+  {
+    const tl_int blobSize = core_rng::g_defaultRNG.GetRandomInteger(8, 128);
+    const tl_int bx = core_rng::g_defaultRNG.GetRandomInteger(0, size - blobSize);
+    const tl_int by = core_rng::g_defaultRNG.GetRandomInteger(0, size - blobSize);
 
-      printf("\r0%%|%s|100%%", dashes.c_str());
+    for (tl_int y = by; y < by + blobSize; ++y)
+    {
+      for (tl_int x = bx; x < bx + blobSize; ++x)
+      { mask[x + y * size] = 1; }
     }
   }
 
-  return sdfImg;
+  DistanceField df;
+
+  core_time::Timer timer;
+  df.Initialize(mask, size, size, a_kernelSize);
+  const f64 fullSec = timer.ElapsedSeconds();
+
+  core_conts::Array<f64> latencies(a_numEdits, 0.0);
+  f64 numPixels = 0;
+
+  for (tl_int i = 0; i < a_numEdits; ++i)
+  {
+    const tl_int x = core_rng::g_defaultRNG.GetRandomInteger(0, size - g_benchStampSize);
+    const tl_int y = core_rng::g_defaultRNG.GetRandomInteger(0, size - g_benchStampSize);
+    const bool   inside = core_rng::g_defaultRNG.GetRandomInteger(0, 2) == 1;
+
+    DoStamp(df, x, y, g_benchStampSize, inside);
+
+    timer.Reset();
+    df.MarkDirty(x, y, g_benchStampSize, g_benchStampSize);
+    numPixels += (f64)df.Update();
+    latencies[i] = timer.ElapsedSeconds() * 1000000.0;
+  }
+
+  // insertion sort for the percentiles
+  f64 totalLatency = 0;
+  for (tl_int i = 0; i < a_numEdits; ++i)
+  {
+    const f64 curr = latencies[i];
+    totalLatency += curr;
+
+    tl_int j = i;
+    while (j > 0 && latencies[j - 1] > curr)
+    { latencies[j] = latencies[j - 1]; --j; }
+    latencies[j] = curr;
+  }
+
+  printf("\nFull SDF of a %dx%d mask (kernel %d): %.2f ms", size, size, 
+         a_kernelSize, fullSec * 1000.0);
+  printf("\n%d random %dx%d edits, update latency in microseconds:", a_numEdits, 
+         g_benchStampSize, g_benchStampSize);
+  printf("\n  avg %10.1f\n  median %7.1f\n  p99 %10.1f\n  max %10.1f", 
+         totalLatency / a_numEdits, latencies[a_numEdits / 2], 
+         latencies[(a_numEdits * 99) / 100], latencies[a_numEdits - 1]);
+  printf("\nPixels recomputed per edit: %.0f", numPixels / a_numEdits);
+
+  return 0;
 }
 
 // xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
@@ -276,7 +1904,7 @@ struct Arg : public option::Arg
   _argc_ = _argc_ > 0 ? --_argc_ : _argc_;\
   _argv_ = _argc_ > 0 ? ++_argv_ : _argv_
 
-enum optionIndex { UNKNOWN = 0, HELP, THREADS, IN_FILE, OUT_FILE, INV_COL, SAFE, SDF_WIDTH, KERNEL_SIZE};
+enum optionIndex { UNKNOWN = 0, HELP, THREADS, IN_FILE, OUT_FILE, INV_COL, SAFE, SDF_WIDTH, KERNEL_SIZE, ALGORITHM, BENCH, BATCH_DIR, MANIFEST, ATLAS, BAND, FORMAT, BENCH_DIRTY, FONT, GLYPHS, GLYPH_SIZE, RANGE, MESH, VOLUME_RES};
 const option::Descriptor usage[] = 
 {
   { UNKNOWN, 0, "", ""           , Arg::Unknown   , "\nUSAGE: tlocUtilsDFGenerator [options]\n\n"
@@ -289,6 +1917,20 @@ const option::Descriptor usage[] =
   { SAFE, 0, "s", "safe"         , Arg::None      , "  -s, \tDisallows overwriting existing files." },
   { SDF_WIDTH, 0, "w", "width"   , Arg::Numeric   , "  -w, \tWidth of the final SDF image. Height is calculated from ratio of source image." },
   { KERNEL_SIZE, 0, "k", "kernel", Arg::Numeric   , "  -k, \tDF is calculated upto this many pixels (in radius) from the current pixel." },
+  { ALGORITHM, 0, "", "algorithm", Arg::Required  , "  \t--algorithm=<brute|edt> \tbrute (default) scans the full kernel per pixel, edt uses an exact distance transform (linear time)." },
+  { BENCH, 0, "", "bench"        , Arg::None      , "  \t--bench \tPrints the time and megapixels per second of every phase." },
+  { BATCH_DIR, 0, "", "batch-dir", Arg::Required  , "  \t--batch-dir=<folder> \tGenerates a DF for every PNG in the folder. -o is the output folder." },
+  { MANIFEST, 0, "", "manifest"  , Arg::Required  , "  \t--manifest=<filename> \tGenerates a DF for every PNG listed (one per line). -o is the output folder." },
+  { ATLAS, 0, "", "atlas"        , Arg::Required  , "  \t--atlas=<filename> \tBatch only: packs all DFs into one PNG and writes <filename>.txt with the sprite rects." },
+  { BAND, 0, "", "band"          , Arg::Numeric   , "  \t--band=<rows> \tStreams the input in bands of this many output rows. The input must be an 8 bit binary PGM, rgba output is written as PAM." },
+  { FORMAT, 0, "", "format"      , Arg::Required  , "  \t--format=<rgba|u16|f32> \trgba (default) encodes direction and distance to RGBA, u16 and f32 keep only the signed distance and are written uncompressed with a header (.tldf). Single image and --band only." },
+  { BENCH_DIRTY, 0, "", "bench-dirty", Arg::Numeric, "  \t--bench-dirty=<edits> \tStamps this many random 32x32 edits onto a 2048x2048 mask and prints the incremental update latency." },
+  { FONT, 0, "", "font"          , Arg::Required  , "  \t--font=<filename> \tGenerates an MSDF atlas from the glyph outlines of a TrueType font. -o is the atlas file." },
+  { GLYPHS, 0, "", "glyphs"      , Arg::NonEmpty  , "  \t--glyphs=<string> \tFont only: characters to generate (one byte each). Default is printable ASCII." },
+  { GLYPH_SIZE, 0, "", "size"    , Arg::Numeric   , "  \t--size=<pixels> \tFont only: pixels per em (default 32)." },
+  { RANGE, 0, "", "range"        , Arg::Numeric   , "  \t--range=<pixels> \tFont and mesh only: distance range in pixels or voxels (default 4)." },
+  { MESH, 0, "", "mesh"          , Arg::Required  , "  \t--mesh=<filename> \tBakes a signed distance volume from an OBJ mesh. -o is the volume, --format=u16|f32 writes a .tldf volume, rgba a PNG of the stacked Z slices." },
+  { VOLUME_RES, 0, "", "volume-res", Arg::Numeric , "  \t--volume-res=<voxels> \tMesh only: voxels along the longest side of the volume (default 128)." },
   { 0, 0, 0, 0, 0, 0 }
 };
 
@@ -319,6 +1961,159 @@ int TLOC_MAIN(int argc, char *argv[])
   if (options[THREADS])
   { g_numOpenMPThreads = atoi(options[THREADS].arg); }
 
+  g_bench = options[BENCH] != nullptr;
+
+  SDFSettings settings;
+
+  if (options[SDF_WIDTH])
+  { settings.m_width = atoi(options[SDF_WIDTH].arg); }
+
+  if (options[KERNEL_SIZE])
+  { settings.m_kernelSize = atoi(options[KERNEL_SIZE].arg); }
+
+  settings.m_invert = options[INV_COL] != nullptr;
+
+  if (options[ALGORITHM])
+  {
+    core_str::String algo(options[ALGORITHM].arg);
+    if (algo.compare("edt") == 0)
+    { settings.m_useEDT = true; }
+    else if (algo.compare("brute") != 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Unknown algorithm: " << algo;
+      return 1;
+    }
+  }
+
+  if (options[FORMAT])
+  {
+    core_str::String format(options[FORMAT].arg);
+    if (format.compare("u16") == 0)
+    { settings.m_format = RawDistanceFieldHeader::k_formatU16; }
+    else if (format.compare("f32") == 0)
+    { settings.m_format = RawDistanceFieldHeader::k_formatF32; }
+    else if (format.compare("rgba") != 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Unknown format: " << format;
+      return 1;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // incremental update benchmark
+
+  if (options[BENCH_DIRTY])
+  { return BenchIncrementalSDF(atoi(options[BENCH_DIRTY].arg), settings.m_kernelSize); }
+
+  // -----------------------------------------------------------------------
+  // font mode
+
+  if (options[FONT])
+  {
+    core_io::Path fontFile = core_io::Path(core_str::String(options[FONT].arg));
+    if (fontFile.FileExists() == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << fontFile << " does not exist";
+      return 1;
+    }
+
+    core_str::String glyphs;
+    if (options[GLYPHS])
+    { glyphs = options[GLYPHS].arg; }
+    else
+    {
+      for (char c = ' '; c <= '~'; ++c)
+      { glyphs += c; }
+    }
+
+    const tl_int size = options[GLYPH_SIZE] ? atoi(options[GLYPH_SIZE].arg) : 32;
+    const tl_int range = options[RANGE] ? atoi(options[RANGE].arg) : 4;
+
+    core_str::String atlasFile = options[OUT_FILE] 
+      ? core_str::String(options[OUT_FILE].arg)
+      : core_str::Format("%s_msdf.png", fontFile.GetFileNameWithoutExtension().c_str());
+
+    if (core_io::Path(atlasFile).FileExists() && options[SAFE])
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << atlasFile << " already exists.";
+      return 1;
+    }
+
+    TLOC_LOG_DEFAULT_INFO_NO_FILENAME() << "Generating MSDF atlas from " 
+      << fontFile << " and saving to " << atlasFile;
+
+    return GenerateFontAtlas(fontFile, glyphs, size, range, atlasFile);
+  }
+
+  // -----------------------------------------------------------------------
+  // mesh mode
+
+  if (options[MESH])
+  {
+    core_io::Path meshFile = core_io::Path(core_str::String(options[MESH].arg));
+    if (meshFile.FileExists() == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << meshFile << " does not exist";
+      return 1;
+    }
+
+    const tl_int resolution = options[VOLUME_RES] ? atoi(options[VOLUME_RES].arg) : 128;
+    const tl_int range = options[RANGE] ? atoi(options[RANGE].arg) : 4;
+
+    const char* ext = settings.m_format == g_formatRGBA ? "png" : "tldf";
+    core_str::String volumeFile = options[OUT_FILE] 
+      ? core_str::String(options[OUT_FILE].arg)
+      : core_str::Format("%s_sdf.%s", meshFile.GetFileNameWithoutExtension().c_str(), ext);
+
+    if (core_io::Path(volumeFile).FileExists() && options[SAFE])
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << volumeFile << " already exists.";
+      return 1;
+    }
+
+    TLOC_LOG_DEFAULT_INFO_NO_FILENAME() << "Baking SDF volume from " 
+      << meshFile << " and saving to " << volumeFile;
+
+    return GenerateMeshVolume(meshFile, resolution, range, settings.m_format, volumeFile);
+  }
+
+  // -----------------------------------------------------------------------
+  // batch mode
+
+  if (options[BATCH_DIR] || options[MANIFEST])
+  {
+    path_cont inFiles;
+    if (options[BATCH_DIR])
+    { GetPngFilesInFolder(core_str::String(options[BATCH_DIR].arg), inFiles); }
+
+    if (options[MANIFEST])
+    {
+      core_io::Path manifest = core_io::Path(core_str::String(options[MANIFEST].arg));
+      if (GetPngFilesFromManifest(manifest, inFiles) == false)
+      {
+        TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not read " << manifest;
+        return 1;
+      }
+    }
+
+    if (inFiles.empty())
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "No PNG files to process";
+      return 1;
+    }
+
+    core_str::String outFolder(options[OUT_FILE] ? options[OUT_FILE].arg : ".");
+    core_str::String atlasFile(options[ATLAS] ? options[ATLAS].arg : "");
+
+    TLOC_LOG_DEFAULT_INFO_NO_FILENAME() << "Generating SDF images from " 
+      << inFiles.size() << " files";
+
+    return ProcessBatch(inFiles, settings, outFolder, atlasFile);
+  }
+
+  // -----------------------------------------------------------------------
+  // single image
+
   if (options[IN_FILE])
   {
     auto opt = options[IN_FILE].arg;
@@ -331,10 +2126,14 @@ int TLOC_MAIN(int argc, char *argv[])
     }
   }
 
+  const bool rawOutput = settings.m_format != g_formatRGBA;
+
+  core_str::String outFileName;
   if (options[OUT_FILE])
   {
     auto opt = options[OUT_FILE].arg;
-    g_outFile = core_io::Path(core_str::String(opt));
+    outFileName = opt;
+    g_outFile = core_io::Path(outFileName);
 
     if (g_outFile.FileExists() && options[SAFE])
     {
@@ -343,7 +2142,37 @@ int TLOC_MAIN(int argc, char *argv[])
     }
   }
   else
-  { g_outFile = core_io::Path(core_str::Format("%s_sdf.png", g_inFile.GetFileNameWithoutExtension().c_str()) ); }
+  {
+    // PNG can't be streamed, --band writes PAM instead
+    const char* ext = rawOutput ? "tldf" : (options[BAND] ? "pam" : "png");
+    outFileName = core_str::Format("%s_sdf.%s", g_inFile.GetFileNameWithoutExtension().c_str(), ext);
+    g_outFile = core_io::Path(outFileName);
+  }
+
+  // -----------------------------------------------------------------------
+  // streaming (single image, band by band)
+
+  if (options[BAND])
+  {
+    const tl_int bandHeight = atoi(options[BAND].arg);
+    if (options[IN_FILE] == nullptr || bandHeight <= 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "--band requires an input file and a positive row count";
+      return 1;
+    }
+
+    TLOC_LOG_DEFAULT_INFO_NO_FILENAME() << "Streaming SDF image from " 
+      << g_inFile << " to " << outFileName;
+
+    core_time::Timer sdfTimer;
+    const tl_int result = GetSDFStreamed
+      (core_str::String(options[IN_FILE].arg), outFileName, settings, bandHeight);
+    printf("\nTime to calculate SDF: %f sec", sdfTimer.ElapsedSeconds());
+
+    return result;
+  }
+
+  core_time::Timer benchTimer;
 
   // load the image
   gfx_med::ImageLoaderPng il;
@@ -354,29 +2183,23 @@ int TLOC_MAIN(int argc, char *argv[])
   }
 
   auto_cref imgPtr = il.GetImage();
-
-  auto sdfDim = imgPtr->GetDimensions(); 
-  if (options[SDF_WIDTH])
-  {
-    auto width = atoi(options[SDF_WIDTH].arg);
-    sdfDim = 
-      gfx_t::f_dimension::ModifyAndKeepRatioX(imgPtr->GetDimensions(), width);
-  }
-
-  tl_int kernelSize = 10;
-  if (options[KERNEL_SIZE])
-  { kernelSize = atoi(options[KERNEL_SIZE].arg); }
+  PrintBench("decode", benchTimer, imgPtr->GetWidth() * imgPtr->GetHeight());
 
   TLOC_LOG_DEFAULT_INFO_NO_FILENAME() << "Generating SDF image from " 
-    << g_inFile << " and saving to " << g_outFile << " with dimensions " << sdfDim;
-
-  bool invert = options[INV_COL] != nullptr;
+    << g_inFile << " and saving to " << g_outFile;
 
   core_time::Timer sdfTimer;
-  auto_cref outImg = GetSDFFromCharImage(imgPtr, sdfDim, kernelSize, invert);
+  SDFOutput sdf;
+  GetSDF(imgPtr, settings, sdf);
   printf("\nTime to calculate SDF: %f sec", sdfTimer.ElapsedSeconds());
 
-  gfx_med::f_image_loader::SaveImage(*outImg, g_outFile);
+  benchTimer.Reset();
+  if (sdf.Save(outFileName) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save " << g_outFile;
+    return 1;
+  }
+  PrintBench("encode", benchTimer, sdf.GetWidth() * sdf.GetHeight());
 
   return 0;
 }
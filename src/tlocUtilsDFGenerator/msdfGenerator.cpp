@@ -0,0 +1,703 @@
+#include "msdfGenerator.h"
+
+#include <cmath>
+
+using namespace tloc;
+
+namespace {
+
+  typedef OutlinePoint  vec2;
+
+  const f64 g_epsilon = 1e-14;
+  const f64 g_pi = 3.14159265358979323846;
+
+  // -----------------------------------------------------------------------
+  // vector helpers
+
+  vec2 DoAdd(const vec2& a, const vec2& b)  { return vec2(a.m_x + b.m_x, a.m_y + b.m_y); }
+  vec2 DoSub(const vec2& a, const vec2& b)  { return vec2(a.m_x - b.m_x, a.m_y - b.m_y); }
+  vec2 DoMul(const vec2& a, f64 s)          { return vec2(a.m_x * s, a.m_y * s); }
+  f64  DoDot(const vec2& a, const vec2& b)  { return a.m_x * b.m_x + a.m_y * b.m_y; }
+  f64  DoCross(const vec2& a, const vec2& b){ return a.m_x * b.m_y - a.m_y * b.m_x; }
+  f64  DoLength(const vec2& a)              { return sqrt(DoDot(a, a)); }
+
+  vec2 DoNormalize(const vec2& a)
+  {
+    const f64 len = DoLength(a);
+    return len == 0 ? vec2(0, 1) : vec2(a.m_x / len, a.m_y / len);
+  }
+
+  vec2 DoMix(const vec2& a, const vec2& b, f64 t)
+  { return vec2(a.m_x + (b.m_x - a.m_x) * t, a.m_y + (b.m_y - a.m_y) * t); }
+
+  f64 DoNonZeroSign(f64 a_value)
+  { return a_value > 0 ? 1.0 : -1.0; }
+
+  // -----------------------------------------------------------------------
+  // polynomial roots, returns the number of real solutions
+
+  tl_int
+    DoSolveQuadratic(f64 x[2], f64 a, f64 b, f64 c)
+  {
+    if (fabs(a) < g_epsilon)
+    {
+      if (fabs(b) < g_epsilon)
+      { return 0; }
+
+      x[0] = -c / b;
+      return 1;
+    }
+
+    f64 discriminant = b * b - 4 * a * c;
+    if (discriminant > 0)
+    {
+      discriminant = sqrt(discriminant);
+      x[0] = (-b + discriminant) / (2 * a);
+      x[1] = (-b - discriminant) / (2 * a);
+      return 2;
+    }
+    else if (discriminant == 0)
+    {
+      x[0] = -b / (2 * a);
+      return 1;
+    }
+
+    return 0;
+  }
+
+  tl_int
+    DoSolveCubicNormed(f64 x[3], f64 a, f64 b, f64 c)
+  {
+    const f64 a2 = a * a;
+    f64 q = (a2 - 3 * b) / 9;
+    const f64 r = (a * (2 * a2 - 9 * b) + 27 * c) / 54;
+    const f64 r2 = r * r;
+    const f64 q3 = q * q * q;
+
+    if (r2 < q3)
+    {
+      const f64 t = acos(core::Clamp(r / sqrt(q3), -1.0, 1.0));
+      a /= 3;
+      q = -2 * sqrt(q);
+      x[0] = q * cos(t / 3) - a;
+      x[1] = q * cos( (t + 2 * g_pi) / 3) - a;
+      x[2] = q * cos( (t - 2 * g_pi) / 3) - a;
+      return 3;
+    }
+
+    f64 A = -pow(fabs(r) + sqrt(r2 - q3), 1.0 / 3.0);
+    if (r < 0) { A = -A; }
+    const f64 B = A == 0 ? 0 : q / A;
+    a /= 3;
+    x[0] = (A + B) - a;
+    x[1] = -0.5 * (A + B) - a;
+    x[2] = 0.5 * sqrt(3.0) * (A - B);
+    return fabs(x[2]) < g_epsilon ? 2 : 1;
+  }
+
+  tl_int
+    DoSolveCubic(f64 x[3], f64 a, f64 b, f64 c, f64 d)
+  {
+    if (fabs(a) < g_epsilon)
+    { return DoSolveQuadratic(x, b, c, d); }
+    return DoSolveCubicNormed(x, b / a, c / a, d / a);
+  }
+
+  // -----------------------------------------------------------------------
+  // Signed distance with a tie breaker: when two edges are equally close (at
+  // a shared vertex) the one the point is more perpendicular to wins.
+
+  struct SignedDistance
+  {
+    SignedDistance()
+      : m_distance(-1e240), m_dot(1)
+    { }
+
+    SignedDistance(f64 a_distance, f64 a_dot)
+      : m_distance(a_distance), m_dot(a_dot)
+    { }
+
+    bool operator<(const SignedDistance& a_other) const
+    {
+      return fabs(m_distance) < fabs(a_other.m_distance) ||
+        (fabs(m_distance) == fabs(a_other.m_distance) && m_dot < a_other.m_dot);
+    }
+
+    f64 m_distance;
+    f64 m_dot;
+  };
+
+  // -----------------------------------------------------------------------
+  // edge evaluation
+
+  vec2
+    DoEdgePoint(const OutlineEdge& a_edge, f64 t)
+  {
+    if (a_edge.m_numPoints == 2)
+    { return DoMix(a_edge.m_p[0], a_edge.m_p[1], t); }
+
+    return DoMix(DoMix(a_edge.m_p[0], a_edge.m_p[1], t),
+                 DoMix(a_edge.m_p[1], a_edge.m_p[2], t), t);
+  }
+
+  vec2
+    DoEdgeDirection(const OutlineEdge& a_edge, f64 t)
+  {
+    if (a_edge.m_numPoints == 2)
+    { return DoSub(a_edge.m_p[1], a_edge.m_p[0]); }
+
+    const vec2 dir = DoMix(DoSub(a_edge.m_p[1], a_edge.m_p[0]),
+                           DoSub(a_edge.m_p[2], a_edge.m_p[1]), t);
+
+    // control point on top of an end point
+    if (dir.m_x == 0 && dir.m_y == 0)
+    { return DoSub(a_edge.m_p[2], a_edge.m_p[0]); }
+    return dir;
+  }
+
+  SignedDistance
+    DoLinearSignedDistance(const OutlineEdge& a_edge, const vec2& a_origin,
+                           f64& a_param)
+  {
+    const vec2& p0 = a_edge.m_p[0];
+    const vec2& p1 = a_edge.m_p[1];
+
+    const vec2 aq = DoSub(a_origin, p0);
+    const vec2 ab = DoSub(p1, p0);
+
+    a_param = DoDot(aq, ab) / DoDot(ab, ab);
+
+    const vec2 eq = DoSub(a_param > 0.5 ? p1 : p0, a_origin);
+    const f64  endPointDistance = DoLength(eq);
+
+    if (a_param > 0 && a_param < 1)
+    {
+      const vec2 ortho = DoNormalize(vec2(ab.m_y, -ab.m_x));
+      const f64  orthoDistance = DoDot(ortho, aq);
+      if (fabs(orthoDistance) < endPointDistance)
+      { return SignedDistance(orthoDistance, 0); }
+    }
+
+    return SignedDistance(DoNonZeroSign(DoCross(aq, ab)) * endPointDistance,
+                          fabs(DoDot(DoNormalize(ab), DoNormalize(eq))));
+  }
+
+  SignedDistance
+    DoQuadraticSignedDistance(const OutlineEdge& a_edge, const vec2& a_origin,
+                              f64& a_param)
+  {
+    const vec2& p0 = a_edge.m_p[0];
+    const vec2& p1 = a_edge.m_p[1];
+    const vec2& p2 = a_edge.m_p[2];
+
+    const vec2 qa = DoSub(p0, a_origin);
+    const vec2 ab = DoSub(p1, p0);
+    const vec2 br = DoSub(DoSub(p2, p1), ab);
+
+    // the closest point has a derivative perpendicular to the vector to it
+    const f64 a = DoDot(br, br);
+    const f64 b = 3 * DoDot(ab, br);
+    const f64 c = 2 * DoDot(ab, ab) + DoDot(qa, br);
+    const f64 d = DoDot(qa, ab);
+
+    f64 t[3];
+    const tl_int numSolutions = DoSolveCubic(t, a, b, c, d);
+
+    vec2 dir = DoEdgeDirection(a_edge, 0);
+    f64  minDistance = DoNonZeroSign(DoCross(dir, qa)) * DoLength(qa);
+    a_param = -DoDot(qa, dir) / DoDot(dir, dir);
+
+    {
+      dir = DoEdgeDirection(a_edge, 1);
+      const vec2 p2q = DoSub(p2, a_origin);
+      const f64  distance = DoNonZeroSign(DoCross(dir, p2q)) * DoLength(p2q);
+      if (fabs(distance) < fabs(minDistance))
+      {
+        minDistance = distance;
+        a_param = DoDot(DoSub(a_origin, p1), dir) / DoDot(dir, dir);
+      }
+    }
+
+    for (tl_int i = 0; i < numSolutions; ++i)
+    {
+      if (t[i] > 0 && t[i] < 1)
+      {
+        const vec2 endPoint = DoAdd(DoAdd(p0, DoMul(ab, 2 * t[i])), DoMul(br, t[i] * t[i]));
+        const vec2 toEndPoint = DoSub(endPoint, a_origin);
+        const f64  distance = DoNonZeroSign(DoCross(DoSub(p2, p0), toEndPoint)) *
+                              DoLength(toEndPoint);
+        if (fabs(distance) <= fabs(minDistance))
+        {
+          minDistance = distance;
+          a_param = t[i];
+        }
+      }
+    }
+
+    if (a_param >= 0 && a_param <= 1)
+    { return SignedDistance(minDistance, 0); }
+
+    if (a_param < 0.5)
+    {
+      return SignedDistance(minDistance,
+        fabs(DoDot(DoNormalize(DoEdgeDirection(a_edge, 0)), DoNormalize(qa))));
+    }
+
+    return SignedDistance(minDistance,
+      fabs(DoDot(DoNormalize(DoEdgeDirection(a_edge, 1)),
+                 DoNormalize(DoSub(p2, a_origin)))));
+  }
+
+  SignedDistance
+    DoEdgeSignedDistance(const OutlineEdge& a_edge, const vec2& a_origin,
+                         f64& a_param)
+  {
+    return a_edge.m_numPoints == 2
+      ? DoLinearSignedDistance(a_edge, a_origin, a_param)
+      : DoQuadraticSignedDistance(a_edge, a_origin, a_param);
+  }
+
+  // Past the end points the distance to the edge's tangent line is used
+  // instead, which keeps the channels straight beyond corners.
+
+  void
+    DoDistanceToPseudoDistance(const OutlineEdge& a_edge, SignedDistance& a_distance,
+                               const vec2& a_origin, f64 a_param)
+  {
+    if (a_param < 0)
+    {
+      const vec2 dir = DoNormalize(DoEdgeDirection(a_edge, 0));
+      const vec2 aq = DoSub(a_origin, a_edge.m_p[0]);
+      if (DoDot(aq, dir) < 0)
+      {
+        const f64 pseudoDistance = DoCross(aq, dir);
+        if (fabs(pseudoDistance) <= fabs(a_distance.m_distance))
+        { a_distance = SignedDistance(pseudoDistance, 0); }
+      }
+    }
+    else if (a_param > 1)
+    {
+      const vec2 dir = DoNormalize(DoEdgeDirection(a_edge, 1));
+      const vec2 bq = DoSub(a_origin, a_edge.m_p[a_edge.m_numPoints - 1]);
+      if (DoDot(bq, dir) > 0)
+      {
+        const f64 pseudoDistance = DoCross(bq, dir);
+        if (fabs(pseudoDistance) <= fabs(a_distance.m_distance))
+        { a_distance = SignedDistance(pseudoDistance, 0); }
+      }
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // Nonzero winding number of a_point (ray towards +x)
+
+  tl_int
+    DoGetWinding(const GlyphOutline& a_outline, const vec2& a_point)
+  {
+    tl_int winding = 0;
+
+    for (tl_size i = 0; i < a_outline.m_contours.size(); ++i)
+    {
+      const outline_edge_cont& edges = a_outline.m_contours[i].m_edges;
+      for (tl_size j = 0; j < edges.size(); ++j)
+      {
+        const OutlineEdge& edge = edges[j];
+
+        f64    t[2];
+        tl_int numSolutions = 0;
+
+        if (edge.m_numPoints == 2)
+        {
+          numSolutions = DoSolveQuadratic(t, 0, edge.m_p[1].m_y - edge.m_p[0].m_y,
+                                          edge.m_p[0].m_y - a_point.m_y);
+        }
+        else
+        {
+          const f64 y0 = edge.m_p[0].m_y, y1 = edge.m_p[1].m_y, y2 = edge.m_p[2].m_y;
+          numSolutions = DoSolveQuadratic(t, y0 - 2 * y1 + y2, 2 * (y1 - y0),
+                                          y0 - a_point.m_y);
+        }
+
+        // half open interval so that shared end points are counted once
+        for (tl_int k = 0; k < numSolutions; ++k)
+        {
+          if (t[k] < 0 || t[k] >= 1)
+          { continue; }
+
+          if (DoEdgePoint(edge, t[k]).m_x <= a_point.m_x)
+          { continue; }
+
+          const f64 dy = DoEdgeDirection(edge, t[k]).m_y;
+          if (dy > 0)      { ++winding; }
+          else if (dy < 0) { --winding; }
+        }
+      }
+    }
+
+    return winding;
+  }
+
+  // -----------------------------------------------------------------------
+  // edge coloring
+
+  bool
+    DoIsCorner(const vec2& a_dirA, const vec2& a_dirB, f64 a_crossThreshold)
+  {
+    return DoDot(a_dirA, a_dirB) <= 0 ||
+      fabs(DoCross(a_dirA, a_dirB)) > a_crossThreshold;
+  }
+
+  // cycles cyan -> magenta -> yellow, never picking a color that shares
+  // only one channel with a_banned
+  void
+    DoSwitchColor(u32& a_color, u32 a_banned = OutlineEdge::k_black)
+  {
+    const u32 combined = a_color & a_banned;
+    if (combined == OutlineEdge::k_red || combined == OutlineEdge::k_green ||
+        combined == OutlineEdge::k_blue)
+    {
+      a_color = combined ^ OutlineEdge::k_white;
+      return;
+    }
+
+    if (a_color == OutlineEdge::k_black || a_color == OutlineEdge::k_white)
+    {
+      a_color = OutlineEdge::k_cyan;
+      return;
+    }
+
+    const u32 shifted = a_color << 1;
+    a_color = (shifted | shifted >> 3) & OutlineEdge::k_white;
+  }
+
+  void
+    DoSplitInThirds(const OutlineEdge& a_edge, OutlineEdge a_parts[3])
+  {
+    for (tl_int i = 0; i < 3; ++i)
+    {
+      a_parts[i].m_numPoints = a_edge.m_numPoints;
+      a_parts[i].m_color = a_edge.m_color;
+    }
+
+    if (a_edge.m_numPoints == 2)
+    {
+      a_parts[0].m_p[0] = a_edge.m_p[0];
+      a_parts[0].m_p[1] = DoEdgePoint(a_edge, 1.0 / 3.0);
+      a_parts[1].m_p[0] = a_parts[0].m_p[1];
+      a_parts[1].m_p[1] = DoEdgePoint(a_edge, 2.0 / 3.0);
+      a_parts[2].m_p[0] = a_parts[1].m_p[1];
+      a_parts[2].m_p[1] = a_edge.m_p[1];
+      return;
+    }
+
+    const vec2* p = a_edge.m_p;
+
+    a_parts[0].m_p[0] = p[0];
+    a_parts[0].m_p[1] = DoMix(p[0], p[1], 1.0 / 3.0);
+    a_parts[0].m_p[2] = DoEdgePoint(a_edge, 1.0 / 3.0);
+
+    a_parts[1].m_p[0] = a_parts[0].m_p[2];
+    a_parts[1].m_p[1] = DoMix(DoMix(p[0], p[1], 5.0 / 9.0),
+                              DoMix(p[1], p[2], 4.0 / 9.0), 0.5);
+    a_parts[1].m_p[2] = DoEdgePoint(a_edge, 2.0 / 3.0);
+
+    a_parts[2].m_p[0] = a_parts[1].m_p[2];
+    a_parts[2].m_p[1] = DoMix(p[1], p[2], 2.0 / 3.0);
+    a_parts[2].m_p[2] = p[2];
+  }
+
+  void
+    DoColorContour(OutlineContour& a_contour, f64 a_crossThreshold)
+  {
+    outline_edge_cont& edges = a_contour.m_edges;
+    const tl_int numEdges = core_utils::CastNumber<tl_int>(edges.size());
+
+    if (numEdges == 0)
+    { return; }
+
+    core_conts::Array<tl_int> corners;
+
+    vec2 prevDir = DoEdgeDirection(edges.back(), 1);
+    for (tl_int i = 0; i < numEdges; ++i)
+    {
+      if (DoIsCorner(DoNormalize(prevDir), DoNormalize(DoEdgeDirection(edges[i], 0)),
+                     a_crossThreshold))
+      { corners.push_back(i); }
+      prevDir = DoEdgeDirection(edges[i], 1);
+    }
+
+    // smooth contour, every channel sees the same distance
+    if (corners.empty())
+    {
+      for (tl_int i = 0; i < numEdges; ++i)
+      { edges[i].m_color = OutlineEdge::k_white; }
+      return;
+    }
+
+    // teardrop: one corner, the colors fan out from it
+    if (corners.size() == 1)
+    {
+      u32 colors[3] = { OutlineEdge::k_white, OutlineEdge::k_white, OutlineEdge::k_white };
+      DoSwitchColor(colors[0]);
+      colors[2] = colors[0];
+      DoSwitchColor(colors[2]);
+
+      const tl_int corner = corners[0];
+
+      if (numEdges >= 3)
+      {
+        for (tl_int i = 0; i < numEdges; ++i)
+        {
+          const tl_int colorIndex = (tl_int)(3 + 2.875 * i / (numEdges - 1) - 1.4375 + 0.5) - 2;
+          edges[(corner + i) % numEdges].m_color = colors[colorIndex];
+        }
+        return;
+      }
+
+      // fewer than three edges for three colors, split them
+      OutlineEdge parts[6];
+      tl_int      numParts = 3;
+
+      DoSplitInThirds(edges[0], parts + 3 * corner);
+      if (numEdges >= 2)
+      {
+        DoSplitInThirds(edges[1], parts + 3 - 3 * corner);
+        parts[0].m_color = parts[1].m_color = colors[0];
+        parts[2].m_color = parts[3].m_color = colors[1];
+        parts[4].m_color = parts[5].m_color = colors[2];
+        numParts = 6;
+      }
+      else
+      {
+        parts[0].m_color = colors[0];
+        parts[1].m_color = colors[1];
+        parts[2].m_color = colors[2];
+      }
+
+      edges.clear();
+      for (tl_int i = 0; i < numParts; ++i)
+      { edges.push_back(parts[i]); }
+      return;
+    }
+
+    // multiple corners: switch colors at every corner, the last spline must
+    // not share a single channel with the first one
+    const tl_int numCorners = core_utils::CastNumber<tl_int>(corners.size());
+    const tl_int start = corners[0];
+
+    tl_int spline = 0;
+    u32    color = OutlineEdge::k_white;
+    DoSwitchColor(color);
+    const u32 initialColor = color;
+
+    for (tl_int i = 0; i < numEdges; ++i)
+    {
+      const tl_int index = (start + i) % numEdges;
+      if (spline + 1 < numCorners && corners[spline + 1] == index)
+      {
+        ++spline;
+        DoSwitchColor(color, spline == numCorners - 1 ? initialColor
+                                                      : (u32)OutlineEdge::k_black);
+      }
+      edges[index].m_color = color;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  struct ChannelDistance
+  {
+    ChannelDistance()
+      : m_edge(nullptr), m_param(0)
+    { }
+
+    SignedDistance      m_minDistance;
+    const OutlineEdge*  m_edge;
+    f64                 m_param;
+  };
+
+  // -----------------------------------------------------------------------
+  // Error correction: where two edges of different colors come close, two
+  // channels can flip between neighbouring pixels while the median does not,
+  // which shows up as artifacts. Such clashing pixels are detected and
+  // collapsed to their median (i.e. a single channel distance).
+
+  const f64 g_clashThreshold = 1.001; // pixels
+
+  f64
+    DoMedian(f64 a, f64 b, f64 c)
+  { return core::tlMax(core::tlMin(a, b), core::tlMin(core::tlMax(a, b), c)); }
+
+  bool
+    DoIsInside(const f64* a_pixel)
+  { return (a_pixel[0] < 0) + (a_pixel[1] < 0) + (a_pixel[2] < 0) >= 2; }
+
+  bool
+    DoChannelFlips(const f64* a, const f64* b, tl_int a_channel)
+  { return (a[a_channel] < 0) != (b[a_channel] < 0); }
+
+  bool
+    DoPixelClash(const f64* a, const f64* b, f64 a_threshold)
+  {
+    // a change of the median is a real edge, not a clash
+    if (DoIsInside(a) != DoIsInside(b))
+    { return false; }
+
+    // all channels agreeing on either side means 0 <-> 1 or 2 <-> 3 channels
+    // changed, which is not a clash either
+    const tl_int aIn = (a[0] < 0) + (a[1] < 0) + (a[2] < 0);
+    const tl_int bIn = (b[0] < 0) + (b[1] < 0) + (b[2] < 0);
+    if (aIn == 0 || aIn == 3 || bIn == 0 || bIn == 3)
+    { return false; }
+
+    // find the two flipping channels, c is the remaining one
+    tl_int ca, cb, cc;
+    if (DoChannelFlips(a, b, 0))
+    {
+      ca = 0;
+      if (DoChannelFlips(a, b, 1))      { cb = 1; cc = 2; }
+      else if (DoChannelFlips(a, b, 2)) { cb = 2; cc = 1; }
+      else { return false; }
+    }
+    else if (DoChannelFlips(a, b, 1) && DoChannelFlips(a, b, 2))
+    { ca = 1; cb = 2; cc = 0; }
+    else
+    { return false; }
+
+    // the channels must actually be discontinuous, and out of the pair only
+    // the pixel farther from the edge is flagged
+    return fabs(a[ca] - b[ca]) >= a_threshold &&
+           fabs(a[cb] - b[cb]) >= a_threshold &&
+           fabs(a[cc]) >= fabs(b[cc]);
+  }
+
+  void
+    DoCorrectErrors(core_conts::Array<f64>& a_distances, 
+                    tl_int a_width, tl_int a_height)
+  {
+    core_conts::Array<tl_int> clashes;
+
+    for (tl_int y = 0; y < a_height; ++y)
+    {
+      for (tl_int x = 0; x < a_width; ++x)
+      {
+        const f64* pixel = &a_distances[(x + y * a_width) * 4];
+
+        if ( (x > 0 && DoPixelClash(pixel, pixel - 4, g_clashThreshold)) ||
+             (x < a_width - 1 && DoPixelClash(pixel, pixel + 4, g_clashThreshold)) ||
+             (y > 0 && DoPixelClash(pixel, pixel - a_width * 4, g_clashThreshold)) ||
+             (y < a_height - 1 && DoPixelClash(pixel, pixel + a_width * 4, g_clashThreshold)) )
+        { clashes.push_back(x + y * a_width); }
+      }
+    }
+
+    for (tl_size i = 0; i < clashes.size(); ++i)
+    {
+      f64* pixel = &a_distances[clashes[i] * 4];
+      const f64 median = DoMedian(pixel[0], pixel[1], pixel[2]);
+      pixel[0] = pixel[1] = pixel[2] = median;
+    }
+  }
+
+  // -----------------------------------------------------------------------
+
+  // [-a_range, a_range] to [0, 255], like the single channel fields
+  u8
+    DoEncodeDistance(f64 a_distance, f64 a_range)
+  {
+    const f64 value = (a_distance / (2.0 * a_range) + 0.5) * 255.0 + 0.5;
+    return (u8)core::Clamp(value, 0.0, 255.0);
+  }
+
+};
+
+// ///////////////////////////////////////////////////////////////////////
+
+void
+  ColorOutlineEdges(GlyphOutline& a_outline, f64 a_angleThreshold)
+{
+  const f64 crossThreshold = sin(a_angleThreshold);
+
+  for (tl_size i = 0; i < a_outline.m_contours.size(); ++i)
+  { DoColorContour(a_outline.m_contours[i], crossThreshold); }
+}
+
+// -----------------------------------------------------------------------
+
+void
+  GenerateMSDF(const GlyphOutline& a_outline, f64 a_scale,
+               f64 a_translateX, f64 a_translateY, f64 a_range,
+               tl_int a_width, tl_int a_height, msdf_cont& a_out)
+{
+  const tl_int numPixels = a_width * a_height;
+
+  // distances in pixels: r, g, b, true distance
+  core_conts::Array<f64> distances(numPixels * 4, 0);
+
+  tl_int numAgree = 0;
+  tl_int numDisagree = 0;
+
+  for (tl_int y = 0; y < a_height; ++y)
+  {
+    for (tl_int x = 0; x < a_width; ++x)
+    {
+      const vec2 p( (x + 0.5) / a_scale - a_translateX,
+                    (a_height - y - 0.5) / a_scale - a_translateY);
+
+      ChannelDistance r, g, b;
+      SignedDistance  minDistance;
+
+      for (tl_size i = 0; i < a_outline.m_contours.size(); ++i)
+      {
+        const outline_edge_cont& edges = a_outline.m_contours[i].m_edges;
+        for (tl_size j = 0; j < edges.size(); ++j)
+        {
+          const OutlineEdge& edge = edges[j];
+
+          f64 param;
+          const SignedDistance distance = DoEdgeSignedDistance(edge, p, param);
+
+          if (distance < minDistance)
+          { minDistance = distance; }
+
+          if ( (edge.m_color & OutlineEdge::k_red) && distance < r.m_minDistance)
+          { r.m_minDistance = distance; r.m_edge = &edge; r.m_param = param; }
+          if ( (edge.m_color & OutlineEdge::k_green) && distance < g.m_minDistance)
+          { g.m_minDistance = distance; g.m_edge = &edge; g.m_param = param; }
+          if ( (edge.m_color & OutlineEdge::k_blue) && distance < b.m_minDistance)
+          { b.m_minDistance = distance; b.m_edge = &edge; b.m_param = param; }
+        }
+      }
+
+      if (r.m_edge) { DoDistanceToPseudoDistance(*r.m_edge, r.m_minDistance, p, r.m_param); }
+      if (g.m_edge) { DoDistanceToPseudoDistance(*g.m_edge, g.m_minDistance, p, g.m_param); }
+      if (b.m_edge) { DoDistanceToPseudoDistance(*b.m_edge, b.m_minDistance, p, b.m_param); }
+
+      f64* pixel = &distances[(x + y * a_width) * 4];
+      pixel[0] = r.m_edge ? r.m_minDistance.m_distance * a_scale : a_range;
+      pixel[1] = g.m_edge ? g.m_minDistance.m_distance * a_scale : a_range;
+      pixel[2] = b.m_edge ? b.m_minDistance.m_distance * a_scale : a_range;
+      pixel[3] = minDistance.m_distance * a_scale;
+
+      // the sign of the distance depends on the contour orientation which
+      // differs between fonts, the winding number tells us which is which
+      if (a_outline.m_contours.empty() == false && fabs(pixel[3]) > 0.5)
+      {
+        const bool inside = DoGetWinding(a_outline, p) != 0;
+        if (inside == (pixel[3] < 0)) { ++numAgree; }
+        else                          { ++numDisagree; }
+      }
+    }
+  }
+
+  const f64 sign = numDisagree > numAgree ? -1.0 : 1.0;
+
+  for (tl_int i = 0; i < numPixels * 4; ++i)
+  { distances[i] *= sign; }
+
+  DoCorrectErrors(distances, a_width, a_height);
+
+  a_out.resize(numPixels * 4);
+  for (tl_int i = 0; i < numPixels * 4; ++i)
+  { a_out[i] = DoEncodeDistance(distances[i], a_range); }
+}
@@ -0,0 +1,32 @@
+#ifndef _TLOC_UTILS_DF_MSDF_GENERATOR_H_
+#define _TLOC_UTILS_DF_MSDF_GENERATOR_H_
+
+#include "glyphOutline.h"
+
+// ///////////////////////////////////////////////////////////////////////
+// Multi-channel signed distance fields computed analytically from glyph
+// outlines. Each edge is assigned to two of the three color channels so that
+// the channels disagree at corners; the median of the three channels then
+// reconstructs sharp corners at low resolutions. The alpha channel holds the
+// true (single channel) signed distance. Pixels where two channels flip
+// between neighbours without the median flipping (clashes) are collapsed to
+// their median.
+//
+// The encoding matches the rest of the DF generator: distances are negative
+// inside the glyph and [-range, range] pixels is mapped to [0, 255].
+
+typedef tl_core_conts::Array<u8>  msdf_cont;
+
+// Assigns edge colors. Edges meeting at an angle sharper than
+// a_angleThreshold (radians) are treated as corners.
+void  ColorOutlineEdges(GlyphOutline& a_outline, f64 a_angleThreshold = 3.0);
+
+// Writes a_width * a_height RGBA8 pixels to a_out, row 0 is the top row.
+// A pixel (x, y) samples the outline at
+//   ( (x + 0.5) / a_scale - a_translateX, (a_height - y - 0.5) / a_scale - a_translateY )
+// a_range is in pixels.
+void  GenerateMSDF(const GlyphOutline& a_outline, f64 a_scale,
+                   f64 a_translateX, f64 a_translateY, f64 a_range,
+                   tl_int a_width, tl_int a_height, msdf_cont& a_out);
+
+#endif
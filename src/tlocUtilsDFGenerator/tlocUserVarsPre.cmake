@@ -6,6 +6,10 @@
 # Do NOT remove the following variables. Modify the variables to suit your project
 set(SOLUTION_SOURCE_FILES
   main.cpp
+  glyphOutline.h
+  glyphOutline.cpp
+  msdfGenerator.h
+  msdfGenerator.cpp
   )
 
 # Do not include individual assets here. Only add paths
@@ -15,10 +19,12 @@ set(SOLUTION_ASSETS_PATH
 
 # Dependent project is compiled after dependency
 set(SOLUTION_PROJECT_DEPENDENCIES
+  tlocDistanceField
   )
 
 # Libraries that the executable needs to link against
 set(SOLUTION_EXECUTABLE_LINK_LIBRARIES
+  tlocDistanceField
   )
 
 find_package(OpenMP)
@@ -0,0 +1,959 @@
+#include <tlocCore/tloc_core.h>
+#include <tlocCore/tloc_core.inl.h>
+#include <tlocGraphics/tloc_graphics.h>
+#include <3rdParty/Core/CL/include/optionparser.h>
+
+#include <tlocImageTools/src/imageDecoder.h>
+#include <tlocImageTools/src/imageView.h>
+#include <tlocImageTools/src/resampler.h>
+#include <tlocImageTools/src/textureCompressor.h>
+#include <tlocImageTools/src/textureStager.h>
+
+#include <tlocCore/containers/tlocArray.inl.h>
+
+#include <cstdio>
+#include <cstring>
+
+using namespace tloc;
+
+namespace {
+
+  bool   g_bench = false;
+  tl_int g_numThreads = 4;
+
+  // the benchmark keeps the fastest of this many runs
+  const tl_int g_benchRuns = 3;
+
+  typedef core_conts::Array<core_str::String>   name_cont;
+  typedef core_conts::Array<DecodedImage>       image_cont;
+  typedef core_conts::Array<ImageDecodeStats>   stats_cont;
+
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// A manifest lists one image per line. Empty lines and lines starting with
+// '#' are ignored.
+
+bool
+GetFilesFromManifest(const core_io::Path& a_manifest, name_cont& a_out)
+{
+  core_io::FileIO_ReadA file(a_manifest);
+  if (file.Open() != ErrorSuccess)
+  { return false; }
+
+  core_str::String contents;
+  file.GetContents(contents);
+
+  tl_size lineBegin = 0;
+  while (lineBegin < contents.length())
+  {
+    tl_size lineEnd = lineBegin;
+    while (lineEnd < contents.length() && contents[lineEnd] != '\n')
+    { ++lineEnd; }
+
+    tl_size trimmedEnd = lineEnd;
+    while (trimmedEnd > lineBegin &&
+           (contents[trimmedEnd - 1] == '\r' || contents[trimmedEnd - 1] == ' '))
+    { --trimmedEnd; }
+
+    if (trimmedEnd > lineBegin && contents[lineBegin] != '#')
+    { a_out.push_back(contents.substr(lineBegin, trimmedEnd - lineBegin)); }
+
+    lineBegin = lineEnd + 1;
+  }
+
+  return true;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Decodes every file with DecodeImageFiles() and prints the time each of
+// them took. With enough threads the batch takes about as long as the
+// slowest image.
+
+f64
+DecodeBatch(const name_cont& a_files, tl_int a_numThreads, image_cont& a_images,
+            stats_cont& a_stats)
+{
+  core_conts::Array<const char*> fileNames;
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  { fileNames.push_back(a_files[i].c_str()); }
+
+  a_images.clear();
+  a_images.resize(a_files.size());
+  a_stats.resize(a_files.size());
+
+  core_time::Timer batchTimer;
+  DecodeImageFiles(&fileNames[0], fileNames.size(), &a_images[0], &a_stats[0],
+                   a_numThreads);
+  return batchTimer.ElapsedSeconds();
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+DecodeImages(const name_cont& a_files)
+{
+  image_cont images;
+  stats_cont stats;
+  const f64 batchTime = DecodeBatch(a_files, g_numThreads, images, stats);
+
+  f64     sumTime = 0;
+  f64     slowestTime = 0;
+  tl_int  numFailed = 0;
+
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  {
+    if (stats[i].m_decoded == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not decode " << a_files[i];
+      ++numFailed;
+      continue;
+    }
+
+    printf("\n%s: %ix%i in %.2f ms", a_files[i].c_str(),
+           images[i].m_width, images[i].m_height, stats[i].m_seconds * 1000.0);
+
+    sumTime += stats[i].m_seconds;
+    slowestTime = core::tlMax(slowestTime, stats[i].m_seconds);
+  }
+
+  printf("\n\nDecoded %u images on %i threads in %.2f ms",
+         (u32)(a_files.size() - numFailed), g_numThreads, batchTime * 1000.0);
+  printf("\n  sum of the images: %.2f ms, slowest image: %.2f ms",
+         sumTime * 1000.0, slowestTime * 1000.0);
+
+  return numFailed > 0 ? 1 : 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Compares loading the files one after another with the gfx_med image
+// loaders with DecodeImageFiles() on one and on --threads threads.
+
+f64
+LoadWithImageLoaders(const name_cont& a_files)
+{
+  core_time::Timer timer;
+
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  {
+    const core_io::Path path(a_files[i]);
+    const char* ext = strrchr(a_files[i].c_str(), '.');
+
+    if (ext && (strcmp(ext, ".png") == 0 || strcmp(ext, ".PNG") == 0))
+    {
+      gfx_med::ImageLoaderPng png;
+      if (png.Load(path) != ErrorSuccess)
+      { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "ImageLoaderPng could not load " << path; }
+    }
+    else
+    {
+      gfx_med::ImageLoaderJpeg jpeg;
+      if (jpeg.Load(path) != ErrorSuccess)
+      { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "ImageLoaderJpeg could not load " << path; }
+    }
+  }
+
+  return timer.ElapsedSeconds();
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+BenchDecoding(const name_cont& a_files)
+{
+  f64 loaderTime = 0;
+  f64 serialTime = 0;
+  f64 batchTime = 0;
+
+  image_cont images;
+  stats_cont stats;
+  stats_cont fastestStats(a_files.size());
+
+  for (tl_int run = 0; run < g_benchRuns; ++run)
+  {
+    const f64 loader = LoadWithImageLoaders(a_files);
+    const f64 serial = DecodeBatch(a_files, 1, images, stats);
+
+    // the per image times of the serial run, without other threads
+    // competing for memory bandwidth
+    for (tl_size i = 0; i < a_files.size(); ++i)
+    {
+      if (run == 0 || stats[i].m_seconds < fastestStats[i].m_seconds)
+      { fastestStats[i] = stats[i]; }
+    }
+
+    const f64 batch = DecodeBatch(a_files, g_numThreads, images, stats);
+
+    if (run == 0 || loader < loaderTime) { loaderTime = loader; }
+    if (run == 0 || serial < serialTime) { serialTime = serial; }
+    if (run == 0 || batch < batchTime) { batchTime = batch; }
+  }
+
+  f64     slowestTime = 0;
+  tl_size numPixels = 0;
+
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  {
+    if (fastestStats[i].m_decoded == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not decode " << a_files[i];
+      return 1;
+    }
+
+    printf("\n%s: %ix%i in %.2f ms", a_files[i].c_str(), images[i].m_width,
+           images[i].m_height, fastestStats[i].m_seconds * 1000.0);
+
+    slowestTime = core::tlMax(slowestTime, fastestStats[i].m_seconds);
+    numPixels += (tl_size)images[i].m_width * images[i].m_height;
+  }
+
+  const f64 megaPixels = (f64)numPixels / 1000000.0;
+
+  printf("\n\nDecoding %u images (%.2f megapixels), fastest of %i runs:",
+         (u32)a_files.size(), megaPixels, g_benchRuns);
+  printf("\n  gfx_med image loaders: %.2f ms (%.1f MP/s)",
+         loaderTime * 1000.0, megaPixels / loaderTime);
+  printf("\n  DecodeImageFiles, 1 thread: %.2f ms (%.1f MP/s)",
+         serialTime * 1000.0, megaPixels / serialTime);
+  printf("\n  DecodeImageFiles, %i threads: %.2f ms (%.1f MP/s, %.2fx)",
+         g_numThreads, batchTime * 1000.0, megaPixels / batchTime,
+         serialTime / batchTime);
+  printf("\n  slowest image: %.2f ms", slowestTime * 1000.0);
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Generates the mip chain of every image. With --save the chain is written
+// next to the image as <image>.mips: width, height and number of levels
+// (u32 each) followed by the RGBA8 levels, ready for glTexImage2D().
+// --bench also times the chain on one thread.
+
+bool
+SaveMipChain(const MipChain& a_chain, const core_str::String& a_fileName)
+{
+  FILE* file = fopen(a_fileName.c_str(), "wb");
+  if (file == nullptr)
+  { return false; }
+
+  const u32 header[3] = { (u32)a_chain.GetLevel(0).m_width,
+                          (u32)a_chain.GetLevel(0).m_height,
+                          (u32)a_chain.GetNumLevels() };
+
+  bool success = fwrite(header, sizeof(header), 1, file) == 1;
+  success = success && fwrite(&a_chain.GetData()[0], 1, a_chain.GetData().size(),
+                              file) == a_chain.GetData().size();
+
+  return fclose(file) == 0 && success;
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+GenerateMips(const name_cont& a_files, const ResampleSettings& a_settings,
+             bool a_srgb, bool a_save)
+{
+  const PixelFormat format(4, 1, a_srgb);
+
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  {
+    DecodedImage image;
+    if (DecodeImageFile(a_files[i].c_str(), image) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not decode " << a_files[i];
+      return 1;
+    }
+
+    MipChain chain;
+
+    core_time::Timer mipTimer;
+    chain.Generate(&image.m_pixels[0], image.m_width, image.m_height, format,
+                   a_settings);
+    const f64 mipTime = mipTimer.ElapsedSeconds();
+
+    printf("\n%s: %ix%i, %u levels (%.2f MB) in %.2f ms on %i threads",
+           a_files[i].c_str(), image.m_width, image.m_height,
+           (u32)chain.GetNumLevels(),
+           (f64)chain.GetData().size() / (1024.0 * 1024.0), mipTime * 1000.0,
+           a_settings.m_numThreads);
+
+    if (g_bench)
+    {
+      ResampleSettings serialSettings = a_settings;
+      serialSettings.m_numThreads = 1;
+
+      f64 serialTime = 0;
+      for (tl_int run = 0; run < g_benchRuns; ++run)
+      {
+        MipChain serialChain;
+
+        core_time::Timer serialTimer;
+        serialChain.Generate(&image.m_pixels[0], image.m_width, image.m_height,
+                             format, serialSettings);
+
+        const f64 time = serialTimer.ElapsedSeconds();
+        if (run == 0 || time < serialTime) { serialTime = time; }
+      }
+
+      printf("\n  1 thread: %.2f ms (%.1f MP/s), %.2fx faster on %i threads",
+             serialTime * 1000.0,
+             (f64)image.m_width * image.m_height / serialTime / 1000000.0,
+             serialTime / mipTime, a_settings.m_numThreads);
+    }
+
+    if (a_save && SaveMipChain(chain, a_files[i] + ".mips") == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save " << a_files[i]
+                                         << ".mips";
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Block compresses every image (or its mip chain with --mips) and reports
+// the quality (PSNR of the first level against the original) and the
+// throughput. With --save the texture is written next to the image as
+// <image>.ctex: GL internal format, width, height and number of levels
+// (u32 each) followed by the levels, ready for glCompressedTexImage2D().
+
+bool
+SaveCompressedTexture(const CompressedTexture& a_texture,
+                      const core_str::String& a_fileName)
+{
+  FILE* file = fopen(a_fileName.c_str(), "wb");
+  if (file == nullptr)
+  { return false; }
+
+  const u32 header[4] = { a_texture.GetGlInternalFormat(),
+                          (u32)a_texture.GetLevel(0).m_width,
+                          (u32)a_texture.GetLevel(0).m_height,
+                          (u32)a_texture.GetNumLevels() };
+
+  bool success = fwrite(header, sizeof(header), 1, file) == 1;
+  success = success && fwrite(&a_texture.GetData()[0], 1,
+                              a_texture.GetData().size(), file) ==
+                       a_texture.GetData().size();
+
+  return fclose(file) == 0 && success;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+CompressTexture(const DecodedImage& a_image, const MipChain* a_mips,
+                const CompressSettings& a_settings, CompressedTexture& a_out)
+{
+  if (a_mips)
+  { return a_out.Compress(*a_mips, a_settings); }
+
+  return a_out.Compress(&a_image.m_pixels[0], a_image.m_width,
+                        a_image.m_height, a_settings);
+}
+
+// -----------------------------------------------------------------------
+
+tl_int
+CompressImages(const name_cont& a_files, const CompressSettings& a_settings,
+               const ResampleSettings* a_mipSettings, bool a_save)
+{
+  for (tl_size i = 0; i < a_files.size(); ++i)
+  {
+    DecodedImage image;
+    if (DecodeImageFile(a_files[i].c_str(), image) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not decode " << a_files[i];
+      return 1;
+    }
+
+    MipChain mips;
+    if (a_mipSettings)
+    {
+      mips.Generate(&image.m_pixels[0], image.m_width, image.m_height,
+                    PixelFormat(4, 1, a_settings.m_srgb), *a_mipSettings);
+    }
+
+    CompressedTexture texture;
+
+    core_time::Timer compressTimer;
+    if (CompressTexture(image, a_mipSettings ? &mips : nullptr, a_settings,
+                        texture) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not compress " << a_files[i];
+      return 1;
+    }
+    const f64 compressTime = compressTimer.ElapsedSeconds();
+
+    const CompressedTexture::Level& level = texture.GetLevel(0);
+
+    DecodedImage decompressed;
+    decompressed.m_width = level.m_width;
+    decompressed.m_height = level.m_height;
+    decompressed.m_pixels.resize((tl_size)level.m_width * level.m_height * 4);
+    DecompressImage(texture.GetLevelData(0), level.m_width, level.m_height,
+                    a_settings.m_format, &decompressed.m_pixels[0],
+                    a_settings.m_numThreads);
+
+    const f64 psnr = GetPsnr(&decompressed.m_pixels[0], &image.m_pixels[0],
+                             image.m_width, image.m_height,
+                             GetNumChannels(a_settings.m_format));
+
+    f64 numPixels = 0;
+    for (tl_size l = 0; l < texture.GetNumLevels(); ++l)
+    { numPixels += (f64)texture.GetLevel(l).m_width * texture.GetLevel(l).m_height; }
+
+    printf("\n%s: %ix%i, %u levels, %s %s",
+           a_files[i].c_str(), image.m_width, image.m_height,
+           (u32)texture.GetNumLevels(), GetFormatName(a_settings.m_format),
+           a_settings.m_quality == k_qualityHigh ? "high quality" : "fast");
+    printf("\n  %.2f MB (RGBA8: %.2f MB), PSNR %.2f dB",
+           (f64)texture.GetData().size() / (1024.0 * 1024.0),
+           numPixels * 4.0 / (1024.0 * 1024.0), psnr);
+    printf("\n  %.2f ms (%.1f MP/s) on %i threads",
+           compressTime * 1000.0, numPixels / compressTime / 1000000.0,
+           a_settings.m_numThreads);
+
+    if (g_bench)
+    {
+      CompressSettings serialSettings = a_settings;
+      serialSettings.m_numThreads = 1;
+
+      f64 serialTime = 0;
+      for (tl_int run = 0; run < g_benchRuns; ++run)
+      {
+        CompressedTexture serialTexture;
+
+        core_time::Timer serialTimer;
+        CompressTexture(image, a_mipSettings ? &mips : nullptr, serialSettings,
+                        serialTexture);
+
+        const f64 time = serialTimer.ElapsedSeconds();
+        if (run == 0 || time < serialTime) { serialTime = time; }
+      }
+
+      printf("\n  1 thread: %.2f ms (%.1f MP/s), %.2fx faster on %i threads",
+             serialTime * 1000.0, numPixels / serialTime / 1000000.0,
+             serialTime / compressTime, a_settings.m_numThreads);
+    }
+
+    if (a_save && SaveCompressedTexture(texture, a_files[i] + ".ctex") == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not save " << a_files[i]
+                                         << ".ctex";
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Streams a UI-like overlay into a texture for a number of frames: a video
+// rectangle copied in every frame, a few widgets filled at random places
+// and a cursor drawn pixel by pixel. Compares re-sending the whole image
+// (what TextureObject::Update() does) with staging the dirty regions only.
+// Nothing is uploaded, the stager just counts what it would send.
+
+namespace {
+
+  const tl_int g_streamSize = 1024;
+  const tl_int g_videoWidth = 320;
+  const tl_int g_videoHeight = 180;
+  const tl_int g_cursorSize = 16;
+  const tl_int g_maxWidgets = 4;
+
+  class CountingStager
+    : public TextureStager
+  {
+  public:
+    CountingStager()
+      : m_numRegions(0)
+    { }
+
+    tl_size m_numRegions;
+
+  protected:
+    void  DoUpload(tl_int , const StagingBuffer& a_buffer)
+    { m_numRegions += a_buffer.m_regions.size(); }
+  };
+
+  tl_int  DoRandom(tl_int a_min, tl_int a_max)
+  { return core_rng::g_defaultRNG.GetRandomInteger(a_min, a_max); }
+
+};
+
+tl_int
+BenchDirtyUpdates(tl_int a_numFrames)
+{
+  if (a_numFrames <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "--bench-dirty requires a positive number of frames";
+    return 1;
+  }
+
+  const tl_int size = g_streamSize;
+
+  TrackedImage image;
+  image.Create(size, size, nullptr);
+  image.ClearDirty();
+
+  core_conts::Array<u8> video((tl_size)g_videoWidth * g_videoHeight * 4);
+  core_conts::Array<u8> fullCopy(image.GetPixels().size());
+
+  CountingStager stager;
+
+  f64 drawTime = 0, stageTime = 0, fullTime = 0;
+  for (tl_int frame = 0; frame < a_numFrames; ++frame)
+  {
+    // a new video frame, the widgets and the cursor
+    for (tl_size i = 0; i < video.size(); ++i)
+    { video[i] = (u8)(i + frame); }
+
+    core_time::Timer drawTimer;
+    image.SetPixels(size - g_videoWidth - 32, 32, g_videoWidth, g_videoHeight,
+                    &video[0], g_videoWidth);
+
+    const tl_int numWidgets = DoRandom(0, g_maxWidgets + 1);
+    for (tl_int i = 0; i < numWidgets; ++i)
+    {
+      const u8 color[4] = { (u8)DoRandom(0, 256), (u8)DoRandom(0, 256),
+                            (u8)DoRandom(0, 256), 255 };
+      image.Fill(DoRandom(0, size), DoRandom(0, size), DoRandom(16, 97),
+                 DoRandom(16, 97), color);
+    }
+
+    const tl_int cursorX = DoRandom(0, size - g_cursorSize);
+    const tl_int cursorY = DoRandom(0, size - g_cursorSize);
+    for (tl_int y = 0; y < g_cursorSize; ++y)
+    {
+      for (tl_int x = 0; x <= y; ++x)
+      {
+        const u8 color[4] = { 255, 255, 255, 255 };
+        image.SetPixel(cursorX + x, cursorY + y, color);
+      }
+    }
+    drawTime += drawTimer.ElapsedSeconds();
+
+    // the whole image, as a full update sends it
+    core_time::Timer fullTimer;
+    memcpy(&fullCopy[0], &image.GetPixels()[0], fullCopy.size());
+    fullTime += fullTimer.ElapsedSeconds();
+
+    core_time::Timer stageTimer;
+    stager.Update(image);
+    stageTime += stageTimer.ElapsedSeconds();
+  }
+
+  const f64 numFrames = (f64)a_numFrames;
+  const f64 fullBytes = (f64)fullCopy.size();
+  const f64 stagedBytes = (f64)stager.GetBytesStaged() / numFrames;
+
+  printf("\n%d frames of a %dx%d RGBA8 texture:", a_numFrames, size, size);
+  printf("\n  full update: %.2f MB, copy %.3f ms per frame",
+         fullBytes / (1024.0 * 1024.0), fullTime * 1000.0 / numFrames);
+  printf("\n  dirty regions: %.2f MB (%.1f%%) in %.1f regions, staging %.3f ms per frame",
+         stagedBytes / (1024.0 * 1024.0), stagedBytes * 100.0 / fullBytes,
+         (f64)stager.m_numRegions / numFrames, stageTime * 1000.0 / numFrames);
+  printf("\n  drawing with dirty tracking: %.3f ms per frame",
+         drawTime * 1000.0 / numFrames);
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Converts and fills a square image the way the samples write their
+// pixels, one at a time through a checked accessor with a float color,
+// and with the bulk image view functions on one and on --threads threads.
+// Reports the bytes read and written per second, next to a plain memcpy()
+// of the same image.
+
+namespace {
+
+  struct PixelBench
+  {
+    const char* m_name;
+    PixelFormat m_src;
+    PixelFormat m_dst;
+  };
+
+  void  DoReadPixel(const ImageView& a_view, tl_int a_x, tl_int a_y,
+                    f32* a_rgba)
+  {
+    const PixelFormat& format = a_view.GetFormat();
+    const u8* pixel = a_view.GetPixel(a_x, a_y);
+
+    for (tl_int c = 0; c < 4; ++c)
+    {
+      if (c >= format.m_numChannels)
+      { a_rgba[c] = c == 3 ? 1.0f : 0.0f; }
+      else if (format.m_bytesPerChannel == 1)
+      { a_rgba[c] = pixel[c] / 255.0f; }
+      else if (format.m_bytesPerChannel == 2)
+      { a_rgba[c] = reinterpret_cast<const u16*>(pixel)[c] / 65535.0f; }
+      else
+      { a_rgba[c] = reinterpret_cast<const f32*>(pixel)[c]; }
+    }
+  }
+
+  void  DoWritePixel(const ImageView& a_view, tl_int a_x, tl_int a_y,
+                     const f32* a_rgba)
+  {
+    const PixelFormat& format = a_view.GetFormat();
+    u8* pixel = a_view.GetPixel(a_x, a_y);
+
+    for (tl_int c = 0; c < format.m_numChannels; ++c)
+    {
+      const f32 value = core::Clamp(a_rgba[c], 0.0f, 1.0f);
+      if (format.m_bytesPerChannel == 1)
+      { pixel[c] = (u8)(value * 255.0f + 0.5f); }
+      else if (format.m_bytesPerChannel == 2)
+      { reinterpret_cast<u16*>(pixel)[c] = (u16)(value * 65535.0f + 0.5f); }
+      else
+      { reinterpret_cast<f32*>(pixel)[c] = value; }
+    }
+  }
+
+  // what a per pixel GetPixel()/SetPixel() loop costs, including the
+  // bounds checks the image accessors do in every build
+  bool  DoConvertPerPixel(const ImageView& a_src, const ImageView& a_dst)
+  {
+    for (tl_int y = 0; y < a_dst.GetHeight(); ++y)
+    {
+      for (tl_int x = 0; x < a_dst.GetWidth(); ++x)
+      {
+        if (x >= a_src.GetWidth() || y >= a_src.GetHeight())
+        { return false; }
+
+        f32 rgba[4];
+        DoReadPixel(a_src, x, y, rgba);
+        DoWritePixel(a_dst, x, y, rgba);
+      }
+    }
+
+    return true;
+  }
+
+  f64   DoGetGbPerSecond(tl_size a_bytes, f64 a_seconds)
+  { return a_seconds > 0 ? (f64)a_bytes / a_seconds / 1e9 : 0.0; }
+
+};
+
+tl_int
+BenchPixelOps(tl_int a_size)
+{
+  if (a_size <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "--bench-pixels requires a positive image size";
+    return 1;
+  }
+
+  const PixelBench benches[] =
+  {
+    { "rgba8 -> rgb8",    PixelFormat(4, 1), PixelFormat(3, 1) },
+    { "rgba8 -> rgba16",  PixelFormat(4, 1), PixelFormat(4, 2) },
+    { "rgba16 -> rgba8",  PixelFormat(4, 2), PixelFormat(4, 1) },
+    { "rgba8 -> rgbaf",   PixelFormat(4, 1), PixelFormat(4, 4) },
+    { "rgbaf -> rgba8",   PixelFormat(4, 4), PixelFormat(4, 1) },
+    { "rgb16 -> rg8",     PixelFormat(3, 2), PixelFormat(2, 1) },
+  };
+  const tl_size numBenches = sizeof(benches) / sizeof(benches[0]);
+
+  const tl_size numPixels = (tl_size)a_size * a_size;
+  core_conts::Array<u8> srcData(numPixels * 16);
+  core_conts::Array<u8> dstData(numPixels * 16);
+
+  for (tl_size i = 0; i < srcData.size(); ++i)
+  { srcData[i] = (u8)(i * 7 + (i >> 12)); }
+
+  printf("\nPixel operations on a %dx%d image, GB/s read + written:", a_size, a_size);
+  printf("\n  %-18s %10s %10s %10s", "", "per pixel", "1 thread", "threads");
+
+  for (tl_size i = 0; i < numBenches; ++i)
+  {
+    const PixelBench& bench = benches[i];
+
+    // float sources hold 0-1 values, like a converted image would
+    const ImageView src(&srcData[0], a_size, a_size, bench.m_src);
+    const ImageView dst(&dstData[0], a_size, a_size, bench.m_dst);
+    if (bench.m_src.m_bytesPerChannel == 4)
+    {
+      memcpy(&dstData[0], &srcData[0], numPixels * 4);
+      ConvertImage(ImageView(&dstData[0], a_size, a_size, PixelFormat()), src,
+                   g_numThreads);
+    }
+
+    f64 perPixelTime = 0, serialTime = 0, threadedTime = 0;
+    for (tl_int run = 0; run < g_benchRuns; ++run)
+    {
+      core_time::Timer perPixelTimer;
+      DoConvertPerPixel(src, dst);
+      const f64 perPixel = perPixelTimer.ElapsedSeconds();
+
+      core_time::Timer serialTimer;
+      ConvertImage(src, dst, 1);
+      const f64 serial = serialTimer.ElapsedSeconds();
+
+      core_time::Timer threadedTimer;
+      ConvertImage(src, dst, g_numThreads);
+      const f64 threaded = threadedTimer.ElapsedSeconds();
+
+      if (run == 0 || perPixel < perPixelTime) { perPixelTime = perPixel; }
+      if (run == 0 || serial < serialTime) { serialTime = serial; }
+      if (run == 0 || threaded < threadedTime) { threadedTime = threaded; }
+    }
+
+    const tl_size bytes =
+      numPixels * (bench.m_src.GetPixelSize() + bench.m_dst.GetPixelSize());
+    printf("\n  %-18s %10.2f %10.2f %10.2f", bench.m_name,
+           DoGetGbPerSecond(bytes, perPixelTime),
+           DoGetGbPerSecond(bytes, serialTime),
+           DoGetGbPerSecond(bytes, threadedTime));
+  }
+
+  // filling an rgba8 image, bytes written only
+  {
+    const ImageView dst(&dstData[0], a_size, a_size, PixelFormat());
+    const f32 color[4] = { 0.25f, 0.5f, 0.75f, 1.0f };
+
+    f64 perPixelTime = 0, serialTime = 0, threadedTime = 0;
+    for (tl_int run = 0; run < g_benchRuns; ++run)
+    {
+      core_time::Timer perPixelTimer;
+      for (tl_int y = 0; y < a_size; ++y)
+      {
+        for (tl_int x = 0; x < a_size; ++x)
+        { DoWritePixel(dst, x, y, color); }
+      }
+      const f64 perPixel = perPixelTimer.ElapsedSeconds();
+
+      core_time::Timer serialTimer;
+      FillImage(dst, color, 1);
+      const f64 serial = serialTimer.ElapsedSeconds();
+
+      core_time::Timer threadedTimer;
+      FillImage(dst, color, g_numThreads);
+      const f64 threaded = threadedTimer.ElapsedSeconds();
+
+      if (run == 0 || perPixel < perPixelTime) { perPixelTime = perPixel; }
+      if (run == 0 || serial < serialTime) { serialTime = serial; }
+      if (run == 0 || threaded < threadedTime) { threadedTime = threaded; }
+    }
+
+    const tl_size bytes = numPixels * 4;
+    printf("\n  %-18s %10.2f %10.2f %10.2f", "fill rgba8",
+           DoGetGbPerSecond(bytes, perPixelTime),
+           DoGetGbPerSecond(bytes, serialTime),
+           DoGetGbPerSecond(bytes, threadedTime));
+  }
+
+  // the bandwidth ceiling: copying rgba8 without converting anything
+  f64 copyTime = 0;
+  for (tl_int run = 0; run < g_benchRuns; ++run)
+  {
+    core_time::Timer copyTimer;
+    memcpy(&dstData[0], &srcData[0], numPixels * 4);
+    const f64 copy = copyTimer.ElapsedSeconds();
+
+    if (run == 0 || copy < copyTime) { copyTime = copy; }
+  }
+
+  printf("\n  %-18s %10s %10.2f", "memcpy rgba8", "",
+         DoGetGbPerSecond(numPixels * 8, copyTime));
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+struct Arg : public option::Arg
+{
+  static void printError(const char* msg1, const option::Option& opt, const char* msg2)
+  { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << msg1 << opt.name << msg2; }
+
+  static option::ArgStatus Unknown(const option::Option& option, bool msg)
+  {
+    if (msg) printError("Unknown option '", option, "'");
+    return option::ARG_ILLEGAL;
+  }
+
+  static option::ArgStatus Required(const option::Option& option, bool msg)
+  {
+    if (option.arg != 0)
+      return option::ARG_OK;
+
+    if (msg) printError("Option '", option, "' requires an argument");
+    return option::ARG_ILLEGAL;
+  }
+
+  static option::ArgStatus Numeric(const option::Option& option, bool msg)
+  {
+    char* endptr = 0;
+    if (option.arg != 0 && strtol(option.arg, &endptr, 10)) { };
+    if (endptr != option.arg && *endptr == 0)
+      return option::ARG_OK;
+
+    if (msg) printError("Option '", option, "' requires a numeric argument");
+    return option::ARG_ILLEGAL;
+  }
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+#define TLOC_COMMAND_LINE_SKIP_PROGRAM_NAME(_argc_, _argv_)\
+  _argc_ = _argc_ > 0 ? --_argc_ : _argc_;\
+  _argv_ = _argc_ > 0 ? ++_argv_ : _argv_
+
+enum optionIndex { UNKNOWN = 0, HELP, IN_FILE, MANIFEST, THREADS, BENCH, MIPS, SAVE, FILTER, WRAP, LINEAR, COMPRESS, HIGH_QUALITY, BENCH_DIRTY, BENCH_PIXELS };
+const option::Descriptor usage[] =
+{
+  { UNKNOWN, 0, "", ""           , Arg::Unknown   , "\nUSAGE: tlocUtilsImageCooker [options]\n\n"
+                                                    "Options:" },
+  { HELP, 0, "", "help"          , Arg::None      , "  \t--help  \tPrint usage and exit." },
+  { IN_FILE, 0, "i", "input"     , Arg::Required  , "  -i <filename>, \t--input=<filename> \tPNG or JPEG file to decode. Can be given more than once." },
+  { MANIFEST, 0, "", "manifest"  , Arg::Required  , "  \t--manifest=<filename> \tDecodes every image listed (one per line)." },
+  { THREADS, 0, "", "threads"    , Arg::Numeric   , "  \t--threads=<n> \tNumber of threads: images decoded at the same time, or threads filtering mip rows, compressing blocks and converting pixels (default: 4)." },
+  { BENCH, 0, "", "bench"        , Arg::None      , "  \t--bench \tCompares the gfx_med image loaders with DecodeImageFiles() on one and on --threads threads (with --mips or --compress: one thread)." },
+  { MIPS, 0, "", "mips"          , Arg::None      , "  \t--mips \tGenerates the mip chain of every image." },
+  { SAVE, 0, "", "save"          , Arg::None      , "  \t--save \tSaves each mip chain as <image>.mips, each compressed texture as <image>.ctex." },
+  { FILTER, 0, "", "filter"      , Arg::Required  , "  \t--filter=<box|kaiser|lanczos> \tMip filter (default: kaiser)." },
+  { WRAP, 0, "", "wrap"          , Arg::None      , "  \t--wrap \tThe images tile, mip filters wrap around their edges." },
+  { LINEAR, 0, "", "linear"      , Arg::None      , "  \t--linear \tThe images hold data (e.g. normals), not sRGB colors." },
+  { COMPRESS, 0, "", "compress"  , Arg::Required  , "  \t--compress=<bc1|bc3|bc5|etc2|etc2a> \tBlock compresses every image (its mip chain with --mips) and reports PSNR and throughput." },
+  { HIGH_QUALITY, 0, "", "hq"    , Arg::None      , "  \t--hq \tWith --compress, the slower high quality encoder." },
+  { BENCH_DIRTY, 0, "", "bench-dirty", Arg::Numeric, "  \t--bench-dirty=<frames> \tStreams a UI overlay into a 1024x1024 texture and compares full updates with dirty region staging." },
+  { BENCH_PIXELS, 0, "", "bench-pixels", Arg::Numeric, "  \t--bench-pixels=<size> \tConverts and fills a <size>x<size> image pixel by pixel and with the bulk image view functions (e.g. 2048)." },
+  { 0, 0, 0, 0, 0, 0 }
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+int TLOC_MAIN(int argc, char *argv[])
+{
+  core::memory::tracking::DoDisableTracking();
+
+  TLOC_COMMAND_LINE_SKIP_PROGRAM_NAME(argc, argv);
+  option::Stats   stats(usage, argc, argv);
+  option::Option* options = new option::Option[stats.options_max];
+  option::Option* buffer  = new option::Option[stats.buffer_max];
+  option::Parser  parse(usage, argc, argv, options, buffer);
+
+  if (parse.error())
+  {
+    option::printUsage(TLOC_LOG_DEFAULT_INFO_NO_FILENAME(), usage);
+    return 1;
+  }
+
+  if (argc == 0 || options[HELP] || options[UNKNOWN] ||
+      (options[IN_FILE] == nullptr && options[MANIFEST] == nullptr &&
+       options[BENCH_DIRTY] == nullptr && options[BENCH_PIXELS] == nullptr))
+  {
+    option::printUsage(TLOC_LOG_DEFAULT_INFO_NO_FILENAME(), usage);
+    return 0;
+  }
+
+  g_bench = options[BENCH] != nullptr;
+
+  if (options[THREADS])
+  { g_numThreads = atoi(options[THREADS].arg); }
+
+  if (g_numThreads <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The number of threads must be positive";
+    return 1;
+  }
+
+  if (options[BENCH_DIRTY])
+  { return BenchDirtyUpdates(atoi(options[BENCH_DIRTY].arg)); }
+
+  if (options[BENCH_PIXELS])
+  { return BenchPixelOps(atoi(options[BENCH_PIXELS].arg)); }
+
+  name_cont inFiles;
+  for (option::Option* opt = options[IN_FILE]; opt; opt = opt->next())
+  { inFiles.push_back(core_str::String(opt->arg)); }
+
+  if (options[MANIFEST])
+  {
+    core_io::Path manifest = core_io::Path(core_str::String(options[MANIFEST].arg));
+    if (GetFilesFromManifest(manifest, inFiles) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not read " << manifest;
+      return 1;
+    }
+  }
+
+  for (tl_size i = 0; i < inFiles.size(); ++i)
+  {
+    if (core_io::Path(inFiles[i]).FileExists() == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << inFiles[i] << " does not exist";
+      return 1;
+    }
+  }
+
+  if (inFiles.empty())
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "No images to decode";
+    return 1;
+  }
+
+  ResampleSettings mipSettings;
+  mipSettings.m_wrap = options[WRAP] != nullptr;
+  mipSettings.m_numThreads = g_numThreads;
+
+  if (options[FILTER])
+  {
+    const char* filter = options[FILTER].arg;
+    if (strcmp(filter, "box") == 0)
+    { mipSettings.m_filter = k_filterBox; }
+    else if (strcmp(filter, "lanczos") == 0)
+    { mipSettings.m_filter = k_filterLanczos; }
+    else if (strcmp(filter, "kaiser") != 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Unknown filter: " << filter;
+      return 1;
+    }
+  }
+
+  if (options[COMPRESS])
+  {
+    CompressSettings settings;
+    settings.m_srgb = options[LINEAR] == nullptr;
+    settings.m_numThreads = g_numThreads;
+    settings.m_quality = options[HIGH_QUALITY] ? k_qualityHigh : k_qualityFast;
+
+    const char* format = options[COMPRESS].arg;
+    if (strcmp(format, "bc1") == 0)
+    { settings.m_format = k_bc1; }
+    else if (strcmp(format, "bc3") == 0)
+    { settings.m_format = k_bc3; }
+    else if (strcmp(format, "bc5") == 0)
+    { settings.m_format = k_bc5; }
+    else if (strcmp(format, "etc2") == 0)
+    { settings.m_format = k_etc2Rgb; }
+    else if (strcmp(format, "etc2a") == 0)
+    { settings.m_format = k_etc2Rgba; }
+    else
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Unknown compressed format: " << format;
+      return 1;
+    }
+
+    return CompressImages(inFiles, settings,
+                          options[MIPS] ? &mipSettings : nullptr,
+                          options[SAVE] != nullptr);
+  }
+
+  if (options[MIPS])
+  {
+    return GenerateMips(inFiles, mipSettings, options[LINEAR] == nullptr,
+                        options[SAVE] != nullptr);
+  }
+
+  if (g_bench)
+  { return BenchDecoding(inFiles); }
+
+  return DecodeImages(inFiles);
+}
@@ -0,0 +1,1184 @@
+#include <tlocCore/tloc_core.h>
+#include <tlocCore/tloc_core.inl.h>
+#include <tlocGraphics/tloc_graphics.h>
+#include <tlocMath/tloc_math.h>
+#include <tlocMath/tloc_math.inl.h>
+#include <3rdParty/Core/CL/include/optionparser.h>
+
+#include <tlocAsyncLoading/src/asyncLoader.h>
+#include <tlocAsyncLoading/src/loadRequests.h>
+#include <tlocMeshTools/src/cookedMesh.h>
+#include <tlocMeshTools/src/indexedMesh.h>
+#include <tlocMeshTools/src/lodSelector.h>
+#include <tlocMeshTools/src/mappedFile.h>
+#include <tlocMeshTools/src/meshlets.h>
+#include <tlocMeshTools/src/meshOptimizer.h>
+#include <tlocMeshTools/src/meshSimplifier.h>
+#include <tlocMeshTools/src/objParser.h>
+#include <tlocMeshTools/src/quantizedMesh.h>
+#include <tlocMeshTools/src/sharedMesh.h>
+
+#include <tlocCore/smart_ptr/tloc_smart_ptr.inl.h>
+#include <tlocCore/containers/tlocArray.inl.h>
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <thread>
+
+using namespace tloc;
+
+namespace {
+
+  bool   g_bench = false;
+  bool   g_optimize = false;
+  bool   g_meshlets = false;
+  tl_int g_numThreads = 4;
+
+  core_conts::Array<f32> g_lodRatios;
+  f32                       g_lodMaxError = 0.02f;
+
+  // the benchmark keeps the fastest of this many runs
+  const tl_int g_benchRuns = 3;
+  const tl_int g_defaultChunkKB = 1024;
+
+  // LOD selection benchmark: the camera flies through a grid of instances
+  // and a LOD keeps its triangles about this many pixels apart
+  const tl_int g_selectFrames = 240;
+  const f32    g_fullDetailPixels = 1024.0f;
+  const f32    g_pixelsPerUnit = 1080.0f / 1.1547f; // 1080p, 60 degrees
+
+  // meshlet culling is checked from these directions, outside the mesh
+  // (at 2.5 times its radius, looking at it) and inside it
+  const f32    g_cullViews[][3] = 
+  { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, 
+    { 0, 0, -1 }, { 1, 1, 1 }, { -1, 0.5f, 0.3f } };
+  const f32    g_cullDistances[] = { 2.5f, 0.5f };
+
+  // asynchronous loading benchmark: 60 frames per second, each spending at
+  // most this much of its time finishing loaded meshes
+  const f64    g_asyncFrameSeconds = 1.0 / 60.0;
+  const f64    g_asyncFrameBudget = 0.002;
+
+  typedef gfx_med::ObjLoader::vert_cont_type   vert_cont;
+  typedef vert_cont::value_type                 vert_type;
+
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+MeshCookSettings
+GetCookSettings()
+{
+  MeshCookSettings settings;
+  settings.m_numThreads = g_numThreads;
+  settings.m_optimize = g_optimize;
+  settings.m_meshlets = g_meshlets;
+  settings.m_lodRatios = g_lodRatios;
+  settings.m_lodMaxError = g_lodMaxError;
+  return settings;
+}
+
+// -----------------------------------------------------------------------
+// Parses "0.5,0.25,0.1". Ratios must be in (0, 1) and decreasing.
+
+bool
+ParseLodRatios(const char* a_arg, core_conts::Array<f32>& a_out)
+{
+  a_out.clear();
+
+  const char* it = a_arg;
+  while (*it)
+  {
+    char* end = nullptr;
+    const f32 ratio = (f32)strtod(it, &end);
+    if (end == it || ratio <= 0.0f || ratio >= 1.0f ||
+        (a_out.empty() == false && ratio >= a_out.back()))
+    { return false; }
+
+    a_out.push_back(ratio);
+
+    it = end;
+    if (*it == ',')
+    { ++it; }
+    else if (*it != 0)
+    { return false; }
+  }
+
+  return a_out.empty() == false;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Same output as ObjLoader::GetUnpacked(): three vertices per triangle with
+// the position, normal and texture coordinates of every corner.
+
+void
+GetUnpacked(const ObjMesh& a_mesh, const ObjGroup& a_group, vert_cont& a_out)
+{
+  a_out.clear();
+  a_out.reserve(a_group.m_numTriangles * 3);
+
+  const tl_size cornerBegin = a_group.m_firstTriangle * 3;
+  const tl_size cornerEnd = cornerBegin + a_group.m_numTriangles * 3;
+
+  for (tl_size i = cornerBegin; i < cornerEnd; ++i)
+  {
+    const ObjCorner& corner = a_mesh.m_corners[i];
+
+    const f32* pos = &a_mesh.m_positions[corner.m_position * 3];
+
+    math_t::Vec3f32 normal(0, 0, 0);
+    if (corner.m_normal != ObjCorner::k_noIndex)
+    {
+      const f32* n = &a_mesh.m_normals[corner.m_normal * 3];
+      normal = math_t::Vec3f32(n[0], n[1], n[2]);
+    }
+
+    math_t::Vec2f32 texCoord(0, 0);
+    if (corner.m_texCoord != ObjCorner::k_noIndex)
+    {
+      const f32* tc = &a_mesh.m_texCoords[corner.m_texCoord * 2];
+      texCoord = math_t::Vec2f32(tc[0], tc[1]);
+    }
+
+    vert_type vert;
+    vert.SetPosition(math_t::Vec3f32(pos[0], pos[1], pos[2]));
+    vert.SetNormal(normal);
+    vert.SetTexCoord(texCoord);
+
+    a_out.push_back(vert);
+  }
+}
+
+// -----------------------------------------------------------------------
+// Welded vertices in the vertex type of ObjLoader, to be used with the
+// index list of the IndexedMesh
+
+void
+GetIndexed(const IndexedMesh& a_mesh, vert_cont& a_out)
+{
+  a_out.clear();
+  a_out.reserve(a_mesh.m_vertices.size());
+
+  for (tl_size i = 0; i < a_mesh.m_vertices.size(); ++i)
+  {
+    const MeshVertex& v = a_mesh.m_vertices[i];
+
+    vert_type vert;
+    vert.SetPosition(math_t::Vec3f32(v.m_position[0], v.m_position[1], v.m_position[2]));
+    vert.SetNormal(math_t::Vec3f32(v.m_normal[0], v.m_normal[1], v.m_normal[2]));
+    vert.SetTexCoord(math_t::Vec2f32(v.m_texCoord[0], v.m_texCoord[1]));
+
+    a_out.push_back(vert);
+  }
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Loading paths. The ObjLoader path is what the samples do: the whole file
+// is read into a string, parsed and then unpacked. The ObjParser paths parse
+// straight from a mapped view of the file, or from a stream read in chunks
+// of a_chunkSize bytes, so the only copy of the text is the chunk.
+
+bool
+LoadWithObjLoader(const core_str::String& a_file, tl_size& a_numVertices)
+{
+  core_io::FileIO_ReadA objFile( (core_io::Path(a_file)) );
+  if (objFile.Open() != ErrorSuccess)
+  { return false; }
+
+  core_str::String objFileContents;
+  objFile.GetContents(objFileContents);
+
+  gfx_med::ObjLoader objLoader;
+  if (objLoader.Init(objFileContents) != ErrorSuccess)
+  { return false; }
+
+  a_numVertices = 0;
+  for (tl_size g = 0; g < objLoader.GetNumGroups(); ++g)
+  {
+    vert_cont vertices;
+    objLoader.GetUnpacked(vertices, g);
+    a_numVertices += vertices.size();
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+LoadMapped(const core_str::String& a_file, ObjMesh& a_mesh, 
+           tl_int a_numThreads = 1)
+{
+  MappedFile file;
+  if (file.Open(a_file.c_str()) == false)
+  { return false; }
+
+  ObjParser parser;
+  if (parser.ParseParallel(file.GetData(), file.GetSize(), a_mesh, 
+                           a_numThreads) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Parsing error in " << a_file
+      << " on line " << parser.GetErrorLine();
+    return false;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool
+LoadStreamed(const core_str::String& a_file, tl_size a_chunkSize, ObjMesh& a_mesh)
+{
+  FILE* file = fopen(a_file.c_str(), "rb");
+  if (file == nullptr)
+  { return false; }
+
+  core_conts::Array<char> chunk(a_chunkSize);
+
+  ObjParser parser;
+  parser.Begin(a_mesh);
+
+  bool parsed = true;
+  for (;;)
+  {
+    const tl_size numRead = fread(&chunk[0], 1, a_chunkSize, file);
+    if (numRead == 0)
+    { break; }
+
+    if (parser.ParseChunk(&chunk[0], numRead) == false)
+    { parsed = false; break; }
+  }
+
+  fclose(file);
+
+  if (parser.End() == false || parsed == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Parsing error in " << a_file
+      << " on line " << parser.GetErrorLine();
+    return false;
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------
+
+tl_size
+GetNumUnpackedVertices(const ObjMesh& a_mesh)
+{
+  tl_size numVertices = 0;
+
+  vert_cont vertices;
+  for (tl_size g = 0; g < a_mesh.m_groups.size(); ++g)
+  {
+    GetUnpacked(a_mesh, a_mesh.m_groups[g], vertices);
+    numVertices += vertices.size();
+  }
+
+  return numVertices;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Loads the file with every path g_benchRuns times and prints the fastest
+// run. Both ObjParser paths are timed with and without unpacking so that
+// they can be compared to ObjLoader (which always unpacks).
+
+namespace {
+
+  void
+    DoPrintBench(const char* a_path, f64 a_seconds, tl_size a_fileSize)
+  {
+    const f64 mb = (f64)a_fileSize / (1024.0 * 1024.0);
+    printf("\n[bench] %-16s %10.4f sec %10.2f MB/s", a_path, a_seconds,
+           a_seconds > 0 ? mb / a_seconds : 0.0);
+  }
+
+};
+
+tl_int
+BenchObjLoading(const core_str::String& a_file, tl_size a_chunkSize)
+{
+  MappedFile sizeCheck;
+  if (sizeCheck.Open(a_file.c_str()) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not open " << a_file;
+    return 1;
+  }
+
+  const tl_size fileSize = sizeCheck.GetSize();
+  sizeCheck.Close();
+
+  enum { k_objLoader = 0, k_mapped, k_mappedUnpacked, k_parallel, 
+         k_parallelUnpacked, k_streamed, k_streamedUnpacked, k_cooked, 
+         k_count };
+
+  const char* names[k_count] =
+  { "ObjLoader", "mapped", "mapped+unpack", "parallel", "parallel+unpack", 
+    "streamed", "streamed+unpack", "cooked" };
+
+  f64     best[k_count];
+  tl_size numVertices[k_count];
+  for (tl_int i = 0; i < k_count; ++i)
+  { best[i] = -1.0; numVertices[i] = 0; }
+
+  // the cooked path only times loading the cooked mesh
+  CookedMesh cookedMesh;
+  const MeshCookSettings settings = GetCookSettings();
+  if (LoadCookedMesh(a_file.c_str(), settings, cookedMesh) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not cook " << a_file;
+    return 1;
+  }
+  cookedMesh.Close();
+
+  for (tl_int run = 0; run < g_benchRuns; ++run)
+  {
+    for (tl_int path = 0; path < k_count; ++path)
+    {
+      core_time::Timer timer;
+
+      bool    loaded = false;
+      ObjMesh mesh;
+      if (path == k_objLoader)
+      { loaded = LoadWithObjLoader(a_file, numVertices[path]); }
+      else if (path == k_mapped || path == k_mappedUnpacked)
+      { loaded = LoadMapped(a_file, mesh); }
+      else if (path == k_parallel || path == k_parallelUnpacked)
+      { loaded = LoadMapped(a_file, mesh, g_numThreads); }
+      else if (path == k_cooked)
+      {
+        CookedMesh cookedMesh;
+        loaded = LoadCookedMesh(a_file.c_str(), settings, cookedMesh);
+      }
+      else
+      { loaded = LoadStreamed(a_file, a_chunkSize, mesh); }
+
+      if (loaded == false)
+      {
+        TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << names[path] << " could not load "
+          << a_file;
+        return 1;
+      }
+
+      if (path == k_mappedUnpacked || path == k_parallelUnpacked || 
+          path == k_streamedUnpacked)
+      { numVertices[path] = GetNumUnpackedVertices(mesh); }
+
+      const f64 seconds = timer.ElapsedSeconds();
+      if (best[path] < 0 || seconds < best[path])
+      { best[path] = seconds; }
+    }
+  }
+
+  printf("\nFile size: %.2f MB, best of %d runs, chunk size %u KB, %d threads",
+         (f64)fileSize / (1024.0 * 1024.0), g_benchRuns, 
+         (u32)(a_chunkSize / 1024), g_numThreads);
+
+  for (tl_int path = 0; path < k_count; ++path)
+  { DoPrintBench(names[path], best[path], fileSize); }
+
+  if (numVertices[k_parallelUnpacked] != numVertices[k_mappedUnpacked])
+  {
+    printf("\nWarning: the parallel parse unpacked %u vertices, the serial one %u",
+           (u32)numVertices[k_parallelUnpacked], (u32)numVertices[k_mappedUnpacked]);
+  }
+
+  if (numVertices[k_objLoader] != numVertices[k_mappedUnpacked])
+  {
+    printf("\nWarning: ObjLoader unpacked %u vertices, ObjParser %u",
+           (u32)numVertices[k_objLoader], (u32)numVertices[k_mappedUnpacked]);
+  }
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Instances of the cooked mesh on a square grid, the camera flying over
+// them. The LOD thresholds follow the ratios: a LOD with a quarter of the
+// triangles is used at half the size on screen.
+
+int
+BenchLodSelection(const core_str::String& a_file, tl_size a_numInstances)
+{
+  CookedMesh cookedMesh;
+  if (LoadCookedMesh(a_file.c_str(), GetCookSettings(), cookedMesh) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not cook " << a_file;
+    return 1;
+  }
+
+  if (cookedMesh.GetNumLods() == 0 || cookedMesh.GetNumVertices() == 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "--select needs a mesh with --lods";
+    return 1;
+  }
+
+  // bounding sphere around the center of the bounding box
+  f32 boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  f32 boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (tl_size i = 0; i < cookedMesh.GetNumVertices(); ++i)
+  {
+    const f32* position = cookedMesh.GetVertices()[i].m_position;
+    for (tl_int axis = 0; axis < 3; ++axis)
+    {
+      boxMin[axis] = core::tlMin(boxMin[axis], position[axis]);
+      boxMax[axis] = core::tlMax(boxMax[axis], position[axis]);
+    }
+  }
+
+  f32 radius = 0.0f;
+  for (tl_int axis = 0; axis < 3; ++axis)
+  {
+    const f32 extent = (boxMax[axis] - boxMin[axis]) * 0.5f;
+    radius += extent * extent;
+  }
+  radius = core::tlMax((f32)sqrt(radius), 0.001f);
+
+  core_conts::Array<f32> thresholds;
+  for (tl_size i = 0; i < cookedMesh.GetNumLods(); ++i)
+  { thresholds.push_back(g_fullDetailPixels * sqrt(cookedMesh.GetLod(i).m_ratio)); }
+
+  LodSelector selector;
+  selector.SetThresholds(&thresholds[0], thresholds.size());
+  const tl_size mesh = selector.AddMesh(cookedMesh);
+
+  const tl_size side = (tl_size)ceil(sqrt((f64)a_numInstances));
+  const f32     spacing = radius * 4.0f;
+  for (tl_size i = 0; i < a_numInstances; ++i)
+  {
+    const f32 center[3] = 
+    { (f32)(i % side) * spacing, 0.0f, (f32)(i / side) * spacing };
+    selector.AddInstance(mesh, center, radius);
+  }
+
+  const f32 gridSize = (f32)side * spacing;
+
+  f64 totalTime = 0;
+  f64 maxTime = 0;
+  u64 numTriangles = 0;
+  u64 numSaved = 0;
+  u64 numChanged = 0;
+  for (tl_int frame = 0; frame < g_selectFrames; ++frame)
+  {
+    LodCamera camera;
+    camera.m_position[0] = gridSize * 0.5f;
+    camera.m_position[1] = radius * 2.0f;
+    camera.m_position[2] = gridSize * (f32)frame / (f32)g_selectFrames;
+    camera.m_pixelsPerUnit = g_pixelsPerUnit;
+
+    core_time::Timer timer;
+    const LodSelectionStats stats = selector.Select(camera, g_numThreads);
+    const f64 seconds = timer.ElapsedSeconds();
+
+    totalTime += seconds;
+    maxTime = core::tlMax(maxTime, seconds);
+
+    // the first frame picks every LOD from scratch
+    if (frame > 0)
+    { numChanged += stats.m_numChanged; }
+    numTriangles += stats.m_numTriangles;
+    numSaved += stats.m_numTrianglesSaved;
+  }
+
+  printf("\nSelected LODs of %u instances over %d frames, %d threads",
+         (u32)a_numInstances, g_selectFrames, g_numThreads);
+  printf("\n  %.3f ms per frame (%.3f ms at most)", 
+         totalTime * 1000.0 / g_selectFrames, maxTime * 1000.0);
+  printf("\n  %.0f triangles per frame, %.0f saved (%.1f%%), %.1f LOD changes",
+         (f64)numTriangles / g_selectFrames, (f64)numSaved / g_selectFrames,
+         100.0 * (f64)numSaved / (f64)(numTriangles + numSaved),
+         (f64)numChanged / (g_selectFrames - 1));
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Stands in for creating the vertex and index buffers of a loaded mesh,
+// the part of loading that has to stay on the main thread.
+
+void
+UploadMesh(const IndexedMesh& a_mesh, core_conts::Array<u8>& a_buffer)
+{
+  const tl_size vertexBytes = a_mesh.m_vertices.size() * sizeof(MeshVertex);
+  const tl_size indexBytes = a_mesh.GetNumIndices() * a_mesh.GetIndexSize();
+
+  a_buffer.resize(vertexBytes + indexBytes);
+  if (vertexBytes > 0)
+  { memcpy(&a_buffer[0], &a_mesh.m_vertices[0], vertexBytes); }
+  if (indexBytes > 0)
+  {
+    const void* indices = a_mesh.GetIndexSize() == 2 
+      ? (const void*)&a_mesh.m_shortIndices[0] : (const void*)&a_mesh.m_indices[0];
+    memcpy(&a_buffer[vertexBytes], indices, indexBytes);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+class UploadedMeshRequest
+  : public ObjMeshRequest
+{
+public:
+  explicit UploadedMeshRequest(const char* a_fileName)
+    : ObjMeshRequest(a_fileName)
+  { }
+
+protected:
+  bool DoFinish()
+  {
+    UploadMesh(GetMesh(), m_buffer);
+    return true;
+  }
+
+private:
+  core_conts::Array<u8> m_buffer;
+};
+
+// -----------------------------------------------------------------------
+// Loads a_numFiles copies of the OBJ file the way the samples do (parsed,
+// welded and uploaded on the main thread before the first frame) and
+// through an AsyncLoader, with frames of g_asyncFrameSeconds finishing the
+// loaded meshes for at most g_asyncFrameBudget each.
+
+int
+BenchAsyncLoading(const core_str::String& a_file, tl_size a_numFiles)
+{
+  core_time::Timer serialTimer;
+  for (tl_size i = 0; i < a_numFiles; ++i)
+  {
+    ObjMesh mesh;
+    if (LoadMapped(a_file, mesh) == false)
+    { return 1; }
+
+    IndexedMesh indexed;
+    WeldMesh(mesh, indexed);
+
+    core_conts::Array<u8> buffer;
+    UploadMesh(indexed, buffer);
+  }
+  const f64 serialTime = serialTimer.ElapsedSeconds();
+
+  core_conts::Array<UploadedMeshRequest*> requests;
+  for (tl_size i = 0; i < a_numFiles; ++i)
+  { requests.push_back(new UploadedMeshRequest(a_file.c_str())); }
+
+  f64     asyncTime = 0;
+  f64     maxFinishTime = 0;
+  tl_int  numFrames = 0;
+  {
+    core_time::Timer asyncTimer;
+
+    AsyncLoader loader(g_numThreads);
+    for (tl_size i = 0; i < a_numFiles; ++i)
+    { loader.Load(*requests[i]); }
+
+    while (loader.GetNumPending() > 0)
+    {
+      core_time::Timer frameTimer;
+      loader.Finish(g_asyncFrameBudget);
+      const f64 finishTime = frameTimer.ElapsedSeconds();
+
+      maxFinishTime = core::tlMax(maxFinishTime, finishTime);
+      ++numFrames;
+
+      // the rest of the frame (rendering, ...)
+      if (finishTime < g_asyncFrameSeconds)
+      {
+        std::this_thread::sleep_for
+          (std::chrono::duration<f64>(g_asyncFrameSeconds - finishTime));
+      }
+    }
+
+    asyncTime = asyncTimer.ElapsedSeconds();
+  }
+
+  tl_size numFailed = 0;
+  for (tl_size i = 0; i < a_numFiles; ++i)
+  {
+    if (requests[i]->GetState() != AsyncRequest::k_done)
+    { ++numFailed; }
+    delete requests[i];
+  }
+
+  if (numFailed > 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << numFailed << " of the asynchronous "
+      "loads of " << a_file << " failed";
+    return 1;
+  }
+
+  printf("\nLoaded %s %u times", a_file.c_str(), (u32)a_numFiles);
+  printf("\n  serial: %f sec with the main thread blocked", serialTime);
+  printf("\n  async:  %f sec on %d threads over %d frames, "
+         "%.3f ms in Finish() at most (budget %.3f ms)",
+         asyncTime, g_numThreads, numFrames, maxFinishTime * 1000.0,
+         g_asyncFrameBudget * 1000.0);
+
+  return 0;
+}
+
+// -----------------------------------------------------------------------
+// Creates a_numInstances instances of the OBJ file the way tlocObjLoader
+// creates its crates (each with its own copy of the vertices) and as
+// references to one SharedMesh from a MeshCache.
+
+int
+BenchSharedMesh(const core_str::String& a_file, tl_size a_numInstances)
+{
+  MeshCache cache;
+  shared_mesh_sptr mesh = cache.Load(a_file.c_str(), g_numThreads);
+  if (mesh.get() == nullptr)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not load " << a_file;
+    return 1;
+  }
+
+  const core_conts::Array<MeshVertex>& vertices = mesh->GetMesh().m_vertices;
+
+  f64 copyTime = 0;
+  {
+    core_time::Timer copyTimer;
+
+    core_conts::Array<core_conts::Array<MeshVertex> > copies(a_numInstances);
+    for (tl_size i = 0; i < a_numInstances; ++i)
+    { copies[i] = vertices; }
+
+    copyTime = copyTimer.ElapsedSeconds();
+  }
+
+  f64 shareTime = 0;
+  {
+    core_time::Timer shareTimer;
+
+    core_conts::Array<shared_mesh_sptr> instances(a_numInstances);
+    for (tl_size i = 0; i < a_numInstances; ++i)
+    { instances[i] = cache.Load(a_file.c_str()); }
+
+    shareTime = shareTimer.ElapsedSeconds();
+
+    // the cache, the mesh above and the instances
+    TLOC_ASSERT(mesh.use_count() == a_numInstances + 2, 
+                "The instances do not share the mesh");
+  }
+
+  const f64 meshMB = (f64)(vertices.size() * sizeof(MeshVertex)) / (1024.0 * 1024.0);
+
+  printf("\nCreated %u instances of %s (%u vertices)", (u32)a_numInstances,
+         a_file.c_str(), (u32)vertices.size());
+  printf("\n  copied: %f sec, %.2f MB of vertices, %u buffers",
+         copyTime, meshMB * a_numInstances, (u32)a_numInstances);
+  printf("\n  shared: %f sec, %.2f MB of vertices, 1 buffer, %u bytes per instance",
+         shareTime, meshMB, (u32)sizeof(shared_mesh_sptr));
+
+  return 0;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Column major view projection (60 degree vertical field of view, square
+// viewport) of a camera at a_eye looking at a_target.
+
+void
+GetViewProjection(const f32* a_eye, const f32* a_target, f32 a_near, f32 a_far,
+                  f32* a_out)
+{
+  f32 forward[3] = { a_target[0] - a_eye[0], a_target[1] - a_eye[1], 
+                     a_target[2] - a_eye[2] };
+  f32 length = sqrt(forward[0] * forward[0] + forward[1] * forward[1] + 
+                    forward[2] * forward[2]);
+  for (tl_int i = 0; i < 3; ++i)
+  { forward[i] /= length; }
+
+  const f32 up[3] = 
+  { 0.0f, fabs(forward[1]) > 0.99f ? 0.0f : 1.0f, fabs(forward[1]) > 0.99f ? 1.0f : 0.0f };
+
+  f32 side[3] = { forward[1] * up[2] - forward[2] * up[1], 
+                  forward[2] * up[0] - forward[0] * up[2],
+                  forward[0] * up[1] - forward[1] * up[0] };
+  length = sqrt(side[0] * side[0] + side[1] * side[1] + side[2] * side[2]);
+  for (tl_int i = 0; i < 3; ++i)
+  { side[i] /= length; }
+
+  const f32 realUp[3] = { side[1] * forward[2] - side[2] * forward[1],
+                          side[2] * forward[0] - side[0] * forward[2],
+                          side[0] * forward[1] - side[1] * forward[0] };
+
+  f32 view[16] = { 0 };
+  for (tl_int i = 0; i < 3; ++i)
+  {
+    view[i * 4 + 0] = side[i];
+    view[i * 4 + 1] = realUp[i];
+    view[i * 4 + 2] = -forward[i];
+    view[12] -= side[i] * a_eye[i];
+    view[13] -= realUp[i] * a_eye[i];
+    view[14] += forward[i] * a_eye[i];
+  }
+  view[15] = 1.0f;
+
+  const f32 focal = 1.0f / tan(0.5236f);
+  f32 projection[16] = { 0 };
+  projection[0] = focal;
+  projection[5] = focal;
+  projection[10] = (a_far + a_near) / (a_near - a_far);
+  projection[11] = -1.0f;
+  projection[14] = 2.0f * a_far * a_near / (a_near - a_far);
+
+  for (tl_int column = 0; column < 4; ++column)
+  {
+    for (tl_int row = 0; row < 4; ++row)
+    {
+      f32 sum = 0.0f;
+      for (tl_int k = 0; k < 4; ++k)
+      { sum += projection[k * 4 + row] * view[column * 4 + k]; }
+      a_out[column * 4 + row] = sum;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------
+// Culls the meshlets from a few views and compares the triangles left with
+// the brute force count. A visible triangle in a culled meshlet is an error.
+
+bool
+CheckMeshletCulling(const IndexedMesh& a_mesh)
+{
+  f32 boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+  f32 boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+  for (tl_size i = 0; i < a_mesh.m_vertices.size(); ++i)
+  {
+    const f32* position = a_mesh.m_vertices[i].m_position;
+    for (tl_int axis = 0; axis < 3; ++axis)
+    {
+      boxMin[axis] = core::tlMin(boxMin[axis], position[axis]);
+      boxMax[axis] = core::tlMax(boxMax[axis], position[axis]);
+    }
+  }
+
+  f32 center[3];
+  f32 radius = 0.0f;
+  for (tl_int axis = 0; axis < 3; ++axis)
+  {
+    center[axis] = (boxMin[axis] + boxMax[axis]) * 0.5f;
+    radius += (boxMax[axis] - center[axis]) * (boxMax[axis] - center[axis]);
+  }
+  radius = core::tlMax((f32)sqrt(radius), 0.001f);
+
+  const tl_size numViews = sizeof(g_cullViews) / sizeof(g_cullViews[0]);
+  const tl_size numDistances = sizeof(g_cullDistances) / sizeof(g_cullDistances[0]);
+  const tl_size numTriangles = a_mesh.GetNumIndices() / 3;
+
+  bool    conservative = true;
+  f64     cullTime = 0;
+  f64     bruteTime = 0;
+  tl_size culledTriangles = 0;
+  tl_size bruteTriangles = 0;
+
+  core_conts::Array<TriangleRange> ranges;
+  for (tl_size d = 0; d < numDistances; ++d)
+  {
+    for (tl_size v = 0; v < numViews; ++v)
+    {
+      const f32* direction = g_cullViews[v];
+      const f32 length = sqrt(direction[0] * direction[0] + 
+                              direction[1] * direction[1] + 
+                              direction[2] * direction[2]);
+
+      MeshletView view;
+      for (tl_int i = 0; i < 3; ++i)
+      { view.m_position[i] = center[i] + direction[i] / length * radius * g_cullDistances[d]; }
+
+      f32 viewProjection[16];
+      GetViewProjection(view.m_position, center, radius * 0.001f, radius * 10.0f, 
+                        viewProjection);
+      GetFrustumPlanes(viewProjection, view.m_planes);
+
+      core_time::Timer cullTimer;
+      const MeshletCullStats stats = CullMeshlets(&a_mesh.m_meshlets[0], 
+        a_mesh.m_meshlets.size(), view, ranges);
+      cullTime += cullTimer.ElapsedSeconds();
+
+      core_time::Timer bruteTimer;
+      const tl_size numVisible = 
+        CountVisibleTriangles(a_mesh, view, 0, numTriangles);
+      bruteTime += bruteTimer.ElapsedSeconds();
+
+      tl_size numKept = 0;
+      for (tl_size i = 0; i < ranges.size(); ++i)
+      {
+        numKept += CountVisibleTriangles(a_mesh, view, ranges[i].m_firstTriangle, 
+                                         ranges[i].m_numTriangles);
+      }
+
+      if (numKept != numVisible)
+      { conservative = false; }
+
+      culledTriangles += stats.m_numTriangles;
+      bruteTriangles += numVisible;
+
+      printf("\n  view %u: %u visible, %u back facing, %u outside meshlets, "
+             "%u triangles (%u visible)",
+             (u32)(d * numViews + v), (u32)stats.m_numVisible, 
+             (u32)stats.m_numBackfacing, (u32)stats.m_numOutside, 
+             (u32)stats.m_numTriangles, (u32)numVisible);
+    }
+  }
+
+  const tl_size numChecks = numViews * numDistances;
+  printf("\n  culling: %f ms, brute force: %f ms per view, "
+         "%.1f%% more triangles than brute force%s",
+         cullTime * 1000.0 / numChecks, bruteTime * 1000.0 / numChecks,
+         bruteTriangles ? 100.0 * ((f64)culledTriangles / bruteTriangles - 1.0) : 0.0,
+         conservative ? "" : ", VISIBLE TRIANGLES WERE CULLED");
+
+  return conservative;
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+// Memory, precision and speed of a quantized vertex format
+
+template <typename T_Vertex>
+void
+PrintQuantization(const char* a_name, const IndexedMesh& a_mesh)
+{
+  const tl_size numVertices = a_mesh.m_vertices.size();
+  const PositionQuantization quantization = 
+    GetPositionQuantization(&a_mesh.m_vertices[0], numVertices);
+
+  core_conts::Array<T_Vertex>   quantized(numVertices);
+  core_conts::Array<MeshVertex> decoded(numVertices);
+
+  core_time::Timer encodeTimer;
+  QuantizeVertices(&a_mesh.m_vertices[0], numVertices, quantization, &quantized[0]);
+  const f64 encodeTime = encodeTimer.ElapsedSeconds();
+
+  core_time::Timer decodeTimer;
+  DequantizeVertices(&quantized[0], numVertices, quantization, &decoded[0]);
+  const f64 decodeTime = decodeTimer.ElapsedSeconds();
+
+  const QuantizationError error = 
+    GetQuantizationError(&a_mesh.m_vertices[0], &decoded[0], numVertices);
+
+  const f64 floatSize = (f64)(numVertices * sizeof(MeshVertex));
+  const f64 size = (f64)(numVertices * sizeof(T_Vertex));
+
+  printf("\n  %s: %u bytes per vertex, %.2f MB (%.0f%% of float)", a_name, 
+         (u32)sizeof(T_Vertex), size / (1024.0 * 1024.0), 100.0 * size / floatSize);
+  printf("\n    largest error: position %g (of the extent), normal %f degrees, "
+         "texture coordinates %g", 
+         error.m_position, error.m_normalDegrees, error.m_texCoord);
+  printf("\n    encoded at %.1f, decoded at %.1f million vertices per second",
+         encodeTime > 0 ? numVertices / encodeTime / 1000000.0 : 0.0,
+         decodeTime > 0 ? numVertices / decodeTime / 1000000.0 : 0.0);
+}
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+struct Arg : public option::Arg
+{
+  static void printError(const char* msg1, const option::Option& opt, const char* msg2)
+  { TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << msg1 << opt.name << msg2; }
+
+  static option::ArgStatus Unknown(const option::Option& option, bool msg)
+  {
+    if (msg) printError("Unknown option '", option, "'");
+    return option::ARG_ILLEGAL;
+  }
+
+  static option::ArgStatus Required(const option::Option& option, bool msg)
+  {
+    if (option.arg != 0)
+      return option::ARG_OK;
+
+    if (msg) printError("Option '", option, "' requires an argument");
+    return option::ARG_ILLEGAL;
+  }
+
+  static option::ArgStatus Numeric(const option::Option& option, bool msg)
+  {
+    char* endptr = 0;
+    if (option.arg != 0 && strtol(option.arg, &endptr, 10)) { };
+    if (endptr != option.arg && *endptr == 0)
+      return option::ARG_OK;
+
+    if (msg) printError("Option '", option, "' requires a numeric argument");
+    return option::ARG_ILLEGAL;
+  }
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+#define TLOC_COMMAND_LINE_SKIP_PROGRAM_NAME(_argc_, _argv_)\
+  _argc_ = _argc_ > 0 ? --_argc_ : _argc_;\
+  _argv_ = _argc_ > 0 ? ++_argv_ : _argv_
+
+enum optionIndex { UNKNOWN = 0, HELP, IN_FILE, CHUNK, THREADS, OPTIMIZE, LODS, LOD_ERROR, MESHLETS, QUANTIZE, COOK, BENCH, SELECT, ASYNC, INSTANCES };
+const option::Descriptor usage[] =
+{
+  { UNKNOWN, 0, "", ""           , Arg::Unknown   , "\nUSAGE: tlocUtilsMeshCooker [options]\n\n"
+                                                    "Options:" },
+  { HELP, 0, "", "help"          , Arg::None      , "  \t--help  \tPrint usage and exit." },
+  { IN_FILE, 0, "i", "input"     , Arg::Required  , "  -i <filename>, \t--input=<filename> \tOBJ file to load." },
+  { CHUNK, 0, "", "chunk"        , Arg::Numeric   , "  \t--chunk=<KB> \tStreams the file in chunks of this size instead of mapping it." },
+  { THREADS, 0, "", "threads"    , Arg::Numeric   , "  \t--threads=<n> \tNumber of threads used to parse a mapped file (default: 4)." },
+  { OPTIMIZE, 0, "", "optimize"  , Arg::None      , "  \t--optimize \tOptimizes the welded mesh for the vertex cache, overdraw and vertex fetch." },
+  { LODS, 0, "", "lods"          , Arg::Required  , "  \t--lods=<r1,r2,...> \tGenerates a LOD for each triangle ratio (e.g. 0.5,0.25,0.1)." },
+  { LOD_ERROR, 0, "", "lod-error", Arg::Required  , "  \t--lod-error=<e> \tLargest LOD error, relative to the size of the mesh (default: 0.02)." },
+  { MESHLETS, 0, "", "meshlets"  , Arg::None      , "  \t--meshlets \tSplits the mesh into meshlets and checks their culling against brute force." },
+  { QUANTIZE, 0, "", "quantize"  , Arg::None      , "  \t--quantize \tPrints the size and precision of the quantized vertex formats." },
+  { COOK, 0, "", "cook"          , Arg::None      , "  \t--cook \tWrites <filename>.tlmc (a cooked mesh) unless it is up to date." },
+  { BENCH, 0, "", "bench"        , Arg::None      , "  \t--bench \tCompares the MB/s of ObjLoader with the mapped (serial and parallel), streamed and cooked loading." },
+  { SELECT, 0, "", "select"      , Arg::Numeric   , "  \t--select=<n> \tTimes the LOD selection of n instances of the cooked mesh (needs --lods)." },
+  { ASYNC, 0, "", "async"        , Arg::Numeric   , "  \t--async=<n> \tLoads the OBJ file n times serially and on a worker pool (--threads), finishing the meshes a few ms per frame." },
+  { INSTANCES, 0, "", "instances", Arg::Numeric   , "  \t--instances=<n> \tCreates n instances of the mesh, each with a copy of its vertices and sharing one mesh." },
+  { 0, 0, 0, 0, 0, 0 }
+};
+
+// xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
+
+int TLOC_MAIN(int argc, char *argv[])
+{
+  core::memory::tracking::DoDisableTracking();
+
+  TLOC_COMMAND_LINE_SKIP_PROGRAM_NAME(argc, argv);
+  option::Stats   stats(usage, argc, argv);
+  option::Option* options = new option::Option[stats.options_max];
+  option::Option* buffer  = new option::Option[stats.buffer_max];
+  option::Parser  parse(usage, argc, argv, options, buffer);
+
+  if (parse.error())
+  {
+    option::printUsage(TLOC_LOG_DEFAULT_INFO_NO_FILENAME(), usage);
+    return 1;
+  }
+
+  if (argc == 0 || options[HELP] || options[UNKNOWN] || options[IN_FILE] == nullptr)
+  {
+    option::printUsage(TLOC_LOG_DEFAULT_INFO_NO_FILENAME(), usage);
+    return 0;
+  }
+
+  g_bench = options[BENCH] != nullptr;
+  g_optimize = options[OPTIMIZE] != nullptr;
+  g_meshlets = options[MESHLETS] != nullptr;
+
+  const core_str::String inFile(options[IN_FILE].arg);
+  if (core_io::Path(inFile).FileExists() == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "File " << inFile << " does not exist";
+    return 1;
+  }
+
+  const tl_int chunkKB = options[CHUNK] ? atoi(options[CHUNK].arg) : g_defaultChunkKB;
+  if (chunkKB <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The chunk size must be positive";
+    return 1;
+  }
+
+  const tl_size chunkSize = (tl_size)chunkKB * 1024;
+
+  if (options[THREADS])
+  { g_numThreads = atoi(options[THREADS].arg); }
+
+  if (g_numThreads <= 0)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The number of threads must be positive";
+    return 1;
+  }
+
+  if (options[LODS] && ParseLodRatios(options[LODS].arg, g_lodRatios) == false)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() 
+      << "LOD ratios must be decreasing and between 0 and 1";
+    return 1;
+  }
+
+  if (options[LOD_ERROR])
+  { g_lodMaxError = (f32)atof(options[LOD_ERROR].arg); }
+
+  if (g_lodMaxError <= 0.0f)
+  {
+    TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The LOD error must be positive";
+    return 1;
+  }
+
+  if (g_bench)
+  { return BenchObjLoading(inFile, chunkSize); }
+
+  if (options[SELECT])
+  {
+    const tl_int numInstances = atoi(options[SELECT].arg);
+    if (numInstances <= 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The number of instances must be positive";
+      return 1;
+    }
+
+    return BenchLodSelection(inFile, (tl_size)numInstances);
+  }
+
+  if (options[ASYNC])
+  {
+    const tl_int numFiles = atoi(options[ASYNC].arg);
+    if (numFiles <= 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The number of files must be positive";
+      return 1;
+    }
+
+    return BenchAsyncLoading(inFile, (tl_size)numFiles);
+  }
+
+  if (options[INSTANCES])
+  {
+    const tl_int numInstances = atoi(options[INSTANCES].arg);
+    if (numInstances <= 0)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "The number of instances must be positive";
+      return 1;
+    }
+
+    return BenchSharedMesh(inFile, (tl_size)numInstances);
+  }
+
+  if (options[COOK])
+  {
+    core_time::Timer cookTimer;
+
+    CookedMesh  cookedMesh;
+    bool        cooked = false;
+    if (LoadCookedMesh(inFile.c_str(), GetCookSettings(), cookedMesh, 
+                       &cooked) == false)
+    {
+      TLOC_LOG_DEFAULT_ERR_NO_FILENAME() << "Could not cook " << inFile;
+      return 1;
+    }
+
+    printf("\n%s %s.tlmc in %f sec", cooked ? "Cooked" : "Up to date:", 
+           inFile.c_str(), cookTimer.ElapsedSeconds());
+    printf("\n  vertices: %u, triangles: %u, groups: %u, %u bit indices",
+           (u32)cookedMesh.GetNumVertices(), (u32)cookedMesh.GetNumIndices() / 3,
+           (u32)cookedMesh.GetNumGroups(), (u32)cookedMesh.GetIndexSize() * 8);
+
+    if (cookedMesh.GetNumMeshlets())
+    { printf("\n  meshlets: %u", (u32)cookedMesh.GetNumMeshlets()); }
+
+    for (tl_size i = 0; i < cookedMesh.GetNumLods(); ++i)
+    {
+      const CookedMeshLod& lod = cookedMesh.GetLod(i);
+      printf("\n  LOD %u: ratio %.3f, triangles: %u, error: %f",
+             (u32)i, lod.m_ratio, lod.m_numIndices / 3, lod.m_error);
+    }
+    return 0;
+  }
+
+  // -----------------------------------------------------------------------
+  // load
+
+  core_time::Timer loadTimer;
+
+  ObjMesh mesh;
+  const bool loaded = options[CHUNK]
+    ? LoadStreamed(inFile, chunkSize, mesh)
+    : LoadMapped(inFile, mesh, g_numThreads);
+
+  if (loaded == false)
+  { return 1; }
+
+  printf("\nLoaded %s in %f sec", inFile.c_str(), loadTimer.ElapsedSeconds());
+  printf("\n  positions: %u, triangles: %u, groups: %u",
+         (u32)mesh.GetNumPositions(), (u32)mesh.GetNumTriangles(),
+         (u32)mesh.m_groups.size());
+
+  // -----------------------------------------------------------------------
+  // weld
+
+  core_time::Timer weldTimer;
+
+  IndexedMesh indexed;
+  WeldMesh(mesh, indexed);
+
+  const tl_size unpackedBytes = mesh.m_corners.size() * sizeof(vert_type);
+  const tl_size indexedBytes = indexed.m_vertices.size() * sizeof(vert_type) +
+                               indexed.GetNumIndices() * indexed.GetIndexSize();
+
+  printf("\nWelded in %f sec", weldTimer.ElapsedSeconds());
+  printf("\n  vertices: %u (%u unpacked), %u bit indices",
+         (u32)indexed.m_vertices.size(), (u32)mesh.m_corners.size(),
+         (u32)indexed.GetIndexSize() * 8);
+  printf("\n  vertex and index data: %.2f MB (%.2f MB unpacked, %.2fx smaller)",
+         (f64)indexedBytes / (1024.0 * 1024.0),
+         (f64)unpackedBytes / (1024.0 * 1024.0),
+         indexedBytes > 0 ? (f64)unpackedBytes / (f64)indexedBytes : 0.0);
+
+  // -----------------------------------------------------------------------
+  // simplify
+
+  if (g_lodRatios.empty() == false)
+  {
+    core_time::Timer lodTimer;
+    GenerateLods(indexed, &g_lodRatios[0], g_lodRatios.size(), g_numThreads, 
+                 g_lodMaxError);
+
+    printf("\nGenerated %u LODs in %f sec", (u32)indexed.m_lods.size(), 
+           lodTimer.ElapsedSeconds());
+    for (tl_size i = 0; i < indexed.m_lods.size(); ++i)
+    {
+      const MeshLod& lod = indexed.m_lods[i];
+      printf("\n  LOD %u: ratio %.3f, triangles: %u, error: %f",
+             (u32)i, lod.m_ratio, (u32)lod.m_indices.size() / 3, lod.m_error);
+    }
+  }
+
+  // -----------------------------------------------------------------------
+  // optimize
+
+  if (g_optimize)
+  {
+    const VertexCacheStats before = AnalyzeVertexCache(indexed);
+
+    core_time::Timer optimizeTimer;
+    OptimizeMesh(indexed);
+    const f64 optimizeTime = optimizeTimer.ElapsedSeconds();
+
+    const VertexCacheStats after = AnalyzeVertexCache(indexed);
+
+    printf("\nOptimized in %f sec", optimizeTime);
+    printf("\n  ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f (FIFO cache of 16)",
+           before.m_acmr, after.m_acmr, before.m_atvr, after.m_atvr);
+  }
+
+  // -----------------------------------------------------------------------
+  // meshlets
+
+  if (g_meshlets)
+  {
+    core_time::Timer meshletTimer;
+    BuildMeshlets(indexed);
+
+    printf("\nBuilt %u meshlets in %f sec (%.1f triangles each)", 
+           (u32)indexed.m_meshlets.size(), meshletTimer.ElapsedSeconds(),
+           indexed.m_meshlets.empty() ? 0.0 
+           : (f64)indexed.GetNumIndices() / 3 / indexed.m_meshlets.size());
+
+    if (indexed.m_meshlets.empty() == false && 
+        CheckMeshletCulling(indexed) == false)
+    { return 1; }
+  }
+
+  // -----------------------------------------------------------------------
+  // quantize
+
+  if (options[QUANTIZE] && indexed.m_vertices.empty() == false)
+  {
+    printf("\nQuantized vertices (%.2f MB as float)", 
+           (f64)(indexed.m_vertices.size() * sizeof(MeshVertex)) / (1024.0 * 1024.0));
+    PrintQuantization<QuantizedVertex8>("8 bit normals", indexed);
+    PrintQuantization<QuantizedVertex16>("16 bit normals", indexed);
+  }
+
+  return 0;
+}
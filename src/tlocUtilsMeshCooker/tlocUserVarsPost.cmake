@@ -0,0 +1,4 @@
+#------------------------------------------------------------------------------
+# This file is included AFTER CMake adds the executable/library. Any operations
+# you want to perform that are done after the project has been created, can
+# be performed in this file.
@@ -0,0 +1,32 @@
+#------------------------------------------------------------------------------
+# This file is included AFTER CMake adds the executable/library
+# Do NOT remove the following variables. Modify the variables to suit your 
+# project.
+
+# Do NOT remove the following variables. Modify the variables to suit your project
+set(SOLUTION_SOURCE_FILES
+  main.cpp
+  )
+
+# Do not include individual assets here. Only add paths
+set(SOLUTION_ASSETS_PATH
+  ../../assets
+  )
+
+# Dependent project is compiled after dependency
+set(SOLUTION_PROJECT_DEPENDENCIES
+  tlocMeshTools
+  tlocAsyncLoading
+  )
+
+# Libraries that the executable needs to link against
+set(SOLUTION_EXECUTABLE_LINK_LIBRARIES
+  tlocAsyncLoading
+  tlocMeshTools
+  )
+
+# the worker threads of tlocAsyncLoading are std::thread
+find_package(Threads)
+if (CMAKE_THREAD_LIBS_INIT)
+  list(APPEND SOLUTION_EXECUTABLE_LINK_LIBRARIES ${CMAKE_THREAD_LIBS_INIT})
+endif()
@@ -45,5 +45,19 @@ list(APPEND SOLUTION_EXECUTABLE_PROJECTS "tlocVolumetric;")
 list(APPEND SOLUTION_EXECUTABLE_PROJECTS "tlocWindow;")
 
 list(APPEND SOLUTION_EXECUTABLE_PROJECTS "tlocUtilsDFGenerator;")
+list(APPEND SOLUTION_EXECUTABLE_PROJECTS "tlocUtilsMeshCooker;")
+list(APPEND SOLUTION_EXECUTABLE_PROJECTS "tlocUtilsImageCooker;")
 
-set(SOLUTION_LIBRARY_PROJECTS "tlocSimpleLibrary")
+set(SOLUTION_LIBRARY_PROJECTS "tlocSimpleLibrary;")
+list(APPEND SOLUTION_LIBRARY_PROJECTS "tlocDistanceField;")
+list(APPEND SOLUTION_LIBRARY_PROJECTS "tlocMeshTools;")
+list(APPEND SOLUTION_LIBRARY_PROJECTS "tlocAsyncLoading;")
+list(APPEND SOLUTION_LIBRARY_PROJECTS "tlocImageTools;")
+
+#------------------------------------------------------------------------------
+# Added when TLOC_INCLUDE_TESTS is on, each one is also a CTest test
+set(SOLUTION_TEST_PROJECTS "tlocTests;")
+
+if(TLOC_INCLUDE_TESTS)
+  enable_testing()
+endif()